@@ -6,6 +6,31 @@ bool puma::export_bin(Workspace *work, const std::string& fileName) {
     return exporter.execute();
 }
 
+bool puma::export_bin(RLEWorkspace *work, const std::string& fileName) {
+
+    // the slices are requested in order, so a cursor on the current run of every column decodes them
+    long X = work->X(), Y = work->Y();
+    std::vector<long> cursor(X*Y);
+    for(long i=0; i<X; i++) {
+        for(long j=0; j<Y; j++) {
+            cursor[i*Y+j] = work->runsBegin(i,j);
+        }
+    }
+
+    Export_bin<short> exporter(X, Y, work->Z(), [work,X,Y,&cursor](long k, short *slice) {
+        for(long j=0; j<Y; j++) {
+            for(long i=0; i<X; i++) {
+                long &n = cursor[i*Y+j];
+                if(n+1 < work->runsEnd(i,j) && work->start(n+1) == k) {
+                    n++;
+                }
+                slice[X*j+i] = work->value(n);
+            }
+        }
+    }, fileName);
+    return exporter.execute();
+}
+
 bool puma::export_bin(Matrix<double> *matrix, const std::string& fileName) {
     Export_bin<double> exporter(matrix,fileName);
     return exporter.execute();
@@ -34,8 +59,21 @@ bool puma::export_bin(puma::MatVec3<double> *matrix, std::string fileName) {
 
 
 
-template<class T> Export_bin<T>::Export_bin(puma::Matrix<T> *matrix, const std::string& fileName) {
-    this->matrix = matrix;
+template<class T> Export_bin<T>::Export_bin(puma::Matrix<T> *matrix, const std::string& fileName)
+    : Export_bin(matrix->X(), matrix->Y(), matrix->Z(), [matrix](long k, T *slice) {
+        long X = matrix->X();
+        for (long j=0; j<matrix->Y(); j++) {
+            for (long i=0; i<X; i++) {
+                slice[X*j+i] = matrix->at(i,j,k);
+            }
+        }
+    }, fileName) { }
+
+template<class T> Export_bin<T>::Export_bin(long X, long Y, long Z, std::function<void(long, T*)> readSlice, const std::string& fileName) {
+    this->X = X;
+    this->Y = Y;
+    this->Z = Z;
+    this->readSlice = std::move(readSlice);
     this->fileName = fileName;
 }
 
@@ -73,24 +111,17 @@ template<class T> bool Export_bin<T>::execute() {
 
 template<class T> bool Export_bin<T>::exportHelper() {
 
-    FILE *file;
-    int n = fileName.length();
-    char fileName_char_array[n + 1];
-    strcpy(fileName_char_array, (fileName+".puma").c_str());
-    file = fopen(fileName_char_array,"w");
+    FILE *file = fopen((fileName+".puma").c_str(),"w");
 
     if (file != NULL) {
-        for (long k=0; k<matrix->Z(); k++) {
-            for (long j=0; j<matrix->Y(); j++) {
-                for (long i=0; i<matrix->X(); i++) {
-                    fwrite(&(matrix->at(i,j,k)), sizeof(T), 1, file);
-                }
-            }
+        // the file is written z slice by z slice, x fastest
+        std::vector<T> slice(X*Y);
+        for (long k=0; k<Z; k++) {
+            readSlice(k, &slice[0]);
+            fwrite(&slice[0], sizeof(T), slice.size(), file);
         }
-        T X = matrix->X(), Y = matrix->Y(), Z = matrix->Z();
-        fwrite(&X, sizeof(T), 1, file);
-        fwrite(&Y, sizeof(T), 1, file);
-        fwrite(&Z, sizeof(T), 1, file);
+        T size[3] = {(T)X, (T)Y, (T)Z};
+        fwrite(size, sizeof(T), 3, file);
 
         fclose(file);
     } else {
@@ -103,7 +134,7 @@ template<class T> bool Export_bin<T>::exportHelper() {
 
 
 template<class T> bool Export_bin<T>::errorCheck(std::string *errorMessage) {
-    if(matrix->size() == 0) {
+    if(X*Y*Z == 0) {
         *errorMessage = "Empty Matrix";
         return false;
     }
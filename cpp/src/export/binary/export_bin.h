@@ -3,6 +3,7 @@
 
 #include "export.h"
 #include "workspace.h"
+#include "rleworkspace.h"
 #include "pstring.h"
 #include "vector.h"
 #include "matrix.h"
@@ -12,6 +13,7 @@
 #include <cstdio>
 #include <cstring>
 #include <utility>
+#include <functional>
 
 
 namespace puma {
@@ -24,6 +26,14 @@ namespace puma {
  */
 bool export_bin(Workspace *work, const std::string& fileName);
 
+/** @brief Exports a puma::RLEWorkspace to a binary file (with extension .puma), decoding the runs slice by slice
+ *
+ *  @param work Pointer to a puma::RLEWorkspace to be exported, the file is the same as for the decoded puma::Workspace
+ *  @param fileName std::string containing the location and filename for export, Ex: /home/jsmith/Desktop/myWorkspace.puma
+ *  @return bool True if output was successful, False if an error occured.
+ */
+bool export_bin(RLEWorkspace *work, const std::string& fileName);
+
 
 /** @brief Exports a puma::Matrix<double> to a binary file (with extension .puma)
  *
@@ -85,11 +95,15 @@ public:
 
     Export_bin(puma::Matrix<T> *matrix, const std::string& fileName);
 
+    //! exports a domain of size X, Y, Z which is not held in a matrix, readSlice(k, slice) filling the X*Y values of the z slice k (x fastest).
+    Export_bin(long X, long Y, long Z, std::function<void(long, T*)> readSlice, const std::string& fileName);
+
     bool execute() override;
 
 private:
 
-    puma::Matrix<T> *matrix;
+    long X, Y, Z;
+    std::function<void(long, T*)> readSlice;
     std::string fileName;
 
     bool empty;
@@ -1,5 +1,7 @@
 #include "bilateralfilter.h"
 
+#include <algorithm>
+
 
 bool puma::filter_Bilateral(puma::Workspace *work, int window_radius, double sigma_d, double sigma_r, int numThreads) {
 
@@ -7,14 +9,44 @@ bool puma::filter_Bilateral(puma::Workspace *work, int window_radius, double sig
     return filter.execute();
 }
 
+bool puma::filter_Bilateral(puma::WorkspaceView *view, int window_radius, double sigma_d, double sigma_r, int numThreads) {
+
+    BilateralFilter filter(view,window_radius,sigma_d,sigma_r, numThreads);
+    return filter.execute();
+}
+
+bool puma::filter_BilateralGrid(puma::Workspace *work, double sigma_d, double sigma_r, int numThreads) {
+
+    BilateralFilter filter(work,0,sigma_d,sigma_r,numThreads,true);
+    return filter.execute();
+}
+
+bool puma::filter_BilateralGrid(puma::WorkspaceView *view, double sigma_d, double sigma_r, int numThreads) {
+
+    BilateralFilter filter(view,0,sigma_d,sigma_r,numThreads,true);
+    return filter.execute();
+}
+
 
-BilateralFilter::BilateralFilter(puma::Workspace *work, int window_radius, double sigma_d, double sigma_r, int numThreads) {
+BilateralFilter::BilateralFilter(puma::Workspace *work, int window_radius, double sigma_d, double sigma_r, int numThreads, bool grid) {
 
-    this->work = work;
+    this->view = puma::WorkspaceView(work);
     this->window_radius = window_radius;
     this->sigma_d = sigma_d;
     this->sigma_r = sigma_r;
     this->numThreads = numThreads;
+    this->grid = grid;
+}
+
+
+BilateralFilter::BilateralFilter(puma::WorkspaceView *view, int window_radius, double sigma_d, double sigma_r, int numThreads, bool grid) {
+
+    this->view = *view;
+    this->window_radius = window_radius;
+    this->sigma_d = sigma_d;
+    this->sigma_r = sigma_r;
+    this->numThreads = numThreads;
+    this->grid = grid;
 }
 
 
@@ -54,104 +86,272 @@ bool BilateralFilter::execute() {
 bool BilateralFilter::filterHelper() {
 
     //creating copy matrix
-    puma::Matrix<short> copyMatrix(work->X(),work->Y(),work->Z());
+    puma::Matrix<short> copyMatrix;
+    if(view.isMapped()) {
+        copyMatrix.mapFile();
+    }
+    copyMatrix.resize(view.X(),view.Y(),view.Z());
 
-    //finding the mean value for every point in the 3d Workspace.
-    //Assigning the mean value to the copyMatrix
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for( long i=0 ; i<work->X(); i++ ) {
-        for( long j=0 ; j<work->Y(); j++ ) {
-            for( long k=0 ; k<work->Z(); k++ ) {
-                copyMatrix(i,j,k) = bilateralValue(i,j,k);
-            }
-        }
+    //finding the bilateral value for every point in the 3d Workspace.
+    //Assigning the bilateral value to the copyMatrix
+    if(grid) {
+        gridFilter(&copyMatrix);
+    }
+    else {
+        filterSlabs(&view,0,view.X()-1,&copyMatrix);
     }
 
-    // since the filtered results are now stored in the copymatrix, they need to be
-    // moved to the Workspace. This is done through the Workspace
-    // copy function, which is already parallel
-    work->matrix.copy(&copyMatrix);
+    // since the filtered results are now stored in the copymatrix, they are stored back into the view.
+    // The storage is swapped in for a whole workspace on the heap, otherwise copied into the box
+    view.assign(&copyMatrix,numThreads);
 
     return true;
 }
 
 
-short BilateralFilter::bilateralValue(long x, long y, long z) {
+void BilateralFilter::grayscaleRange(puma::WorkspaceView *input, short *low, short *high) {
 
-    // determing the appropriate window for the filter algorithm. If the window
-    // goes outside the computational domain, the window is cut short.
-    int xStart = 0;
-    if(xStart < x-window_radius) {
-        xStart = x-window_radius;
+    short minValue = input->matrix(0,0,0), maxValue = minValue;
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for reduction(min:minValue) reduction(max:maxValue)
+    for(long i=0; i<input->X(); i++) {
+        for(long j=0; j<input->Y(); j++) {
+            for(long k=0; k<input->Z(); k++) {
+                minValue = std::min(minValue, input->matrix(i,j,k));
+                maxValue = std::max(maxValue, input->matrix(i,j,k));
+            }
+        }
     }
+    *low = minValue;
+    *high = maxValue;
+}
 
-    int yStart = 0;
-    if(yStart < y-window_radius) {
-        yStart = y-window_radius;
+
+bool BilateralFilter::filterSlabs(puma::WorkspaceView *input, long x1, long x2, puma::Matrix<short> *output) {
+
+    if(grid) {
+        std::cout << "Bilateral grid cannot be applied slab by slab" << std::endl;
+        return false;
     }
 
-    int zStart = 0;
-    if(zStart < z-window_radius) {
-        zStart = z-window_radius;
+    if(output->X() != x2-x1+1 || output->Y() != input->Y() || output->Z() != input->Z()) {
+        output->resize(x2-x1+1,input->Y(),input->Z());
     }
 
-    int xEnd = x+window_radius;
-    if(xEnd > work->X()-1) {
-        xEnd = work->X()-1;
+    short low, high;
+    grayscaleRange(input,&low,&high);
+
+    // The weight exp(-d^2/(2 sigma_d^2) - dI^2/(2 sigma_r^2)) is the product of a spatial weight, which only depends on
+    // the offset in the window, and of a range weight, which only depends on the grayscale difference |dI| <= high-low,
+    // so both are tabulated once. The products differ from the exponential of the sum by a few units in the last
+    // place, so the weighted means agree with the direct formula to about 1e-15 relative: the filtered values only
+    // differ (by one) where the weighted mean is that close to an integer.
+
+    // the offsets in the window are at most the size of the domain along each axis
+    long rX = std::min((long)window_radius, input->X()-1);
+    long rY = std::min((long)window_radius, input->Y()-1);
+    long rZ = std::min((long)window_radius, input->Z()-1);
+    std::vector<double> spatial((2*rX+1)*(2*rY+1)*(2*rZ+1));
+    for(long a=-rX; a<=rX; a++) {
+        for(long b=-rY; b<=rY; b++) {
+            for(long c=-rZ; c<=rZ; c++) {
+                spatial[((a+rX)*(2*rY+1) + b+rY)*(2*rZ+1) + c+rZ] = exp( - ( a*a + b*b + c*c ) / (2*sigma_d*sigma_d) );
+            }
+        }
     }
 
-    int yEnd = y+window_radius;
-    if(yEnd > work->Y()-1) {
-        yEnd = work->Y()-1;
+    std::vector<double> range((long)high-low+1);
+    for(long d=0; d<(long)range.size(); d++) {
+        range[d] = exp( - (double)(d*d) / (2*sigma_r*sigma_r) );
     }
 
-    int zEnd = z+window_radius;
-    if(zEnd > work->Z()-1) {
-        zEnd = work->Z()-1;
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for( long i=x1 ; i<=x2; i++ ) {
+        for( long j=0 ; j<input->Y(); j++ ) {
+            for( long k=0 ; k<input->Z(); k++ ) {
+                (*output)(i-x1,j,k) = bilateralValue(input,i,j,k,&spatial[0],rX,rY,rZ,&range[0]);
+            }
+        }
     }
 
+    return true;
+}
+
+
+short BilateralFilter::bilateralValue(puma::WorkspaceView *input, long x, long y, long z, const double *spatial, long rX, long rY, long rZ, const double *range) {
+
+    // determing the appropriate window for the filter algorithm. If the window
+    // goes outside the computational domain, the window is cut short.
+    long xStart = std::max(0L,x-window_radius), xEnd = std::min(input->X()-1,x+window_radius);
+    long yStart = std::max(0L,y-window_radius), yEnd = std::min(input->Y()-1,y+window_radius);
+    long zStart = std::max(0L,z-window_radius), zEnd = std::min(input->Z()-1,z+window_radius);
+
     // defining variables for calculations
-    double bilateral;
-    double w;
-    double term_1_w;
-    double term_2_w;
     double sum_w = 0;
     double sum_I_times_w = 0;
-    double work_value = work->matrix(x,y,z);
+    int work_value = input->matrix(x,y,z);
+    const short *origin = &input->matrix.at(0,0,0);
+    long strideI = input->matrix.strideI(), strideJ = input->matrix.strideJ();
 
     //iterating through the window and calculating
     for( long i=xStart; i<=xEnd; i++ ) {
         for( long j=yStart; j<=yEnd; j++ ) {
+            const short *row = origin + strideI*i + strideJ*j;
+            const double *spatialRow = spatial + ((i-x+rX)*(2*rY+1) + j-y+rY)*(2*rZ+1) + rZ;
             for( long k=zStart; k<=zEnd; k++ ) {
-                term_1_w = - ( (x-i)*(x-i) + (y-j)*(y-j) + (z-k)*(z-k) ) / (2* sigma_d*sigma_d);
-                term_2_w = - ( work_value - work->matrix(i,j,k) )*( work_value - work->matrix(i,j,k) ) / (2*sigma_r*sigma_r);
-                w = exp( term_1_w + term_2_w );
+                double w = spatialRow[k-z] * range[std::abs(work_value - row[k])];
 
                 sum_w += w;
-                sum_I_times_w += work->matrix(i,j,k)*w;
+                sum_I_times_w += row[k]*w;
             }
         }
     }
 
-    bilateral = sum_I_times_w/sum_w;
+    double bilateral = sum_I_times_w/sum_w;
 
     return bilateral;
 }
 
 
+void BilateralFilter::gridFilter(puma::Matrix<short> *copyMatrix) {
+
+    // The grid has cells of sigma_d voxels along x, y and z and of sigma_r in grayscale, with two empty cells of padding
+    // on each side for the blur and the interpolation. Every voxel adds its grayscale and a unit weight to the nearest
+    // cell, the (grayscale * weight, weight) grid is blurred by the [1 4 6 4 1] binomial kernel (a Gaussian of one
+    // cell) along its four axes, and the filtered voxel is the ratio of the two, interpolated at the voxel position
+    // and grayscale and rounded to the nearest integer.
+    short low, high;
+    grayscaleRange(&view,&low,&high);
+
+    const long pad = 2;
+    long X = view.X(), Y = view.Y(), Z = view.Z();
+    long gX = (long)((X-1)/sigma_d) + 2 + 2*pad;
+    long gY = (long)((Y-1)/sigma_d) + 2 + 2*pad;
+    long gZ = (long)((Z-1)/sigma_d) + 2 + 2*pad;
+    long gR = (long)((high-low)/sigma_r) + 2 + 2*pad;
+    long size = gX*gY*gZ*gR;
+
+    std::vector<float> sums(size,0), weights(size,0);
+
+    // the voxels of a slab of cells are all added by the same thread
+    std::vector<long> cellX(X);
+    for(long i=0; i<X; i++) {
+        cellX[i] = (long)(i/sigma_d + 0.5) + pad;
+    }
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long cx=pad; cx<gX-pad; cx++) {
+        for(long i=0; i<X; i++) {
+            if(cellX[i] != cx) {
+                continue;
+            }
+            for(long j=0; j<Y; j++) {
+                long cy = (long)(j/sigma_d + 0.5) + pad;
+                for(long k=0; k<Z; k++) {
+                    long cz = (long)(k/sigma_d + 0.5) + pad;
+                    short value = view.matrix(i,j,k);
+                    long cr = (long)((value-low)/sigma_r + 0.5) + pad;
+                    long cell = ((cx*gY + cy)*gZ + cz)*gR + cr;
+                    sums[cell] += value;
+                    weights[cell] += 1;
+                }
+            }
+        }
+    }
+
+    long strides[4] = {gY*gZ*gR, gZ*gR, gR, 1};
+    long lengths[4] = {gX, gY, gZ, gR};
+    for(int axis=0; axis<4; axis++) {
+        blurGrid(&sums,lengths[axis],strides[axis],numThreads);
+        blurGrid(&weights,lengths[axis],strides[axis],numThreads);
+    }
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<X; i++) {
+        double fx = i/sigma_d + pad;
+        long x0 = (long)fx;
+        double ax = fx - x0;
+        for(long j=0; j<Y; j++) {
+            double fy = j/sigma_d + pad;
+            long y0 = (long)fy;
+            double ay = fy - y0;
+            for(long k=0; k<Z; k++) {
+                double fz = k/sigma_d + pad;
+                long z0 = (long)fz;
+                double az = fz - z0;
+                short value = view.matrix(i,j,k);
+                double fr = (value-low)/sigma_r + pad;
+                long r0 = (long)fr;
+                double ar = fr - r0;
+
+                // quadrilinear interpolation between the 16 cells around the voxel
+                double sum = 0, weight = 0;
+                for(int a=0; a<2; a++) {
+                    for(int b=0; b<2; b++) {
+                        for(int c=0; c<2; c++) {
+                            for(int d=0; d<2; d++) {
+                                double w = (a ? ax : 1-ax) * (b ? ay : 1-ay) * (c ? az : 1-az) * (d ? ar : 1-ar);
+                                long cell = (((x0+a)*gY + y0+b)*gZ + z0+c)*gR + r0+d;
+                                sum += w*sums[cell];
+                                weight += w*weights[cell];
+                            }
+                        }
+                    }
+                }
+
+                (*copyMatrix)(i,j,k) = weight > 0 ? (short)std::lround(sum/weight) : value;
+            }
+        }
+    }
+}
+
+
+void BilateralFilter::blurGrid(std::vector<float> *values, long length, long stride, int numThreads) {
+
+    // the grid seen as [outer][length][stride], blurred along the middle index. The padding cells are empty, so
+    // values beyond the ends are zeros.
+    long outer = (long)values->size() / (length*stride);
+    float *v = &(*values)[0];
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel
+    {
+        std::vector<float> line(length+4,0);
+
+#pragma omp for
+        for(long l=0; l<outer*stride; l++) {
+            float *first = v + (l/stride)*length*stride + l%stride;
+            for(long n=0; n<length; n++) {
+                line[n+2] = first[n*stride];
+            }
+            for(long n=0; n<length; n++) {
+                first[n*stride] = (line[n] + 4*line[n+1] + 6*line[n+2] + 4*line[n+3] + line[n+4]) / 16;
+            }
+        }
+    }
+}
+
+
 bool BilateralFilter::logInput() {
 
-    puma::Logger *logger = work->log;
+    puma::Logger *logger = view.log;
 
     logger->appendLogSection("Execute Bilateral 3D Filter");
     logger->appendLogItem("Current Time: ");
     logger->appendLogItem(logger->getTime());
     logger->newLine();
     logger->appendLogLine(" -- Inputs:");
-    logger->appendLogItem("Window Radius: ");
-    logger->appendLogItem(window_radius);
-    logger->newLine();
+    if(grid) {
+        logger->appendLogLine("Bilateral Grid Approximation");
+    }
+    else {
+        logger->appendLogItem("Window Radius: ");
+        logger->appendLogItem(window_radius);
+        logger->newLine();
+    }
     logger->appendLogItem("Domain Parameter (sigma_d): ");
     logger->appendLogItem(sigma_d);
     logger->newLine();
@@ -167,7 +367,7 @@ bool BilateralFilter::logInput() {
 
 bool BilateralFilter::logOutput() {
 
-    puma::Logger *logger = work->log;
+    puma::Logger *logger = view.log;
 
     logger->appendLogLine("Successfully Executed Filter");
     logger->appendLogItem("Current Time: ");
@@ -185,16 +385,19 @@ bool BilateralFilter::errorCheck(std::string *errorMessage) {
     bool returnBool = true;
     *errorMessage = "";
 
-    if(work->size() == 0) {
+    if(view.size() == 0) {
         (*errorMessage).append("Empty Grayscale Workspace\n");
         returnBool = false;
     }
 
-    if(window_radius <= 0) {
+    if(grid) {
+        // the grid has no window
+    }
+    else if(window_radius <= 0) {
         (*errorMessage).append("Invalid window radius, must be >= 0\n");
         returnBool = false;
     }
-    else if(window_radius > work->size()) {
+    else if(window_radius > view.size()) {
         (*errorMessage).append("Invalid window radius, must be smaller than the domain size. Check inputs\n");
         returnBool = false;
     }
@@ -203,7 +406,7 @@ bool BilateralFilter::errorCheck(std::string *errorMessage) {
         (*errorMessage).append("Invalid sigma_d, must be > 0\n");
         returnBool = false;
     }
-    else if(sigma_d > work->size()) {
+    else if(sigma_d > view.size()) {
         (*errorMessage).append("Invalid sigma_d, must be smaller than the domain size. Check inputs\n");
         returnBool = false;
     }
@@ -2,6 +2,7 @@
 #define FILTER_H
 
 #include "operation.h"
+#include "workspaceview.h"
 
 class Filter : public Operation
 {
@@ -10,6 +11,17 @@ public:
 
     virtual bool execute() = 0;
 
+    // Slab interface, through which FilterPipeline runs a chain of filters a few x slabs at a time.
+    // A filter that supports it computes the slab x of its result from the slabs [x-halo(), x+halo()] of its input only.
+
+    //! number of slabs read on each side of a filtered slab, -1 if the filter needs the whole domain
+    virtual long halo() { return -1; }
+
+    //! filters the slabs [x1,x2] of input into output, resized to x2-x1+1 slabs. The windows are cut at the faces of
+    //! input, so the slabs are filtered as in the whole domain as long as input holds the halo() slabs on each side
+    //! of them, or ends there at a face of the domain. The parameters must have passed errorCheck().
+    virtual bool filterSlabs(puma::WorkspaceView * /*input*/, long /*x1*/, long /*x2*/, puma::Matrix<short> * /*output*/) { return false; }
+
 };
 
 #endif // FILTER_H
@@ -1,5 +1,7 @@
 #include "meanfilter3d.h"
 
+#include <algorithm>
+
 
 bool puma::filter_Mean3D(Workspace *work, int window_radius, int numThreads) {
 
@@ -7,10 +9,24 @@ bool puma::filter_Mean3D(Workspace *work, int window_radius, int numThreads) {
     return filter.execute();
 }
 
+bool puma::filter_Mean3D(puma::WorkspaceView *view, int window_radius, int numThreads) {
+
+    MeanFilter3D filter(view,window_radius,numThreads);
+    return filter.execute();
+}
+
 
 MeanFilter3D::MeanFilter3D(puma::Workspace *work, int window_radius, int numThreads) {
 
-    this->work = work;
+    this->view = puma::WorkspaceView(work);
+    this->window_radius = window_radius;
+    this->numThreads = numThreads;
+}
+
+
+MeanFilter3D::MeanFilter3D(puma::WorkspaceView *view, int window_radius, int numThreads) {
+
+    this->view = *view;
     this->window_radius = window_radius;
     this->numThreads = numThreads;
 }
@@ -52,90 +68,122 @@ bool MeanFilter3D::execute() {
 bool MeanFilter3D::filterHelper() {
 
     //creating copy matrix
-    puma::Matrix<short> copyMatrix(work->X(),work->Y(),work->Z());
+    puma::Matrix<short> copyMatrix;
+    if(view.isMapped()) {
+        copyMatrix.mapFile();
+    }
+    copyMatrix.resize(view.X(),view.Y(),view.Z());
 
     //finding the mean value for every point in the 3d Workspace.
     //Assigning the mean value to the copyMatrix
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for( long i=0 ; i<work->X(); i++ ) {
-        for( long j=0 ; j<work->Y(); j++ ) {
-            for( long k=0 ; k<work->Z(); k++ ) {
-                copyMatrix(i,j,k) = meanValue(i,j,k);
-            }
-        }
-    }
+    filterSlabs(&view,0,view.X()-1,&copyMatrix);
 
-    // since the filtered results are now stored in the copymatrix, they need to be
-    // moved to the Workspace. This is done through the Workspace
-    // copy function, which is already parallel
-    work->matrix.copy(&copyMatrix);
+    // since the filtered results are now stored in the copymatrix, they are stored back into the view.
+    // The storage is swapped in for a whole workspace on the heap, otherwise copied into the box
+    view.assign(&copyMatrix,numThreads);
 
     return true;
 }
 
 
-short MeanFilter3D::meanValue(long x, long y, long z) {
+bool MeanFilter3D::filterSlabs(puma::WorkspaceView *input, long x1, long x2, puma::Matrix<short> *output) {
 
-    // determing the appropriate window for the filter algorithm. If the window
-    // goes outside the computational domain, the window is cut short.
-    int xStart = 0;
-    if(xStart < x-window_radius) {
-        xStart = x-window_radius;
+    long X = input->X(), Y = input->Y(), Z = input->Z();
+    if(output->X() != x2-x1+1 || output->Y() != Y || output->Z() != Z) {
+        output->resize(x2-x1+1,Y,Z);
     }
 
-    int yStart = 0;
-    if(yStart < y-window_radius) {
-        yStart = y-window_radius;
-    }
+    // The window is a box, cut short at the faces of the domain, so its sum is computed with running sums instead of
+    // re-adding its (2r+1)^3 voxels: addSlice adds (or removes) the window sums over y and z of one x slice, and the
+    // window is slid along x by adding the slice that enters it and removing the one that leaves it. The cost per voxel
+    // does not depend on the window radius. The sums are exact integers, so the means are the ones of the direct sum.
+    // Every thread slides the window over its own range of x.
+    long r = window_radius;
+    long numChunks = std::min((long)numThreads, x2-x1+1);
 
-    int zStart = 0;
-    if(zStart < z-window_radius) {
-        zStart = z-window_radius;
-    }
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(static)
+    for(long c=0; c<numChunks; c++) {
+        long xBegin = x1 + c*(x2-x1+1)/numChunks;
+        long xEnd = x1 + (c+1)*(x2-x1+1)/numChunks;
+
+        std::vector<long> windowSums(Y*Z,0), rowSums(Y*Z), prefix(Z+1);
+        for(long x=std::max(0L,xBegin-r); x<=std::min(X-1,xBegin+r); x++) {
+            addSlice(input,x,1,&windowSums,&rowSums,&prefix);
+        }
 
-    int xEnd = x+window_radius;
-    if(xEnd > work->X()-1) {
-        xEnd = work->X()-1;
-    }
+        for(long i=xBegin; i<xEnd; i++) {
+            if(i > xBegin) {
+                if(i+r < X) {
+                    addSlice(input,i+r,1,&windowSums,&rowSums,&prefix);
+                }
+                if(i-r-1 >= 0) {
+                    addSlice(input,i-r-1,-1,&windowSums,&rowSums,&prefix);
+                }
+            }
 
-    int yEnd = y+window_radius;
-    if(yEnd > work->Y()-1) {
-        yEnd = work->Y()-1;
+            long xSize = std::min(X-1,i+r) - std::max(0L,i-r) + 1;
+            for(long j=0; j<Y; j++) {
+                long ySize = std::min(Y-1,j+r) - std::max(0L,j-r) + 1;
+                for(long k=0; k<Z; k++) {
+                    long zSize = std::min(Z-1,k+r) - std::max(0L,k-r) + 1;
+                    (*output)(i-x1,j,k) = (short)(windowSums[j*Z+k] / (xSize*ySize*zSize));
+                }
+            }
+        }
     }
 
-    int zEnd = z+window_radius;
-    if(zEnd > work->Z()-1) {
-        zEnd = work->Z()-1;
-    }
+    return true;
+}
 
-    // computing the size of the window in each direction
-    int xSize = xEnd - xStart + 1;
-    int ySize = yEnd - yStart + 1;
-    int zSize = zEnd - zStart + 1;
 
-    //Creating new variables for the average calculation
-    int sum = 0;
-    int count = xSize* ySize * zSize;
+void MeanFilter3D::addSlice(puma::WorkspaceView *input, long x, long sign, std::vector<long> *windowSums, std::vector<long> *rowSums, std::vector<long> *prefix) {
 
-    //iterating through the window and adding all the elements into the totalValues
-    for( long i=xStart; i<=xEnd; i++ ) {
-        for( long j=yStart; j<=yEnd; j++ ) {
-            for( long k=zStart; k<=zEnd; k++ ) {
-                sum += work->matrix(i,j,k);
-            }
+    long Y = input->Y(), Z = input->Z();
+    long r = window_radius;
+    long *rows = &(*rowSums)[0];
+    long *p = &(*prefix)[0];
+
+    // window sums along z of every row, from the prefix sums of the row
+    for(long j=0; j<Y; j++) {
+        const short *row = &input->matrix.at(x,j,0);
+        p[0] = 0;
+        for(long k=0; k<Z; k++) {
+            p[k+1] = p[k] + row[k];
+        }
+        for(long k=0; k<Z; k++) {
+            rows[j*Z+k] = p[std::min(Z-1,k+r)+1] - p[std::max(0L,k-r)];
         }
     }
 
-    short mean = sum / count;
+    // prefix sums of the rows along y, whose differences are the window sums along y
+    for(long j=1; j<Y; j++) {
+        for(long k=0; k<Z; k++) {
+            rows[j*Z+k] += rows[(j-1)*Z+k];
+        }
+    }
 
-    return mean;
+    long *sums = &(*windowSums)[0];
+    for(long j=0; j<Y; j++) {
+        const long *last = rows + std::min(Y-1,j+r)*Z;
+        if(j-r-1 >= 0) {
+            const long *beforeFirst = rows + (j-r-1)*Z;
+            for(long k=0; k<Z; k++) {
+                sums[j*Z+k] += sign*(last[k] - beforeFirst[k]);
+            }
+        }
+        else {
+            for(long k=0; k<Z; k++) {
+                sums[j*Z+k] += sign*last[k];
+            }
+        }
+    }
 }
 
 
 bool MeanFilter3D::logInput() {
 
-    puma::Logger *logger = work->log;
+    puma::Logger *logger = view.log;
 
     logger->appendLogSection("Execute Mean 3D Filter");
     logger->appendLogItem("Current Time: ");
@@ -154,7 +202,7 @@ bool MeanFilter3D::logInput() {
 
 bool MeanFilter3D::logOutput() {
 
-    puma::Logger *logger = work->log;
+    puma::Logger *logger = view.log;
 
     logger->appendLogLine("Successfully Executed Filter");
     logger->appendLogItem("Current Time: ");
@@ -172,7 +220,7 @@ bool MeanFilter3D::errorCheck(std::string *errorMessage) {
     bool returnBool = true;
     *errorMessage = "";
 
-    if(work->size() == 0) {
+    if(view.size() == 0) {
         (*errorMessage).append("Empty Grayscale Workspace\n");
         returnBool = false;
     }
@@ -181,7 +229,7 @@ bool MeanFilter3D::errorCheck(std::string *errorMessage) {
         (*errorMessage).append("Invalid window radius, must be >= 0\n");
         returnBool = false;
     }
-    else if(window_radius > work->size()) {
+    else if(window_radius > view.size()) {
         (*errorMessage).append("Invalid window radius, must be smaller than the domain size. Check inputs\n");
         returnBool = false;
     }
@@ -3,6 +3,9 @@
 
 #include "filter.h"
 #include "workspace.h"
+#include "workspaceview.h"
+
+#include <vector>
 
 
 namespace puma {
@@ -14,25 +17,31 @@ namespace puma {
 \return true for success or false for fail 
 */
 bool filter_Mean3D(Workspace *work, int window_radius, int numThreads = 0);
+//! filters a box of a workspace in place, the window being cut at the faces of the box as for a cropped workspace
+bool filter_Mean3D(puma::WorkspaceView *view, int window_radius, int numThreads = 0);
 }
 
-class MeanFilter3D : Filter
+class MeanFilter3D : public Filter
 {
 public:
 
     MeanFilter3D(puma::Workspace *work, int window_radius, int numThreads = 0);
+    MeanFilter3D(puma::WorkspaceView *view, int window_radius, int numThreads = 0);
 
     bool execute() override;
 
+    long halo() override { return window_radius; }
+    bool filterSlabs(puma::WorkspaceView *input, long x1, long x2, puma::Matrix<short> *output) override;
+
 
 private:
 
-    puma::Workspace *work;
+    puma::WorkspaceView view;
     int window_radius;
     int numThreads;
 
     bool filterHelper();
-    short meanValue(long x, long y, long z);
+    void addSlice(puma::WorkspaceView *input, long x, long sign, std::vector<long> *windowSums, std::vector<long> *rowSums, std::vector<long> *prefix);
 
     bool logInput() override;
     bool logOutput() override;
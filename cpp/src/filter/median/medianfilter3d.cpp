@@ -1,5 +1,7 @@
 #include "medianfilter3d.h"
 
+#include <algorithm>
+
 
 bool puma::filter_Median3D(Workspace *work, int window_radius, int numThreads) {
 
@@ -7,10 +9,24 @@ bool puma::filter_Median3D(Workspace *work, int window_radius, int numThreads) {
     return filter.execute();
 }
 
+bool puma::filter_Median3D(puma::WorkspaceView *view, int window_radius, int numThreads) {
+
+    MedianFilter3D filter(view,window_radius,numThreads);
+    return filter.execute();
+}
+
 
 MedianFilter3D::MedianFilter3D(puma::Workspace *work, int window_radius, int numThreads) {
 
-    this->work = work;
+    this->view = puma::WorkspaceView(work);
+    this->window_radius = window_radius;
+    this->numThreads = numThreads;
+}
+
+
+MedianFilter3D::MedianFilter3D(puma::WorkspaceView *view, int window_radius, int numThreads) {
+
+    this->view = *view;
     this->window_radius = window_radius;
     this->numThreads = numThreads;
 }
@@ -52,160 +68,139 @@ bool MedianFilter3D::execute() {
 bool MedianFilter3D::filterHelper() {
 
     //creating copy matrix
-    puma::Matrix<short> copyMatrix(work->X(),work->Y(),work->Z());
+    puma::Matrix<short> copyMatrix;
+    if(view.isMapped()) {
+        copyMatrix.mapFile();
+    }
+    copyMatrix.resize(view.X(),view.Y(),view.Z());
 
     //finding the median value for every point in the 3d Workspace.
     //Assigning the median value to the copyMatrix
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for( long i=0 ; i<work->X(); i++ ) {
-        for( long j=0 ; j<work->Y(); j++ ) {
-            for( long k=0 ; k<work->Z(); k++ ) {
-                copyMatrix(i,j,k) = medianValue(i,j,k);
-            }
-        }
-    }
+    filterSlabs(&view,0,view.X()-1,&copyMatrix);
 
-    // since the filtered results are now stored in the copymatrix, they need to be
-    // moved to the Workspace. This is done through the Workspace
-    // copy function, which is already parallel
-    work->matrix.copy(&copyMatrix);
+    // since the filtered results are now stored in the copymatrix, they are stored back into the view.
+    // The storage is swapped in for a whole workspace on the heap, otherwise copied into the box
+    view.assign(&copyMatrix,numThreads);
 
     return true;
 }
 
 
-void MedianFilter3D::swap(short &val1, short &val2) {
-
-    short temp = val1;
-    val1 = val2;
-    val2 = temp;
-}
+bool MedianFilter3D::filterSlabs(puma::WorkspaceView *input, long x1, long x2, puma::Matrix<short> *output) {
 
+    long X = input->X(), Y = input->Y(), Z = input->Z();
+    if(output->X() != x2-x1+1 || output->Y() != Y || output->Z() != Z) {
+        output->resize(x2-x1+1,Y,Z);
+    }
+    long r = window_radius;
 
-short MedianFilter3D::partition(short *arIntegers, int left, int right, int pivot) {
-
-    short pivotValue = arIntegers[pivot];
-
-    swap(arIntegers[pivot], arIntegers[right]);
-    short storeIndex = left;
+    // range of the grayscale, which sets the size of the histograms
+    short low = input->matrix(0,0,0), high = low;
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for reduction(min:low) reduction(max:high)
+    for(long i=0; i<X; i++) {
+        for(long j=0; j<Y; j++) {
+            for(long k=0; k<Z; k++) {
+                low = std::min(low, input->matrix(i,j,k));
+                high = std::max(high, input->matrix(i,j,k));
+            }
+        }
+    }
+    minValue = low;
+    long numValues = (long)high - low + 1;
+    blockBits = 0;
+    while((1L << (2*blockBits)) < numValues) {
+        blockBits++;
+    }
+    long numBlocks = ((numValues-1) >> blockBits) + 1;
 
-    for (int i = left; i < right; i++)
+    // The median is read from a histogram of the window instead of sorting the window of every voxel. Along a row,
+    // the window slides by one voxel in z at a time, so the plane of voxels that enters it is added to the histogram
+    // and the one that leaves it removed, (2r+1)^2 updates per voxel. The window is cut short at the faces of the
+    // domain, and the median of an even number of values is the mean of the two middle ones, truncated to a short.
+    omp_set_num_threads(numThreads);
+#pragma omp parallel
     {
-        if (arIntegers[i] <= pivotValue)
-        {
-            swap(arIntegers[i], arIntegers[storeIndex]);
-            storeIndex++;
+        std::vector<int> counts(numValues,0), blockCounts(numBlocks,0);
+
+#pragma omp for
+        for(long i=x1; i<=x2; i++) {
+            long xStart = std::max(0L,i-r), xEnd = std::min(X-1,i+r);
+            for(long j=0; j<Y; j++) {
+                long yStart = std::max(0L,j-r), yEnd = std::min(Y-1,j+r);
+
+                for(long z=0; z<=std::min(Z-1,r); z++) {
+                    updateHistogram(input,xStart,xEnd,yStart,yEnd,z,1,&counts[0],&blockCounts[0]);
+                }
+
+                for(long k=0; k<Z; k++) {
+                    if(k > 0) {
+                        if(k+r < Z) {
+                            updateHistogram(input,xStart,xEnd,yStart,yEnd,k+r,1,&counts[0],&blockCounts[0]);
+                        }
+                        if(k-r-1 >= 0) {
+                            updateHistogram(input,xStart,xEnd,yStart,yEnd,k-r-1,-1,&counts[0],&blockCounts[0]);
+                        }
+                    }
+
+                    long zSize = std::min(Z-1,k+r) - std::max(0L,k-r) + 1;
+                    long size = (xEnd-xStart+1) * (yEnd-yStart+1) * zSize;
+                    if(size % 2 == 0) {
+                        double median = (rankValue(size/2,&counts[0],&blockCounts[0]) + rankValue(size/2-1,&counts[0],&blockCounts[0]))/2.0;
+                        (*output)(i-x1,j,k) = (short)median;
+                    }
+                    else {
+                        (*output)(i-x1,j,k) = rankValue(size/2,&counts[0],&blockCounts[0]);
+                    }
+                }
+
+                // empties the histogram for the next row
+                for(long z=std::max(0L,Z-1-r); z<Z; z++) {
+                    updateHistogram(input,xStart,xEnd,yStart,yEnd,z,-1,&counts[0],&blockCounts[0]);
+                }
+            }
         }
     }
-    swap(arIntegers[storeIndex], arIntegers[right]);
-    return storeIndex;
-}
-
-
-short MedianFilter3D::median3(short *arIntegers,int left,int right) {
-
-    short center = (left+right)/2;
-
-    if(arIntegers[center] < arIntegers[left])
-        swap(arIntegers[left],arIntegers[center]);
-    if(arIntegers[right] < arIntegers[left])
-        swap(arIntegers[left],arIntegers[right]);
-    if(arIntegers[right] < arIntegers[center])
-        swap(arIntegers[center],arIntegers[right]);
-
-    swap(arIntegers[center],arIntegers[right-1]);
-
-    return center;
-}
-
-
-void MedianFilter3D::quicksort(short* arIntegers, int left, int right) {
-
-    if (right > left) {
-        short pivotIndex = median3(arIntegers,left,right);
-        short pivotNewIndex = partition(arIntegers, left, right, pivotIndex);
 
-        quicksort(arIntegers, left, pivotNewIndex-1);
-        quicksort(arIntegers, pivotNewIndex+1, right);
-    }
+    return true;
 }
 
 
-short MedianFilter3D::getMedian(short* daArray, int iSize) {
-
-    //taking the unsorted input array and sorting it
-    quicksort(daArray,0,iSize-1);
+void MedianFilter3D::updateHistogram(puma::WorkspaceView *input, long x1, long x2, long y1, long y2, long z, int change, int *counts, int *blockCounts) {
 
-    //computed the median value of the array
-    double dMedian = 0.0;
-    if ((iSize % 2) == 0) {
-        dMedian = (daArray[iSize/2] + daArray[(iSize/2) - 1])/2.0;
-    } else {
-        dMedian = daArray[iSize/2];
+    for(long i=x1; i<=x2; i++) {
+        for(long j=y1; j<=y2; j++) {
+            long value = input->matrix(i,j,z) - minValue;
+            counts[value] += change;
+            blockCounts[value >> blockBits] += change;
+        }
     }
-    return (short)dMedian;
 }
 
 
-short MedianFilter3D::medianValue(long x, long y, long z) {
+short MedianFilter3D::rankValue(long rank, const int *counts, const int *blockCounts) {
 
-    // determing the appropriate window for the filter algorithm. If the window
-    // goes outside the computational domain, the window is cut short.
-    int xStart = 0;
-    if(xStart < x-window_radius) {
-        xStart = x-window_radius;
-    }
-    int yStart = 0;
-    if(yStart < y-window_radius) {
-        yStart = y-window_radius;
-    }
-    int zStart = 0;
-    if(zStart < z-window_radius) {
-        zStart = z-window_radius;
+    // value of the element at position rank (from 0) of the sorted window
+    long below = 0;
+    long block = 0;
+    while(below + blockCounts[block] <= rank) {
+        below += blockCounts[block];
+        block++;
     }
 
-    int xEnd = x+window_radius;
-    if(xEnd > work->X()-1) {
-        xEnd = work->X()-1;
+    long value = block << blockBits;
+    while(below + counts[value] <= rank) {
+        below += counts[value];
+        value++;
     }
 
-    int yEnd = y+window_radius;
-    if(yEnd > work->Y()-1) {
-        yEnd = work->Y()-1;
-    }
-    int zEnd = z+window_radius;
-    if(zEnd > work->Z()-1) {
-        zEnd = work->Z()-1;
-    }
-
-    // computing the size of the window in each direction
-    int xSize = xEnd - xStart + 1;
-    int ySize = yEnd - yStart + 1;
-    int zSize = zEnd - zStart + 1;
-
-    // creating an array that will store all of the values in the window
-    short totalValues[xSize * ySize * zSize];
-
-    //iterating through the window and adding all the elements into the totalValues
-    for( long i=xStart; i<=xEnd; i++ ) {
-        for( long j=yStart; j<=yEnd; j++ ) {
-            for( long k=zStart; k<=zEnd; k++ ) {
-                totalValues[zSize*ySize*(i-xStart)+zSize*(j-yStart)+(k-zStart)] = work->matrix(i,j,k);
-            }
-        }
-    }
-
-    //computing the median value of the window elements
-    short median = getMedian(totalValues, xSize*ySize*zSize);
-
-    return median;
+    return (short)(value + minValue);
 }
 
 
 bool MedianFilter3D::logInput() {
 
-    puma::Logger *logger = work->log;
+    puma::Logger *logger = view.log;
 
     logger->appendLogSection("Execute Median 3D Filter");
     logger->appendLogItem("Current Time: ");
@@ -224,7 +219,7 @@ bool MedianFilter3D::logInput() {
 
 bool MedianFilter3D::logOutput() {
 
-    puma::Logger *logger = work->log;
+    puma::Logger *logger = view.log;
 
     logger->appendLogLine("Successfully Executed Filter");
     logger->appendLogItem("Current Time: ");
@@ -242,7 +237,7 @@ bool MedianFilter3D::errorCheck(std::string *errorMessage) {
     bool returnBool = true;
     *errorMessage = "";
 
-    if(work->size() == 0) {
+    if(view.size() == 0) {
         (*errorMessage).append("Empty Grayscale Workspace\n");
         returnBool = false;
     }
@@ -251,7 +246,7 @@ bool MedianFilter3D::errorCheck(std::string *errorMessage) {
         (*errorMessage).append("Invalid window radius, must be >= 0\n");
         returnBool = false;
     }
-    else if(window_radius > work->size()) {
+    else if(window_radius > view.size()) {
         (*errorMessage).append("Invalid window radius, must be smaller than the domain size. Check inputs\n");
         returnBool = false;
     }
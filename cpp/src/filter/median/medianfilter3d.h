@@ -3,6 +3,9 @@
 
 #include "filter.h"
 #include "workspace.h"
+#include "workspaceview.h"
+
+#include <vector>
 
 
 namespace puma {
@@ -14,33 +17,38 @@ namespace puma {
 \return true for success or false for fail
 */
 bool filter_Median3D(puma::Workspace *work, int window_radius, int numThreads = 0);
+//! filters a box of a workspace in place, the window being cut at the faces of the box as for a cropped workspace
+bool filter_Median3D(puma::WorkspaceView *view, int window_radius, int numThreads = 0);
 }
 
-class MedianFilter3D : Filter
+class MedianFilter3D : public Filter
 {
 public:
 
     MedianFilter3D(puma::Workspace *work, int window_radius, int numThreads = 0);
+    MedianFilter3D(puma::WorkspaceView *view, int window_radius, int numThreads = 0);
 
     bool execute() override;
 
+    long halo() override { return window_radius; }
+    bool filterSlabs(puma::WorkspaceView *input, long x1, long x2, puma::Matrix<short> *output) override;
+
 
 private:
 
-    puma::Workspace *work;
+    puma::WorkspaceView view;
     int window_radius;
     int numThreads;
 
-    //functions for the quicksort algorithm. Needed for getMedian
-    void quicksort(short *arIntegers, int left, int right);
-    short median3(short *arIntegers,int left,int right);
-    short partition(short *arIntegers, int left, int right, int pivot);
-    void swap(short &val1, short &val2);
+    // the window histogram, counts of every value from minValue on, and the same counts summed over blocks of
+    // 2^blockBits values, to find a given rank in about the square root of the number of values
+    short minValue;
+    int blockBits;
 
     bool filterHelper();
 
-    short getMedian(short* daArray, int iSize);
-    short medianValue(long x, long y, long z);
+    void updateHistogram(puma::WorkspaceView *input, long x1, long x2, long y1, long y2, long z, int change, int *counts, int *blockCounts);
+    short rankValue(long rank, const int *counts, const int *blockCounts);
 
     bool logInput() override;
     bool logOutput() override;
@@ -0,0 +1,292 @@
+#include "filterpipeline.h"
+
+#include <algorithm>
+
+
+FilterPipeline::FilterPipeline(puma::Workspace *work, long chunk, int numThreads) {
+
+    this->view = puma::WorkspaceView(work);
+    this->chunk = chunk;
+    this->numThreads = numThreads;
+}
+
+
+FilterPipeline::FilterPipeline(puma::WorkspaceView *view, long chunk, int numThreads) {
+
+    this->view = *view;
+    this->chunk = chunk;
+    this->numThreads = numThreads;
+}
+
+
+void FilterPipeline::add(Filter *filter) {
+
+    filters.push_back(filter);
+}
+
+
+bool FilterPipeline::execute() {
+
+    //execute function needs to do four things:
+    // 1. log the inputs
+    // 2. error check the inputs
+    // 3. computation
+    // 4. log the outputs
+
+    //step 1. log the inputs
+    logInput();
+
+    //step 2. error check the inputs
+    std::string errorMessage;
+    if( !errorCheck(&errorMessage) ) {
+        std::cout << "Filter Pipeline Error: " <<  errorMessage << std::endl;
+        return false;
+    }
+
+    //step 3. computation
+    // the result is written into the view while it is read, which is safe since every slab of the input is loaded
+    // into the buffer of the first filter before the slab at the same position of the result is written
+    bool success = stream(&view,0,view.X()-1,&view.matrix);
+    view.source()->modified();
+
+    if(!success) {
+        std::cout << "Unable to execute filter pipeline" << std::endl;
+        return false;
+    }
+
+    //step 4. log the outputs
+    logOutput();
+
+    return true;
+}
+
+
+long FilterPipeline::halo() {
+
+    long sum = 0;
+    for(Filter *filter : filters) {
+        if(filter->halo() < 0) {
+            return -1;
+        }
+        sum += filter->halo();
+    }
+    return sum;
+}
+
+
+bool FilterPipeline::filterSlabs(puma::WorkspaceView *input, long x1, long x2, puma::Matrix<short> *output) {
+
+    if(output->X() != x2-x1+1 || output->Y() != input->Y() || output->Z() != input->Z()) {
+        output->resize(x2-x1+1,input->Y(),input->Z());
+    }
+
+    puma::MatrixView<short> result(output);
+    return stream(input,x1,x2,&result);
+}
+
+
+bool FilterPipeline::stream(puma::WorkspaceView *input, long x1, long x2, puma::MatrixView<short> *output) {
+
+    long n = (long)filters.size();
+    long X = input->X(), Y = input->Y(), Z = input->Z();
+
+    // the slabs [first[s],last[s]] of the input of filter s are needed for the slabs [x1,x2] of the result,
+    // which are [first[n],last[n]]
+    std::vector<long> first(n+1), last(n+1);
+    first[n] = x1;
+    last[n] = x2;
+    long maxHalo = 0;
+    for(long s=n-1; s>=0; s--) {
+        long h = filters[s]->halo();
+        first[s] = std::max(0L, first[s+1]-h);
+        last[s] = std::min(X-1, last[s+1]+h);
+        maxHalo = std::max(maxHalo,h);
+    }
+
+    long slabs = chunk > 0 ? chunk : std::max((long)numThreads, 2*maxHalo);
+    slabs = std::max(slabs,1L);
+
+    // The buffer of filter s holds the slabs [bufferFirst[s], bufferFirst[s]+bufferCount[s]-1] of its input, and
+    // next[s] is the next slab of its output. After each chunk, it keeps at most its halo on each side of next[s], and
+    // receives at most the chunk plus the halos of the filters before it, which sets its capacity.
+    std::vector<puma::Workspace> buffers;
+    buffers.reserve(n);
+    std::vector<long> bufferFirst(n), bufferCount(n,0), next(n);
+    long before = 0;
+    for(long s=0; s<n; s++) {
+        long h = filters[s]->halo();
+        long capacity = std::min(slabs + 2*h + before, last[s]-first[s]+1);
+        buffers.emplace_back(capacity,Y,Z,(short)0,view.voxelLength,view.log);
+        bufferFirst[s] = first[s];
+        next[s] = first[s+1];
+        before += h;
+    }
+
+    std::vector<puma::Matrix<short> > results(n);
+    long loaded = first[0]-1;
+
+    while(next[n-1] <= last[n]) {
+
+        // loads the next chunk of the input into the buffer of the first filter
+        long count = std::min(slabs, last[0]-loaded);
+        puma::MatrixView<short> firstBuffer(&buffers[0].matrix);
+        copySlabs(&input->matrix,loaded+1,&firstBuffer,bufferCount[0],count);
+        bufferCount[0] += count;
+        loaded += count;
+
+        for(long s=0; s<n; s++) {
+            long h = filters[s]->halo();
+            long bufferLast = bufferFirst[s] + bufferCount[s] - 1;
+
+            // the slabs whose window is in the buffer, or all the remaining ones once it holds the last slab
+            long until = bufferLast == last[s] ? last[s+1] : std::min(last[s+1], bufferLast-h);
+            if(until < next[s]) {
+                break;
+            }
+
+            puma::WorkspaceView bufferView(&buffers[s],0,bufferCount[s]-1,0,-1,0,-1);
+            if(!filters[s]->filterSlabs(&bufferView,next[s]-bufferFirst[s],until-bufferFirst[s],&results[s])) {
+                return false;
+            }
+
+            puma::MatrixView<short> result(&results[s]);
+            long produced = until-next[s]+1;
+            if(s < n-1) {
+                if(bufferCount[s+1] + produced > buffers[s+1].X()) {
+                    std::cout << "Error in FilterPipeline: buffer overflow" << std::endl;
+                    return false;
+                }
+                puma::MatrixView<short> nextBuffer(&buffers[s+1].matrix);
+                copySlabs(&result,0,&nextBuffer,bufferCount[s+1],produced);
+                bufferCount[s+1] += produced;
+            }
+            else {
+                copySlabs(&result,0,output,next[s]-x1,produced);
+            }
+            next[s] = until+1;
+
+            // drops the slabs that the remaining slabs of the output do not read
+            long drop = std::min(std::max(0L, next[s]-h-bufferFirst[s]), bufferCount[s]);
+            if(drop > 0) {
+                puma::MatrixView<short> buffer(&buffers[s].matrix);
+                copySlabs(&buffer,drop,&buffer,0,bufferCount[s]-drop);
+                bufferFirst[s] += drop;
+                bufferCount[s] -= drop;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+void FilterPipeline::copySlabs(puma::MatrixView<short> *from, long fromX, puma::MatrixView<short> *to, long toX, long count) {
+
+    if(count <= 0) {
+        return;
+    }
+
+    long Y = from->Y(), Z = from->Z();
+
+    // the slabs are copied in increasing order, so a buffer can be shifted towards its start in place
+    if(from->source() == to->source() && toX < fromX) {
+        for(long i=0; i<count; i++) {
+            for(long j=0; j<Y; j++) {
+                const short *row = &from->at(fromX+i,j,0);
+                std::copy(row, row+Z, &to->at(toX+i,j,0));
+            }
+        }
+        return;
+    }
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<count; i++) {
+        for(long j=0; j<Y; j++) {
+            const short *row = &from->at(fromX+i,j,0);
+            std::copy(row, row+Z, &to->at(toX+i,j,0));
+        }
+    }
+}
+
+
+bool FilterPipeline::logInput() {
+
+    puma::Logger *logger = view.log;
+
+    logger->appendLogSection("Execute Filter Pipeline");
+    logger->appendLogItem("Current Time: ");
+    logger->appendLogItem(logger->getTime());
+    logger->newLine();
+    logger->appendLogLine(" -- Inputs:");
+    logger->appendLogItem("Number of Filters: ");
+    logger->appendLogItem((long)filters.size());
+    logger->newLine();
+    logger->appendLogItem("Chunk (slabs): ");
+    logger->appendLogItem(chunk);
+    logger->newLine();
+
+    logger->writeLog();
+
+    for(Filter *filter : filters) {
+        filter->logInput();
+    }
+
+    return true;
+}
+
+
+bool FilterPipeline::logOutput() {
+
+    puma::Logger *logger = view.log;
+
+    logger->appendLogLine("Successfully Executed Filter Pipeline");
+    logger->appendLogItem("Current Time: ");
+    logger->appendLogItem(logger->getTime());
+    logger->newLine();
+
+    logger->writeLog();
+
+    return true;
+}
+
+
+bool FilterPipeline::errorCheck(std::string *errorMessage) {
+
+    bool returnBool = true;
+    *errorMessage = "";
+
+    if(view.size() == 0) {
+        (*errorMessage).append("Empty Grayscale Workspace\n");
+        returnBool = false;
+    }
+
+    if(filters.empty()) {
+        (*errorMessage).append("No filters in the pipeline\n");
+        returnBool = false;
+    }
+
+    if(chunk < 0) {
+        (*errorMessage).append("Invalid chunk, must be >= 0\n");
+        returnBool = false;
+    }
+
+    for(Filter *filter : filters) {
+        if(filter->halo() < 0) {
+            (*errorMessage).append("A filter of the pipeline cannot be applied slab by slab\n");
+            returnBool = false;
+        }
+
+        std::string filterMessage;
+        if(!filter->errorCheck(&filterMessage)) {
+            (*errorMessage).append(filterMessage);
+            returnBool = false;
+        }
+    }
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    return returnBool;
+}
@@ -0,0 +1,70 @@
+#ifndef FilterPipeline_H
+#define FilterPipeline_H
+
+#include "filter.h"
+#include "workspace.h"
+#include "workspaceview.h"
+
+#include <vector>
+
+
+//! Applies a chain of filters to a workspace in a single pass along x, a few slabs at a time.
+/*!
+ *  Executing the filters one after the other reads and writes the whole domain, and allocates a copy of it, once per
+ *  filter. The pipeline instead loads a chunk of x slabs, passes it through every filter in turn, and writes the slabs
+ *  of the last filter back into the workspace. Every filter keeps a rolling buffer of the slabs of its input that it
+ *  still needs, i.e. the halo() slabs on each side of the ones it has not filtered yet, so the intermediate results
+ *  never exist as whole volumes and the extra memory is a few slabs per filter. The result is exactly the one of the
+ *  filters executed one after the other.
+ *
+ *  Only filters that read a finite number of slabs (Filter::halo() >= 0) can be chained: mean, median and the exact
+ *  bilateral filter, but not the bilateral grid. The filters are not copied, they must outlive the pipeline, and they
+ *  are constructed on the workspace of the pipeline, which their error check and log refer to:
+ *
+ *  MedianFilter3D median(&work,2);
+ *  MeanFilter3D mean(&work,1);
+ *  FilterPipeline pipeline(&work);
+ *  pipeline.add(&median);
+ *  pipeline.add(&mean);
+ *  pipeline.execute();
+ *
+ *  A pipeline is itself a Filter, with the sum of the halos of its filters, so it can be chained in another pipeline.
+ */
+class FilterPipeline : public Filter
+{
+public:
+
+    //! chunk is the number of slabs loaded at a time, 0 for the larger of the number of threads and twice the largest
+    //! halo. numThreads is used to copy the slabs, every filter runs with its own number of threads.
+    explicit FilterPipeline(puma::Workspace *work, long chunk = 0, int numThreads = 0);
+    explicit FilterPipeline(puma::WorkspaceView *view, long chunk = 0, int numThreads = 0);
+
+    //! appends a filter, which is applied to the result of the previous ones
+    void add(Filter *filter);
+
+    bool execute() override;
+
+    long halo() override;
+    bool filterSlabs(puma::WorkspaceView *input, long x1, long x2, puma::Matrix<short> *output) override;
+
+private:
+
+    puma::WorkspaceView view;
+    long chunk;
+    int numThreads;
+    std::vector<Filter*> filters;
+
+    // filters the slabs [x1,x2] of input into the slabs of output, which can be the matrix of input itself
+    bool stream(puma::WorkspaceView *input, long x1, long x2, puma::MatrixView<short> *output);
+
+    // copies count slabs from the slab fromX of from to the slab toX of to
+    void copySlabs(puma::MatrixView<short> *from, long fromX, puma::MatrixView<short> *to, long toX, long count);
+
+    bool logInput() override;
+    bool logOutput() override;
+    bool errorCheck(std::string *errorMessage) override;
+
+};
+
+
+#endif // FilterPipeline_H
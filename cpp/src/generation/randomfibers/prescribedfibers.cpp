@@ -159,6 +159,8 @@ bool Generate_PrescribedFibers::normalizeScale() {
     int sizeY = maxY + 2 * buffer;
     int sizeZ = maxZ + 2 * buffer;
 
+    // the voxels are written directly through matrix, so the coarse levels of the workspace are dropped
+    work->modified();
     work->matrix.resize(sizeX,sizeY,sizeZ);
     work->matrix.set(0);
     if(dirMatrix){
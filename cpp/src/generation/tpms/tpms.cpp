@@ -52,6 +52,8 @@ bool Generate_TPMS::TPMSGenerationHelper() {
     double qMax = input.qMax;
 
     puma::Matrix<double> mat(input.xSize,input.ySize,input.zSize);
+    // the voxels are written directly through matrix, so the coarse levels of the workspace are dropped
+    tpmsWS->modified();
     tpmsWS->matrix.resize(input.xSize,input.ySize,input.zSize);
 
 #pragma omp parallel for
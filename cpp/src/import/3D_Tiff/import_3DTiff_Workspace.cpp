@@ -122,6 +122,8 @@ bool Import_3DTiff_Workspace::importHelper() {
     long localY = yMax - yMin + 1;
     long localZ = zMax - zMin + 1;
 
+    // the voxels are written directly through matrix, so the coarse levels of the workspace are dropped
+    work->modified();
     work->matrix.resize(localX, localY, localZ);
 
         omp_set_num_threads(numThreads);
@@ -5,6 +5,8 @@
 
 bool puma::import_bin(Workspace *work, const std::string& fileName, int numThreads) {
     Import_bin<short> importer(&(work->matrix),fileName,numThreads);
+    // the voxels are written directly through matrix, so the coarse levels of the workspace are dropped
+    work->modified();
     return importer.import();
 }
 
@@ -103,10 +105,10 @@ template<class T> bool Import_bin<T>::importHelper() {
 
             omp_set_num_threads(numThreads);
 #pragma omp parallel for
-            for(int k=0;k<Z;k++) {
+            for(int i=0;i<X;i++) {
                 for(int j=0;j<Y;j++) {
-                    for(int i=0;i<X;i++) {
-                        matrix->at(i,j,k) = tempVec[X*Y*k+X*j+i];
+                    for(int k=0;k<Z;k++) {
+                        matrix->at(i,j,k) = tempVec[(long)X*Y*k+(long)X*j+i];
                     }
                 }
             }
@@ -229,12 +231,13 @@ bool Import_bin_MatrixVec3::importHelper() {
 
             omp_set_num_threads(numThreads);
 #pragma omp parallel for
-            for(int k=0;k<Z;k++) {
+            for(int i=0;i<X;i++) {
                 for(int j=0;j<Y;j++) {
-                    for(int i=0;i<X;i++) {
-                        matrix->at(i,j,k).x = tempVec[X*Y*k+X*j+i];
-                        matrix->at(i,j,k).y = tempVec[startIndex + X*Y*k+X*j+i];
-                        matrix->at(i,j,k).z = tempVec[2*startIndex + X*Y*k+X*j+i];
+                    for(int k=0;k<Z;k++) {
+                        long n = (long)X*Y*k+(long)X*j+i;
+                        matrix->at(i,j,k).x = tempVec[n];
+                        matrix->at(i,j,k).y = tempVec[(long)startIndex + n];
+                        matrix->at(i,j,k).z = tempVec[2*(long)startIndex + n];
                     }
                 }
             }
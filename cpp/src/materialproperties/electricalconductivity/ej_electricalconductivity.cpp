@@ -5,6 +5,13 @@
 
 puma::Vec3<double> puma::compute_EJElectricalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
                                                        char dir, double solverTol, int solverMaxIt, bool print, int numThreads) {
+    return compute_EJElectricalConductivity(grayWS,T,matCond,dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+
+puma::Vec3<double> puma::compute_EJElectricalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                       char dir, double solverTol, int solverMaxIt, bool print,
+                                                       puma::SolverTelemetry *telemetry, int numThreads) {
 
     Workspace segWS(grayWS->getShape(), grayWS->log);
     segWS.setPrinter(grayWS->printer);
@@ -23,6 +30,7 @@ puma::Vec3<double> puma::compute_EJElectricalConductivity(Workspace *grayWS, pum
     }
 
     EJ_ElectricalConductivity cond(&segWS,T,condPairs,dir,solverTol,solverMaxIt,print ,numThreads);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 
 }
@@ -54,6 +62,7 @@ puma::Vec3<double> EJ_ElectricalConductivity::compute() {
     EJ_Diffusion::computeKMatrix(segWS,matCond,&kMatrix,numThreads);
 
     EJ_Diffusion solver(T,&kMatrix,dir,solverTol,solverMaxIt,print, segWS->printer, numThreads);
+    solver.setTelemetry(telemetry);
     ElectricalConductivity = solver.compute_DiffusionCoefficient();
 
     logOutput();
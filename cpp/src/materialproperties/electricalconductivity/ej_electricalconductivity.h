@@ -27,6 +27,16 @@ namespace puma {
  */
     puma::Vec3<double> compute_EJElectricalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
                                                      char dir, double solverTol, int solverMaxIt, bool print, int numThreads = 0);
+
+//! computes Electrical conductivity from a grayscale workspace using the explicit jump method, recording the solver iterations.
+/*!
+ * Same as above, with the residual and the time breakdown of each iteration of the solver recorded in the telemetry.
+ * \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording).
+ * \return a puma vector containing the Electrical conductivity in the x, y, and z directions.
+ */
+    puma::Vec3<double> compute_EJElectricalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                     char dir, double solverTol, int solverMaxIt, bool print,
+                                                     puma::SolverTelemetry *telemetry, int numThreads = 0);
 }
 
 //! A class for computing Electrical conductivity using the explicit jump method.
@@ -59,6 +69,9 @@ public:
      */
     puma::Vec3<double> compute();
 
+    //! sets a recorder for the iterations of the solver used by compute().
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
+
 
 private:
 
@@ -86,6 +99,9 @@ private:
     //! Specifies the number of threads used for the simulation.
     int numThreads;
 
+    //! An optional recorder for the solver iterations (nullptr if unused).
+    puma::SolverTelemetry *telemetry{nullptr};
+
     //! A puma vector which stores the Electrical conductivity in the x, y, and z directions.
     puma::Vec3<double> ElectricalConductivity;
 
@@ -6,6 +6,13 @@
 puma::Vec3<double> puma::compute_FVElectricalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
                                                        std::string sideBC, std::string solverType, char dir, double solverTol,
                                                        int solverMaxIt, bool print, int numThreads) {
+    return compute_FVElectricalConductivity(grayWS,T,matCond,std::move(sideBC),std::move(solverType),dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+
+puma::Vec3<double> puma::compute_FVElectricalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                       std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                       int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads) {
 
     Workspace segWS(grayWS->getShape(), grayWS->log);
     segWS.setPrinter(grayWS->printer);
@@ -24,6 +31,7 @@ puma::Vec3<double> puma::compute_FVElectricalConductivity(Workspace *grayWS, pum
     }
 
     FV_ElectricalConductivity cond(&segWS,T,condPairs,std::move(sideBC),std::move(solverType),dir,solverTol,solverMaxIt, print,numThreads);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 }
 
@@ -58,6 +66,7 @@ puma::Vec3<double> FV_ElectricalConductivity::compute() {
     FV_Diffusion::computeKMatrix(segWS,matCond,&kMatrix, numThreads);
 
     FV_Diffusion solver(T,&kMatrix,sideBC,solverType,dir,solverTol,solverMaxIt,print, segWS->printer, numThreads);
+    solver.setTelemetry(telemetry);
     ElectricalConductivity = solver.compute_DiffusionCoefficient();
 
     logOutput();
@@ -126,7 +135,12 @@ bool FV_ElectricalConductivity::errorCheck(std::string *errorMessage) {
          solverType == "conjugate_gradient" || solverType == "Conjugate_Gradient" ||
          solverType == "Conjugate_gradient" || solverType == "conjugate_Gradient" ||
          solverType == "cg" || solverType == "bicgstab" ||
-         solverType == "BiCGSTAB" || solverType == "Bicgstab")) {
+         solverType == "BiCGSTAB" || solverType == "Bicgstab" ||
+         solverType == "bicgstab_fused" || solverType == "BiCGSTAB_Fused" ||
+         solverType == "bicgstab_mixed" || solverType == "BiCGSTAB_Mixed" ||
+         solverType == "cg_fused" || solverType == "CG_Fused" ||
+         solverType == "multigrid" || solverType == "cg_multigrid" ||
+         solverType == "sor" || solverType == "SOR")) {
         *errorMessage = "Invalid Iterative Solver";
         return false;
     }
@@ -18,7 +18,7 @@ namespace puma {
  * \param T a pointer to a puma matrix to store the resulting temperature field.
  * \param matCond a map containing the ID's for each material and their corresponding Electrical conductivities.
  * \param sideBC a string specifying the boundary conditions on the sides of the domain (should be 'periodic' or 'symmetric').
- * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient' or 'bicgstab').
+ * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient', 'bicgstab', 'cg_fused', 'bicgstab_fused', 'bicgstab_mixed', 'multigrid' or 'sor').
  * \param dir a char specifying which direction to run the simulation in (should be 'x', 'y', or 'z').
  * \param solverTol a double specifying the convergence criterion for the iterative solver used.
  * \param solverMaxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
@@ -30,6 +30,17 @@ namespace puma {
                                                      std::string sideBC, std::string solverType, char dir, double solverTol,
                                                      int solverMaxIt, bool print, int numThreads = 0);
 
+//! computes Electrical conductivity from a grayscale workspace using the finite volume method, recording the solver iterations.
+/*!
+ * Same as above, with the residual and the time breakdown of each iteration of the solver recorded in the telemetry.
+ * The 'bicgstab', 'bicgstab_fused' and 'cg_fused' solverTypes support telemetry.
+ * \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording).
+ * \return a puma vector containing the Electrical conductivity in the x, y, and z directions.
+ */
+    puma::Vec3<double> compute_FVElectricalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                     std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                     int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads = 0);
+
 }
 
 //! A class for computing Electrical conductivity using the finite volume method.
@@ -47,7 +58,7 @@ public:
      * \param T a pointer to a puma matrix to store the resulting temperature field.
      * \param matCond a map containing the ID's for each material and their corresponding Electrical conductivities.
      * \param sideBC a string specifying the boundary conditions on the sides of the domain (should be 'periodic' or 'symmetric').
-     * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient' or 'bicgstab').
+     * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient', 'bicgstab', 'cg_fused', 'bicgstab_fused', 'bicgstab_mixed', 'multigrid' or 'sor').
      * \param dir a char specifying which direction to run the simulation in (should be 'x', 'y', or 'z').
      * \param solverTol a double specifying the convergence criterion for the iterative solver used.
      * \param solverMaxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
@@ -64,6 +75,9 @@ public:
      */
     puma::Vec3<double> compute();
 
+    //! sets a recorder for the iterations of the solver used by compute().
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
+
 
 private:
 
@@ -79,7 +93,7 @@ private:
     //! Specifies the boundary conditions on the sides of the domain (should be 'periodic' or 'symmetric').
     std::string sideBC;
 
-    //! Specifies the iterative solver used in the simulation (should be 'conjugateGradient' or 'bicgstab').
+    //! Specifies the iterative solver used in the simulation (should be 'conjugateGradient', 'bicgstab', 'cg_fused', 'bicgstab_fused', 'bicgstab_mixed', 'multigrid' or 'sor').
     std::string solverType;
 
     //! Specifies the direction in of the applied temperature drop.
@@ -97,6 +111,9 @@ private:
     //! Specifies the number of threads used for the simulation.
     int numThreads;
 
+    //! An optional recorder for the solver iterations (nullptr if unused).
+    puma::SolverTelemetry *telemetry{nullptr};
+
     //! A puma vector which stores the Electrical conductivity in the x, y, and z directions.
     puma::Vec3<double> ElectricalConductivity;
 
@@ -13,6 +13,47 @@ puma::Vec3<double> puma::compute_MeanInterceptLength(puma::Workspace *grayWS, pu
 }
 
 
+puma::Vec3<double> puma::compute_MeanInterceptLength(puma::RLEWorkspace *segWS, puma::Cutoff cutoff, int numThreads) {
+
+    if(cutoff.first < -0.5 || cutoff.second > 32767 || cutoff.first > cutoff.second){  // maximum signed short value 32767
+        std::cout << "Mean Intercept Length Error: Invalid Cutoff Ranges" << std::endl;
+        return puma::Vec3<double>(-1,-1,-1);
+    }
+
+    if(segWS->size() == 0) {
+        std::cout << "Mean Intercept Length Error: Empty Material Matrix" << std::endl;
+        return puma::Vec3<double>(-1,-1,-1);
+    }
+
+    return MeanInterceptLength::fromCounts(segWS->count(cutoff,numThreads),
+                                           segWS->countTransitions('x',cutoff,false,numThreads),
+                                           segWS->countTransitions('y',cutoff,false,numThreads),
+                                           segWS->countTransitions('z',cutoff,false,numThreads),
+                                           segWS->voxelLength);
+}
+
+
+puma::Vec3<double> puma::compute_MeanInterceptLength(puma::WorkspaceView *view, puma::Cutoff cutoff, int numThreads) {
+
+    if(cutoff.first < -0.5 || cutoff.second > 32767 || cutoff.first > cutoff.second){  // maximum signed short value 32767
+        std::cout << "Mean Intercept Length Error: Invalid Cutoff Ranges" << std::endl;
+        return puma::Vec3<double>(-1,-1,-1);
+    }
+
+    if(view->size() == 0) {
+        std::cout << "Mean Intercept Length Error: Empty Material Matrix" << std::endl;
+        return puma::Vec3<double>(-1,-1,-1);
+    }
+
+    puma::BitMask mask(view,cutoff,numThreads);
+    return MeanInterceptLength::fromCounts(mask.count(numThreads),
+                                           mask.countTransitions('x',false,numThreads),
+                                           mask.countTransitions('y',false,numThreads),
+                                           mask.countTransitions('z',false,numThreads),
+                                           view->voxelLength);
+}
+
+
 MeanInterceptLength::MeanInterceptLength(puma::Workspace *segWS, puma::Cutoff cutoff, int numThreads) {
 
     this->segWS = segWS;
@@ -40,11 +81,21 @@ puma::Vec3<double> MeanInterceptLength::compute() {
 
 void MeanInterceptLength::meanInterceptLengthHelper() {
 
-    long totalCollisionsX = getNumCollisionsX();
-    long totalCollisionsY = getNumCollisionsY();
-    long totalCollisionsZ = getNumCollisionsZ();
+    // the void cells and the void to solid collisions are counted on a bit mask of the void
+    puma::BitMask mask(segWS,cutoff,numThreads);
+
+    long totalCollisionsX = mask.countTransitions('x',false,numThreads);
+    long totalCollisionsY = mask.countTransitions('y',false,numThreads);
+    long totalCollisionsZ = mask.countTransitions('z',false,numThreads);
 
-    long numVoidCells = getNumVoidCells();
+    long numVoidCells = mask.count(numThreads);
+
+    meanInterceptLength = fromCounts(numVoidCells, totalCollisionsX, totalCollisionsY, totalCollisionsZ, segWS->voxelLength);
+}
+
+puma::Vec3<double> MeanInterceptLength::fromCounts(long numVoidCells, long totalCollisionsX, long totalCollisionsY, long totalCollisionsZ, double voxelLength) {
+
+    puma::Vec3<double> meanInterceptLength;
 
     //in the case of a fully-dense domain
     if(numVoidCells == 0){
@@ -58,7 +109,7 @@ void MeanInterceptLength::meanInterceptLengthHelper() {
             std::cout << "Mean Intercept Length Warning: Infinite Mean Intercept Length in X Direction" << std::endl;
         }
         else{
-            meanInterceptLength.x = (double)numVoidCells*segWS->voxelLength / (double)totalCollisionsX;
+            meanInterceptLength.x = (double)numVoidCells*voxelLength / (double)totalCollisionsX;
         }
 
         if(totalCollisionsY == 0){
@@ -66,7 +117,7 @@ void MeanInterceptLength::meanInterceptLengthHelper() {
             std::cout << "Mean Intercept Length Warning: Infinite Mean Intercept Length in Y Direction" << std::endl;
         }
         else{
-            meanInterceptLength.y = (double)numVoidCells*segWS->voxelLength / (double)totalCollisionsY;
+            meanInterceptLength.y = (double)numVoidCells*voxelLength / (double)totalCollisionsY;
         }
 
         if(totalCollisionsZ == 0){
@@ -74,126 +125,13 @@ void MeanInterceptLength::meanInterceptLengthHelper() {
             std::cout << "Mean Intercept Length Warning: Infinite Mean Intercept Length in Z Direction" << std::endl;
         }
         else{
-            meanInterceptLength.z = (double)numVoidCells*segWS->voxelLength / (double)totalCollisionsZ;
+            meanInterceptLength.z = (double)numVoidCells*voxelLength / (double)totalCollisionsZ;
         }
     }
-}
 
-long MeanInterceptLength::getNumVoidCells() {
-
-    long x = segWS->X();
-    long y = segWS->Y();
-    long z = segWS->Z();
-
-    // Find Number of Void Cells
-    long numVoidCells = 0;
-    for(long i=0; i<x; i++) {
-        for (long j = 0; j < y; j++) {
-            for (long k = 0; k < z; k++) {
-                if (segWS->matrix(i, j, k) <= cutoff.second && segWS->matrix(i, j, k) >= cutoff.first) {
-                    numVoidCells++;
-                }
-            }
-        }
-    }
-
-    return numVoidCells;
-}
-
-
-long MeanInterceptLength::getNumCollisionsX() {
-
-    long x = segWS->X();
-    long y = segWS->Y();
-    long z = segWS->Z();
-
-    // Number of Intersections in X Direction
-    std::vector<int> numVoidToSolidX(x);
-
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(long i=0; i<x-1; i++) {
-        for (long j=0; j<y; j++) {
-            for (long k=0; k<z; k++) {
-                if(segWS->matrix(i,j,k) <= cutoff.second && segWS->matrix(i,j,k) >= cutoff.first) {
-                    if(!(segWS->matrix(i+1,j,k) <= cutoff.second && segWS->matrix(i+1,j,k) >= cutoff.first)) {
-                        numVoidToSolidX[i]++;
-                    }
-                }
-            }
-        }
-    }
-    long totalCollisionsX = 0;
-    for(long l=0; l<x; l++){
-        totalCollisionsX += numVoidToSolidX[l];
-    }
-
-    return totalCollisionsX;
-}
-
-
-long MeanInterceptLength::getNumCollisionsY() {
-
-    long x = segWS->X();
-    long y = segWS->Y();
-    long z = segWS->Z();
-
-    // Number of Intersections in Y Direction
-    std::vector<int> numVoidToSolidY(y);
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for (long j = 0; j < y - 1; j++) {
-        for(long i=0; i<x; i++) {
-            for (long k = 0; k < z; k++) {
-                if (segWS->matrix(i, j, k) <= cutoff.second && segWS->matrix(i, j, k) >= cutoff.first) {
-                    if (!(segWS->matrix(i, j + 1, k) <= cutoff.second &&
-                          segWS->matrix(i, j + 1, k) >= cutoff.first)) {
-                        numVoidToSolidY[j]++;
-                    }
-                }
-            }
-        }
-    }
-    long totalCollisionsY = 0;
-    for(long l=0; l<y; l++){
-        totalCollisionsY += numVoidToSolidY[l];
-    }
-
-    return totalCollisionsY;
-}
-
-
-long MeanInterceptLength::getNumCollisionsZ() {
-
-    long x = segWS->X();
-    long y = segWS->Y();
-    long z = segWS->Z();
-
-    // Number of Intersections in Z Direction
-    std::vector<int> numVoidToSolidZ(z);
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for (long k = 0; k < z - 1; k++) {
-        for(long i=0; i<x; i++) {
-            for (long j = 0; j < y; j++) {
-                if (segWS->matrix(i, j, k) <= cutoff.second && segWS->matrix(i, j, k) >= cutoff.first) {
-                    if (!(segWS->matrix(i, j, k + 1) <= cutoff.second &&
-                          segWS->matrix(i, j, k + 1) >= cutoff.first)) {
-                        numVoidToSolidZ[k]++;
-                    }
-                }
-            }
-        }
-    }
-    long totalCollisionsZ = 0;
-    for(long l=0; l<z; l++){
-        totalCollisionsZ += numVoidToSolidZ[l];
-    }
-
-    return totalCollisionsZ;
+    return meanInterceptLength;
 }
 
-
 bool MeanInterceptLength::logInput() {
     puma::Logger *logger = segWS->log;
 
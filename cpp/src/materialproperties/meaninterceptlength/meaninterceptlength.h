@@ -3,6 +3,9 @@
 
 #include "materialproperty.h"
 #include "workspace.h"
+#include "rleworkspace.h"
+#include "workspaceview.h"
+#include "bitmask.h"
 #include "vector.h"
 
 
@@ -16,6 +19,22 @@ namespace puma {
      * \return a puma vector containing the mean intercept length in the x, y, and z directions.
      */
     puma::Vec3<double> compute_MeanInterceptLength(puma::Workspace *grayWS, puma::Cutoff cutoff, int numThreads = 0);
+
+    //! computes the mean intercept length on a run-length encoded workspace, directly on the runs.
+    /*!
+     * \param segWS a run-length encoded workspace containing the domain.
+     * \param cutoff the grayscale range (inclusive) which is considered void.
+     * \return a puma vector containing the mean intercept length in the x, y, and z directions.
+     */
+    puma::Vec3<double> compute_MeanInterceptLength(puma::RLEWorkspace *segWS, puma::Cutoff cutoff, int numThreads = 0);
+
+    //! computes the mean intercept length on a box of a workspace, without copying it.
+    /*!
+     * \param view a view of the box of the domain, whose faces are treated as the domain boundaries.
+     * \param cutoff the grayscale range (inclusive) which is considered void.
+     * \return a puma vector containing the mean intercept length in the x, y, and z directions.
+     */
+    puma::Vec3<double> compute_MeanInterceptLength(puma::WorkspaceView *view, puma::Cutoff cutoff, int numThreads = 0);
 }
 
 //! A class for computing mean intercept length
@@ -40,6 +59,9 @@ public:
      */
     puma::Vec3<double> compute();
 
+    //! computes the mean intercept length from the number of void cells and of collisions in each direction.
+    static puma::Vec3<double> fromCounts(long numVoidCells, long collisionsX, long collisionsY, long collisionsZ, double voxelLength);
+
 
 private:
 
@@ -61,37 +83,6 @@ private:
      */
     void meanInterceptLengthHelper();
 
-    //! Gets the number of transitions from void to solid (i.e. collisions) in the x direction.
-    /*!
-     * This only counts interfaces which transition from void to solid when moving in the
-     * positive x direction and not those which transition from void to solid.
-     * \return number of collisions in the x direction.
-     */
-    long getNumCollisionsX();
-
-    //! Gets the number of transitions from void to solid (i.e. collisions) in the y direction.
-    /*!
-     * This only counts interfaces which transition from void to solid when moving in the
-     * positive y direction and not those which transition from void to solid.
-     * \return number of collisions in the y direction.
-     */
-    long getNumCollisionsY();
-
-    //! Gets the number of transitions from void to solid (i.e. collisions) in the z direction.
-    /*!
-     * This only counts interfaces which transition from void to solid when moving in the
-     * positive z direction and not those which transition from void to solid.
-     * \return number of collisions in the z direction.
-     */
-    long getNumCollisionsZ();
-
-    //! Gets the number of void cells.
-    /*!
-     * \return number of void cells.
-     */
-    long getNumVoidCells();
-
-
     //! Logs the inputs into a file.
     /*!
      * \return a boolean indicating the function executed without errors.
@@ -412,15 +412,10 @@ puma::Vec3<double> ArtificialFlux_AMatrix::computeFluxes(puma::Matrix<double> *x
 
     puma::Vec3<double> fluxes(0,0,0);
 
-#ifdef MAC
-    fluxes.x = accumulate(fluxVec_X.begin(), fluxVec_X.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.y = accumulate(fluxVec_Y.begin(), fluxVec_Y.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.z = accumulate(fluxVec_Z.begin(), fluxVec_Z.end(),0.0)/((X)*(Y)*(Z));
-#elif LINUX
-    fluxes.x = __gnu_parallel::accumulate(fluxVec_X.begin(), fluxVec_X.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.y = __gnu_parallel::accumulate(fluxVec_Y.begin(), fluxVec_Y.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.z = __gnu_parallel::accumulate(fluxVec_Z.begin(), fluxVec_Z.end(),0.0)/((X)*(Y)*(Z));
-#endif
+    // summed with puma::Reduction so that the fluxes do not depend on the number of threads
+    fluxes.x = puma::Reduction::sum((long)fluxVec_X.size(), [&fluxVec_X](long n) { return fluxVec_X[n]; }, numThreads)/((X)*(Y)*(Z));
+    fluxes.y = puma::Reduction::sum((long)fluxVec_Y.size(), [&fluxVec_Y](long n) { return fluxVec_Y[n]; }, numThreads)/((X)*(Y)*(Z));
+    fluxes.z = puma::Reduction::sum((long)fluxVec_Z.size(), [&fluxVec_Z](long n) { return fluxVec_Z[n]; }, numThreads)/((X)*(Y)*(Z));
 
     return fluxes;
 }
@@ -4,12 +4,7 @@
 #include "vector.h"
 #include "fv_boundarycondition.h"
 #include "AMatrix.h"
-
-#ifdef MAC
-#include <numeric>
-#elif LINUX
-#include <parallel/numeric>
-#endif
+#include "reduction.h"
 
 
 class ArtificialFlux_AMatrix : public AMatrix
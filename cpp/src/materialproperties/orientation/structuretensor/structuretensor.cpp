@@ -45,23 +45,11 @@ bool StructureTensor::computeGradient(){
     if (print) { std::cout << "Start Computation of Structure Tensors:" << std::endl; }
 
     if (print) { std::cout << "Computing Derivative of Gaussian kernels" << std::endl; }
-    // generate derivative of Gaussian (dog) kernel
-    puma::Matrix<double> dogkerny;
-    kerngen(&dogkerny, 2);
-
-    // Permutation kernels
-    int dim = 2*(int)ceil(3.*dogSigma)+1;
-    puma::Matrix<double> dogkernx(dim,dim,dim), dogkernz(dim,dim,dim);
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(int i=0;i<dim;i++){
-        for(int j=0;j<dim;j++){
-            for(int k=0;k<dim;k++){
-                dogkernx.at(j,i,k) = dogkerny.at(i,j,k); // permute [2,1,3]
-                dogkernz.at(i,k,j) = dogkerny.at(i,j,k); // permute [1,3,2]
-            }
-        }
-    }
+    // the derivative of Gaussian (dog) kernels are the outer products of a 1D derivative along one axis and 1D
+    // Gaussians along the other two, so they are applied as three 1D passes
+    std::vector<double> dogkern, doggauss;
+    kerngen(&dogkern, 2);
+    doggauss = puma::Convolution::gaussian(dogSigma);
 
     // passing workspace to puma matrix
     omp_set_num_threads(numThreads);
@@ -76,13 +64,13 @@ bool StructureTensor::computeGradient(){
 
     // compute gradients (convolve WS with filter (NB double check xx,yy))
     if (print) { std::cout << "1/3 convolution ... " << std::flush; }
-    convn(&img_gpxx_gpxygauss, &dogkernx, &gx_gpyy_gpyzgauss, 's'); // img, x, gx
+    puma::Convolution::separable(&img_gpxx_gpxygauss, dogkern, doggauss, doggauss, &gx_gpyy_gpyzgauss, 's', numThreads); // img, x, gx
     if (print) { std::cout << "Done" << std::endl; }
     if (print) { std::cout << "2/3 convolution ... " << std::flush; }
-    convn(&img_gpxx_gpxygauss, &dogkerny, &gy_gpzz, 's');           // img, y, gy
+    puma::Convolution::separable(&img_gpxx_gpxygauss, doggauss, dogkern, doggauss, &gy_gpzz, 's', numThreads);           // img, y, gy
     if (print) { std::cout << "Done" << std::endl; }
     if (print) { std::cout << "3/3 convolution ... " << std::flush; }
-    convn(&img_gpxx_gpxygauss, &dogkernz, &gz_gpxxgauss, 's');      // img, z, gz
+    puma::Convolution::separable(&img_gpxx_gpxygauss, doggauss, doggauss, dogkern, &gz_gpxxgauss, 's', numThreads);      // img, z, gz
     if (print) { std::cout << "Done" << std::endl; }
 
     // compute gradient products
@@ -103,27 +91,27 @@ bool StructureTensor::computeGradient(){
 
     if (print) { std::cout << "Start Gauss Sigma" << std::endl; }
     // generate gaussian kernel
-    puma::Matrix<double> gausskern;
+    std::vector<double> gausskern;
     kerngen(&gausskern, 1);
 
     // blur the gradient products with a Gaussian filter
     if (print) { std::cout << "1/6 convolution ... " << std::flush; }
-    convn(&img_gpxx_gpxygauss, &gausskern, &gz_gpxxgauss, 's');   // gpxx, gauss, gpxxgauss
+    puma::Convolution::separable(&img_gpxx_gpxygauss, gausskern, gausskern, gausskern, &gz_gpxxgauss, 's', numThreads);   // gpxx, gauss, gpxxgauss
     if (print) { std::cout << "Done" << std::endl; }
     if (print) { std::cout << "2/6 convolution ... " << std::flush; }
-    convn(&gpxy_gpxzgauss, &gausskern, &img_gpxx_gpxygauss, 's'); // gpxy, gauss, gpxygauss
+    puma::Convolution::separable(&gpxy_gpxzgauss, gausskern, gausskern, gausskern, &img_gpxx_gpxygauss, 's', numThreads); // gpxy, gauss, gpxygauss
     if (print) { std::cout << "Done" << std::endl; }
     if (print) { std::cout << "3/6 convolution ... " << std::flush; }
-    convn(&gpxz_gpyygauss, &gausskern, &gpxy_gpxzgauss, 's');     // gpxz, gauss, gpxzgauss
+    puma::Convolution::separable(&gpxz_gpyygauss, gausskern, gausskern, gausskern, &gpxy_gpxzgauss, 's', numThreads);     // gpxz, gauss, gpxzgauss
     if (print) { std::cout << "Done" << std::endl; }
     if (print) { std::cout << "4/6 convolution ... " << std::flush; }
-    convn(&gx_gpyy_gpyzgauss, &gausskern, &gpxz_gpyygauss, 's');  // gpyy, gauss, gpyygauss
+    puma::Convolution::separable(&gx_gpyy_gpyzgauss, gausskern, gausskern, gausskern, &gpxz_gpyygauss, 's', numThreads);  // gpyy, gauss, gpyygauss
     if (print) { std::cout << "Done" << std::endl; }
     if (print) { std::cout << "5/6 convolution ... " << std::flush; }
-    convn(&gpyz_gpzzgauss, &gausskern, &gx_gpyy_gpyzgauss, 's');  // gpyz, gauss, gpyzgauss
+    puma::Convolution::separable(&gpyz_gpzzgauss, gausskern, gausskern, gausskern, &gx_gpyy_gpyzgauss, 's', numThreads);  // gpyz, gauss, gpyzgauss
     if (print) { std::cout << "Done" << std::endl; }
     if (print) { std::cout << "6/6 convolution ... " << std::flush; }
-    convn(&gy_gpzz, &gausskern, &gpyz_gpzzgauss, 's');            // gpzz, gauss, gpzzgauss
+    puma::Convolution::separable(&gy_gpzz, gausskern, gausskern, gausskern, &gpyz_gpzzgauss, 's', numThreads);            // gpzz, gauss, gpzzgauss
     if (print) { std::cout << "Done" << std::endl; }
 
     if (print) { std::cout << "Start Eigen Calculation" << std::endl; }
@@ -167,195 +155,18 @@ bool StructureTensor::computeGradient(){
 
 
 
-// Function to generate either the derivative of Gaussian (2) or Gaussian (1) kernels
-void StructureTensor::kerngen(puma::Matrix<double> *filter, int derivative){
+// Function to generate either the 1D derivative of Gaussian (2) or Gaussian (1) kernels
+void StructureTensor::kerngen(std::vector<double> *filter, int derivative){
 
-    int halfsize;
     if(derivative==2){
-        halfsize = (int)ceil(3.*dogSigma);
-        if (print) { std::cout << "Gaussian derivative with Kernel size: " << (halfsize*2+1) << " voxels (sigma=" << dogSigma <<")" << std::endl; }
+        *filter = puma::Convolution::gaussianDerivative(dogSigma);
+        if (print) { std::cout << "Gaussian derivative with Kernel size: " << filter->size() << " voxels (sigma=" << dogSigma <<")" << std::endl; }
     } else {
-        halfsize = (int)ceil(3.*gausRho);
-        if (print) { std::cout << "Gaussian filter with Kernel size: " << (halfsize*2+1) << " voxels (rho=" << gausRho <<")" << std::endl; }
-    }
-
-    std::vector<double> x;
-    for(int i=0;i<=halfsize*2; i++){
-        x.push_back((double)(i-halfsize));
-    }
-    int dim = x.size();
-    filter->resize(dim,dim,dim);
-
-    if(derivative==2){ // derivative of Gaussian kernels
-        omp_set_num_threads(numThreads);
-#pragma omp parallel for
-        for(int i=0;i<dim;i++){
-            for(int j=0;j<dim;j++){
-                for(int k=0;k<dim;k++){
-                    filter->at(i,j,k) = -x[j] * exp(-pow(x[j],2) / (2*pow(dogSigma,2))) *
-                            exp(-pow(x[i],2) / (2*pow(dogSigma,2))) * exp(-pow(x[k],2) / (2*pow(dogSigma,2)));
-                }
-            }
-        }
-    } else { // Gaussian kernels
-        omp_set_num_threads(numThreads);
-#pragma omp parallel for
-        for(int i=0;i<dim;i++){
-            for(int j=0;j<dim;j++){
-                for(int k=0;k<dim;k++){
-                    filter->at(i,j,k) = exp(-pow(x[j],2) / (2*pow(gausRho,2))) *
-                            exp(-pow(x[i],2) / (2*pow(gausRho,2))) * exp(-pow(x[k],2) / (2*pow(gausRho,2)));
-                }
-            }
-        }
-    }
-    double sum=0;
-    for(int i=0;i<dim;i++){
-        for(int j=0;j<dim;j++){
-            for(int k=0;k<dim;k++){
-                sum +=  std::abs(filter->at(i,j,k));
-            }
-        }
-    }
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(int i=0;i<dim;i++){
-        for(int j=0;j<dim;j++){
-            for(int k=0;k<dim;k++){
-                filter->at(i,j,k) /= sum;
-            }
-        }
-    }
-}
-
-
-// Convolution function
-void StructureTensor::convn(puma::Matrix<double> *img, puma::Matrix<double> *filter, puma::Matrix<double> *img_out, char bc){
-
-    int kern_size = (int)filter->X(), kern_origin = floor((double)kern_size/2);
-    puma::Matrix<double> flipped_kern(kern_size,kern_size,kern_size);
-
-    // flipping kernel
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(int i=0;i<kern_size;i++){
-        for(int j=0;j<kern_size;j++){
-            for(int k=0;k<kern_size;k++){
-                flipped_kern.at(i,j,k) = filter->at(kern_size-i-1,kern_size-j-1,kern_size-k-1);
-            }
-        }
-    }
-
-    if(bc=='c'){ // Cropping kernel at the boundary
-
-        // image for loop
-        omp_set_num_threads(numThreads);
-#pragma omp parallel for
-        for(int i=0;i<X;i++){
-            int i_start, j_start, k_start, i_end, j_end, k_end;
-            double acc;
-            for(int j=0;j<Y;j++){
-                for(int k=0;k<Z;k++){
-
-                    // setting start points for kernel
-                    i_start = 0, j_start = 0, k_start = 0;
-                    if(i<kern_origin){
-                        i_start = kern_origin - i;
-                        if(j<kern_origin){
-                            j_start = kern_origin - j;
-                            if(k<kern_origin){
-                                k_start = kern_origin - k;
-                            }
-                        }
-                        if(k<kern_origin){
-                            k_start = kern_origin - k;
-                        }
-                    } else if(j<kern_origin) {
-                        j_start = kern_origin - j;
-                        if(k<kern_origin){
-                            k_start = kern_origin - k;
-                        }
-                    } else if(k<kern_origin){
-                        k_start = kern_origin - k;
-                    }
-
-                    // setting end points for kernel
-                    i_end = kern_size, j_end = kern_size, k_end = kern_size;
-                    if(i>=(X-kern_origin)){
-                        i_end = X - i + kern_origin;
-                        if(j>=(Y-kern_origin)){
-                            j_end = Y - j + kern_origin;
-                            if(k>=(Z-kern_origin)){
-                                k_end = Z - k + kern_origin;
-                            }
-                        }
-                        if(k>=(Z-kern_origin)){
-                            k_end = Z - k + kern_origin;
-                        }
-                    } else if(j>=(Y-kern_origin)) {
-                        j_end = Y - j + kern_origin;
-                        if(k>=(Z-kern_origin)){
-                            k_end = Z - k + kern_origin;
-                        }
-                    } else if(k>=(Z-kern_origin)){
-                        k_end = Z - k + kern_origin;
-                    }
-
-                    // filter kernel for
-                    acc = 0;
-                    for(int i_kern=i_start;i_kern<i_end;i_kern++){
-                        for(int j_kern=j_start;j_kern<j_end;j_kern++){
-                            for(int k_kern=k_start;k_kern<k_end;k_kern++){
-                                acc += flipped_kern.at(i_kern,j_kern,k_kern)*img->at(i-(kern_origin-i_kern),j-(kern_origin-j_kern),k-(kern_origin-k_kern));
-                            }
-                        }
-                    }
-                    img_out->at(i,j,k) = acc;
-                }
-            }
-        }
-
-    } else if (bc == 's') { // Symmetric boundary conditions (reflect image)
-
-        for(int i=0;i<X;i++){
-
-            omp_set_num_threads(numThreads);
-#pragma omp parallel for
-            for(int j=0;j<Y;j++){
-                int i_start, j_start, k_start, i_end, j_end, k_end;
-                double acc;
-                for(int k=0;k<Z;k++){
-
-                    // setting start and end points for kernel
-                    i_start = 0, j_start = 0, k_start = 0;
-                    i_end = kern_size, j_end = kern_size, k_end = kern_size;
-
-                    // filter kernel for
-                    acc = 0;
-                    for(int i_kern=i_start;i_kern<i_end;i_kern++){
-                        for(int j_kern=j_start;j_kern<j_end;j_kern++){
-                            for(int k_kern=k_start;k_kern<k_end;k_kern++){
-                                acc += flipped_kern.at(i_kern,j_kern,k_kern) *
-                                        img->at(indexAt(i-(kern_origin-i_kern),(int)img->X()), indexAt(j-(kern_origin-j_kern),(int)img->Y()), indexAt(k-(kern_origin-k_kern),(int)img->Z()));
-                            }
-                        }
-                    }
-                    img_out->at(i,j,k) = acc;
-                }
-            }
-        }
+        *filter = puma::Convolution::gaussian(gausRho);
+        if (print) { std::cout << "Gaussian filter with Kernel size: " << filter->size() << " voxels (rho=" << gausRho <<")" << std::endl; }
     }
 }
 
-// Symmetric BC
-long StructureTensor::indexAt(int index, int size) {
-
-    if(index<0) index=abs(index);
-    if(index>=size) index=size-(index-size+1);
-
-    return index;
-}
-
 
 
 bool StructureTensor::logInput() {
@@ -5,6 +5,7 @@
 #include "orientation.h"
 #include "workspace.h"
 #include "vector.h"
+#include "convolution.h"
 
 #include "Eigenvalues"
 
@@ -41,10 +42,7 @@ private:
     int X,Y,Z;
     puma::MatVec3<double> *direction;
 
-    void kerngen(puma::Matrix<double> *filter, int derivative); // derivative: 1 for Gaussian, 2 for derivative
-    void convn(puma::Matrix<double> *img, puma::Matrix<double> *filter, puma::Matrix<double> *img_out, char bc);
-
-    static long indexAt(int index, int size);
+    void kerngen(std::vector<double> *filter, int derivative); // derivative: 1 for Gaussian, 2 for derivative
 
     bool logInput() override;
     bool logOutput() override;
@@ -11,6 +11,37 @@ std::pair<double, double> puma::compute_SurfaceAreaVoxels(Workspace *work, puma:
     return surfArea.compute();
 }
 
+std::pair<double, double> puma::compute_SurfaceAreaVoxels(RLEWorkspace *work, puma::Cutoff cutoff, int numThreads) {
+    if(work->size() == 0) {
+        std::cout << "Surface Area Error: Empty Material Matrix" << std::endl;
+        return std::pair<double,double>{-1,-1};
+    }
+
+    // every face between a voxel inside the cutoff and one outside, as in the dense voxel method
+    long faces = work->countTransitions('x',cutoff,true,numThreads) + work->countTransitions('y',cutoff,true,numThreads)
+               + work->countTransitions('z',cutoff,true,numThreads);
+
+    double sA = (double)faces*work->voxelLength*work->voxelLength;
+    double volume = (double)work->size()*std::pow(work->voxelLength,3);
+    return std::pair<double,double>{sA, sA/volume};
+}
+
+std::pair<double, double> puma::compute_SurfaceAreaVoxels(WorkspaceView *view, puma::Cutoff cutoff, int numThreads) {
+    if(view->size() == 0) {
+        std::cout << "Surface Area Error: Empty Material Matrix" << std::endl;
+        return std::pair<double,double>{-1,-1};
+    }
+
+    // the mask is built from the box only, so the faces of the box are treated as the domain boundaries
+    puma::BitMask mask(view,cutoff,numThreads);
+    long faces = mask.countTransitions('x',true,numThreads) + mask.countTransitions('y',true,numThreads)
+               + mask.countTransitions('z',true,numThreads);
+
+    double sA = (double)faces*view->voxelLength*view->voxelLength;
+    double volume = (double)view->size()*std::pow(view->voxelLength,3);
+    return std::pair<double,double>{sA, sA/volume};
+}
+
 SurfaceArea::SurfaceArea(puma::Workspace *work, puma::Cutoff cutoff, bool interpVerts, int numThreads) {
     this->work = work;
     this->cutoff = cutoff;
@@ -96,21 +127,12 @@ void SurfaceArea::getSurfaceArea_MarchingCubes() {
 
 void SurfaceArea::getSurfaceArea_Voxel() {
 
-    long double sA=0;
-    for(long i=0;i<work->X();i++){
-        for(long j=0;j<work->Y();j++){
-            for(long k=0;k<work->Z();k++){
-                if(work->operator () (i,j,k) >= cutoff.first && work->operator () (i,j,k) <= cutoff.second){
-                    if(i!=0){ if(work->operator () (i-1,j,k) < cutoff.first || work->operator () (i-1,j,k) > cutoff.second){ sA+=work->voxelLength*work->voxelLength;}}
-                    if(j!=0){ if(work->operator () (i,j-1,k) < cutoff.first || work->operator () (i,j-1,k) > cutoff.second){ sA+=work->voxelLength*work->voxelLength;}}
-                    if(k!=0){ if(work->operator () (i,j,k-1) < cutoff.first || work->operator () (i,j,k-1) > cutoff.second){ sA+=work->voxelLength*work->voxelLength;}}
-                    if(i!=work->X()-1){ if(work->operator () (i+1,j,k) < cutoff.first || work->operator () (i+1,j,k) > cutoff.second){ sA+=work->voxelLength*work->voxelLength;}}
-                    if(j!=work->Y()-1){ if(work->operator () (i,j+1,k) < cutoff.first || work->operator () (i,j+1,k) > cutoff.second){ sA+=work->voxelLength*work->voxelLength;}}
-                    if(k!=work->Z()-1){ if(work->operator () (i,j,k+1) < cutoff.first || work->operator () (i,j,k+1) > cutoff.second){ sA+=work->voxelLength*work->voxelLength;}}
-                }
-            }
-        }
-    }
+    // every face between a voxel inside the cutoff and one outside, counted on whole words of the bit mask
+    puma::BitMask mask(work,cutoff,numThreads);
+    long faces = mask.countTransitions('x',true,numThreads) + mask.countTransitions('y',true,numThreads)
+               + mask.countTransitions('z',true,numThreads);
+
+    double sA = (double)faces*work->voxelLength*work->voxelLength;
 
     surfaceArea.first = sA;
     surfaceArea.second = sA/volume;
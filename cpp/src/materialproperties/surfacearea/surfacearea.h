@@ -3,6 +3,8 @@
 
 #include "materialproperty.h"
 #include "workspace.h"
+#include "rleworkspace.h"
+#include "bitmask.h"
 #include "triangle.h"
 #include "isosurface.h"
 
@@ -14,6 +16,8 @@ namespace puma {
 
 std::pair<double, double> compute_SurfaceAreaMarchingCubes(Workspace *grayWS, puma::Cutoff cutoff, bool interpVerts, int numThreads = 0);
 std::pair<double, double> compute_SurfaceAreaVoxels(Workspace *grayWS, puma::Cutoff cutoff, int numThreads = 0);
+std::pair<double, double> compute_SurfaceAreaVoxels(RLEWorkspace *segWS, puma::Cutoff cutoff, int numThreads = 0);
+std::pair<double, double> compute_SurfaceAreaVoxels(WorkspaceView *view, puma::Cutoff cutoff, int numThreads = 0);
 
 }
 
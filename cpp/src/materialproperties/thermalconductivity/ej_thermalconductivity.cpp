@@ -5,6 +5,17 @@
 
 puma::Vec3<double> puma::compute_EJThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
                                                        char dir, double solverTol, int solverMaxIt, bool print, int numThreads) {
+    return compute_EJThermalConductivity(grayWS,T,matCond,dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+puma::Vec3<double> puma::compute_EJThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                       char dir, double solverTol, int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint, int numThreads) {
+    return compute_EJThermalConductivity(grayWS,T,matCond,dir,solverTol,solverMaxIt,print,checkpoint,nullptr,numThreads);
+}
+
+puma::Vec3<double> puma::compute_EJThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                       char dir, double solverTol, int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint,
+                                                       puma::SolverTelemetry *telemetry, int numThreads) {
 
     Workspace segWS(grayWS->getShape(), grayWS->log);
     segWS.setPrinter(grayWS->printer);
@@ -23,6 +34,8 @@ puma::Vec3<double> puma::compute_EJThermalConductivity(Workspace *grayWS, puma::
     }
 
     EJ_ThermalConductivity cond(&segWS,T,condPairs,dir,solverTol,solverMaxIt,print ,numThreads);
+    cond.setCheckpoint(checkpoint);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 
 }
@@ -54,6 +67,8 @@ puma::Vec3<double> EJ_ThermalConductivity::compute() {
     EJ_Diffusion::computeKMatrix(segWS,matCond,&kMatrix,numThreads);
 
     EJ_Diffusion solver(T,&kMatrix,dir,solverTol,solverMaxIt,print, segWS->printer, numThreads);
+    solver.setCheckpoint(checkpoint);
+    solver.setTelemetry(telemetry);
     thermalConductivity = solver.compute_DiffusionCoefficient();
 
     logOutput();
@@ -27,6 +27,27 @@ namespace puma {
  */
 puma::Vec3<double> compute_EJThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
                                                  char dir, double solverTol, int solverMaxIt, bool print, int numThreads = 0);
+
+//! computes thermal conductivity from a grayscale workspace using the explicit jump method, checkpointing the solver.
+/*!
+ * Same as above, with the state of the solver saved as set in the checkpoint. If the checkpoint has resuming enabled
+ * and its file holds the state of the same problem, the solver continues from it.
+ * \param checkpoint a pointer to a SolverCheckpoint (nullptr to disable checkpointing).
+ * \return a puma vector containing the thermal conductivity in the x, y, and z directions.
+ */
+puma::Vec3<double> compute_EJThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                 char dir, double solverTol, int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint, int numThreads = 0);
+
+//! computes thermal conductivity from a grayscale workspace using the explicit jump method, recording the solver iterations.
+/*!
+ * Same as above, with the residual and the time breakdown of each iteration of the solver recorded in the telemetry.
+ * \param checkpoint a pointer to a SolverCheckpoint (nullptr to disable checkpointing).
+ * \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording).
+ * \return a puma vector containing the thermal conductivity in the x, y, and z directions.
+ */
+puma::Vec3<double> compute_EJThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                 char dir, double solverTol, int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint,
+                                                 puma::SolverTelemetry *telemetry, int numThreads = 0);
 }
 
 //! A class for computing thermal conductivity using the explicit jump method.
@@ -59,6 +80,12 @@ public:
      */
     puma::Vec3<double> compute();
 
+    //! sets a checkpoint policy for the solver.
+    void setCheckpoint(puma::SolverCheckpoint *checkpoint) { this->checkpoint = checkpoint; }
+
+    //! sets a recorder for the iterations of the solver.
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
+
 
 private:
 
@@ -86,6 +113,12 @@ private:
     //! Specifies the number of threads used for the simulation.
     int numThreads;
 
+    //! An optional checkpoint policy for the solver (nullptr if unused).
+    puma::SolverCheckpoint *checkpoint{nullptr};
+
+    //! An optional recorder for the solver iterations (nullptr if unused).
+    puma::SolverTelemetry *telemetry{nullptr};
+
     //! A puma vector which stores the thermal conductivity in the x, y, and z directions.
     puma::Vec3<double> thermalConductivity;
 
@@ -5,6 +5,12 @@
 puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const puma::MatCond& matCond,
                                                                   std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
                                                                   int solverMaxIt, bool print, int numThreads) {
+    return compute_FVanisotropicThermalConductivity(grayWS,T,q,matCond,std::move(method),std::move(sideBC),std::move(solverType),dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const puma::MatCond& matCond,
+                                                                  std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                                  int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads) {
     Workspace segWS(grayWS->getShape(), grayWS->log);
     puma::MatCond condPairs;
     int matId = 0;
@@ -40,6 +46,7 @@ puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *gra
     puma::MatVec3<double> direction(1,1,1,puma::Vec3<double>(0.,0.,0.));
     puma::Matrix<double> prescribedBC(1,1,1);
     FV_anisotropic_ThermalConductivity cond(&segWS,T,q,condPairs,&direction,std::move(method),std::move(sideBC),&prescribedBC,std::move(solverType),dir,solverTol,solverMaxIt,print,numThreads);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 }
 
@@ -48,6 +55,12 @@ puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *gra
 puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const puma::MatCond& matCond,
                                                                   std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC, std::string solverType, char dir, double solverTol,
                                                                   int solverMaxIt, bool print, int numThreads) {
+    return compute_FVanisotropicThermalConductivity(grayWS,T,q,matCond,std::move(method),std::move(sideBC),prescribedBC,std::move(solverType),dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const puma::MatCond& matCond,
+                                                                  std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC, std::string solverType, char dir, double solverTol,
+                                                                  int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads) {
     Workspace segWS(grayWS->getShape(), grayWS->log);
     puma::MatCond condPairs;
     int matId = 0;
@@ -82,6 +95,7 @@ puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *gra
 
     puma::MatVec3<double> direction(1,1,1,puma::Vec3<double>(0.,0.,0.));
     FV_anisotropic_ThermalConductivity cond(&segWS,T,q,condPairs,&direction,std::move(method),std::move(sideBC),prescribedBC,std::move(solverType),dir,solverTol,solverMaxIt,print,numThreads);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 }
 
@@ -90,6 +104,12 @@ puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *gra
 puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double>>& matCond,
                                                                   puma::MatVec3<double> *direction, std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
                                                                   int solverMaxIt, bool print, int numThreads) {
+    return compute_FVanisotropicThermalConductivity(grayWS,T,q,matCond,direction,std::move(method),std::move(sideBC),std::move(solverType),dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double>>& matCond,
+                                                                  puma::MatVec3<double> *direction, std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                                  int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads) {
 
     if(!(direction->X() == grayWS->X() && direction->Y() == grayWS->Y() && direction->Z() == grayWS->Z())) {
         std::cout << "Orientation MatVec has wrong size" << std::endl;
@@ -135,6 +155,7 @@ puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *gra
 
     puma::Matrix<double> prescribedBC(1,1,1);
     FV_anisotropic_ThermalConductivity cond(&segWS,T,q,condPairs,direction,std::move(method),std::move(sideBC),&prescribedBC,std::move(solverType),dir,solverTol,solverMaxIt,print,numThreads);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 }
 
@@ -143,6 +164,12 @@ puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *gra
 puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double>>& matCond,
                                                                   puma::MatVec3<double> *direction, std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC,
                                                                   std::string solverType, char dir, double solverTol, int solverMaxIt, bool print, int numThreads) {
+    return compute_FVanisotropicThermalConductivity(grayWS,T,q,matCond,direction,std::move(method),std::move(sideBC),prescribedBC,std::move(solverType),dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double>>& matCond,
+                                                                  puma::MatVec3<double> *direction, std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC,
+                                                                  std::string solverType, char dir, double solverTol, int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads) {
 
     if(!(direction->X() == grayWS->X() && direction->Y() == grayWS->Y() && direction->Z() == grayWS->Z())) {
         std::cout << "Orientation MatVec has wrong size" << std::endl;
@@ -187,6 +214,7 @@ puma::Vec3<double> puma::compute_FVanisotropicThermalConductivity(Workspace *gra
     }
 
     FV_anisotropic_ThermalConductivity cond(&segWS,T,q,condPairs,direction,std::move(method),std::move(sideBC),prescribedBC,std::move(solverType),dir,solverTol,solverMaxIt,print,numThreads);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 }
 
@@ -219,10 +247,11 @@ puma::Vec3<double> FV_anisotropic_ThermalConductivity::compute() {
         return puma::Vec3<double>(-1,-1,-1);
     }
 
-    puma::Matrix<std::vector<double>> kMatrix(segWS->X(),segWS->Y(),segWS->Z(),std::vector<double> (6, 0));
+    FV_anisotropic_TensorField kMatrix;
     FV_anisotropic_Diffusion::computeKMatrix(segWS,matCond, &kMatrix,direction,print,numThreads);
 
     FV_anisotropic_Diffusion solver(T,q,&kMatrix,sideBC,prescribedBC,solverType,dir,segWS->voxelLength,solverTol,solverMaxIt,print,method,numThreads);
+    solver.setTelemetry(telemetry);
     anisotropicthermalConductivity = solver.compute_DiffusionCoefficient();
 
     logOutput();
@@ -329,6 +358,12 @@ bool FV_anisotropic_ThermalConductivity::errorCheck(std::string *errorMessage) {
              solverType == "Bicgstab") {
         solverType = "bicgstab";
     }
+    else if (solverType == "bicgstab_fused" || solverType == "BiCGSTAB_Fused") {
+        solverType = "bicgstab_fused";
+    }
+    else if (solverType == "cg_fused" || solverType == "CG_Fused") {
+        solverType = "cg_fused";
+    }
     else {
         *errorMessage = "Invalid Iterative Solver";
         return false;
@@ -23,7 +23,7 @@ namespace puma {
     \param matCond Local conductivity of the phases
     \param method which discretization method to use ('mpfa', 'empfa')
     \param sideBC what side boundary conditions ('p'eriodic, 's'ymmetric)
-    \param solverType which iterative solver to use ('cg', 'bicgstab')
+    \param solverType which iterative solver to use ('cg', 'bicgstab', 'cg_fused', 'bicgstab_fused')
     \param dir in what direction the conductivity has to be homogenized ('x', 'y', 'z')
     \param solverTol the solver tolerance
     \param solverMaxIt maximum solver iteration
@@ -35,6 +35,13 @@ namespace puma {
                                                                 std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
                                                                 int solverMaxIt, bool print = true, int numThreads = 0);
 
+    /*! Same as above, recording the residual and the time breakdown of each iteration of the solver (GLOBALLY Anisotropic Materials - no direction matrix)
+    \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording), supported by the 'bicgstab', 'cg_fused' and 'bicgstab_fused' solvers
+    */
+    puma::Vec3<double> compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double> >& matCond,
+                                                                std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                                int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads = 0);
+
     /*! Compute the effective thermal conductivity with anisotropic local phases (GLOBALLY Anisotropic Materials - no direction matrix, with prescribedBC)
     \param grayWS input workspace
     \param T Temperature field
@@ -43,7 +50,7 @@ namespace puma {
     \param method which discretization method to use ('mpfa', 'empfa')
     \param sideBC what side boundary conditions ('p'eriodic, 's'ymmetric)
     \param prescribedBC impose custom dirichlet BC impose on the sides. It has to be of size 2 in the simulation direction, e.g. prescribedBC(2, Y, Z, 0) for dirichlet on X sides when dir='x'
-    \param solverType which iterative solver to use ('cg', 'bicgstab')
+    \param solverType which iterative solver to use ('cg', 'bicgstab', 'cg_fused', 'bicgstab_fused')
     \param dir in what direction the conductivity has to be homogenized ('x', 'y', 'z')
     \param solverTol the solver tolerance
     \param solverMaxIt maximum solver iteration
@@ -55,6 +62,13 @@ namespace puma {
                                                                 std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC, std::string solverType, char dir, double solverTol,
                                                                 int solverMaxIt, bool print = true, int numThreads = 0);
 
+    /*! Same as above, recording the residual and the time breakdown of each iteration of the solver (GLOBALLY Anisotropic Materials - no direction matrix, with prescribedBC)
+    \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording), supported by the 'bicgstab', 'cg_fused' and 'bicgstab_fused' solvers
+    */
+    puma::Vec3<double> compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double> >& matCond,
+                                                                std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC, std::string solverType, char dir, double solverTol,
+                                                                int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads = 0);
+
     /*! Compute the effective thermal conductivity with anisotropic local phases (LOCALLY Anisotropic Materials - with direction matrix)
     \param grayWS input workspace
     \param T Temperature field
@@ -63,7 +77,7 @@ namespace puma {
     \param direction the local orientation field throughout the domain
     \param method which discretization method to use ('mpfa', 'empfa')
     \param sideBC what side boundary conditions ('p'eriodic, 's'ymmetric)
-    \param solverType which iterative solver to use ('cg', 'bicgstab')
+    \param solverType which iterative solver to use ('cg', 'bicgstab', 'cg_fused', 'bicgstab_fused')
     \param dir in what direction the conductivity has to be homogenized ('x', 'y', 'z')
     \param solverTol the solver tolerance
     \param solverMaxIt maximum solver iteration
@@ -75,6 +89,13 @@ namespace puma {
                                                                 puma::MatVec3<double> *direction, std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
                                                                 int solverMaxIt, bool print = true, int numThreads = 0);
 
+    /*! Same as above, recording the residual and the time breakdown of each iteration of the solver (LOCALLY Anisotropic Materials - with direction matrix)
+    \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording), supported by the 'bicgstab', 'cg_fused' and 'bicgstab_fused' solvers
+    */
+    puma::Vec3<double> compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double> >& matCond,
+                                                                puma::MatVec3<double> *direction, std::string method, std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                                int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads = 0);
+
     /*! Compute the effective thermal conductivity with anisotropic local phases (GLOBALLY Anisotropic Materials - with direction matrix, with prescribedBC)
     \param grayWS input workspace
     \param T Temperature field
@@ -84,7 +105,7 @@ namespace puma {
     \param method which discretization method to use ('mpfa', 'empfa')
     \param sideBC what side boundary conditions ('p'eriodic, 's'ymmetric)
     \param prescribedBC impose custom dirichlet BC impose on the sides. It has to be of size 2 in the simulation direction, e.g. prescribedBC(2, Y, Z, 0) for dirichlet on X sides when dir='x'
-    \param solverType which iterative solver to use ('cg', 'bicgstab')
+    \param solverType which iterative solver to use ('cg', 'bicgstab', 'cg_fused', 'bicgstab_fused')
     \param dir in what direction the conductivity has to be homogenized ('x', 'y', 'z')
     \param solverTol the solver tolerance
     \param solverMaxIt maximum solver iteration
@@ -95,6 +116,13 @@ namespace puma {
     puma::Vec3<double> compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double>>& matCond,
                                                                 puma::MatVec3<double> *direction, std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC,
                                                                 std::string solverType, char dir, double solverTol, int solverMaxIt, bool print = true, int numThreads = 0);
+
+    /*! Same as above, recording the residual and the time breakdown of each iteration of the solver (GLOBALLY Anisotropic Materials - with direction matrix, with prescribedBC)
+    \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording), supported by the 'bicgstab', 'cg_fused' and 'bicgstab_fused' solvers
+    */
+    puma::Vec3<double> compute_FVanisotropicThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, puma::MatVec3<double> *q, const std::map<int, std::vector<double>>& matCond,
+                                                                puma::MatVec3<double> *direction, std::string method, std::string sideBC, puma::Matrix<double> *prescribedBC,
+                                                                std::string solverType, char dir, double solverTol, int solverMaxIt, bool print, puma::SolverTelemetry *telemetry, int numThreads = 0);
 }
 
 
@@ -107,6 +135,9 @@ public:
                                        int solverMaxIt, bool print, int numThreads);
     puma::Vec3<double> compute();
 
+    //! sets a recorder for the iterations of the solver used by compute().
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
+
 
 private:
     puma::Workspace *segWS;
@@ -123,6 +154,7 @@ private:
     std::string method;
     puma::MatVec3<double> *direction;
     int numThreads;
+    puma::SolverTelemetry *telemetry{nullptr};
 
     puma::Vec3<double> anisotropicthermalConductivity;
 
@@ -6,6 +6,21 @@
 puma::Vec3<double> puma::compute_FVThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
                                                           std::string sideBC, std::string solverType, char dir, double solverTol,
                                                           int solverMaxIt, bool print, int numThreads) {
+    return compute_FVThermalConductivity(grayWS,T,matCond,std::move(sideBC),std::move(solverType),dir,solverTol,solverMaxIt,print,nullptr,numThreads);
+}
+
+
+puma::Vec3<double> puma::compute_FVThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                          std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                          int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint, int numThreads) {
+    return compute_FVThermalConductivity(grayWS,T,matCond,std::move(sideBC),std::move(solverType),dir,solverTol,solverMaxIt,print,checkpoint,nullptr,numThreads);
+}
+
+
+puma::Vec3<double> puma::compute_FVThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                          std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                          int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint,
+                                                          puma::SolverTelemetry *telemetry, int numThreads) {
 
     Workspace segWS(grayWS->getShape(), grayWS->log);
     segWS.setPrinter(grayWS->printer);
@@ -24,10 +39,37 @@ puma::Vec3<double> puma::compute_FVThermalConductivity(Workspace *grayWS, puma::
     }
 
     FV_ThermalConductivity cond(&segWS,T,condPairs,std::move(sideBC),std::move(solverType),dir,solverTol,solverMaxIt, print,numThreads);
+    cond.setCheckpoint(checkpoint);
+    cond.setTelemetry(telemetry);
     return cond.compute();
 }
 
 
+std::vector<puma::Vec3<double>> puma::compute_FVThermalConductivityTensor(Workspace *grayWS, puma::Matrix<double> *Tx, puma::Matrix<double> *Ty, puma::Matrix<double> *Tz,
+                                                                         const std::map<int, double>& matCond, std::string sideBC, std::string solverType,
+                                                                         double solverTol, int solverMaxIt, bool print, bool warmStart, int numThreads) {
+
+    Workspace segWS(grayWS->getShape(), grayWS->log);
+    segWS.setPrinter(grayWS->printer);
+    std::map<int, double> condPairs;
+    int matId = 0;
+    int lowCutOff = 0;
+    for (auto & it : matCond) {
+        if (it.first < -0.5 || it.first > 32767) {
+            segWS.printer->error("Finite Volume Thermal Conductivity Error: Invalid MatCond puma::Cutoff");
+            return std::vector<puma::Vec3<double>>(3, puma::Vec3<double>(-1,-1,-1));
+        }
+        segWS.setMaterialID(grayWS,puma::Cutoff(lowCutOff,it.first),matId);
+        condPairs[matId] = it.second;
+        lowCutOff = it.first+1;
+        matId++;
+    }
+
+    FV_ThermalConductivity cond(&segWS,Tx,condPairs,std::move(sideBC),std::move(solverType),'x',solverTol,solverMaxIt, print,numThreads);
+    return cond.computeTensor(Tx,Ty,Tz,warmStart);
+}
+
+
 FV_ThermalConductivity::FV_ThermalConductivity(puma::Workspace *segWS, puma::Matrix<double> *T, std::map<int, double> matCond,
                                                std::string sideBC, std::string solverType, char dir, double solverTol,
                                                int solverMaxIt, bool print, int numThreads) {
@@ -58,6 +100,8 @@ puma::Vec3<double> FV_ThermalConductivity::compute() {
     FV_Diffusion::computeKMatrix(segWS,matCond,&kMatrix, numThreads);
 
     FV_Diffusion solver(T,&kMatrix,sideBC,solverType,dir,solverTol,solverMaxIt,print, segWS->printer, numThreads);
+    solver.setCheckpoint(checkpoint);
+    solver.setTelemetry(telemetry);
     thermalConductivity = solver.compute_DiffusionCoefficient();
 
     logOutput();
@@ -65,6 +109,30 @@ puma::Vec3<double> FV_ThermalConductivity::compute() {
     return thermalConductivity;
 }
 
+std::vector<puma::Vec3<double>> FV_ThermalConductivity::computeTensor(puma::Matrix<double> *Tx, puma::Matrix<double> *Ty, puma::Matrix<double> *Tz, bool warmStart) {
+
+    logInput();
+    std::string errorMessage;
+    if( !errorCheck(&errorMessage) ) {
+        std::cout << "Thermal Conductivity Error: " <<  errorMessage << std::endl;
+        return std::vector<puma::Vec3<double>>(3, puma::Vec3<double>(-1,-1,-1));
+    }
+
+    puma::Matrix<double> kMatrix(segWS->X(),segWS->Y(),segWS->Z());
+    FV_Diffusion::computeKMatrix(segWS,matCond,&kMatrix, numThreads);
+
+    FV_Diffusion solver(Tx,&kMatrix,sideBC,solverType,'x',solverTol,solverMaxIt,print, segWS->printer, numThreads);
+    solver.setWarmStart(warmStart);
+    std::vector<puma::Vec3<double>> tensor = solver.compute_DiffusionTensor(Tx,Ty,Tz);
+
+    for(auto &row : tensor) {
+        thermalConductivity = row;
+        logOutput();
+    }
+
+    return tensor;
+}
+
 bool FV_ThermalConductivity::logInput() {
     puma::Logger *logger = segWS->log;
 
@@ -126,7 +194,12 @@ bool FV_ThermalConductivity::errorCheck(std::string *errorMessage) {
          solverType == "conjugate_gradient" || solverType == "Conjugate_Gradient" ||
          solverType == "Conjugate_gradient" || solverType == "conjugate_Gradient" ||
          solverType == "cg" || solverType == "bicgstab" ||
-         solverType == "BiCGSTAB" || solverType == "Bicgstab")) {
+         solverType == "BiCGSTAB" || solverType == "Bicgstab" ||
+         solverType == "bicgstab_fused" || solverType == "BiCGSTAB_Fused" ||
+         solverType == "bicgstab_mixed" || solverType == "BiCGSTAB_Mixed" ||
+         solverType == "cg_fused" || solverType == "CG_Fused" ||
+         solverType == "multigrid" || solverType == "cg_multigrid" ||
+         solverType == "sor" || solverType == "SOR")) {
         *errorMessage = "Invalid Iterative Solver";
         return false;
     }
@@ -18,7 +18,7 @@ namespace puma {
  * \param T a pointer to a puma matrix to store the resulting temperature field.
  * \param matCond a map containing the ID's for each material and their corresponding thermal conductivities.
  * \param sideBC a string specifying the boundary conditions on the sides of the domain (should be 'periodic' or 'symmetric').
- * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient' or 'bicgstab').
+ * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient', 'bicgstab', 'cg_fused', 'bicgstab_fused', 'bicgstab_mixed', 'multigrid' or 'sor').
  * \param dir a char specifying which direction to run the simulation in (should be 'x', 'y', or 'z').
  * \param solverTol a double specifying the convergence criterion for the iterative solver used.
  * \param solverMaxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
@@ -30,6 +30,52 @@ puma::Vec3<double> compute_FVThermalConductivity(Workspace *grayWS, puma::Matrix
                                                  std::string sideBC, std::string solverType, char dir, double solverTol,
                                                  int solverMaxIt, bool print, int numThreads = 0);
 
+//! computes thermal conductivity from a grayscale workspace using the finite volume method, checkpointing the solver.
+/*!
+ * Same as above, with the state of the solver saved as set in the checkpoint. If the checkpoint has resuming enabled
+ * and its file holds the state of the same problem, the solver continues from it. Only the 'bicgstab' solverType supports checkpoints.
+ * \param checkpoint a pointer to a SolverCheckpoint (nullptr to disable checkpointing).
+ * \return a puma vector containing the thermal conductivity in the x, y, and z directions.
+ */
+puma::Vec3<double> compute_FVThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                 std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                 int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint, int numThreads = 0);
+
+//! computes thermal conductivity from a grayscale workspace using the finite volume method, recording the solver iterations.
+/*!
+ * Same as above, with the residual and the time breakdown of each iteration of the solver recorded in the telemetry.
+ * The 'bicgstab', 'bicgstab_fused' and 'cg_fused' solverTypes support telemetry.
+ * \param checkpoint a pointer to a SolverCheckpoint (nullptr to disable checkpointing).
+ * \param telemetry a pointer to a SolverTelemetry (nullptr to disable recording).
+ * \return a puma vector containing the thermal conductivity in the x, y, and z directions.
+ */
+puma::Vec3<double> compute_FVThermalConductivity(Workspace *grayWS, puma::Matrix<double> *T, const std::map<int, double>& matCond,
+                                                 std::string sideBC, std::string solverType, char dir, double solverTol,
+                                                 int solverMaxIt, bool print, puma::SolverCheckpoint *checkpoint,
+                                                 puma::SolverTelemetry *telemetry, int numThreads = 0);
+
+//! computes the thermal conductivity for temperature drops in x, y and z from a grayscale workspace using the finite volume method.
+/*!
+ * The three problems share one finite volume operator and are solved together, which is faster than three calls to
+ * compute_FVThermalConductivity.
+ * \param grayWS a grayscale workspace containing the domain.
+ * \param Tx a pointer to a puma matrix to store the temperature field for the drop in x.
+ * \param Ty a pointer to a puma matrix to store the temperature field for the drop in y.
+ * \param Tz a pointer to a puma matrix to store the temperature field for the drop in z.
+ * \param matCond a map containing the ID's for each material and their corresponding thermal conductivities.
+ * \param sideBC a string specifying the boundary conditions on the sides of the domain (should be 'periodic' or 'symmetric').
+ * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient', 'bicgstab', 'cg_fused', 'bicgstab_fused', 'bicgstab_mixed', 'multigrid' or 'sor').
+ * \param solverTol a double specifying the convergence criterion for the iterative solver used.
+ * \param solverMaxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
+ * \param print a boolean which specifies whether the the number of iterations and residual are printed after each iteration of the solver.
+ * \param warmStart a boolean which, if true, uses the temperature fields passed in as initial guesses when they have the size of the domain (e.g. in a sweep over the conductivities).
+ * \param numThreads an integer which specifies the number of threads used for the simulation.
+ * \return a vector of three puma vectors containing the thermal conductivity in the x, y, and z directions, for the drops in x, y and z respectively.
+ */
+std::vector<puma::Vec3<double>> compute_FVThermalConductivityTensor(Workspace *grayWS, puma::Matrix<double> *Tx, puma::Matrix<double> *Ty, puma::Matrix<double> *Tz,
+                                                                   const std::map<int, double>& matCond, std::string sideBC, std::string solverType,
+                                                                   double solverTol, int solverMaxIt, bool print, bool warmStart, int numThreads = 0);
+
 }
 
 //! A class for computing thermal conductivity using the finite volume method.
@@ -47,7 +93,7 @@ public:
      * \param T a pointer to a puma matrix to store the resulting temperature field.
      * \param matCond a map containing the ID's for each material and their corresponding thermal conductivities.
      * \param sideBC a string specifying the boundary conditions on the sides of the domain (should be 'periodic' or 'symmetric').
-     * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient' or 'bicgstab').
+     * \param solverType a string specifying the iterative solver used in the simulation (should be 'conjugateGradient', 'bicgstab', 'cg_fused', 'bicgstab_fused', 'bicgstab_mixed', 'multigrid' or 'sor').
      * \param dir a char specifying which direction to run the simulation in (should be 'x', 'y', or 'z').
      * \param solverTol a double specifying the convergence criterion for the iterative solver used.
      * \param solverMaxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
@@ -64,6 +110,22 @@ public:
      */
     puma::Vec3<double> compute();
 
+    //! computes the thermal conductivity for temperature drops in x, y and z, sharing one operator. The direction and temperature field passed to the constructor are not used.
+    /*!
+     * \param Tx a pointer to a puma matrix to store the temperature field for the drop in x.
+     * \param Ty a pointer to a puma matrix to store the temperature field for the drop in y.
+     * \param Tz a pointer to a puma matrix to store the temperature field for the drop in z.
+     * \param warmStart a boolean which, if true, uses the temperature fields passed in as initial guesses when they have the size of the domain.
+     * \return a vector of three puma vectors containing the thermal conductivity in the x, y, and z directions, for the drops in x, y and z respectively.
+     */
+    std::vector<puma::Vec3<double>> computeTensor(puma::Matrix<double> *Tx, puma::Matrix<double> *Ty, puma::Matrix<double> *Tz, bool warmStart);
+
+    //! sets a checkpoint policy for the solver used by compute().
+    void setCheckpoint(puma::SolverCheckpoint *checkpoint) { this->checkpoint = checkpoint; }
+
+    //! sets a recorder for the iterations of the solver used by compute().
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
+
 
 private:
 
@@ -79,7 +141,7 @@ private:
     //! Specifies the boundary conditions on the sides of the domain (should be 'periodic' or 'symmetric').
     std::string sideBC;
 
-    //! Specifies the iterative solver used in the simulation (should be 'conjugateGradient' or 'bicgstab').
+    //! Specifies the iterative solver used in the simulation (should be 'conjugateGradient', 'bicgstab', 'cg_fused', 'bicgstab_fused', 'bicgstab_mixed', 'multigrid' or 'sor').
     std::string solverType;
 
     //! Specifies the direction in of the applied temperature drop.
@@ -97,6 +159,12 @@ private:
     //! Specifies the number of threads used for the simulation.
     int numThreads;
 
+    //! An optional checkpoint policy for the solver (nullptr if unused).
+    puma::SolverCheckpoint *checkpoint{nullptr};
+
+    //! An optional recorder for the solver iterations (nullptr if unused).
+    puma::SolverTelemetry *telemetry{nullptr};
+
     //! A puma vector which stores the thermal conductivity in the x, y, and z directions.
     puma::Vec3<double> thermalConductivity;
 
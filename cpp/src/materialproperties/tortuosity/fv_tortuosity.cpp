@@ -122,7 +122,12 @@ bool FV_Tortuosity::errorCheck(std::string *errorMessage) {
          solverType.compare("conjugate_gradient") == 0 || solverType.compare("Conjugate_Gradient") == 0 ||
          solverType.compare("Conjugate_gradient") == 0 || solverType.compare("conjugate_Gradient") == 0 ||
          solverType.compare("bicgstab") == 0 || solverType.compare("BiCGSTAB") == 0 ||
-         solverType.compare("Bicgstab") == 0)) {
+         solverType.compare("Bicgstab") == 0 ||
+         solverType.compare("bicgstab_fused") == 0 || solverType.compare("BiCGSTAB_Fused") == 0 ||
+         solverType.compare("bicgstab_mixed") == 0 || solverType.compare("BiCGSTAB_Mixed") == 0 ||
+         solverType.compare("cg_fused") == 0 || solverType.compare("CG_Fused") == 0 ||
+         solverType.compare("multigrid") == 0 || solverType.compare("cg_multigrid") == 0 ||
+         solverType.compare("sor") == 0 || solverType.compare("SOR") == 0)) {
         *errorMessage = "Invalid Iterative Solver";
         return false;
     }
@@ -1,6 +1,27 @@
 #include "mp_volumefraction.h"
 
 
+// the checks of the cutoff shared by the overloads
+static bool validCutoff(puma::Cutoff cutoff, std::string *errorMessage) {
+
+    if(cutoff.first<=-1 || cutoff.second<=-1) {
+        *errorMessage = "puma::Cutoff cannot be negative";
+        return false;
+    }
+
+    if(cutoff.first > cutoff.second) {
+        *errorMessage = "lowpuma::Cutoff > highpuma::Cutoff. lowpuma::Cutoff must be less than highpuma::Cutoff";
+        return false;
+    }
+
+    if(cutoff.second > 32767) {
+        *errorMessage = "highpuma::Cutoff > 32767. Must be <= 32767";
+        return false;
+    }
+
+    return true;
+}
+
 double puma::compute_VolumeFraction(Workspace *work, puma::Cutoff cutoff, int numThreads) {
     MP_VolumeFraction vf(work,cutoff,numThreads);
     return vf.compute();
@@ -11,6 +32,57 @@ double puma::compute_VolumeFraction(Workspace *work, int value, int numThreads)
     return vf.compute();
 }
 
+double puma::compute_VolumeFraction(RLEWorkspace *work, puma::Cutoff cutoff, int numThreads) {
+    if(work->size() == 0) {
+        std::cout << "Volume Fraction Error: Empty Grayscale Matrix" << std::endl;
+        return -1;
+    }
+
+    std::string errorMessage;
+    if(!validCutoff(cutoff, &errorMessage)) {
+        std::cout << "Volume Fraction Error: " <<  errorMessage << std::endl;
+        return -1;
+    }
+
+    return (double)work->count(cutoff,numThreads)/(double)work->size();
+}
+
+double puma::compute_VolumeFraction(WorkspaceView *view, puma::Cutoff cutoff, int numThreads) {
+    if(view->size() == 0) {
+        std::cout << "Volume Fraction Error: Empty Grayscale Matrix" << std::endl;
+        return -1;
+    }
+
+    std::string errorMessage;
+    if(!validCutoff(cutoff, &errorMessage)) {
+        std::cout << "Volume Fraction Error: " <<  errorMessage << std::endl;
+        return -1;
+    }
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    // the box is read in place, one x slab per iteration
+    std::vector<long> slabCount(view->X(),0);
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<view->X(); i++) {
+        for(long j=0; j<view->Y(); j++) {
+            const short *column = &view->matrix(i,j,0);
+            for(long k=0; k<view->Z(); k++) {
+                slabCount[i] += (column[k] >= cutoff.first && column[k] <= cutoff.second);
+            }
+        }
+    }
+
+    long total = 0;
+    for(long i=0; i<view->X(); i++) {
+        total += slabCount[i];
+    }
+    return (double)total/(double)view->size();
+}
+
 MP_VolumeFraction::MP_VolumeFraction(puma::Workspace *work, puma::Cutoff cutoff, int numThreads) {
     this->work = work;
     this-> cutoff = cutoff;
@@ -27,7 +99,10 @@ double MP_VolumeFraction::compute() {
         return -1;
     }
 
+    // a single pass over the data, so the mapped backend can read ahead and drop the pages behind
+    work->matrix.advise('s');
     volumeFraction = MP_VolumeFractionHelper::volumeFraction(&work->matrix,cutoff,numThreads);
+    work->matrix.advise('n');
 
 
     logOutput();
@@ -82,18 +157,7 @@ bool MP_VolumeFraction::errorCheck(std::string *errorMessage) {
         return false;
     }
 
-    if(cutoff.first<=-1 || cutoff.second<=-1) {
-        *errorMessage = "puma::Cutoff cannot be negative";
-        return false;
-    }
-
-    if(cutoff.first > cutoff.second) {
-        *errorMessage = "lowpuma::Cutoff > highpuma::Cutoff. lowpuma::Cutoff must be less than highpuma::Cutoff";
-        return false;
-    }
-
-    if(cutoff.second > 32767) {
-        *errorMessage = "highpuma::Cutoff > 32767. Must be <= 32767";
+    if(!validCutoff(cutoff, errorMessage)) {
         return false;
     }
 
@@ -3,12 +3,16 @@
 
 #include "materialproperty.h"
 #include "workspace.h"
+#include "rleworkspace.h"
+#include "workspaceview.h"
 #include "mp_volumefractionhelper.h"
 
 
 namespace puma{
 double compute_VolumeFraction(Workspace *work, int value, int numThreads = 0);
 double compute_VolumeFraction(Workspace *work, puma::Cutoff cutoff, int numThreads = 0);
+double compute_VolumeFraction(RLEWorkspace *work, puma::Cutoff cutoff, int numThreads = 0);
+double compute_VolumeFraction(WorkspaceView *view, puma::Cutoff cutoff, int numThreads = 0);
 }
 
 class MP_VolumeFraction : MaterialProperty
@@ -13,7 +13,15 @@
 #include "isosurface.h"
 #include "isosurfacehelper.h"
 #include "logger.h"
+#include "numa.h"
+#include "reduction.h"
+#include "convolution.h"
 #include "matrix.h"
+#include "matrixview.h"
+#include "brickedmatrix.h"
+#include "rleworkspace.h"
+#include "workspaceview.h"
+#include "bitmask.h"
 #include "triangle.h"
 #include "vector.h"
 #include "cutoff.h"
@@ -21,6 +29,8 @@
 #include "prng_engine.h"
 #include "timer.h"
 #include "iterativesolvers.h"
+#include "solvercheckpoint.h"
+#include "solvertelemetry.h"
 #include "MarchingCubes.h"
 #include "Printer.h"
 
@@ -52,6 +62,7 @@
 #include "bilateralfilter.h"
 #include "meanfilter3d.h"
 #include "medianfilter3d.h"
+#include "filterpipeline.h"
 
 //generation
 #include "generate.h"
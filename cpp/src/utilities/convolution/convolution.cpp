@@ -0,0 +1,418 @@
+#include "convolution.h"
+
+#include "fftw3.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+bool puma::Convolution::convolve(Matrix<double> *img, Matrix<double> *kernel, Matrix<double> *out, char bc, int numThreads) {
+
+    std::vector<double> kx, ky, kz;
+    if(factor(kernel, &kx, &ky, &kz)) {
+        return separable(img, kx, ky, kz, out, bc, numThreads);
+    }
+    if(kernel->size() >= fftMinKernelSize) {
+        return fft(img, kernel, out, bc, numThreads);
+    }
+    return direct(img, kernel, out, bc, numThreads);
+}
+
+
+bool puma::Convolution::separable(Matrix<double> *img, const std::vector<double> &kx, const std::vector<double> &ky,
+                                  const std::vector<double> &kz, Matrix<double> *out, char bc, int numThreads) {
+
+    if(!checkInput(img, (long)kx.size(), (long)ky.size(), (long)kz.size(), bc)) {
+        return false;
+    }
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    // the x pass reads whole planes of the input, so it cannot run in place
+    Matrix<double> copy;
+    if(out == img) {
+        copy = *img;
+        img = &copy;
+    }
+
+    long X = img->X(), Y = img->Y(), Z = img->Z();
+    out->resize(X,Y,Z);
+
+    // the x pass goes from img to out, then the y and z passes work in place on out, with a plane or row buffer
+    passX(&img->at(0), &out->at(0), X, Y*Z, kx, bc, numThreads);
+    passY(&out->at(0), X, Y, Z, ky, bc, numThreads);
+    passZ(&out->at(0), X*Y, Z, kz, bc, numThreads);
+
+    return true;
+}
+
+
+bool puma::Convolution::fft(Matrix<double> *img, Matrix<double> *kernel, Matrix<double> *out, char bc, int numThreads) {
+
+    if(!checkInput(img, kernel->X(), kernel->Y(), kernel->Z(), bc)) {
+        return false;
+    }
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    long X = img->X(), Y = img->Y(), Z = img->Z();
+    long oX = kernel->X()/2, oY = kernel->Y()/2, oZ = kernel->Z()/2;
+
+    // The image is padded by the kernel half size on every side, with zeros ('c') or its reflection ('s'), so that
+    // the circular convolution computed by the transforms equals the linear one on the voxels of the domain
+    long pX = X + 2*oX, pY = Y + 2*oY, pZ = Z + 2*oZ, pZF = pZ/2 + 1;
+    long N = pX*pY*pZ, NF = pX*pY*pZF;
+
+    double *padded = fftw_alloc_real(N);
+    double *kernelPadded = fftw_alloc_real(N);
+    fftw_complex *imgF = fftw_alloc_complex(NF);
+    fftw_complex *kernelF = fftw_alloc_complex(NF);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<pX; i++) {
+        long si = source(i - oX, X, bc);
+        for(long j=0; j<pY; j++) {
+            long sj = source(j - oY, Y, bc);
+            for(long k=0; k<pZ; k++) {
+                long sk = source(k - oZ, Z, bc);
+                padded[(i*pY + j)*pZ + k] = (si<0 || sj<0 || sk<0) ? 0. : img->at(si,sj,sk);
+                kernelPadded[(i*pY + j)*pZ + k] = 0.;
+            }
+        }
+    }
+
+    // kernel voxel (a,b,c) is the offset (a-oX,b-oY,c-oZ), stored at that offset modulo the padded size
+    for(long a=0; a<kernel->X(); a++) {
+        for(long b=0; b<kernel->Y(); b++) {
+            for(long c=0; c<kernel->Z(); c++) {
+                long i = (a - oX + pX) % pX, j = (b - oY + pY) % pY, k = (c - oZ + pZ) % pZ;
+                kernelPadded[(i*pY + j)*pZ + k] = kernel->at(a,b,c);
+            }
+        }
+    }
+
+    static bool threadsInitialized = false;
+#pragma omp critical(puma_fftw_planner)
+    {
+        if(!threadsInitialized) {
+            fftw_init_threads();
+            threadsInitialized = true;
+        }
+    }
+
+    fftw_plan imgPlan, kernelPlan, backPlan;
+#pragma omp critical(puma_fftw_planner)
+    {
+        fftw_plan_with_nthreads(numThreads);
+        imgPlan = fftw_plan_dft_r2c_3d((int)pX, (int)pY, (int)pZ, padded, imgF, FFTW_ESTIMATE);
+        kernelPlan = fftw_plan_dft_r2c_3d((int)pX, (int)pY, (int)pZ, kernelPadded, kernelF, FFTW_ESTIMATE);
+        backPlan = fftw_plan_dft_c2r_3d((int)pX, (int)pY, (int)pZ, imgF, padded, FFTW_ESTIMATE);
+    }
+
+    fftw_execute(imgPlan);
+    fftw_execute(kernelPlan);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long n=0; n<NF; n++) {
+        double re = imgF[n][0]*kernelF[n][0] - imgF[n][1]*kernelF[n][1];
+        double im = imgF[n][0]*kernelF[n][1] + imgF[n][1]*kernelF[n][0];
+        imgF[n][0] = re;
+        imgF[n][1] = im;
+    }
+
+    fftw_execute(backPlan);
+
+    out->resize(X,Y,Z);
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<X; i++) {
+        for(long j=0; j<Y; j++) {
+            for(long k=0; k<Z; k++) {
+                out->at(i,j,k) = padded[((i+oX)*pY + j+oY)*pZ + k+oZ]/N;
+            }
+        }
+    }
+
+#pragma omp critical(puma_fftw_planner)
+    {
+        fftw_destroy_plan(imgPlan);
+        fftw_destroy_plan(kernelPlan);
+        fftw_destroy_plan(backPlan);
+    }
+    fftw_free(padded);
+    fftw_free(kernelPadded);
+    fftw_free(imgF);
+    fftw_free(kernelF);
+
+    return true;
+}
+
+
+bool puma::Convolution::direct(Matrix<double> *img, Matrix<double> *kernel, Matrix<double> *out, char bc, int numThreads) {
+
+    if(!checkInput(img, kernel->X(), kernel->Y(), kernel->Z(), bc)) {
+        return false;
+    }
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    Matrix<double> copy;
+    if(out == img) {
+        copy = *img;
+        img = &copy;
+    }
+
+    long X = img->X(), Y = img->Y(), Z = img->Z();
+    long kX = kernel->X(), kY = kernel->Y(), kZ = kernel->Z();
+    long oX = kX/2, oY = kY/2, oZ = kZ/2;
+
+    // voxel read along each axis for every output index and kernel index
+    std::vector<long> sX(X*kX), sY(Y*kY), sZ(Z*kZ);
+    for(long i=0; i<X; i++) { for(long a=0; a<kX; a++) { sX[i*kX + a] = source(i + oX - a, X, bc); } }
+    for(long j=0; j<Y; j++) { for(long b=0; b<kY; b++) { sY[j*kY + b] = source(j + oY - b, Y, bc); } }
+    for(long k=0; k<Z; k++) { for(long c=0; c<kZ; c++) { sZ[k*kZ + c] = source(k + oZ - c, Z, bc); } }
+
+    out->resize(X,Y,Z);
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<X; i++) {
+        for(long j=0; j<Y; j++) {
+            for(long k=0; k<Z; k++) {
+                double acc = 0;
+                for(long a=0; a<kX; a++) {
+                    long si = sX[i*kX + a];
+                    if(si < 0) { continue; }
+                    for(long b=0; b<kY; b++) {
+                        long sj = sY[j*kY + b];
+                        if(sj < 0) { continue; }
+                        for(long c=0; c<kZ; c++) {
+                            long sk = sZ[k*kZ + c];
+                            if(sk < 0) { continue; }
+                            acc += kernel->at(a,b,c) * img->at(si,sj,sk);
+                        }
+                    }
+                }
+                out->at(i,j,k) = acc;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool puma::Convolution::factor(Matrix<double> *kernel, std::vector<double> *kx, std::vector<double> *ky, std::vector<double> *kz,
+                               double tolerance) {
+
+    long kX = kernel->X(), kY = kernel->Y(), kZ = kernel->Z();
+    if(kernel->size() == 0) {
+        return false;
+    }
+
+    // the line through the largest entry along each axis gives the factors, scaled so that their product is the entry
+    long i0 = 0, j0 = 0, k0 = 0;
+    double largest = 0;
+    for(long a=0; a<kX; a++) {
+        for(long b=0; b<kY; b++) {
+            for(long c=0; c<kZ; c++) {
+                if(std::abs(kernel->at(a,b,c)) > largest) {
+                    largest = std::abs(kernel->at(a,b,c));
+                    i0 = a; j0 = b; k0 = c;
+                }
+            }
+        }
+    }
+    if(largest == 0) {
+        return false;
+    }
+
+    double pivot = kernel->at(i0,j0,k0);
+    kx->resize(kX);
+    ky->resize(kY);
+    kz->resize(kZ);
+    for(long a=0; a<kX; a++) { (*kx)[a] = kernel->at(a,j0,k0); }
+    for(long b=0; b<kY; b++) { (*ky)[b] = kernel->at(i0,b,k0)/pivot; }
+    for(long c=0; c<kZ; c++) { (*kz)[c] = kernel->at(i0,j0,c)/pivot; }
+
+    for(long a=0; a<kX; a++) {
+        for(long b=0; b<kY; b++) {
+            for(long c=0; c<kZ; c++) {
+                if(std::abs(kernel->at(a,b,c) - (*kx)[a]*(*ky)[b]*(*kz)[c]) > tolerance*largest) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+std::vector<double> puma::Convolution::gaussian(double sigma) {
+
+    int halfSize = (int)ceil(3.*sigma);
+    std::vector<double> kernel(2*halfSize+1);
+
+    double sum = 0;
+    for(int i=0; i<(int)kernel.size(); i++) {
+        double x = (double)(i-halfSize);
+        kernel[i] = exp(-pow(x,2) / (2*pow(sigma,2)));
+        sum += kernel[i];
+    }
+    for(double &value : kernel) {
+        value /= sum;
+    }
+    return kernel;
+}
+
+
+std::vector<double> puma::Convolution::gaussianDerivative(double sigma) {
+
+    int halfSize = (int)ceil(3.*sigma);
+    std::vector<double> kernel(2*halfSize+1);
+
+    double sum = 0;
+    for(int i=0; i<(int)kernel.size(); i++) {
+        double x = (double)(i-halfSize);
+        kernel[i] = -x * exp(-pow(x,2) / (2*pow(sigma,2)));
+        sum += std::abs(kernel[i]);
+    }
+    for(double &value : kernel) {
+        value /= sum;
+    }
+    return kernel;
+}
+
+
+bool puma::Convolution::checkInput(Matrix<double> *img, long kX, long kY, long kZ, char bc) {
+
+    if(bc != 'c' && bc != 's') {
+        std::cout << "Error in Convolution: boundary condition must be 'c' (cropped kernel) or 's' (symmetric)" << std::endl;
+        return false;
+    }
+    if(kX%2 == 0 || kY%2 == 0 || kZ%2 == 0) {
+        std::cout << "Error in Convolution: kernel sizes must be odd" << std::endl;
+        return false;
+    }
+    if(img->size() == 0) {
+        std::cout << "Error in Convolution: empty image" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+long puma::Convolution::source(long index, long size, char bc) {
+
+    if(index >= 0 && index < size) {
+        return index;
+    }
+    if(bc == 'c') {
+        return -1;
+    }
+
+    if(index < 0) { index = -index; }
+    if(index >= size) { index = size - (index - size + 1); }
+
+    // only reached by kernels longer than the image
+    return std::min(std::max(index, 0L), size-1);
+}
+
+
+void puma::Convolution::passX(const double *in, double *out, long X, long YZ, const std::vector<double> &k, char bc, int numThreads) {
+
+    long size = (long)k.size(), origin = size/2;
+
+    // the planes are cut in blocks that stay in cache while the kernel is applied
+    const long block = 2048;
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<X; i++) {
+        for(long begin=0; begin<YZ; begin+=block) {
+            long end = std::min(YZ, begin + block);
+            double *row = out + i*YZ;
+            for(long n=begin; n<end; n++) {
+                row[n] = 0;
+            }
+            for(long a=0; a<size; a++) {
+                long s = source(i + origin - a, X, bc);
+                if(s < 0) { continue; }
+                const double *src = in + s*YZ;
+                double w = k[a];
+                for(long n=begin; n<end; n++) {
+                    row[n] += w * src[n];
+                }
+            }
+        }
+    }
+}
+
+
+void puma::Convolution::passY(double *values, long X, long Y, long Z, const std::vector<double> &k, char bc, int numThreads) {
+
+    long size = (long)k.size(), origin = size/2;
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel
+    {
+        std::vector<double> plane(Y*Z);
+
+#pragma omp for
+        for(long i=0; i<X; i++) {
+            double *slab = values + i*Y*Z;
+            std::copy(slab, slab + Y*Z, plane.begin());
+            for(long j=0; j<Y; j++) {
+                double *row = slab + j*Z;
+                for(long n=0; n<Z; n++) {
+                    row[n] = 0;
+                }
+                for(long a=0; a<size; a++) {
+                    long s = source(j + origin - a, Y, bc);
+                    if(s < 0) { continue; }
+                    const double *src = &plane[s*Z];
+                    double w = k[a];
+                    for(long n=0; n<Z; n++) {
+                        row[n] += w * src[n];
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+void puma::Convolution::passZ(double *values, long XY, long Z, const std::vector<double> &k, char bc, int numThreads) {
+
+    long size = (long)k.size(), origin = size/2;
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel
+    {
+        // the row with origin voxels of padding on both sides, so that the inner loop has no boundary test
+        std::vector<double> padded(Z + 2*origin);
+
+#pragma omp for
+        for(long r=0; r<XY; r++) {
+            double *row = values + r*Z;
+            for(long q=0; q<Z + 2*origin; q++) {
+                long s = source(q - origin, Z, bc);
+                padded[q] = s < 0 ? 0. : row[s];
+            }
+            for(long n=0; n<Z; n++) {
+                row[n] = 0;
+            }
+            for(long a=0; a<size; a++) {
+                const double *src = &padded[2*origin - a];
+                double w = k[a];
+                for(long n=0; n<Z; n++) {
+                    row[n] += w * src[n];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef PUMA_Convolution_H
+#define PUMA_Convolution_H
+
+#include "matrix.h"
+
+#include <vector>
+
+
+namespace puma {
+
+    //! 3D convolution of a Matrix<double> with a kernel of odd sizes, centred on its middle voxel.
+    /*!
+     *  out(i,j,k) = sum over (a,b,c) of kernel(a,b,c) * img(i+ox-a, j+oy-b, k+oz-c), with (ox,oy,oz) the kernel centre.
+     *  Two boundary conditions are supported:
+     *  'c' crops the kernel at the faces, i.e. the image is zero outside of the domain,
+     *  's' reflects the image at the faces (index -n reads n, and index X-1+n reads X-n).
+     *  There are three ways of computing it, which give the same result up to round-off:
+     *  separable: three 1D passes, (kx+ky+kz) operations per voxel, for kernels that are an outer product of 1D
+     *  kernels (e.g. Gaussians and derivatives of Gaussians),
+     *  fft: FFTW transforms of the image padded by the kernel half size, an almost constant cost per voxel whatever the
+     *  kernel size,
+     *  direct: kx*ky*kz operations per voxel, the cheapest for small kernels that do not factor.
+     *  convolve() picks one of them.
+     */
+    class Convolution
+    {
+    public:
+
+        //! kernels with at least this many voxels that do not factor are convolved through FFTW. The direct sum costs
+        //! about 5 ns per kernel voxel and per image voxel on one core, the three transforms of fft() a few hundred ns
+        //! per image voxel at most, so the FFT is already faster for 5x5x5 kernels
+        static const long fftMinKernelSize = 5*5*5;
+
+        //! convolves with the kernel, through separable() if it factors, otherwise through fft() or direct()
+        //! depending on its size. numThreads <= 0 uses all the processors
+        static bool convolve(Matrix<double> *img, Matrix<double> *kernel, Matrix<double> *out, char bc, int numThreads = 0);
+
+        //! convolves with the outer product of three 1D kernels of odd lengths, kx along x, ky along y, kz along z.
+        //! out can be img
+        static bool separable(Matrix<double> *img, const std::vector<double> &kx, const std::vector<double> &ky,
+                              const std::vector<double> &kz, Matrix<double> *out, char bc, int numThreads = 0);
+
+        static bool fft(Matrix<double> *img, Matrix<double> *kernel, Matrix<double> *out, char bc, int numThreads = 0);
+
+        static bool direct(Matrix<double> *img, Matrix<double> *kernel, Matrix<double> *out, char bc, int numThreads = 0);
+
+        //! writes the 1D factors of the kernel if it is an outer product (to a relative tolerance), returns false otherwise
+        static bool factor(Matrix<double> *kernel, std::vector<double> *kx, std::vector<double> *ky, std::vector<double> *kz,
+                           double tolerance = 1e-12);
+
+        //! Gaussian of standard deviation sigma on 2*ceil(3*sigma)+1 voxels, with unit sum
+        static std::vector<double> gaussian(double sigma);
+
+        //! derivative of Gaussian -x*exp(-x^2/(2*sigma^2)) on 2*ceil(3*sigma)+1 voxels, with unit sum of absolute values
+        static std::vector<double> gaussianDerivative(double sigma);
+
+    private:
+
+        static bool checkInput(Matrix<double> *img, long kX, long kY, long kZ, char bc);
+
+        // the voxel read at index (possibly outside of [0,size)) along one axis, -1 for the zeros of 'c'
+        static long source(long index, long size, char bc);
+
+        static void passX(const double *in, double *out, long X, long YZ, const std::vector<double> &k, char bc, int numThreads);
+        static void passY(double *values, long X, long Y, long Z, const std::vector<double> &k, char bc, int numThreads);
+        static void passZ(double *values, long XY, long Z, const std::vector<double> &k, char bc, int numThreads);
+    };
+
+}
+
+#endif // PUMA_Convolution_H
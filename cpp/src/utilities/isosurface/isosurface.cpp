@@ -166,7 +166,7 @@ bool IsoSurface::manipulateSegmentedMatrix(puma::Matrix<short> *newMatrix) {
     }
     if(interpolateVerts) {
         puma::Matrix<short> tempMatrix;
-        tempMatrix.copy(newMatrix);
+        tempMatrix.swap(*newMatrix);
         return IsoSurfaceHelper::InterpolateVertsSegmented(&tempMatrix, newMatrix, numThreads);
     }
     return true;
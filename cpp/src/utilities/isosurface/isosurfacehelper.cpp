@@ -411,7 +411,7 @@ bool IsoSurfaceHelper::DownScale(puma::Matrix<float> *newMatrix, int factor, int
         }
     }
 
-    newMatrix->copy(&scaledMatrix);
+    newMatrix->swap(scaledMatrix);
 
     return true;
 }
@@ -446,7 +446,7 @@ bool IsoSurfaceHelper::DownScale(puma::Matrix<short> *newMatrix, int factor, int
         }
     }
 
-    newMatrix->copy(&scaledMatrix);
+    newMatrix->swap(scaledMatrix);
 
     return true;
 }
@@ -0,0 +1,199 @@
+#include "bitmask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <omp.h>
+
+
+puma::BitMask::BitMask(puma::Workspace *work, puma::Cutoff cutoff, int numThreads) {
+    build(&work->matrix, cutoff, numThreads);
+}
+
+puma::BitMask::BitMask(puma::Matrix<short> *matrix, puma::Cutoff cutoff, int numThreads) {
+    build(matrix, cutoff, numThreads);
+}
+
+puma::BitMask::BitMask(puma::WorkspaceView *view, puma::Cutoff cutoff, int numThreads) {
+    build(&view->matrix, cutoff, numThreads);
+}
+
+bool puma::BitMask::build(puma::Matrix<short> *matrix, puma::Cutoff cutoff, int numThreads) {
+    return buildFrom(matrix, cutoff, numThreads);
+}
+
+bool puma::BitMask::build(puma::MatrixView<short> *view, puma::Cutoff cutoff, int numThreads) {
+    return buildFrom(view, cutoff, numThreads);
+}
+
+template<class M>
+bool puma::BitMask::buildFrom(M *matrix, puma::Cutoff cutoff, int numThreads) {
+
+    x = matrix->X();
+    y = matrix->Y();
+    z = matrix->Z();
+    words = (z + 63) >> 6;
+    bits.assign(x*y*words, 0);
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    // the cutoff is turned into integer bounds, so that the test is a single unsigned compare
+    int low = (int)std::ceil(cutoff.first);
+    int high = (int)std::floor(cutoff.second);
+    if(low > high) {
+        return true;
+    }
+
+    long columns = x*y;
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long c=0; c<columns; c++) {
+        const short *values = &matrix->at(c/y, c%y, 0);
+        for(long w=0; w<words; w++) {
+            long kEnd = std::min(z - 64*w, 64L);
+            const short *v = values + 64*w;
+
+            // one byte per voxel first, which vectorizes, then each 8 bytes are packed into 8 bits by a multiply
+            uint8_t flags[64] = {0};
+            for(long b=0; b<kEnd; b++) {
+                flags[b] = (uint8_t)((unsigned)(v[b] - low) <= (unsigned)(high - low));
+            }
+
+            uint64_t word = 0;
+            for(int g=0; g<8; g++) {
+                uint64_t bytes;
+                std::memcpy(&bytes, flags + 8*g, 8);
+                word |= ((bytes * 0x0102040810204080ULL) >> 56) << (8*g);
+            }
+            bits[c*words+w] = word;
+        }
+    }
+
+    return true;
+}
+
+long puma::BitMask::count(int numThreads) const {
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    std::vector<long> slabCount(x,0);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<x; i++) {
+        for(long n=i*y*words; n<(i+1)*y*words; n++) {
+            slabCount[i] += __builtin_popcountll(bits[n]);
+        }
+    }
+
+    long total = 0;
+    for(long i=0; i<x; i++) {
+        total += slabCount[i];
+    }
+    return total;
+}
+
+long puma::BitMask::countTransitions(char axis, bool bothWays, int numThreads) const {
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    std::vector<long> slabCount(x,0);
+
+    // the unused bits of the last word are zero in every column, so they never make a transition in x or y.
+    // Along z, the pair (z-1,z) is cut off by lastValid.
+    uint64_t lastValid = (z <= 1 || (z-1) % 64 == 0) ? 0 : (~0ULL >> (64 - (z-1) % 64));
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<x; i++) {
+        for(long j=0; j<y; j++) {
+            const uint64_t *a = &bits[(i*y+j)*words];
+
+            if(axis == 'x' || axis == 'y') {
+                if((axis == 'x' && i == x-1) || (axis == 'y' && j == y-1)) {
+                    continue;
+                }
+                const uint64_t *b = (axis == 'x') ? a + y*words : a + words;
+                for(long w=0; w<words; w++) {
+                    uint64_t t = bothWays ? (a[w] ^ b[w]) : (a[w] & ~b[w]);
+                    slabCount[i] += __builtin_popcountll(t);
+                }
+            } else {
+                for(long w=0; w<words; w++) {
+                    // bit b of next is the voxel k+1
+                    uint64_t next = (a[w] >> 1) | ((w+1 < words) ? (a[w+1] << 63) : 0);
+                    uint64_t t = bothWays ? (a[w] ^ next) : (a[w] & ~next);
+                    if(w == words-1) {
+                        t &= lastValid;
+                    }
+                    slabCount[i] += __builtin_popcountll(t);
+                }
+            }
+        }
+    }
+
+    long total = 0;
+    for(long i=0; i<x; i++) {
+        total += slabCount[i];
+    }
+    return total;
+}
+
+long puma::BitMask::nextBit(long c, long from, bool value) const {
+
+    const uint64_t *column = &bits[c*words];
+    long w = from >> 6;
+    if(w >= words) {
+        return z;
+    }
+
+    uint64_t word = value ? column[w] : ~column[w];
+    word &= ~0ULL << (from & 63);
+    while(word == 0) {
+        w++;
+        if(w >= words) {
+            return z;
+        }
+        word = value ? column[w] : ~column[w];
+    }
+
+    long k = 64*w + __builtin_ctzll(word);
+    return (k < z) ? k : z;
+}
+
+bool puma::BitMask::chordLengthsZ(std::vector<long> *histogram, int numThreads) const {
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    std::vector<std::vector<long>> slabHistogram(x, std::vector<long>(z+1,0));
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<x; i++) {
+        for(long c=i*y; c<(i+1)*y; c++) {
+            long k = nextBit(c, 0, true);
+            while(k < z) {
+                long end = nextBit(c, k, false);
+                slabHistogram[i][end-k]++;
+                k = nextBit(c, end, true);
+            }
+        }
+    }
+
+    histogram->assign(z+1,0);
+    for(long i=0; i<x; i++) {
+        for(long n=0; n<=z; n++) {
+            (*histogram)[n] += slabHistogram[i][n];
+        }
+    }
+
+    return true;
+}
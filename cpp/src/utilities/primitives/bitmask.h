@@ -0,0 +1,78 @@
+#ifndef PUMA_BitMask_H
+#define PUMA_BitMask_H
+
+#include "workspace.h"
+#include "workspaceview.h"
+#include "cutoff.h"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace puma {
+
+    //! A 3D binary mask with one bit per voxel, marking the voxels whose value is inside a cutoff.
+    /*!
+     *  Every (i,j) column is packed along z into 64 bit words, bit b of word w being the voxel k = 64*w+b. The
+     *  unused bits of the last word of a column are always zero. Counting is done with popcount, neighbour tests
+     *  with bitwise operations on whole words, and runs along z are scanned with count trailing zeros.
+     *  \sa Workspace
+     */
+    class BitMask
+    {
+    public:
+
+        BitMask() = default;
+        BitMask(Workspace *work, puma::Cutoff cutoff, int numThreads = 0);
+        BitMask(Matrix<short> *matrix, puma::Cutoff cutoff, int numThreads = 0);
+        BitMask(WorkspaceView *view, puma::Cutoff cutoff, int numThreads = 0);
+
+        //! sets the mask from the voxels of a matrix inside the cutoff, resizing it to the matrix.
+        bool build(Matrix<short> *matrix, puma::Cutoff cutoff, int numThreads = 0);
+        bool build(MatrixView<short> *view, puma::Cutoff cutoff, int numThreads = 0);
+
+        long X() const { return x; }
+        long Y() const { return y; }
+        long Z() const { return z; }
+        long size() const { return x*y*z; }
+
+        bool at(long i, long j, long k) const {
+            return (bits[(i*y+j)*words + (k >> 6)] >> (k & 63)) & 1;
+        }
+
+        //! number of voxels in the mask.
+        long count(int numThreads = 0) const;
+
+        //! number of pairs of neighbouring voxels along an axis ('x', 'y' or 'z') where the first voxel is in the
+        //! mask and the second (with the larger index) is not. If bothWays, the reverse pairs are added.
+        long countTransitions(char axis, bool bothWays, int numThreads = 0) const;
+
+        //! histogram of the lengths of the runs of voxels in the mask along z, where (*histogram)[n] is the
+        //! number of runs of n voxels. Runs touching the domain boundaries are included.
+        bool chordLengthsZ(std::vector<long> *histogram, int numThreads = 0) const;
+
+        //! returns the memory used by the mask, in bytes.
+        double memoryBytes() const { return (double)bits.size()*sizeof(uint64_t); }
+
+    private:
+
+        long x{0};
+        long y{0};
+        long z{0};
+
+        // words per column
+        long words{0};
+
+        std::vector<uint64_t> bits;
+
+        // packs the columns of a Matrix or a MatrixView, which both store a column contiguously along k
+        template<class M>
+        bool buildFrom(M *matrix, puma::Cutoff cutoff, int numThreads);
+
+        // first k >= from whose bit equals value in column c, or z if there is none
+        long nextBit(long c, long from, bool value) const;
+    };
+
+}
+
+#endif // PUMA_BitMask_H
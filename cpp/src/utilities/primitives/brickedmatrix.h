@@ -0,0 +1,182 @@
+#ifndef PUMA_BrickedMatrix_H
+#define PUMA_BrickedMatrix_H
+
+#include "matrix.h"
+
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+
+/* Bricked voxel layout for PuMA.
+    The domain is split into 8x8x8 bricks that are contiguous in memory, and the bricks are stored in Morton
+    (z-order) order, so that voxels that are close in any direction are also close in memory. This is meant
+    for stencil kernels: the x neighbour of a voxel is 64 elements away inside a brick, instead of zy in a Matrix.
+    Bricks on the upper faces of the domain are padded. Conversion to and from the linear puma::Matrix layout
+    is done by fromMatrix and toMatrix, which should be used for I/O.
+    Note: T should be of a number type (int, short, float, double, etc.)
+*/
+namespace puma {
+
+    template<class T>
+    class BrickedMatrix {
+    public:
+
+        static const int brickBits = 3;
+        static const int brickEdge = 1 << brickBits;
+        static const int brickVolume = brickEdge*brickEdge*brickEdge;
+
+        // distances in storage between a voxel and its neighbours in the same brick, for stencil kernels
+        // working on brickData: the neighbours of a voxel that is not on a face of its brick are at +-stride.
+        static const long strideX = brickEdge*brickEdge;
+        static const long strideY = brickEdge;
+        static const long strideZ = 1;
+
+        //! origin and extent of a brick, with the extent clipped to the domain.
+        struct Brick {
+            long i0, j0, k0;
+            int nx, ny, nz;
+            long offset;
+        };
+
+        BrickedMatrix() = default;
+
+        BrickedMatrix(long xR, long yR, long zR) {
+            resize(xR, yR, zR);
+        }
+
+        BrickedMatrix(long xR, long yR, long zR, T t) {
+            resize(xR, yR, zR);
+            set(t);
+        }
+
+        void resize(long xR, long yR, long zR) {
+            x = xR; y = yR; z = zR;
+            bx = (x + brickEdge - 1) >> brickBits;
+            by = (y + brickEdge - 1) >> brickBits;
+            bz = (z + brickEdge - 1) >> brickBits;
+            byz = by*bz;
+
+            // ranking the bricks by their Morton code, so that the storage is compact for any domain shape
+            long nBricks = bx*by*bz;
+            std::vector<std::pair<unsigned long, long>> codes(nBricks);
+            for(long b=0; b<nBricks; b++) {
+                codes[b] = std::make_pair(morton(b/byz, (b/bz)%by, b%bz), b);
+            }
+            std::sort(codes.begin(), codes.end());
+
+            brickOffset.resize(nBricks);
+            bricks.resize(nBricks);
+            for(long n=0; n<nBricks; n++) {
+                long b = codes[n].second;
+                Brick &brick = bricks[n];
+                brick.i0 = (b/byz) << brickBits;
+                brick.j0 = ((b/bz)%by) << brickBits;
+                brick.k0 = (b%bz) << brickBits;
+                brick.nx = (int)std::min((long)brickEdge, x - brick.i0);
+                brick.ny = (int)std::min((long)brickEdge, y - brick.j0);
+                brick.nz = (int)std::min((long)brickEdge, z - brick.k0);
+                brick.offset = n*brickVolume;
+                brickOffset[b] = brick.offset;
+            }
+
+            data.assign(nBricks*brickVolume, T());
+        }
+
+        T& operator()(long i, long j, long k) { return data[index(i,j,k)]; }
+        const T& operator()(long i, long j, long k) const { return data[index(i,j,k)]; }
+        T& at(long i, long j, long k) { return data[index(i,j,k)]; }
+        const T& at(long i, long j, long k) const { return data[index(i,j,k)]; }
+
+        //! storage index of a voxel.
+        long index(long i, long j, long k) const {
+            return brickOffset[(i >> brickBits)*byz + (j >> brickBits)*bz + (k >> brickBits)] + local(i, j, k);
+        }
+
+        //! index of a voxel inside its brick.
+        static long local(long i, long j, long k) {
+            return ((i & (brickEdge-1)) << (2*brickBits)) | ((j & (brickEdge-1)) << brickBits) | (k & (brickEdge-1));
+        }
+
+        //! the bricks in storage order. Looping over them, and over the voxels of each brick, walks the memory linearly.
+        const std::vector<Brick>& brickList() const { return bricks; }
+
+        T* brickData(const Brick &brick) { return &data[brick.offset]; }
+        const T* brickData(const Brick &brick) const { return &data[brick.offset]; }
+
+        void set(T t) { std::fill(data.begin(), data.end(), t); }
+
+        bool fromMatrix(Matrix<T> *matrix, int numThreads = 0) {
+            resize(matrix->X(), matrix->Y(), matrix->Z());
+            long nBricks = (long)bricks.size();
+
+            if(numThreads > 0) { omp_set_num_threads(numThreads); }
+#pragma omp parallel for
+            for(long n=0; n<nBricks; n++) {
+                const Brick &brick = bricks[n];
+                for(int i=0; i<brick.nx; i++) {
+                    for(int j=0; j<brick.ny; j++) {
+                        for(int k=0; k<brick.nz; k++) {
+                            data[brick.offset + local(i,j,k)] = matrix->at(brick.i0+i, brick.j0+j, brick.k0+k);
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        bool toMatrix(Matrix<T> *matrix, int numThreads = 0) const {
+            matrix->resize(x, y, z);
+            long nBricks = (long)bricks.size();
+
+            if(numThreads > 0) { omp_set_num_threads(numThreads); }
+#pragma omp parallel for
+            for(long n=0; n<nBricks; n++) {
+                const Brick &brick = bricks[n];
+                for(int i=0; i<brick.nx; i++) {
+                    for(int j=0; j<brick.ny; j++) {
+                        for(int k=0; k<brick.nz; k++) {
+                            matrix->at(brick.i0+i, brick.j0+j, brick.k0+k) = data[brick.offset + local(i,j,k)];
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        long X() const { return x; }
+        long Y() const { return y; }
+        long Z() const { return z; }
+        long size() const { return x*y*z; }
+
+        //! number of elements allocated, including the padding of the bricks on the upper faces.
+        long storageSize() const { return (long)data.size(); }
+
+    private:
+
+        long x{0}, y{0}, z{0};
+        long bx{0}, by{0}, bz{0}, byz{0};
+
+        std::vector<T> data;
+        std::vector<long> brickOffset;
+        std::vector<Brick> bricks;
+
+        static unsigned long spread(unsigned long v) {
+            // spreads the lower 21 bits of v to every third bit
+            v &= 0x1fffff;
+            v = (v | v << 32) & 0x1f00000000ffffUL;
+            v = (v | v << 16) & 0x1f0000ff0000ffUL;
+            v = (v | v << 8) & 0x100f00f00f00f00fUL;
+            v = (v | v << 4) & 0x10c30c30c30c30c3UL;
+            v = (v | v << 2) & 0x1249249249249249UL;
+            return v;
+        }
+
+        static unsigned long morton(long i, long j, long k) {
+            return (spread(i) << 2) | (spread(j) << 1) | spread(k);
+        }
+    };
+
+}
+
+#endif // PUMA_BrickedMatrix_H
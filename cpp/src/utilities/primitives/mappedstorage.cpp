@@ -0,0 +1,111 @@
+#include "mappedstorage.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+#if !defined(WIN32) || defined(__CYGWIN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define PUMA_MAPPED_STORAGE
+#endif
+
+
+#ifdef PUMA_MAPPED_STORAGE
+
+int puma::MappedStorage::open(const std::string &path) {
+    if(!path.empty()) {
+        return ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+
+    const char *dir = std::getenv("TMPDIR");
+    std::string name = std::string(dir == nullptr ? "/tmp" : dir) + "/puma_matrix_XXXXXX";
+    std::vector<char> nameBuffer(name.begin(), name.end());
+    nameBuffer.push_back('\0');
+    int fd = mkstemp(&nameBuffer[0]);
+    if(fd != -1) {
+        unlink(&nameBuffer[0]);
+    }
+    return fd;
+}
+
+void puma::MappedStorage::close(int fd) {
+    ::close(fd);
+}
+
+bool puma::MappedStorage::map(int fd, long bytes, void **data) {
+    // the file is truncated first so that stale data is never paged in
+    if(ftruncate(fd, 0) != 0 || ftruncate(fd, bytes) != 0) {
+        return false;
+    }
+    if(bytes == 0) {
+        *data = nullptr;
+        return true;
+    }
+    void *mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(mapping == MAP_FAILED) {
+        return false;
+    }
+    *data = mapping;
+    return true;
+}
+
+void puma::MappedStorage::unmap(void *data, long bytes) {
+    munmap(data, bytes);
+}
+
+long puma::MappedStorage::pageSize() {
+    return sysconf(_SC_PAGESIZE);
+}
+
+bool puma::MappedStorage::advise(void *data, long bytes, char pattern) {
+    int advice;
+    if(pattern == 'n') {
+        advice = MADV_NORMAL;
+    } else if(pattern == 's') {
+        advice = MADV_SEQUENTIAL;
+    } else if(pattern == 'r') {
+        advice = MADV_RANDOM;
+    } else {
+        std::cout << "Error in Matrix::advise: invalid pattern, can be 'n', 's' or 'r'" << std::endl;
+        return false;
+    }
+    return madvise(data, bytes, advice) == 0;
+}
+
+bool puma::MappedStorage::release(void *begin, long bytes) {
+    if(msync(begin, bytes, MS_SYNC) != 0) {
+        return false;
+    }
+    return madvise(begin, bytes, MADV_DONTNEED) == 0;
+}
+
+#else // no memory mapping, the matrices stay on the heap
+
+int puma::MappedStorage::open(const std::string &) {
+    std::cout << "Error in Matrix::mapFile: memory mapped files are not supported on this platform" << std::endl;
+    return -1;
+}
+
+void puma::MappedStorage::close(int) { }
+
+bool puma::MappedStorage::map(int, long, void **) {
+    return false;
+}
+
+void puma::MappedStorage::unmap(void *, long) { }
+
+long puma::MappedStorage::pageSize() {
+    return 4096;
+}
+
+bool puma::MappedStorage::advise(void *, long, char) {
+    return false;
+}
+
+bool puma::MappedStorage::release(void *, long) {
+    return false;
+}
+
+#endif // PUMA_MAPPED_STORAGE
@@ -0,0 +1,39 @@
+#ifndef PUMA_MAPPEDSTORAGE_H
+#define PUMA_MAPPEDSTORAGE_H
+
+#include <string>
+
+
+namespace puma {
+
+    //! The system calls behind the memory mapped backend of puma::Matrix (Matrix::mapFile).
+    /*!
+     *  Kept out of matrix.h so that the POSIX headers are only included here. On systems without POSIX memory
+     *  mapping, open fails and the matrices stay on the heap.
+     */
+    class MappedStorage
+    {
+    public:
+
+        //! opens path, creating it if needed, or an unlinked temporary file in $TMPDIR (or /tmp) if path is empty.
+        //! Returns the file descriptor, or -1 on failure.
+        static int open(const std::string &path);
+        static void close(int fd);
+
+        //! resizes the file to bytes, discarding its content, and maps it. data is set to nullptr if bytes is 0.
+        //! Returns false on failure, with data left unchanged.
+        static bool map(int fd, long bytes, void **data);
+        static void unmap(void *data, long bytes);
+
+        static long pageSize();
+
+        //! sets the paging policy ('n' normal, 's' sequential, 'r' random) of a mapping.
+        static bool advise(void *data, long bytes, char pattern);
+
+        //! writes back the pages of [begin, begin+bytes) and drops them from memory. begin and bytes are page aligned.
+        static bool release(void *begin, long bytes);
+    };
+
+}
+
+#endif // PUMA_MAPPEDSTORAGE_H
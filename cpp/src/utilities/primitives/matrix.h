@@ -4,11 +4,18 @@
 #include "vector.h"
 #include "pstring.h"
 #include "cutoff.h"
+#include "numa.h"
+#include "reduction.h"
+#include "voxelkernel.h"
+#include "mappedstorage.h"
 
 #include <iostream>
 #include <vector>
 #include <map>
 #include <iomanip>
+#include <utility>
+#include <type_traits>
+#include <atomic>
 #include <omp.h>
 
 
@@ -17,6 +24,12 @@
 */
 namespace puma{
 
+    // a value never returned before, shared by the matrices of all types
+    inline unsigned long long nextMatrixGeneration() {
+        static std::atomic<unsigned long long> counter(0);
+        return ++counter;
+    }
+
     template<class T>
     class Matrix {
     private:
@@ -27,6 +40,23 @@ namespace puma{
         long zy;
         long mySize;
 
+        // file descriptor of the memory mapped backend, -1 when the data is on the heap
+        int mapFd{-1};
+        long mapBytes{0};
+
+        // changed whenever the storage, the shape or all the values change, see generation()
+        unsigned long long generationId{0};
+
+        // touchPages initializes new heap storage with the NUMA first touch decomposition, when enabled
+        bool allocate(bool touchPages = true);
+        void release();
+
+        // sets every element to t, with the NUMA first touch decomposition when enabled
+        void touch(T t);
+
+        // threads of the loops writing new storage first, passed in a num_threads clause to leave the caller's setting alone
+        static int touchThreads() { return puma::NUMA::firstTouch() ? puma::NUMA::numThreads() : omp_get_max_threads(); }
+
     public:
 
         Matrix(long xR, long yR, long zR, T t) {
@@ -36,8 +66,8 @@ namespace puma{
             this->z=zR;
             zy = z*y;
             mySize = x*y*z;
-            data = new T[mySize];
-            set(t);
+            allocate(false);
+            touch(t);
         }
 
         Matrix(long xR, long yR, long zR) {
@@ -47,26 +77,78 @@ namespace puma{
             this->z=zR;
             zy = z*y;
             mySize = x*y*z;
-            data = new T[mySize];
+            allocate();
         }
 
-        explicit Matrix(Matrix<T> *other) {
+        explicit Matrix(Matrix<T> *other) : Matrix(*other) { }
 
-            this->x=other->X();
-            this->y=other->Y();
-            this->z=other->Z();
+        Matrix(const Matrix<T> &other) {
+
+            this->x=other.x;
+            this->y=other.y;
+            this->z=other.z;
             zy = z*y;
             mySize = x*y*z;
-            data = new T[mySize];
+            allocate(false);
 
-            for(long i=0; i<x; i++) {
-                for(long j=0; j<y; j++) {
-                    for(long k=0; k<z; k++) {
-                        data[zy*i+z*j+k] = other->operator ()(i,j,k);
-                    }
-                }
+#pragma omp parallel for schedule(static) num_threads(touchThreads())
+            for(long i=0; i<mySize; i++) {
+                data[i] = other.data[i];
+            }
+
+        }
+
+        // moves take over the storage, the moved from matrix is left empty
+        Matrix(Matrix<T> &&other) noexcept : Matrix() {
+            swap(other);
+        }
+
+        // the storage is reused when the size matches, and a memory mapped backend is kept
+        Matrix<T>& operator=(const Matrix<T> &other) {
+            if(this == &other) {
+                return *this;
+            }
+
+            this->x=other.x;
+            this->y=other.y;
+            this->z=other.z;
+            zy = z*y;
+
+            int n = omp_get_max_threads();
+            if(mySize != x*y*z) {
+                release();
+                mySize = x*y*z;
+                allocate(false);
+                n = touchThreads();
+            }
+
+#pragma omp parallel for schedule(static) num_threads(n)
+            for(long i=0; i<mySize; i++) {
+                data[i] = other.data[i];
             }
+            generationId = nextMatrixGeneration();
 
+            return *this;
+        }
+
+        Matrix<T>& operator=(Matrix<T> &&other) noexcept {
+            Matrix<T> moved(std::move(other));
+            swap(moved);
+            return *this;
+        }
+
+        // exchanges the storage (including a memory mapped backend) and the dimensions of two matrices, without copying
+        void swap(Matrix<T> &other) noexcept {
+            std::swap(data, other.data);
+            std::swap(x, other.x);
+            std::swap(y, other.y);
+            std::swap(z, other.z);
+            std::swap(zy, other.zy);
+            std::swap(mySize, other.mySize);
+            std::swap(mapFd, other.mapFd);
+            std::swap(mapBytes, other.mapBytes);
+            generationId = nextMatrixGeneration();
+            other.generationId = nextMatrixGeneration();
         }
 
         Matrix() {
@@ -76,12 +158,15 @@ namespace puma{
             this->z=0;
             zy = z*y;
             mySize = x*y*z;
-            data = new T[mySize];
+            allocate();
 
         }
 
         ~Matrix() {
-            delete [] data;
+            release();
+            if(mapFd != -1) {
+                puma::MappedStorage::close(mapFd);
+            }
         }
 
         T& operator()(long i, long j, long k) const;
@@ -99,11 +184,13 @@ namespace puma{
         bool copy(Matrix<T> *other);
         bool crop(long x1, long x2, long y1, long y2, long z1, long z2);
 
-        double reduce();
-        double dot(Matrix<T> *p2) const;
+        // Reductions go through puma::Reduction, so the results are bitwise the same on any number of threads.
+        // numThreads <= 0 uses the thread count of the caller, which is never changed.
+        double reduce(int numThreads = 0);
+        double dot(Matrix<T> *p2, int numThreads = 0) const;
 
-        T min();
-        T max();
+        T min(int numThreads = 0);
+        T max(int numThreads = 0);
 
         bool flipAroundValue(float average);
         bool flipAroundValue(Matrix<float> *newMatrix, float average);
@@ -111,11 +198,24 @@ namespace puma{
         bool normalize(float minValue, float maxValue);
         bool normalize(Matrix<float> *newMatrix, float minValue, float maxValue);
 
-        double average();
+        double average(int numThreads = 0);
 
         void resize(long xR, long yR, long zR, T t);
         void resize(long xR, long yR, long zR);
 
+        // Out of core storage: the matrix is backed by a memory mapped file, and paged in and out by the OS.
+        // The backend is kept through resize and copy. If path is empty, an unlinked temporary file in
+        // $TMPDIR (or /tmp) is used, otherwise the raw data is left in the file when the matrix is destroyed.
+        // Where memory mapping is not supported (see MappedStorage), the matrix stays on the heap and false is returned.
+        bool mapFile(const std::string &path = "");
+        bool isMapped() const { return mapFd != -1; }
+
+        // Access hints for the mapped backend, no-ops when the matrix is on the heap.
+        // advise sets the paging policy ('n' normal, 's' sequential, 'r' random) of the whole mapping,
+        // releaseSlabs writes back the x slabs x1 to x2 and drops the pages that lie entirely inside them.
+        bool advise(char pattern);
+        bool releaseSlabs(long x1, long x2);
+
         bool print(int precision = 3) const;
         bool printRange(int xstart, int xend, int ystart, int yend, int zstart, int zend, int precision = 3) const;
         bool printSlice(char alongAxis, int sliceNumber, int precision = 3) const;
@@ -128,6 +228,10 @@ namespace puma{
         long ZY();
         long size() const;
 
+        // Identifies the content: a new value is taken on every resize, copy, set, swap, crop, in place flip
+        // or normalization and mapFile. Writes through operator() or at() do not change it.
+        unsigned long long generation() const { return generationId; }
+
     };
 
 
@@ -148,6 +252,104 @@ namespace puma{
 
 
 
+    template<class T> bool Matrix<T>::allocate(bool touchPages) {
+        generationId = nextMatrixGeneration();
+        if(mapFd == -1) {
+            data = new T[mySize];
+            // class types were already touched by their constructors in new
+            if(touchPages && puma::NUMA::firstTouch() && std::is_arithmetic<T>::value) {
+                touch(T());
+            }
+            return true;
+        }
+
+        // the mapping is rounded up to whole pages
+        long page = puma::MappedStorage::pageSize();
+        mapBytes = ((mySize*(long)sizeof(T) + page - 1)/page)*page;
+        void *mapping;
+        if(puma::MappedStorage::map(mapFd, mapBytes, &mapping)) {
+            data = (T*)mapping;
+            return true;
+        }
+
+        std::cout << "Error in Matrix: could not map " << mapBytes << " bytes, falling back to memory" << std::endl;
+        puma::MappedStorage::close(mapFd);
+        mapFd = -1;
+        mapBytes = 0;
+        data = new T[mySize];
+        return false;
+    }
+
+    template<class T> void Matrix<T>::touch(T t) {
+#pragma omp parallel for schedule(static) num_threads(touchThreads())
+        for(long i=0; i<mySize; i++) {
+            data[i] = t;
+        }
+    }
+
+    template<class T> void Matrix<T>::release() {
+        if(mapFd == -1) {
+            delete [] data;
+        } else if(data != nullptr) {
+            puma::MappedStorage::unmap(data, mapBytes);
+        }
+        data = nullptr;
+    }
+
+    template<class T> bool Matrix<T>::mapFile(const std::string &path) {
+        if(mapFd != -1) {
+            std::cout << "Error in Matrix::mapFile: matrix is already mapped" << std::endl;
+            return false;
+        }
+
+        int fd = puma::MappedStorage::open(path);
+        if(fd == -1) {
+            std::cout << "Error in Matrix::mapFile: could not open file " << (path.empty() ? "in temporary directory" : path) << std::endl;
+            return false;
+        }
+
+        T *heapData = data;
+        mapFd = fd;
+        bool success = allocate();
+
+#pragma omp parallel for
+        for(long i=0; i<mySize; i++) {
+            data[i] = heapData[i];
+        }
+        delete [] heapData;
+
+        return success;
+    }
+
+    template<class T> bool Matrix<T>::advise(char pattern) {
+        if(mapFd == -1 || data == nullptr) {
+            return true;
+        }
+
+        return puma::MappedStorage::advise(data, mapBytes, pattern);
+    }
+
+    template<class T> bool Matrix<T>::releaseSlabs(long x1, long x2) {
+        if(x1 < 0 || x1 > x2 || x2 >= x) {
+            std::cout << "Error in Matrix::releaseSlabs: slab range out of boundary" << std::endl;
+            return false;
+        }
+
+        if(mapFd == -1 || data == nullptr) {
+            return true;
+        }
+
+        // pages shared with the neighbouring slabs are kept
+        long page = puma::MappedStorage::pageSize();
+        long start = ((zy*x1*(long)sizeof(T) + page - 1)/page)*page;
+        long end = ((zy*(x2+1)*(long)sizeof(T))/page)*page;
+        if(end <= start) {
+            return true;
+        }
+
+        return puma::MappedStorage::release((char*)data + start, end-start);
+    }
+
     template<class T> long Matrix<T>::X() {
         return x;
     }
@@ -237,22 +439,7 @@ namespace puma{
     }
 
     template<class T> bool Matrix<T>::copy(Matrix<T> *other) {
-        this->x=other->X();
-        this->y=other->Y();
-        this->z=other->Z();
-
-        zy = z*y;
-        mySize = x*y*z;
-
-        delete [] data;
-        data = new T[mySize];
-
-#pragma omp parallel for
-        for(long i=0; i<mySize; i++) {
-            data[i] = other->operator ()(i);
-
-        }
-
+        *this = *other;
         return true;
     }
 
@@ -262,16 +449,13 @@ namespace puma{
             return false;
         }
 
-#pragma omp parallel for
-        for(int i=0;i<x;i++){
-            for (int j = 0; j < y; j++) {
-                for (int k = 0; k < z; k++) {
-                    if(this->operator ()(i,j,k) > average) {
-                        this->operator ()(i,j,k) = (T) (2.0*average - this->operator ()(i,j,k));
-                    }
-                }
+        generationId = nextMatrixGeneration();
+        // the functions without numThreads keep the thread count of the surrounding code
+        for_each_voxel(this, [average](T &value) {
+            if(value > average) {
+                value = (T) (2.0*average - value);
             }
-        }
+        }, omp_get_max_threads());
         return true;
     }
 
@@ -283,18 +467,13 @@ namespace puma{
 
         newMatrix->resize(x,y,z);
 
-#pragma omp parallel for
-        for(int i=0;i<x;i++){
-            for (int j = 0; j < y; j++) {
-                for (int k = 0; k < z; k++) {
-                    if(this->operator ()(i,j,k) > average) {
-                        newMatrix->operator ()(i,j,k) = (T) (2.0*average - this->operator ()(i,j,k));
-                    } else {
-                        newMatrix->operator ()(i,j,k) = (float) this->operator ()(i,j,k);
-                    }
-                }
+        for_each_voxel(this, newMatrix, [average](const T &value, float &flipped) {
+            if(value > average) {
+                flipped = (T) (2.0*average - value);
+            } else {
+                flipped = (float) value;
             }
-        }
+        }, omp_get_max_threads());
         return true;
     }
 
@@ -310,10 +489,10 @@ namespace puma{
         auto min = (float)this->min();
         auto max = (float)this->max();
 
-#pragma omp parallel for
-        for(long i=0;i<mySize;i++){
-            data[i] = minValue+(range*(data[i]-min)/(max-min));
-        }
+        generationId = nextMatrixGeneration();
+        for_each_voxel(this, [minValue,range,min,max](T &value) {
+            value = minValue+(range*(value-min)/(max-min));
+        }, omp_get_max_threads());
 
         return true;
     }
@@ -331,201 +510,52 @@ namespace puma{
         auto min = (float)this->min();
         auto max = (float)this->max();
 
-#pragma omp parallel for
-        for(long i=0;i<mySize;i++){
-            newMatrix->operator ()(i) = minValue+(range*(data[i]-min)/(max-min));
-        }
+        for_each_voxel(this, newMatrix, [minValue,range,min,max](const T &value, float &normalized) {
+            normalized = minValue+(range*(value-min)/(max-min));
+        }, omp_get_max_threads());
 
         return true;
     }
 
-    template<class T> double Matrix<T>::reduce() {
-
-        if(mySize==0) {
-            return 0;
-        }
-
-        int splitSize = omp_get_num_procs();
-        if(splitSize==0) splitSize=1;
-
-        long iteration = mySize/splitSize;
-
-        std::vector<long> cStart(splitSize);
-        std::vector<long> cEnd(splitSize);
-
-        for(long i=0;i<splitSize-1;i++){
-            cStart[i]=i*iteration;
-            cEnd[i]=(i+1)*iteration;
-        }
-        cStart[splitSize-1]=(splitSize-1)*iteration;
-        cEnd[splitSize-1]=mySize;
-
-        std::vector<double> splitCount(splitSize,0);
-        double total = 0;
-
-#pragma omp parallel for
-        for(long c=0;c<splitSize;c++){
-            for(long i=cStart[c];i<cEnd[c];i++){
-                splitCount[c]+=data[i];
-            }
-        }
-
-        for(int i=0;i<splitSize;i++){
-            total+=splitCount[i];
-        }
-
-        return total;
-
+    template<class T> double Matrix<T>::reduce(int numThreads) {
+        const T *values = data;
+        return puma::Reduction::sum(mySize, [values](long i) { return (double)values[i]; }, numThreads);
     }
 
-    template<class T> double Matrix<T>::dot(Matrix<T> *p2) const {
+    template<class T> double Matrix<T>::dot(Matrix<T> *p2, int numThreads) const {
         if(mySize != p2->size()){
             std::cout << "PMatrix Error: Matrices must be of the same size when taking dot product" << std::endl;
             return -1;
         }
 
-        if(mySize==0) {
-            return 0;
-        }
-
-        int splitSize = omp_get_num_procs();
-
-        if(splitSize==0) splitSize=1;
-
-        long iteration = mySize/splitSize;
-
-        std::vector<long> cStart(splitSize);
-        std::vector<long> cEnd(splitSize);
-
-        for(long i=0;i<splitSize-1;i++){
-            cStart[i]=i*iteration;
-            cEnd[i]=(i+1)*iteration;
-        }
-        cStart[splitSize-1]=(splitSize-1)*iteration;
-        cEnd[splitSize-1]=mySize;
-
-        std::vector<double> splitCount(splitSize,0);
-        double total = 0;
-
-#pragma omp parallel for
-        for(long c=0;c<splitSize;c++){
-            for(long i=cStart[c];i<cEnd[c];i++){
-                splitCount[c]+=data[i]*(*p2)(i);
-            }
-        }
-
-        for(int i=0;i<splitSize;i++){
-            total+=splitCount[i];
-        }
-
-
-        //    double total = 0;
-
-        //#pragma omp parallel for reduction(+:total)
-        //    for (long i = 0; i < mySize; i++) {
-        //        total += data[i] * p2->at(i);
-        //    }
-
-        //    std::cout << "new version" << std::endl;
-
-
-        return total;
+        const T *values = data;
+        const T *values2 = p2->data;
+        return puma::Reduction::sum(mySize, [values,values2](long i) { return (double)values[i]*(double)values2[i]; }, numThreads);
     }
 
-    template<class T> T Matrix<T>::min() {
-
-        if(mySize==0) {
-            return 0;
-        }
-
-        int splitSize = omp_get_num_procs();
-        if(splitSize==0) splitSize=1;
-
-        long iteration = mySize/splitSize;
-
-        std::vector<long> cStart(splitSize);
-        std::vector<long> cEnd(splitSize);
-
-        for(long i=0;i<splitSize-1;i++){
-            cStart[i]=i*iteration;
-            cEnd[i]=(i+1)*iteration;
-        }
-        cStart[splitSize-1]=(splitSize-1)*iteration;
-        cEnd[splitSize-1]=mySize;
-
-        std::vector<double> splitMin(splitSize,1e10);
-
-#pragma omp parallel for
-        for(long c=0;c<splitSize;c++){
-            for(long i=cStart[c];i<cEnd[c];i++){
-                if(data[i] < splitMin[c]) { splitMin[c] = data[i]; }
-            }
-        }
-
-        double min = splitMin[0];
-        for(int i=1;i<splitSize;i++){
-            if(splitMin[i] < min) { min = splitMin[i]; }
-        }
-
-        return min;
-
+    template<class T> T Matrix<T>::min(int numThreads) {
+        const T *values = data;
+        return puma::Reduction::min<T>(mySize, [values](long i) { return values[i]; }, numThreads);
     }
 
-    template<class T> T Matrix<T>::max() {
-
-        if(mySize==0) {
-            return 0;
-        }
-
-        int splitSize = omp_get_num_procs();
-        if(splitSize==0) splitSize=1;
-
-        long iteration = mySize/splitSize;
-
-        std::vector<long> cStart(splitSize);
-        std::vector<long> cEnd(splitSize);
-
-        for(long i=0;i<splitSize-1;i++){
-            cStart[i]=i*iteration;
-            cEnd[i]=(i+1)*iteration;
-        }
-        cStart[splitSize-1]=(splitSize-1)*iteration;
-        cEnd[splitSize-1]=mySize;
-
-        std::vector<double> splitMax(splitSize,-1e10);
-
-#pragma omp parallel for
-        for(long c=0;c<splitSize;c++){
-            for(long i=cStart[c];i<cEnd[c];i++){
-                if(data[i] > splitMax[c]) { splitMax[c] = data[i]; }
-            }
-        }
-
-        double max = splitMax[0];
-        for(int i=1;i<splitSize;i++){
-            if(splitMax[i] > max) { max = splitMax[i]; }
-        }
-
-        return max;
-
+    template<class T> T Matrix<T>::max(int numThreads) {
+        const T *values = data;
+        return puma::Reduction::max<T>(mySize, [values](long i) { return values[i]; }, numThreads);
     }
 
-    template<class T> double Matrix<T>::average() {
+    template<class T> double Matrix<T>::average(int numThreads) {
 
         if(mySize==0) {
             return 0;
         }
 
-        double red = reduce();
+        double red = reduce(numThreads);
         return red/(double)mySize;
     }
 
     template<class T> bool Matrix<T>::set(T t) {
-#pragma omp parallel for
-        for(long i=0; i<mySize; i++) {
-            data[i] = t;
-        }
-        return true;
+        generationId = nextMatrixGeneration();
+        return for_each_voxel(this, [t](T &value) { value = t; }, omp_get_max_threads());
     }
 
     template<class T> bool Matrix<T>::set(long x1, long x2, long y1, long y2, long z1, long z2, T t) {
@@ -542,16 +572,8 @@ namespace puma{
             return false;
         }
 
-#pragma omp parallel for
-        for(long i=x1; i<=x2; i++) {
-            for(long j=y1; j<=y2; j++) {
-                for(long k=z1; k<=z2; k++) {
-                    data[zy*i+z*j+k] = t;
-                }
-            }
-        }
-
-        return true;
+        generationId = nextMatrixGeneration();
+        return for_each_voxel(this, x1, x2, y1, y2, z1, z2, [t](T &value) { value = t; }, omp_get_max_threads());
 
     }
 
@@ -560,10 +582,10 @@ namespace puma{
         this->y=yR;
         this->z=zR;
         zy = z*y;
+        release();
         mySize = x*y*z;
-        delete [] data;
-        data = new T[mySize];
-        set(t);
+        allocate(false);
+        touch(t);
     }
 
     template<class T> void Matrix<T>::resize(long xR, long yR, long zR) {
@@ -571,9 +593,9 @@ namespace puma{
         this->y=yR;
         this->z=zR;
         zy = z*y;
+        release();
         mySize = x*y*z;
-        delete [] data;
-        data = new T[mySize];
+        allocate();
     }
 
     template<class T> std::string Matrix<T>::sizeToString() const {
@@ -0,0 +1,139 @@
+#ifndef PUMA_MatrixView_H
+#define PUMA_MatrixView_H
+
+#include "matrix.h"
+
+
+namespace puma {
+
+    //! A non-owning window on a box of a puma::Matrix.
+    /*!
+     *  The view keeps a pointer to the first voxel of the box and the strides of the matrix it looks into, so
+     *  (i,j,k) of the view is (x1+i,y1+j,z1+k) of the matrix, and no data is copied. Writes through the view change
+     *  the matrix. The view is only valid as long as the matrix is not resized, swapped or destroyed.
+     *  \sa Matrix, WorkspaceView
+     */
+    template<class T>
+    class MatrixView
+    {
+    public:
+
+        MatrixView() = default;
+
+        //! view of the whole matrix
+        explicit MatrixView(Matrix<T> *matrix) : MatrixView(matrix,0,-1,0,-1,0,-1) { }
+
+        //! view of the box [x1,x2] x [y1,y2] x [z1,z2], bounds included as in Matrix::crop. -1 as upper bound means
+        //! the last index. An invalid box gives an empty view, as does the whole view of an empty matrix (silently).
+        MatrixView(Matrix<T> *matrix, long x1, long x2, long y1, long y2, long z1, long z2) {
+
+            if(matrix->size() == 0 && x1 == 0 && y1 == 0 && z1 == 0 && x2 == -1 && y2 == -1 && z2 == -1) {
+                this->matrix = matrix;
+                return;
+            }
+
+            // to simplify function call
+            if(x2 == -1){ x2 = matrix->X()-1; }
+            if(y2 == -1){ y2 = matrix->Y()-1; }
+            if(z2 == -1){ z2 = matrix->Z()-1; }
+
+            if( x1<0 || x1>x2 || x2>=matrix->X() ||
+                y1<0 || y1>y2 || y2>=matrix->Y() ||
+                z1<0 || z1>z2 || z2>=matrix->Z() ) {
+                std::cout << "Error in MatrixView: box out of boundary" << std::endl;
+                return;
+            }
+
+            this->matrix = matrix;
+            origin = &matrix->at(x1,y1,z1);
+            x = x2-x1+1;
+            y = y2-y1+1;
+            z = z2-z1+1;
+            x0 = x1;
+            y0 = y1;
+            z0 = z1;
+            strideX = matrix->ZY();
+            strideY = matrix->Z();
+        }
+
+        T& operator()(long i, long j, long k) const { return origin[strideX*i+strideY*j+k]; }
+        T& at(long i, long j, long k) const { return origin[strideX*i+strideY*j+k]; }
+
+        long X() const { return x; }
+        long Y() const { return y; }
+        long Z() const { return z; }
+        long size() const { return x*y*z; }
+
+        //! position of the first voxel of the view in the matrix
+        long X0() const { return x0; }
+        long Y0() const { return y0; }
+        long Z0() const { return z0; }
+
+        //! distance between neighbours along x and y in the underlying storage (z is contiguous)
+        long strideI() const { return strideX; }
+        long strideJ() const { return strideY; }
+
+        Matrix<T>* source() const { return matrix; }
+
+        //! true if the view covers the whole matrix
+        bool isWhole() const { return matrix != nullptr && size() == matrix->size(); }
+
+        //! copies the box into a matrix, which is resized to the view
+        bool copyTo(Matrix<T> *other, int numThreads = 0) const {
+            other->resize(x,y,z);
+            if(numThreads<=0 || numThreads>1000) {
+                numThreads = omp_get_num_procs();
+            }
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0; i<x; i++) {
+                for(long j=0; j<y; j++) {
+                    for(long k=0; k<z; k++) {
+                        other->at(i,j,k) = origin[strideX*i+strideY*j+k];
+                    }
+                }
+            }
+            return true;
+        }
+
+        //! writes a matrix of the size of the view into the box
+        bool copyFrom(Matrix<T> *other, int numThreads = 0) const {
+            if(other->X() != x || other->Y() != y || other->Z() != z) {
+                std::cout << "Error in MatrixView::copyFrom: matrix and view must have the same size" << std::endl;
+                return false;
+            }
+            if(numThreads<=0 || numThreads>1000) {
+                numThreads = omp_get_num_procs();
+            }
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0; i<x; i++) {
+                for(long j=0; j<y; j++) {
+                    for(long k=0; k<z; k++) {
+                        origin[strideX*i+strideY*j+k] = other->at(i,j,k);
+                    }
+                }
+            }
+            return true;
+        }
+
+    private:
+
+        Matrix<T> *matrix{nullptr};
+        T *origin{nullptr};
+
+        long x{0};
+        long y{0};
+        long z{0};
+
+        long x0{0};
+        long y0{0};
+        long z0{0};
+
+        long strideX{0};
+        long strideY{0};
+    };
+
+}
+
+#endif // PUMA_MatrixView_H
@@ -0,0 +1,59 @@
+#include "numa.h"
+
+#include <iostream>
+#include <vector>
+
+#ifdef LINUX
+#include <sched.h>
+#endif
+
+
+bool puma::NUMA::pinThreads(int numThreads) {
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+#ifdef LINUX
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0) {
+        std::cout << "Error in NUMA::pinThreads: could not read the process affinity" << std::endl;
+        return false;
+    }
+
+    std::vector<int> cpus;
+    for(int c=0; c<CPU_SETSIZE; c++) {
+        if(CPU_ISSET(c, &allowed)) {
+            cpus.push_back(c);
+        }
+    }
+    if(cpus.empty()) {
+        return false;
+    }
+
+    // thread t goes to the processor t*numCpus/numThreads, so consecutive threads (i.e. consecutive x slabs) share
+    // a socket, and all the sockets are used
+    int failed = 0;
+    omp_set_num_threads(numThreads);
+#pragma omp parallel reduction(+:failed)
+    {
+        long t = omp_get_thread_num();
+        cpu_set_t single;
+        CPU_ZERO(&single);
+        CPU_SET(cpus[t*(long)cpus.size()/omp_get_num_threads()], &single);
+        if(sched_setaffinity(0, sizeof(cpu_set_t), &single) != 0) {
+            failed++;
+        }
+    }
+
+    if(failed > 0) {
+        std::cout << "Error in NUMA::pinThreads: could not bind " << failed << " threads" << std::endl;
+        return false;
+    }
+    return true;
+#else
+    std::cout << "Error in NUMA::pinThreads: thread binding is only supported on Linux, use OMP_PROC_BIND instead" << std::endl;
+    return false;
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef PUMA_NUMA_H
+#define PUMA_NUMA_H
+
+#include <omp.h>
+
+
+namespace puma {
+
+    //! Process wide placement settings for the heap storage of puma::Matrix on multi-socket machines.
+    /*!
+     *  Linux places a page on the NUMA node of the thread that first writes it. With first touch enabled, every
+     *  newly allocated Matrix (constructors, resize, copies) is initialized by an "omp parallel for schedule(static)"
+     *  over its linear index with numThreads() threads. This is the decomposition of the "omp parallel for" loops
+     *  over the linear index or over the x slabs used by the AMatrix residuals and by the iterative solvers, so each
+     *  thread later works on pages local to its socket. For this to hold, the solvers have to run with the same
+     *  number of threads, and the threads must not migrate between sockets: either export
+     *  OMP_PROC_BIND=spread and OMP_PLACES=cores before starting, or call pinThreads once at the start.
+     *  Only arithmetic element types are placed, since class types (e.g. Vec3) are touched by their constructors.
+     *  Memory mapped matrices are placed by the page cache and are not affected.
+     */
+    class NUMA
+    {
+    public:
+
+        //! enables or disables the parallel first touch. numThreads <= 0 uses all the processors
+        static void setFirstTouch(bool enable, int numThreads = 0) {
+            settings().firstTouch = enable;
+            settings().numThreads = (numThreads<=0 || numThreads>1000) ? omp_get_num_procs() : numThreads;
+        }
+
+        static bool firstTouch() { return settings().firstTouch; }
+        static int numThreads() { return settings().numThreads; }
+
+        //! binds each OpenMP thread to one processor, spreading the threads evenly over the processors this process
+        //! may run on (i.e. over both sockets). Returns false if the binding is not supported or fails.
+        static bool pinThreads(int numThreads = 0);
+
+    private:
+
+        struct Settings {
+            bool firstTouch{false};
+            int numThreads{1};
+        };
+
+        static Settings& settings() {
+            static Settings current;
+            return current;
+        }
+    };
+
+}
+
+#endif // PUMA_NUMA_H
@@ -0,0 +1,173 @@
+#ifndef PUMA_Reduction_H
+#define PUMA_Reduction_H
+
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+
+namespace puma {
+
+    //! Parallel reductions whose result does not depend on the number of threads.
+    /*!
+     *  The range [0,n) is cut into blocks of blockSize elements at fixed positions. Each block is summed into 8 lanes
+     *  (which the compiler maps onto SIMD registers) that are added in a fixed order, and the block sums are added
+     *  pairwise, first within tasks of blocksPerTask blocks and then across the tasks. Threads only decide which tasks
+     *  they compute, never the order of the additions, so sums are bitwise reproducible on any number of threads,
+     *  and the pairwise tree keeps the rounding error growing with log(n) rather than n.
+     *  The element i is given by a functor value(i), so that the same engine serves sums, dot products and norms.
+     */
+    class Reduction
+    {
+    public:
+
+        static const long blockSize = 1024;
+        static const long blocksPerTask = 64;
+
+        //! sum of value(i) for i in [0,n), in double precision. numThreads <= 0 uses the caller's thread count (omp_get_max_threads)
+        template<class F>
+        static double sum(long n, F value, int numThreads = 0) {
+            if(n <= 0) {
+                return 0;
+            }
+
+            long taskSize = blockSize*blocksPerTask;
+            long numTasks = (n + taskSize - 1)/taskSize;
+            std::vector<double> taskSum(numTasks);
+
+#pragma omp parallel for schedule(static) num_threads(threads(numThreads))
+            for(long t=0; t<numTasks; t++) {
+                long begin = t*taskSize;
+                long end = std::min(n, begin + taskSize);
+                long numBlocks = (end - begin + blockSize - 1)/blockSize;
+
+                double blockSum[blocksPerTask];
+                for(long b=0; b<numBlocks; b++) {
+                    long blockBegin = begin + b*blockSize;
+                    blockSum[b] = sumBlock(value, blockBegin, std::min(end, blockBegin + blockSize));
+                }
+                taskSum[t] = pairwise(blockSum, numBlocks);
+            }
+
+            return pairwise(&taskSum[0], numTasks);
+        }
+
+        //! number of blocks of blockSize elements covering [0,n)
+        static long blocks(long n) {
+            return n <= 0 ? 0 : (n + blockSize - 1)/blockSize;
+        }
+
+        //! sum of value(i) over the block b of [0,n), added in the same order as in sum. value is called once per i, in
+        //! increasing order, so it can also update the vectors it reads (fused kernels)
+        template<class F>
+        static double blockSum(long b, long n, F value) {
+            long begin = b*blockSize;
+            return sumBlock(value, begin, std::min(n, begin + blockSize));
+        }
+
+        //! adds the numBlocks block sums of blockSum the way sum adds them, so that a loop which computes the blocks
+        //! itself (in any thread) gets bitwise the result of sum
+        static double combine(const double *blockSums, long numBlocks) {
+            long numTasks = (numBlocks + blocksPerTask - 1)/blocksPerTask;
+            if(numTasks <= 1) {
+                return pairwise(blockSums, numBlocks);
+            }
+            std::vector<double> taskSum(numTasks);
+            for(long t=0; t<numTasks; t++) {
+                taskSum[t] = pairwise(blockSums + t*blocksPerTask, std::min(blocksPerTask, numBlocks - t*blocksPerTask));
+            }
+            return pairwise(&taskSum[0], numTasks);
+        }
+
+        //! smallest value(i) for i in [0,n), n has to be positive
+        template<class T, class F>
+        static T min(long n, F value, int numThreads = 0) {
+            return extremum<T>(n, value, numThreads, [](T a, T b) { return b < a ? b : a; });
+        }
+
+        //! largest value(i) for i in [0,n), n has to be positive
+        template<class T, class F>
+        static T max(long n, F value, int numThreads = 0) {
+            return extremum<T>(n, value, numThreads, [](T a, T b) { return b > a ? b : a; });
+        }
+
+    private:
+
+        static int threads(int numThreads) {
+            return (numThreads<=0 || numThreads>1000) ? omp_get_max_threads() : numThreads;
+        }
+
+        template<class F>
+        static double sumBlock(F &value, long begin, long end) {
+            double lane[8] = {0,0,0,0,0,0,0,0};
+
+            long i = begin;
+            for(; i+8<=end; i+=8) {
+                for(int l=0; l<8; l++) {
+                    lane[l] += value(i+l);
+                }
+            }
+            for(int l=0; i<end; i++, l++) {
+                lane[l] += value(i);
+            }
+
+            return ((lane[0]+lane[1]) + (lane[2]+lane[3])) + ((lane[4]+lane[5]) + (lane[6]+lane[7]));
+        }
+
+        static double pairwise(const double *values, long n) {
+            if(n == 0) {
+                return 0;
+            }
+            if(n == 1) {
+                return values[0];
+            }
+            long half = n/2;
+            return pairwise(values, half) + pairwise(values + half, n - half);
+        }
+
+        // min and max do not depend on the order, so only the split in tasks is shared with sum
+        template<class T, class F, class C>
+        static T extremum(long n, F value, int numThreads, C pick) {
+            if(n <= 0) {
+                return T();
+            }
+
+            long taskSize = blockSize*blocksPerTask;
+            long numTasks = (n + taskSize - 1)/taskSize;
+            std::vector<T> taskResult(numTasks);
+
+#pragma omp parallel for schedule(static) num_threads(threads(numThreads))
+            for(long t=0; t<numTasks; t++) {
+                long begin = t*taskSize;
+                long end = std::min(n, begin + taskSize);
+                // independent lanes, like in sumBlock, so that the compares vectorize
+                T lane[8];
+                for(int l=0; l<8; l++) {
+                    lane[l] = value(begin);
+                }
+                long i = begin;
+                for(; i+8<=end; i+=8) {
+                    for(int l=0; l<8; l++) {
+                        lane[l] = pick(lane[l], value(i+l));
+                    }
+                }
+                for(; i<end; i++) {
+                    lane[0] = pick(lane[0], value(i));
+                }
+                for(int l=1; l<8; l++) {
+                    lane[0] = pick(lane[0], lane[l]);
+                }
+                taskResult[t] = lane[0];
+            }
+
+            T result = taskResult[0];
+            for(long t=1; t<numTasks; t++) {
+                result = pick(result, taskResult[t]);
+            }
+            return result;
+        }
+    };
+
+}
+
+#endif // PUMA_Reduction_H
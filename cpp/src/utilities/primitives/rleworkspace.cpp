@@ -0,0 +1,184 @@
+#include "rleworkspace.h"
+
+#include <algorithm>
+#include <omp.h>
+
+
+puma::RLEWorkspace::RLEWorkspace(puma::Workspace *work, int numThreads) {
+    fromWorkspace(work, numThreads);
+}
+
+bool puma::RLEWorkspace::fromWorkspace(puma::Workspace *work, int numThreads) {
+
+    x = work->X();
+    y = work->Y();
+    z = work->Z();
+    voxelLength = work->voxelLength;
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    // first pass counts the runs of every column, so that the runs can be written in place
+    long columns = x*y;
+    columnStart.assign(columns+1, 0);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long c=0; c<columns; c++) {
+        long runs = (z > 0) ? 1 : 0;
+        for(long k=1; k<z; k++) {
+            if(work->matrix(c*z+k) != work->matrix(c*z+k-1)) {
+                runs++;
+            }
+        }
+        columnStart[c+1] = runs;
+    }
+
+    for(long c=0; c<columns; c++) {
+        columnStart[c+1] += columnStart[c];
+    }
+
+    runValue.resize(columnStart[columns]);
+    runStart.resize(columnStart[columns]);
+
+#pragma omp parallel for
+    for(long c=0; c<columns; c++) {
+        long n = columnStart[c];
+        for(long k=0; k<z; k++) {
+            if(k == 0 || work->matrix(c*z+k) != work->matrix(c*z+k-1)) {
+                runValue[n] = work->matrix(c*z+k);
+                runStart[n] = (int)k;
+                n++;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool puma::RLEWorkspace::toWorkspace(puma::Workspace *work, int numThreads) const {
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    // the voxels are written directly through matrix, so the coarse levels of the workspace are dropped
+    work->modified();
+    work->matrix.resize(x,y,z);
+    work->voxelLength = voxelLength;
+
+    long columns = x*y;
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long c=0; c<columns; c++) {
+        for(long n=columnStart[c]; n<columnStart[c+1]; n++) {
+            long end = (n+1 < columnStart[c+1]) ? runStart[n+1] : z;
+            for(long k=runStart[n]; k<end; k++) {
+                work->matrix(c*z+k) = runValue[n];
+            }
+        }
+    }
+
+    return true;
+}
+
+short puma::RLEWorkspace::at(long i, long j, long k) const {
+    auto first = runStart.begin() + columnStart[i*y+j];
+    auto last = runStart.begin() + columnStart[i*y+j+1];
+    return runValue[std::upper_bound(first, last, (int)k) - runStart.begin() - 1];
+}
+
+long puma::RLEWorkspace::count(puma::Cutoff cutoff, int numThreads) const {
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    std::vector<long> slabCount(x,0);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<x; i++) {
+        for(long c=i*y; c<(i+1)*y; c++) {
+            for(long n=columnStart[c]; n<columnStart[c+1]; n++) {
+                if(runValue[n] >= cutoff.first && runValue[n] <= cutoff.second) {
+                    long end = (n+1 < columnStart[c+1]) ? runStart[n+1] : z;
+                    slabCount[i] += end - runStart[n];
+                }
+            }
+        }
+    }
+
+    long total = 0;
+    for(long i=0; i<x; i++) {
+        total += slabCount[i];
+    }
+    return total;
+}
+
+long puma::RLEWorkspace::countTransitions(char axis, puma::Cutoff cutoff, bool bothWays, int numThreads) const {
+
+    if(numThreads<=0 || numThreads>1000) {
+        numThreads = omp_get_num_procs();
+    }
+
+    std::vector<long> slabCount(x,0);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0; i<x; i++) {
+        for(long j=0; j<y; j++) {
+            long c = i*y+j;
+            if(axis == 'x') {
+                if(i < x-1) { slabCount[i] += columnTransitions(c, c+y, cutoff, bothWays); }
+            } else if(axis == 'y') {
+                if(j < y-1) { slabCount[i] += columnTransitions(c, c+1, cutoff, bothWays); }
+            } else {
+                for(long n=columnStart[c]; n<columnStart[c+1]-1; n++) {
+                    bool inA = runValue[n] >= cutoff.first && runValue[n] <= cutoff.second;
+                    bool inB = runValue[n+1] >= cutoff.first && runValue[n+1] <= cutoff.second;
+                    if((inA && !inB) || (bothWays && inB && !inA)) {
+                        slabCount[i]++;
+                    }
+                }
+            }
+        }
+    }
+
+    long total = 0;
+    for(long i=0; i<x; i++) {
+        total += slabCount[i];
+    }
+    return total;
+}
+
+long puma::RLEWorkspace::columnTransitions(long a, long b, puma::Cutoff cutoff, bool bothWays) const {
+
+    long n = columnStart[a];
+    long m = columnStart[b];
+    long k = 0;
+    long transitions = 0;
+
+    while(k < z) {
+        long endN = (n+1 < columnStart[a+1]) ? runStart[n+1] : z;
+        long endM = (m+1 < columnStart[b+1]) ? runStart[m+1] : z;
+        long end = std::min(endN, endM);
+
+        bool inA = runValue[n] >= cutoff.first && runValue[n] <= cutoff.second;
+        bool inB = runValue[m] >= cutoff.first && runValue[m] <= cutoff.second;
+        if((inA && !inB) || (bothWays && inB && !inA)) {
+            transitions += end - k;
+        }
+
+        k = end;
+        if(endN == end) { n++; }
+        if(endM == end) { m++; }
+    }
+
+    return transitions;
+}
+
+double puma::RLEWorkspace::memoryBytes() const {
+    return (double)columnStart.size()*sizeof(long) + (double)runValue.size()*sizeof(short) + (double)runStart.size()*sizeof(int);
+}
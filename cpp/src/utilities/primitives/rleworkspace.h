@@ -0,0 +1,78 @@
+#ifndef PUMA_RLEWorkspace_H
+#define PUMA_RLEWorkspace_H
+
+#include "workspace.h"
+#include "cutoff.h"
+
+#include <vector>
+
+
+namespace puma {
+
+    //! A segmented domain stored as runs of equal values along the z axis.
+    /*!
+     *  Every (i,j) column is a list of runs, each with its value and its first k. The runs of all the columns are
+     *  kept in two flat arrays, with the runs of column i*Y+j between columnStart[i*Y+j] and columnStart[i*Y+j+1].
+     *  Memory and the cost of the scans below scale with the number of interfaces along z, so a mostly void domain
+     *  is stored with little more than one run per column.
+     *  \sa Workspace
+     */
+    class RLEWorkspace
+    {
+    public:
+
+        RLEWorkspace() = default;
+        explicit RLEWorkspace(Workspace *work, int numThreads = 0);
+
+        //! encodes the matrix of a workspace, replacing the current content.
+        bool fromWorkspace(Workspace *work, int numThreads = 0);
+
+        //! decodes the runs into the matrix of a workspace, which is resized to the domain.
+        bool toWorkspace(Workspace *work, int numThreads = 0) const;
+
+        long X() const { return x; }
+        long Y() const { return y; }
+        long Z() const { return z; }
+        long size() const { return x*y*z; }
+
+        //! value of a single voxel, found by a binary search in its column.
+        short at(long i, long j, long k) const;
+
+        //! total number of runs.
+        long numRuns() const { return (long)runValue.size(); }
+
+        //! the runs of column (i,j) are the indices from runsBegin(i,j) to runsEnd(i,j)-1.
+        long runsBegin(long i, long j) const { return columnStart[i*y+j]; }
+        long runsEnd(long i, long j) const { return columnStart[i*y+j+1]; }
+        short value(long run) const { return runValue[run]; }
+        long start(long run) const { return runStart[run]; }
+
+        //! number of voxels with a value inside the cutoff.
+        long count(puma::Cutoff cutoff, int numThreads = 0) const;
+
+        //! number of pairs of neighbouring voxels along an axis ('x', 'y' or 'z') where the first voxel is inside
+        //! the cutoff and the second (with the larger index) is outside. If bothWays, the reverse pairs are added.
+        long countTransitions(char axis, puma::Cutoff cutoff, bool bothWays, int numThreads = 0) const;
+
+        //! returns the memory used by the runs, in bytes.
+        double memoryBytes() const;
+
+        double voxelLength{1e-6};
+
+    private:
+
+        long x{0};
+        long y{0};
+        long z{0};
+
+        std::vector<long> columnStart;
+        std::vector<short> runValue;
+        std::vector<int> runStart;
+
+        // transitions between the runs of two neighbouring columns, merged along k
+        long columnTransitions(long a, long b, puma::Cutoff cutoff, bool bothWays) const;
+    };
+
+}
+
+#endif // PUMA_RLEWorkspace_H
@@ -0,0 +1,203 @@
+#ifndef PUMA_VoxelKernel_H
+#define PUMA_VoxelKernel_H
+
+#include <iostream>
+#include <omp.h>
+
+
+namespace puma {
+
+    template<class T> class Matrix;
+    template<class T> class MatrixView;
+
+    namespace voxelkernel {
+
+        inline int threads(int numThreads) {
+            return (numThreads<=0 || numThreads>1000) ? omp_get_num_procs() : numThreads;
+        }
+
+        constexpr int minOf(int a) { return a; }
+        template<class... R> constexpr int minOf(int a, int b, R... r) { return minOf(a<b ? a : b, r...); }
+
+        constexpr int maxOf(int a) { return a; }
+        template<class... R> constexpr int maxOf(int a, int b, R... r) { return maxOf(a>b ? a : b, r...); }
+
+        // applies f to the voxels [k1,k2] of the rows [j1,j2] of the slabs [i1,i2], bounds included
+        template<class T, class F>
+        void box(T *values, long strideI, long strideJ, long i1, long i2, long j1, long j2, long k1, long k2,
+                 F f, int numThreads) {
+            omp_set_num_threads(threads(numThreads));
+#pragma omp parallel for schedule(static) firstprivate(f)
+            for(long i=i1; i<=i2; i++) {
+                for(long j=j1; j<=j2; j++) {
+                    T *row = values + strideI*i + strideJ*j;
+                    for(long k=k1; k<=k2; k++) {
+                        f(row[k]);
+                    }
+                }
+            }
+        }
+    }
+
+
+    // Loops over the voxels of a puma::Matrix with the index arithmetic hoisted out of the functor.
+    // The functor f is applied to one voxel at a time and may only write that voxel, so the loops are split over x
+    // with "omp parallel for schedule(static)" (the decomposition used by NUMA first touch) and the innermost loop,
+    // along the contiguous z axis, is left to the compiler to vectorize. The base pointers and strides are loaded once
+    // per loop instead of recomputing zy*i+z*j+k through the Matrix accessors at every voxel.
+    // numThreads <= 0 uses all the processors.
+
+    //! applies f(T &value) to every voxel of the matrix
+    template<class T, class F>
+    bool for_each_voxel(Matrix<T> *matrix, F f, int numThreads = 0) {
+        long size = matrix->size();
+        if(size == 0) {
+            return true;
+        }
+
+        T *values = &matrix->at(0);
+        omp_set_num_threads(voxelkernel::threads(numThreads));
+#pragma omp parallel for schedule(static) firstprivate(f)
+        for(long i=0; i<size; i++) {
+            f(values[i]);
+        }
+        return true;
+    }
+
+    //! applies f(const U &in, T &out) to every pair of voxels of two matrices of the same size
+    template<class U, class T, class F>
+    bool for_each_voxel(Matrix<U> *in, Matrix<T> *out, F f, int numThreads = 0) {
+        if(in->X() != out->X() || in->Y() != out->Y() || in->Z() != out->Z()) {
+            std::cout << "Error in for_each_voxel: matrices must have the same size" << std::endl;
+            return false;
+        }
+
+        long size = in->size();
+        if(size == 0) {
+            return true;
+        }
+
+        const U *inValues = &in->at(0);
+        T *outValues = &out->at(0);
+        omp_set_num_threads(voxelkernel::threads(numThreads));
+#pragma omp parallel for schedule(static) firstprivate(f)
+        for(long i=0; i<size; i++) {
+            f(inValues[i], outValues[i]);
+        }
+        return true;
+    }
+
+    //! applies f(T &value) to the voxels of the box [x1,x2] x [y1,y2] x [z1,z2], bounds included. The box is not checked.
+    template<class T, class F>
+    bool for_each_voxel(Matrix<T> *matrix, long x1, long x2, long y1, long y2, long z1, long z2, F f, int numThreads = 0) {
+        if(matrix->size() == 0 || x1 > x2 || y1 > y2 || z1 > z2) {
+            return true;
+        }
+        voxelkernel::box(&matrix->at(0), matrix->ZY(), matrix->Z(), x1, x2, y1, y2, z1, z2, f, numThreads);
+        return true;
+    }
+
+    //! applies f(T &value) to every voxel of the view
+    template<class T, class F>
+    bool for_each_voxel(MatrixView<T> *view, F f, int numThreads = 0) {
+        if(view->size() == 0) {
+            return true;
+        }
+        voxelkernel::box(&view->at(0,0,0), view->strideI(), view->strideJ(),
+                         0, view->X()-1, 0, view->Y()-1, 0, view->Z()-1, f, numThreads);
+        return true;
+    }
+
+
+    //! a neighbour at a fixed offset from the voxel a stencil is applied to
+    template<int DI, int DJ, int DK>
+    struct Offset {
+        enum { i = DI, j = DJ, k = DK };
+    };
+
+    //! the neighbourhood a stencil reads, given as a list of Offset. The voxel itself is always part of it.
+    template<class... Offsets>
+    struct Shape {
+        enum {
+            iMin = voxelkernel::minOf(0, Offsets::i...), iMax = voxelkernel::maxOf(0, Offsets::i...),
+            jMin = voxelkernel::minOf(0, Offsets::j...), jMax = voxelkernel::maxOf(0, Offsets::j...),
+            kMin = voxelkernel::minOf(0, Offsets::k...), kMax = voxelkernel::maxOf(0, Offsets::k...)
+        };
+    };
+
+    //! the neighbourhood of one voxel, as passed by for_each_stencil. The offsets are compile time constants, so
+    //! at<-1,0,0>() is a single load at a fixed distance from the voxel, and offsets outside of the shape S are
+    //! rejected by the compiler.
+    template<class T, class S>
+    class Stencil
+    {
+    public:
+
+        Stencil(const T *centre, long strideI, long strideJ, long i, long j, long k)
+            : i(i), j(j), k(k), centre(centre), strideI(strideI), strideJ(strideJ) { }
+
+        template<int DI, int DJ, int DK>
+        const T& at() const {
+            static_assert(DI >= S::iMin && DI <= S::iMax && DJ >= S::jMin && DJ <= S::jMax && DK >= S::kMin && DK <= S::kMax,
+                          "Stencil::at: offset outside of the stencil shape");
+            return centre[DI*strideI + DJ*strideJ + DK];
+        }
+
+        const T& operator()() const { return *centre; }
+
+        //! position of the voxel in the input matrix
+        const long i;
+        const long j;
+        const long k;
+
+    private:
+
+        const T *centre;
+        long strideI;
+        long strideJ;
+    };
+
+    //! applies f(const Stencil<T,S> &in, U &out) to every voxel (i,j,k) of in whose neighbourhood S lies inside in,
+    //! with out written at the same (i,j,k). out may be larger than in (e.g. the face conductances of a voxel grid).
+    /*!
+     *  e.g. the harmonic mean across the x faces:
+     *  for_each_stencil<Shape<Offset<-1,0,0>>>(&k, &kX, [](const Stencil<double,Shape<Offset<-1,0,0>>> &s, double &f) {
+     *      f = s() * s.at<-1,0,0>() / (s() + s.at<-1,0,0>());
+     *  });
+     */
+    template<class S, class T, class U, class F>
+    bool for_each_stencil(Matrix<T> *in, Matrix<U> *out, F f, int numThreads = 0) {
+        long iBegin = -S::iMin, iEnd = in->X() - S::iMax;
+        long jBegin = -S::jMin, jEnd = in->Y() - S::jMax;
+        long kBegin = -S::kMin, kEnd = in->Z() - S::kMax;
+
+        if(out->X() < iEnd || out->Y() < jEnd || out->Z() < kEnd) {
+            std::cout << "Error in for_each_stencil: output matrix smaller than the input" << std::endl;
+            return false;
+        }
+        if(iBegin >= iEnd || jBegin >= jEnd || kBegin >= kEnd) {
+            return true;
+        }
+
+        const T *inValues = &in->at(0);
+        U *outValues = &out->at(0);
+        long inI = in->ZY(), inJ = in->Z();
+        long outI = out->ZY(), outJ = out->Z();
+
+        omp_set_num_threads(voxelkernel::threads(numThreads));
+#pragma omp parallel for schedule(static) firstprivate(f)
+        for(long i=iBegin; i<iEnd; i++) {
+            for(long j=jBegin; j<jEnd; j++) {
+                const T *inRow = inValues + inI*i + inJ*j;
+                U *outRow = outValues + outI*i + outJ*j;
+                for(long k=kBegin; k<kEnd; k++) {
+                    f(Stencil<T,S>(inRow + k, inI, inJ, i, j, k), outRow[k]);
+                }
+            }
+        }
+        return true;
+    }
+
+}
+
+#endif // PUMA_VoxelKernel_H
@@ -5,6 +5,10 @@
 #include "matrix.h"
 #include "Printer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 
 namespace puma {
 
@@ -19,7 +23,6 @@ namespace puma {
             matrix.resize(x,y,z,val);
             log->emptyLog();
             this->voxelLength = voxelLength;
-            printer = new puma::Printer();
         }
 
         Workspace(long x, long y, long z, double voxelLength) {
@@ -27,7 +30,6 @@ namespace puma {
             matrix.resize(x,y,z,0);
             log->emptyLog();
             this->voxelLength = voxelLength;
-            printer = new puma::Printer();
         }
 
         explicit Workspace(double voxelLength) {
@@ -35,7 +37,6 @@ namespace puma {
             matrix.resize(0,0,0,0);
             log->emptyLog();
             this->voxelLength = voxelLength;
-            printer = new puma::Printer();
         }
 
         Workspace() {
@@ -43,7 +44,6 @@ namespace puma {
             matrix.resize(0,0,0,0);
             log->emptyLog();
             this->voxelLength = 1e-6;
-            printer = new puma::Printer();
         }
 
         explicit Workspace(Workspace *other) {
@@ -51,7 +51,6 @@ namespace puma {
             matrix.copy(&other->matrix);
             log->emptyLog();
             this->voxelLength = 1e-6;
-            printer = new puma::Printer();
         }
 
         explicit Workspace(const puma::Vec3<long>& shape) {
@@ -59,7 +58,6 @@ namespace puma {
             matrix.resize(shape.x,shape.y,shape.z,0);
             log->emptyLog();
             this->voxelLength = 1e-6;
-            printer = new puma::Printer();
         }
 
         Workspace(long x, long y, long z, short val, double voxelLength, Logger *otherLog) {
@@ -67,7 +65,6 @@ namespace puma {
             matrix.resize(x,y,z,val);
             this->voxelLength = voxelLength;
             myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(long x, long y, long z, double voxelLength, Logger *otherLog) {
@@ -75,7 +72,6 @@ namespace puma {
             matrix.resize(x,y,z,0);
             this->voxelLength = voxelLength;
             myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(double voxelLength, Logger *otherLog) {
@@ -83,7 +79,6 @@ namespace puma {
             matrix.resize(0,0,0,0);
             this->voxelLength = voxelLength;
             myLogger = false;
-            printer = new puma::Printer();
         }
 
         explicit Workspace(Logger *otherLog) {
@@ -91,7 +86,6 @@ namespace puma {
             matrix.resize(0,0,0,0);
             this->voxelLength = 1e-6;
             myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(Workspace *other, Logger *otherLog) {
@@ -99,7 +93,6 @@ namespace puma {
             matrix.copy(&other->matrix);
             this->voxelLength = 1e-6;
             myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(const puma::Vec3<long>& shape, Logger *otherLog) {
@@ -107,7 +100,6 @@ namespace puma {
             matrix.resize(shape.x,shape.y,shape.z,0);
             this->voxelLength = 1e-6;
             myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(long x, long y, long z, short val, double voxelLength, bool logBool) {
@@ -115,8 +107,6 @@ namespace puma {
             matrix.resize(x,y,z,val);
             log->emptyLog();
             this->voxelLength = voxelLength;
-            myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(long x, long y, long z, double voxelLength, bool logBool) {
@@ -124,8 +114,6 @@ namespace puma {
             matrix.resize(x,y,z,0);
             log->emptyLog();
             this->voxelLength = voxelLength;
-            myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(double voxelLength, bool logBool) {
@@ -133,8 +121,6 @@ namespace puma {
             matrix.resize(0,0,0,0);
             log->emptyLog();
             this->voxelLength = voxelLength;
-            myLogger = false;
-            printer = new puma::Printer();
         }
 
         explicit Workspace(bool logBool) {
@@ -142,8 +128,6 @@ namespace puma {
             matrix.resize(0,0,0,0);
             log->emptyLog();
             this->voxelLength = 1e-6;
-            myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(Workspace *other, bool logBool) {
@@ -151,8 +135,6 @@ namespace puma {
             matrix.copy(&other->matrix);
             log->emptyLog();
             this->voxelLength = 1e-6;
-            myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(const puma::Vec3<long>& shape, bool logBool) {
@@ -160,8 +142,6 @@ namespace puma {
             matrix.resize(shape.x,shape.y,shape.z,0);
             log->emptyLog();
             this->voxelLength = 1e-6;
-            myLogger = false;
-            printer = new puma::Printer();
         }
 
         Workspace(const puma::Vec3<long>& shape, double voxelLength, bool logBool) {
@@ -169,13 +149,42 @@ namespace puma {
             matrix.resize(shape.x,shape.y,shape.z,0);
             log->emptyLog();
             this->voxelLength = voxelLength;
-            myLogger = false;
-            printer = new puma::Printer();
         }
 
+        // a moved from workspace is left empty, with an inactive logger
+        Workspace(Workspace &&other) noexcept : Workspace(false) {
+            swap(other);
+        }
+
+        Workspace& operator=(Workspace &&other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        // the logger and printer are owned through pointers, so a workspace is only copied explicitly with Workspace(Workspace *other)
+        Workspace(const Workspace &other) = delete;
+        Workspace& operator=(const Workspace &other) = delete;
+
         ~Workspace() {
             if(myLogger) { delete log; }
             if(myPrinter) { delete printer; }
+            modified();
+        }
+
+        void swap(Workspace &other) noexcept {
+            // the coarse levels follow the voxels they were built from
+            bool mineValid = pyramidGeneration == matrix.generation();
+            bool theirsValid = other.pyramidGeneration == other.matrix.generation();
+            matrix.swap(other.matrix);
+            std::swap(log, other.log);
+            std::swap(printer, other.printer);
+            std::swap(myPrinter, other.myPrinter);
+            std::swap(myLogger, other.myLogger);
+            std::swap(voxelLength, other.voxelLength);
+            std::swap(pyramid, other.pyramid);
+            std::swap(pyramidPooling, other.pyramidPooling);
+            pyramidGeneration = theirsValid ? matrix.generation() : 0;
+            other.pyramidGeneration = mineValid ? other.matrix.generation() : 0;
         }
 
         // --- End Constructors --- //
@@ -186,18 +195,103 @@ namespace puma {
 
         puma::Matrix<short> matrix;
         puma::Logger *log;
-        puma::Printer *printer;
-        bool myPrinter{true};
+        puma::Printer *printer{defaultPrinter()};
+        bool myPrinter{false};
         bool myLogger{true};
 
         double voxelLength;
 
         // --- End Variables --- //
 
+    private:
+
+        // coarse levels, see coarse(), with the pooling and the matrix generation they were built from
+        std::vector<Workspace*> pyramid;
+        char pyramidPooling{'a'};
+        unsigned long long pyramidGeneration{0};
+
+        // pools the 2x2x2 blocks of the workspace into a new workspace with half the resolution
+        Workspace* pooled(char pooling, int numThreads) {
+            long X = matrix.X(), Y = matrix.Y(), Z = matrix.Z();
+            long cX = (X+1)/2, cY = (Y+1)/2, cZ = (Z+1)/2;
+            Workspace *level = new Workspace(cX, cY, cZ, 0, 2*voxelLength, false);
+
+            if(numThreads<=0 || numThreads>1000) {
+                numThreads = omp_get_num_procs();
+            }
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0; i<cX; i++) {
+                for(long j=0; j<cY; j++) {
+                    bool fullRows = (2*i+1 < X) && (2*j+1 < Y);
+                    for(long k=0; k<cZ; k++) {
+                        short values[8] = {};
+                        int count = 0;
+                        if(fullRows && 2*k+1 < Z) {
+                            // interior block, read as two voxels from each of the four rows along k
+                            for(long a=2*i; a<2*i+2; a++) {
+                                for(long b=2*j; b<2*j+2; b++) {
+                                    const short *row = &matrix.at(a,b,2*k);
+                                    values[count++] = row[0];
+                                    values[count++] = row[1];
+                                }
+                            }
+                        } else {
+                            for(long a=2*i; a<std::min(2*i+2,X); a++) {
+                                for(long b=2*j; b<std::min(2*j+2,Y); b++) {
+                                    for(long c=2*k; c<std::min(2*k+2,Z); c++) {
+                                        values[count++] = matrix(a,b,c);
+                                    }
+                                }
+                            }
+                        }
+                        level->matrix(i,j,k) = (pooling == 'm') ? majority(values, count) : mean(values, count);
+                    }
+                }
+            }
+            return level;
+        }
+
+        static short mean(const short *values, int count) {
+            int sum = 0;
+            for(int n=0; n<count; n++) {
+                sum += values[n];
+            }
+            return (short)std::lround((double)sum/count);
+        }
+
+        static short majority(const short *values, int count) {
+            // most blocks of a segmented domain hold a single material
+            int same = 1;
+            while(same < count && values[same] == values[0]) {
+                same++;
+            }
+            if(same == count) {
+                return values[0];
+            }
+
+            short best = values[0];
+            int bestCount = 0;
+            for(int n=0; n<count; n++) {
+                int occurrences = 0;
+                for(int m=0; m<count; m++) {
+                    occurrences += (values[m] == values[n]);
+                }
+                if(occurrences > bestCount || (occurrences == bestCount && values[n] < best)) {
+                    best = values[n];
+                    bestCount = occurrences;
+                }
+            }
+            return best;
+        }
+
+    public:
+
 
         // --- Start Functions --- //
 
         void newWorkspace(double voxelLength) {
+            modified();
             matrix.resize(0,0,0,0);
             log->emptyLog();
             this->voxelLength = voxelLength;
@@ -209,14 +303,22 @@ namespace puma {
 
         void setPrinter(puma::Printer *print) {
             std::cout << "Printer changed to user input" << std::endl;
+            if(myPrinter) { delete printer; }
             printer = print;
             myPrinter = false;
         }
 
         void newPrinter() {
             std::cout << "Printer returned to default" << std::endl;
-            printer = new puma::Printer();
-            myPrinter = true;
+            if(myPrinter) { delete printer; }
+            printer = defaultPrinter();
+            myPrinter = false;
+        }
+
+        // the default printer is stateless, so every workspace shares one instead of allocating its own
+        static puma::Printer* defaultPrinter() {
+            static puma::Printer printer;
+            return &printer;
         }
 
         short operator() (long i, long j, long k) { return matrix(i,j,k); }
@@ -244,6 +346,7 @@ namespace puma {
         double average() { return matrix.average(); }
 
         bool crop(long x1, long x2, long y1, long y2, long z1, long z2) {
+            modified();
             return matrix.crop(x1,x2,y1,y2,z1,z2);
         }
 
@@ -252,6 +355,7 @@ namespace puma {
                 std::cout << "Invalid size. X, Y, and Z must be >0" << std::endl;
                 return;
             }
+            modified();
             matrix.resize(X,Y,Z,0);
         }
 
@@ -260,6 +364,7 @@ namespace puma {
                 std::cout << "Invalid size. X, Y, and Z must be >0" << std::endl;
                 return;
             }
+            modified();
             matrix.resize(X,Y,Z,0);
         }
 
@@ -272,23 +377,14 @@ namespace puma {
                 return;
             }
 
-            int X = (int)matrix.X();
-            int Y = (int)matrix.Y();
-            int Z = (int)matrix.Z();
-
-#pragma omp parallel for
-            for(long i=0; i<X; i++) {
-                for(long j=0; j<Y; j++) {
-                    for(long k=0; k<Z; k++) {
-
-                        short value = matrix(i,j,k);
-                        if(value <= cutoff.second && value >= cutoff.first) {
-                            matrix(i,j,k) = identifier;
-                        }
-                    }
-                }
-            }
+            modified();
 
+            float low = cutoff.first, high = cutoff.second;
+            short id = (short)identifier;
+            // the voxel is always stored, so the loop has no branch and vectorizes
+            puma::for_each_voxel(&matrix, [low,high,id](short &value) {
+                value = (value <= high && value >= low) ? id : value;
+            }, omp_get_max_threads());
         }
 
         void setMaterialID(Workspace *other, puma::Cutoff cutoff, int identifier) {
@@ -299,25 +395,63 @@ namespace puma {
                 return;
             }
 
-            int X = (int)matrix.X();
-            int Y = (int)matrix.Y();
-            int Z = (int)matrix.Z();
+            modified();
 
-#pragma omp parallel for
-            for(long i=0; i<X; i++) {
-                for(long j=0; j<Y; j++) {
-                    for(long k=0; k<Z; k++) {
+            float low = cutoff.first, high = cutoff.second;
+            short id = (short)identifier;
+            puma::for_each_voxel(&other->matrix, &matrix, [low,high,id](const short &value, short &result) {
+                result = (value <= high && value >= low) ? id : result;
+            }, omp_get_max_threads());
+        }
 
-                        short value = other->matrix(i,j,k);
-                        if(value <= cutoff.second && value >= cutoff.first) {
-                            matrix(i,j,k) = identifier;
-                        }
-                    }
-                }
+
+        //! returns a copy of the domain downsampled by factor (2, 4, 8, ... a power of two), owned by the workspace.
+        /*!
+         *  The levels form a pyramid: each one pools the 2x2x2 blocks of the level below ('a' for the rounded mean,
+         *  'm' for the most frequent value, the smallest one on ties), and blocks cut by the domain faces pool the
+         *  voxels they contain, so every level has ceil(X/factor) voxels along x. The voxel length of a level is
+         *  voxelLength*factor, so the property functions can run on it directly for a quick estimate.
+         *  Levels are built on first use and kept until the workspace is modified. The Workspace functions that
+         *  change the voxels, and the filters, invalidate them. A level built before the matrix was resized, copied,
+         *  set or swapped (see Matrix::generation) is rebuilt, but after writing voxels directly through matrix
+         *  with operator() or at(), modified() has to be called.
+         *  \param factor the downsampling factor, 1 returns the workspace itself
+         *  \param pooling 'a' for mean pooling (grayscale) or 'm' for majority pooling (segmented)
+         *  \return the coarse workspace, or nullptr if the factor or pooling is invalid
+         */
+        Workspace* coarse(int factor, char pooling = 'a', int numThreads = 0) {
+            if(factor < 1 || (factor & (factor-1)) != 0 || (pooling != 'a' && pooling != 'm')) {
+                std::cout << "Error in Workspace::coarse: factor must be a power of two and pooling 'a' or 'm'" << std::endl;
+                return nullptr;
+            }
+            if(factor == 1) {
+                return this;
+            }
+
+            if(pooling != pyramidPooling || matrix.generation() != pyramidGeneration) {
+                modified();
+                pyramidPooling = pooling;
+                pyramidGeneration = matrix.generation();
             }
 
+            // level n is downsampled by 2^(n+1), and is built from level n-1
+            Workspace *level = this;
+            for(size_t n=0; (2L << n) <= factor; n++) {
+                if(n == pyramid.size()) {
+                    pyramid.push_back(level->pooled(pooling, numThreads));
+                }
+                level = pyramid[n];
+            }
+            return level;
         }
 
+        //! drops the coarse levels, to be called after writing voxels directly through matrix
+        void modified() {
+            for(Workspace *level : pyramid) {
+                delete level;
+            }
+            pyramid.clear();
+        }
 
         // --- End Functions --- //
 
@@ -0,0 +1,70 @@
+#ifndef PUMA_WorkspaceView_H
+#define PUMA_WorkspaceView_H
+
+#include "workspace.h"
+#include "matrixview.h"
+
+
+namespace puma {
+
+    //! A non-owning window on a box of a puma::Workspace, e.g. one sub-volume of a representative volume study.
+    /*!
+     *  The view shares the voxels, voxel length and logger of its workspace. Properties computed on a view treat the
+     *  box as the whole domain (exactly as on a workspace cropped to the box), and filters applied to a view write
+     *  their result back into the box, leaving the rest of the workspace unchanged.
+     *  \sa Workspace, MatrixView
+     */
+    class WorkspaceView
+    {
+    public:
+
+        WorkspaceView() = default;
+
+        //! view of the whole workspace
+        explicit WorkspaceView(Workspace *work) : WorkspaceView(work,0,-1,0,-1,0,-1) { }
+
+        //! view of the box [x1,x2] x [y1,y2] x [z1,z2], bounds included as in Workspace::crop
+        WorkspaceView(Workspace *work, long x1, long x2, long y1, long y2, long z1, long z2)
+            : matrix(&work->matrix,x1,x2,y1,y2,z1,z2) {
+            this->work = work;
+            log = work->log;
+            voxelLength = work->voxelLength;
+        }
+
+        short operator() (long i, long j, long k) const { return matrix(i,j,k); }
+
+        long X() const { return matrix.X(); }
+        long Y() const { return matrix.Y(); }
+        long Z() const { return matrix.Z(); }
+        long size() const { return matrix.size(); }
+
+        Workspace* source() const { return work; }
+
+        bool isMapped() const { return work != nullptr && work->matrix.isMapped(); }
+
+        //! stores a result of the size of the view into the box. A view of a whole workspace on the heap takes over
+        //! the storage of result by a swap, so result is left with the previous voxels. The coarse levels of the
+        //! workspace are dropped.
+        bool assign(Matrix<short> *result, int numThreads = 0) {
+            work->modified();
+            if(matrix.isWhole() && !isMapped() && result->X() == X() && result->Y() == Y() && result->Z() == Z()) {
+                work->matrix.swap(*result);
+                // the swap moved the storage, so the view is pointed at the new one
+                matrix = MatrixView<short>(&work->matrix);
+                return true;
+            }
+            return matrix.copyFrom(result, numThreads);
+        }
+
+        MatrixView<short> matrix;
+        Logger *log{nullptr};
+        double voxelLength{1e-6};
+
+    private:
+
+        Workspace *work{nullptr};
+    };
+
+}
+
+#endif // PUMA_WorkspaceView_H
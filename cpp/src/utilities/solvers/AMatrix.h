@@ -3,12 +3,16 @@
 
 #include "matrix.h"
 
+#include <vector>
+
 
 //! An abstract class representing a linear system.
 class AMatrix
 {
 public:
 
+    virtual ~AMatrix() = default;
+
     //! multiplies the linear system by a vector.
     /*!
      * \param x a pointer to a puma matrix that is multiplied by the linear system.
@@ -18,6 +22,108 @@ public:
     virtual bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) = 0;
     virtual bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) = 0;
 
+    //! multiplies several vectors at once, vector s by system s of the operator (used by the block solvers).
+    /*!
+     * The default applies A_times_X to each vector. Operators which hold several systems sharing their coefficients
+     * override it to go over the coefficients only once.
+     * \param x a pointer to a vector of puma matrices that are multiplied by the linear system. nullptr entries are skipped.
+     * \param r a pointer to a vector of puma matrices where the solutions are stored.
+     * \return a boolean indicating the function executed without errors.
+     */
+    virtual bool A_times_X(std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *r) {
+        for(size_t s=0;s<x->size();s++) {
+            if(x->at(s) && !A_times_X(x->at(s), r->at(s))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    virtual bool Minv_times_X(std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *r) {
+        for(size_t s=0;s<x->size();s++) {
+            if(x->at(s) && !Minv_times_X(x->at(s), r->at(s))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //! single precision versions of A_times_X and Minv_times_X, used by the inner iterations of the mixed precision solvers.
+    /*!
+     * The default goes through the double precision product, on copies of the vectors allocated for each call, which
+     * gives the right result but none of the savings.
+     * Operators which are limited by memory bandwidth override them with single precision kernels.
+     * \param x a pointer to a puma matrix that is multiplied by the linear system.
+     * \param r a pointer to a puma matrix where the solution is stored.
+     * \return a boolean indicating the function executed without errors.
+     */
+    virtual bool A_times_X(puma::Matrix<float> *x, puma::Matrix<float> *r) {
+        puma::Matrix<double> xDouble, rDouble(r->X(), r->Y(), r->Z());
+        toDouble(x, &xDouble);
+        if(!A_times_X(&xDouble, &rDouble)) {
+            return false;
+        }
+        toFloat(&rDouble, r);
+        return true;
+    }
+
+    virtual bool Minv_times_X(puma::Matrix<float> *x, puma::Matrix<float> *r) {
+        puma::Matrix<double> xDouble, rDouble(r->X(), r->Y(), r->Z());
+        toDouble(x, &xDouble);
+        if(!Minv_times_X(&xDouble, &rDouble)) {
+            return false;
+        }
+        toFloat(&rDouble, r);
+        return true;
+    }
+
+    //! computes the dot product of two vectors the operator applies to, used by the iterative solvers for every reduction.
+    /*!
+     * Operators whose vectors only hold part of the unknowns (e.g. one slab of a distributed domain) override it to
+     * sum over all the parts.
+     */
+    virtual double dot(puma::Matrix<double> *x, puma::Matrix<double> *y, int numThreads = 0) {
+        return x->dot(y, numThreads);
+    }
+
+    //! estimates the bytes read and written by one call to A_times_X on x, used by SolverTelemetry.
+    /*!
+     * The default counts one read of x and one write of the result. Operators which read coefficients override it.
+     * \param x a pointer to a puma matrix of the size of the vectors the operator is applied to.
+     * \return the estimated number of bytes.
+     */
+    virtual double productBytes(puma::Matrix<double> *x) {
+        return 2. * x->size() * sizeof(double);
+    }
+
+    //! relaxes the unknowns of one colour of a red-black ordering of A x = b, used by IterativeSolver::SOR_RedBlack.
+    /*!
+     * Computes x += omega * Minv * (b - A x) on the unknowns of the given colour. The default does nothing and
+     * returns false, for operators whose unknowns cannot be split into two independent colours.
+     * \param x a pointer to a puma matrix holding the current iterate, updated in place.
+     * \param b a pointer to a puma matrix holding the right-hand side.
+     * \param color 0 for red unknowns, 1 for black unknowns.
+     * \param omega the relaxation factor.
+     * \return a boolean indicating whether the operator supports red-black relaxation.
+     */
+    virtual bool relaxRedBlack(puma::Matrix<double> * /*x*/, puma::Matrix<double> * /*b*/, int /*color*/, double /*omega*/) {
+        return false;
+    }
+
+private:
+    static void toDouble(puma::Matrix<float> *src, puma::Matrix<double> *dst) {
+        dst->resize(src->X(), src->Y(), src->Z());
+        for(long i=0;i<src->size();i++) {
+            dst->at(i) = src->at(i);
+        }
+    }
+
+    static void toFloat(puma::Matrix<double> *src, puma::Matrix<float> *dst) {
+        for(long i=0;i<src->size();i++) {
+            dst->at(i) = (float)src->at(i);
+        }
+    }
+
 };
 
 #endif // AMATRIX_H
@@ -1,5 +1,8 @@
 #include "ej_diffusion.h"
 
+#include <iomanip>
+#include <sstream>
+
 
 
 EJ_Diffusion::EJ_Diffusion(puma::Matrix<double> *T, puma::Matrix<double> *kMat, char dir, double solverTol, int solverMaxIt, bool print, int numThreads)
@@ -93,7 +96,12 @@ bool EJ_Diffusion::setupJAndF(EJ_AMatrix *A) {
 }
 
 bool EJ_Diffusion::runIterativeSolver(EJ_AMatrix *A) {
-    IterativeSolver::BiCGSTAB(A,&J,&F,solverTol,solverMaxIt,print, printer,numThreads);
+    if(checkpoint) {
+        std::stringstream settings;
+        settings << "EJ_Diffusion " << dir << ' ' << kMat->X() << ' ' << kMat->Y() << ' ' << kMat->Z() << ' ' << std::setprecision(17) << solverTol;
+        checkpoint->setOperator(kMat, settings.str());
+    }
+    IterativeSolver::BiCGSTAB(A,&J,&F,solverTol,solverMaxIt,print, printer, checkpoint, telemetry, numThreads);
     return true;
 }
 
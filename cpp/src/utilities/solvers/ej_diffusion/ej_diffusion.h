@@ -38,6 +38,12 @@ public:
      * \return a puma vector containing the diffusion coefficient in the x, y, and z directions.
      */
     puma::Vec3<double> compute_DiffusionCoefficient();
+
+    //! saves the state of BiCGSTAB (including the jumps the temperature field is computed from) to a checkpoint file, and resumes from it.
+    void setCheckpoint(puma::SolverCheckpoint *checkpoint) { this->checkpoint = checkpoint; }
+
+    //! records the residual and the time breakdown of each iteration of BiCGSTAB.
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
     
     //! computes a puma matrix which contains the diffusion coefficient at each cell in the domain.
     /*!
@@ -103,6 +109,12 @@ private:
     //! Specifies the number of threads used for the simulation.
     int numThreads;
 
+    //! An optional checkpoint policy for the solver (nullptr if unused).
+    puma::SolverCheckpoint *checkpoint{nullptr};
+
+    //! An optional recorder of the solver iterations (nullptr if unused).
+    puma::SolverTelemetry *telemetry{nullptr};
+
     //! Runs BiCGSTAB
     /*!
      * \param A a pointer to an EJ_AMatrix which represents the linear system to be solved by BiCGSTAB.
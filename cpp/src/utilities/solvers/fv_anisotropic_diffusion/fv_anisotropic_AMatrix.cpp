@@ -1,110 +1,135 @@
 #include "fv_anisotropic_AMatrix.h"
 
 
-FV_anisotropic_AMatrix::FV_anisotropic_AMatrix(puma::Matrix<std::vector<double>> *E_Matrix, puma::Matrix<std::vector<double>> *flux_Matrix, std::vector<long> startend, std::string sideBC, int numThreads) {
-    this->E_Matrix = E_Matrix;
-    this->flux_Matrix = flux_Matrix;
+FV_anisotropic_AMatrix::FV_anisotropic_AMatrix(puma::Matrix<int> *E_Index, std::vector<double> *E_Table, std::vector<long> startend, std::string sideBC, int numThreads) {
+    this->E_Index = E_Index;
+    this->E_Table = E_Table;
     this->numThreads = numThreads;
-    this->X = (int)E_Matrix->X()-1;
-    this->Y = (int)E_Matrix->Y()-1;
-    this->Z = (int)E_Matrix->Z()-1;
+    this->X = (int)E_Index->X()-1;
+    this->Y = (int)E_Index->Y()-1;
+    this->Z = (int)E_Index->Z()-1;
     this->startend = std::move(startend);
     this->sideBC = std::move(sideBC);
+    this->symmetric = this->sideBC == "s";
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-bool FV_anisotropic_AMatrix::computeQuadrantFluxes(puma::Matrix<double> *x) {
-
-    //     Execute q=E*T
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(long i=startend[0];i<startend[1];i++){
-        std::vector<double> N(8);
-        std::vector<double> q(12);
-        for(long j=startend[2];j<startend[3];j++){
-            for(long k=startend[4];k<startend[5];k++){
-
-                // 12x8 * 8x1
-                N[0] = (*x).at(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k-1,Z));  // Cell P
-                N[1] = (*x).at(indexAt(i,X),indexAt(j-1,Y),indexAt(k-1,Z));    // Cell E
-                N[2] = (*x).at(indexAt(i-1,X),indexAt(j,Y),indexAt(k-1,Z));    // Cell N
-                N[3] = (*x).at(indexAt(i,X),indexAt(j,Y),indexAt(k-1,Z));      // Cell NE
-                N[4] = (*x).at(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k,Z));    // Cell T
-                N[5] = (*x).at(indexAt(i,X),indexAt(j-1,Y),indexAt(k,Z));      // Cell TE
-                N[6] = (*x).at(indexAt(i-1,X),indexAt(j,Y),indexAt(k,Z));      // Cell TN
-                N[7] = (*x).at(indexAt(i,X),indexAt(j,Y),indexAt(k,Z));        // Cell TNE
-
-                // Multiply EMatrix[Z*(Y*i+j)+k] by the N vector of temperatures defined above
+/* Description: Computes q=E*T for the nodes (voxel corners) of the x plane i, 12 fluxes per node:
+ *      qxPtne, qxNtse, qxTbne, qxTNbse, qyPtne, qyEtnw, qyTbne, qyTEbnw, qzPtne, qzEtnw, qzNtse, qzNEtsw.
+ *      Nodes outside the range of startend have zero fluxes. Called by all the threads of a parallel region,
+ *      which share the loop over j.
+ * Inputs:
+ *      x - Matrix of temperatures
+ *      i - index of the plane of nodes
+ * Outputs:
+ *      q - the fluxes of node (i,j,k) at q[12*(j*(Z+1)+k)]
+ */
+void FV_anisotropic_AMatrix::computeNodeFluxes(puma::Matrix<double> *x, long i, double *q) {
+
+#pragma omp for
+    for(long j=0;j<=Y;j++){
+        double N[8];
+        for(long k=0;k<=Z;k++){
+            double *qNode = &q[12*(j*(Z+1)+k)];
+            int node = E_Index->at(i,j,k);
+            if(node < 0) {
                 for(int i2=0;i2<12;i2++) {
-                    q[i2] = 0;
-                    for(int j2=0;j2<8;j2++) {
-                        if(!std::isnan(E_Matrix->at(i,j,k)[8*i2+j2]) && !std::isinf(E_Matrix->at(i,j,k)[8*i2+j2])) { q[i2] += E_Matrix->at(i,j,k)[8*i2+j2] * N[j2]; }
-                    }
-                }
-
-                // Assigning fluxes to the flux_Matrix
-                long i2 = i-1; long j2 = j-1; long k2 = k-1; // Cell P
-                if(i2>=0 && j2>=0 && k2>=0 && i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[0] = q[0]; // qxPtne
-                    flux_Matrix->at(i2,j2,k2)[0+8] = q[4]; // qyPtne
-                    flux_Matrix->at(i2,j2,k2)[0+16] = q[8]; // qzPtne
+                    qNode[i2] = 0;
                 }
+                continue;
+            }
 
-                i2 = i; j2 = j-1; k2 = k-1; // Cell E
-                if(j2>=0 && k2>=0 && i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[1] = q[0]; // qxPtne
-                    flux_Matrix->at(i2,j2,k2)[1+8] = q[5]; // qyEtnw
-                    flux_Matrix->at(i2,j2,k2)[1+16] = q[9]; // qzEtnw
+            // 12x8 * 8x1
+            N[0] = (*x).at(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k-1,Z));  // Cell P
+            N[1] = (*x).at(indexAt(i,X),indexAt(j-1,Y),indexAt(k-1,Z));    // Cell E
+            N[2] = (*x).at(indexAt(i-1,X),indexAt(j,Y),indexAt(k-1,Z));    // Cell N
+            N[3] = (*x).at(indexAt(i,X),indexAt(j,Y),indexAt(k-1,Z));      // Cell NE
+            N[4] = (*x).at(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k,Z));    // Cell T
+            N[5] = (*x).at(indexAt(i,X),indexAt(j-1,Y),indexAt(k,Z));      // Cell TE
+            N[6] = (*x).at(indexAt(i-1,X),indexAt(j,Y),indexAt(k,Z));      // Cell TN
+            N[7] = (*x).at(indexAt(i,X),indexAt(j,Y),indexAt(k,Z));        // Cell TNE
+
+            // Multiply the stencil of the node by the N vector of temperatures defined above
+            // (non finite coefficients were zeroed when the stencils were computed)
+            const double *E = &(*E_Table)[96*(size_t)node];
+            for(int i2=0;i2<12;i2++) {
+                qNode[i2] = 0;
+                for(int j2=0;j2<8;j2++) {
+                    qNode[i2] += E[8*i2+j2] * N[j2];
                 }
+            }
+        }
+    }
+}
 
-                i2 = i-1; j2 = j; k2 = k-1; // Cell N
-                if(i2>=0  && k2>=0 && i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[2] = q[1]; // qxNtse
-                    flux_Matrix->at(i2,j2,k2)[2+8] = q[4]; // qyPtne
-                    flux_Matrix->at(i2,j2,k2)[2+16] = q[10]; // qzNtse
-                }
 
-                i2 = i; j2 = j; k2 = k-1; // Cell NE
-                if(k2>=0 && i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[3] = q[1]; // qxNtse
-                    flux_Matrix->at(i2,j2,k2)[3+8] = q[5]; // qyEtnw
-                    flux_Matrix->at(i2,j2,k2)[3+16] = q[11]; // qzNEtsw
-                }
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-                i2 = i-1; j2 = j-1; k2 = k; // Cell T
-                if(i2>=0 && j2>=0 && i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[4] = q[2]; // qxTbne
-                    flux_Matrix->at(i2,j2,k2)[4+8] = q[6]; // qyTbne
-                    flux_Matrix->at(i2,j2,k2)[4+16] = q[8]; // qzPtne
-                }
 
-                i2 = i; j2 = j-1; k2 = k; // Cell TE
-                if(j2>=0 && i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[5] = q[2]; // qxTbne
-                    flux_Matrix->at(i2,j2,k2)[5+8] = q[7]; // qyTEbnw
-                    flux_Matrix->at(i2,j2,k2)[5+16] = q[9]; // qzEtnw
-                }
+/* Description: Calls voxel(i,j,k,f) for the voxels in a range, with f the fluxes in the 8 quadrants of the voxel:
+ *      f[s] along x, f[8+s] along y and f[16+s] along z for quadrant s (P, E, N, NE, T, TE, TN, TNE).
+ *      The voxel is cell P of the node at its TNE corner, cell E of the node at its TNW corner, and so on, so
+ *      quadrant s (bits sx, sy, sz) takes its fluxes from node (i+1-sx, j+1-sy, k+1-sz). The node fluxes are computed
+ *      one x plane at a time rather than stored per voxel, since 24 values per voxel would outweigh everything
+ *      else the solver keeps. The two planes of node fluxes are allocated by each call, so the operator can be
+ *      applied by several solves at once. voxel is called in parallel over j, from a single parallel region
+ *      around the loop over the planes.
+ */
+template<class V> void FV_anisotropic_AMatrix::sweepVoxels(puma::Matrix<double> *x, long i0, long i1, long j0, long j1, long k0, long k1, V voxel) {
+    if(i0 >= i1) {
+        return;
+    }
 
-                i2 = i-1; j2 = j; k2 = k; // Cell TN
-                if(i2>=0 && i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[6] = q[3]; // qxTNbse
-                    flux_Matrix->at(i2,j2,k2)[6+8] = q[6]; // qyTbne
-                    flux_Matrix->at(i2,j2,k2)[6+16] = q[10]; // qzNtse
-                }
+    // the 12 fluxes of the nodes of two consecutive x planes
+    std::vector<double> nodeFluxes[2];
+    nodeFluxes[0].resize(12*(size_t)(Y+1)*(Z+1));
+    nodeFluxes[1].resize(12*(size_t)(Y+1)*(Z+1));
 
-                i2 = i; j2 = j; k2 = k; // Cell TNE
-                if( i2<X && j2<Y && k2<Z) {
-                    flux_Matrix->at(i2,j2,k2)[7] = q[3]; // qxTNbse
-                    flux_Matrix->at(i2,j2,k2)[7+8] = q[7]; // qyTEbnw
-                    flux_Matrix->at(i2,j2,k2)[7+16] = q[11]; // qzNEtsw
+    omp_set_num_threads(numThreads);
+#pragma omp parallel
+    {
+        int next = 0;
+        computeNodeFluxes(x, i0, &nodeFluxes[next][0]);
+        for(long i=i0;i<i1;i++) {
+            // the barrier at the end of each omp for keeps a plane from being overwritten while it is read, and from
+            // being read before it is complete
+            next = 1-next;
+            computeNodeFluxes(x, i+1, &nodeFluxes[next][0]);
+            const double *q0 = &nodeFluxes[1-next][0]; // nodes of plane i
+            const double *q1 = &nodeFluxes[next][0];   // nodes of plane i+1
+
+#pragma omp for
+            for(long j=j0;j<j1;j++) {
+                double f[24];
+                for(long k=k0;k<k1;k++) {
+                    for(int s=0;s<8;s++) {
+                        int sx = s&1, sy = (s>>1)&1, sz = (s>>2)&1;
+                        const double *qNode = (sx ? q0 : q1) + 12*((j+1-sy)*(Z+1)+(k+1-sz));
+                        f[s]    = qNode[sy+2*sz];
+                        f[8+s]  = qNode[4+sx+2*sz];
+                        f[16+s] = qNode[8+sx+2*sy];
+                    }
+                    voxel(i,j,k,f);
                 }
             }
         }
     }
+}
+
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+bool FV_anisotropic_AMatrix::computeFluxes(puma::Matrix<double> *x, puma::MatVec3<double> *q, double scale) {
+    q->resize(X,Y,Z);
+    sweepVoxels(x, 0,X, 0,Y, 0,Z, [q,scale](long i, long j, long k, const double *f) {
+        q->at(i,j,k).x = (f[0] + f[1] + f[2] + f[3] + f[4] + f[5] + f[6] + f[7]) / scale;
+        q->at(i,j,k).y = (f[0+8] + f[1+8] + f[2+8] + f[3+8] + f[4+8] + f[5+8] + f[6+8] + f[7+8]) / scale;
+        q->at(i,j,k).z = (f[0+16] + f[1+16] + f[2+16] + f[3+16] + f[4+16] + f[5+16] + f[6+16] + f[7+16]) / scale;
+    });
     return true;
 }
 
@@ -122,23 +147,12 @@ bool FV_anisotropic_AMatrix::computeQuadrantFluxes(puma::Matrix<double> *x) {
  */
 bool FV_anisotropic_AMatrix::A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) {
 
-    //step 1. compute all of the fluxes in the quadrant
-    computeQuadrantFluxes(&(*x));
-
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(long i=startend[6];i<startend[7];i++) {
-        for(long j=startend[8]; j<startend[9]; j++) {
-            for(long k=startend[10]; k<startend[11]; k++) {
-                r->at(i,j,k) = (flux_Matrix->at(i,j,k)[1] + flux_Matrix->at(i,j,k)[3] + flux_Matrix->at(i,j,k)[5] + flux_Matrix->at(i,j,k)[7]) -
-                               (flux_Matrix->at(i,j,k)[0] + flux_Matrix->at(i,j,k)[2] + flux_Matrix->at(i,j,k)[4] + flux_Matrix->at(i,j,k)[6]) +
-                               (flux_Matrix->at(i,j,k)[2+8] + flux_Matrix->at(i,j,k)[3+8] + flux_Matrix->at(i,j,k)[6+8] + flux_Matrix->at(i,j,k)[7+8]) -
-                               (flux_Matrix->at(i,j,k)[0+8] + flux_Matrix->at(i,j,k)[1+8] + flux_Matrix->at(i,j,k)[4+8] + flux_Matrix->at(i,j,k)[5+8]) +
-                               (flux_Matrix->at(i,j,k)[4+16] + flux_Matrix->at(i,j,k)[5+16] + flux_Matrix->at(i,j,k)[6+16] + flux_Matrix->at(i,j,k)[7+16]) -
-                               (flux_Matrix->at(i,j,k)[0+16] + flux_Matrix->at(i,j,k)[1+16] + flux_Matrix->at(i,j,k)[2+16] + flux_Matrix->at(i,j,k)[3+16]);
-            }
-        }
-    }
+    // balance of the fluxes in the quadrants of each voxel
+    sweepVoxels(x, startend[6],startend[7], startend[8],startend[9], startend[10],startend[11], [r](long i, long j, long k, const double *f) {
+        r->at(i,j,k) = (f[1] + f[3] + f[5] + f[7]) - (f[0] + f[2] + f[4] + f[6]) +
+                       (f[2+8] + f[3+8] + f[6+8] + f[7+8]) - (f[0+8] + f[1+8] + f[4+8] + f[5+8]) +
+                       (f[4+16] + f[5+16] + f[6+16] + f[7+16]) - (f[0+16] + f[1+16] + f[2+16] + f[3+16]);
+    });
 
     return true;
 }
@@ -149,7 +163,7 @@ bool FV_anisotropic_AMatrix::A_times_X(puma::Matrix<double> *x, puma::Matrix<dou
 long FV_anisotropic_AMatrix::indexAt(long index, long size) {
 
     // Symmetric BC
-    if (sideBC == "s") {
+    if (symmetric) {
         if(index==-1)   { index=0; }
         if(index==size) { index=size-1; }
     } else { // Periodic BC
@@ -11,20 +11,42 @@
 class FV_anisotropic_AMatrix : public AMatrix
 {
 public:
-    FV_anisotropic_AMatrix(puma::Matrix<std::vector<double>> *E_Matrix, puma::Matrix<std::vector<double>> *flux_Matrix, std::vector<long> startend, std::string sideBC, int numThreads);
+    //! constructs the operator from the flux stencils of the nodes.
+    /*!
+     * \param E_Index a pointer to a puma matrix holding, for each node (voxel corner), the entry of E_Table with its 12x8 stencil (-1 if unused).
+     * \param E_Table a pointer to the stencils, 96 values per entry. Nodes surrounded by the same tensors share an entry.
+     * \param startend the ranges of the nodes and of the voxels where the fluxes and the residual are computed.
+     * \param sideBC a string specifying the side boundary conditions ("s" symmetric or "p" periodic).
+     * \param numThreads an integer which specifies the number of threads used.
+     */
+    FV_anisotropic_AMatrix(puma::Matrix<int> *E_Index, std::vector<double> *E_Table, std::vector<long> startend, std::string sideBC, int numThreads);
     bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override;
     bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r){return true;};
-    bool computeQuadrantFluxes(puma::Matrix<double> *x);
+
+    //! computes the flux of each voxel, from the sum of the fluxes in its 8 quadrants.
+    /*!
+     * \param x a pointer to a puma matrix containing the temperatures.
+     * \param q a pointer to a puma MatVec3 where the fluxes are stored, resized to the domain.
+     * \param scale a double dividing the sums of the quadrant fluxes (4 times the voxel length gives the flux).
+     * \return a boolean indicating the function executed without errors.
+     */
+    bool computeFluxes(puma::Matrix<double> *x, puma::MatVec3<double> *q, double scale);
+
+    //! counts x, the result and the stencil index of each node. The shared stencils and the two planes of node fluxes mostly stay in cache.
+    double productBytes(puma::Matrix<double> *x) override { return (2. * sizeof(double) + sizeof(int)) * x->size(); }
 
 private:
-    puma::Matrix<std::vector<double>> *E_Matrix;
-    puma::Matrix<std::vector<double>> *flux_Matrix;
+    puma::Matrix<int> *E_Index;
+    std::vector<double> *E_Table;
     int numThreads;
     int X,Y,Z;
     std::vector<long> startend;
     std::string sideBC;
+    bool symmetric;
 
     long indexAt(long index, long size);
+    void computeNodeFluxes(puma::Matrix<double> *x, long i, double *q);
+    template<class V> void sweepVoxels(puma::Matrix<double> *x, long i0, long i1, long j0, long j1, long k0, long k1, V voxel);
 };
 
 #endif // FV_ANISTROPIC_MATRIX_H
@@ -1,70 +1,89 @@
 #include "fv_anisotropic_diffusion.h"
 
+#include <algorithm>
+#include <limits>
 
-bool FV_anisotropic_Diffusion::computeKMatrix(puma::Workspace *segWS, std::map<int, std::vector<double>> matCond, puma::Matrix< std::vector<double> > *kMat,
+
+bool FV_anisotropic_Diffusion::computeKMatrix(puma::Workspace *segWS, std::map<int, std::vector<double>> matCond, FV_anisotropic_TensorField *kMat,
                                               puma::MatVec3<double> *direction, bool print, int numThreads) {
 
     if(print) { std::cout << "Assigning conductivities ... " << std::flush;}
 
+    kMat->resize(segWS->X(),segWS->Y(),segWS->Z());
+
+    // table entry of each material, indexed by its ID. Materials with 2 entries keep their isotropic tensor, used at fiber intersections.
+    // Voxels of materials missing from matCond are non conductive.
+    int maxID = matCond.empty() ? 0 : std::max(0, matCond.rbegin()->first);
+    double zero[6] = {0,0,0,0,0,0};
+    unsigned short zeroID = kMat->addTensor(zero);
+    std::vector<unsigned short> tableID(maxID+1, zeroID);
+    std::vector<bool> oriented(maxID+1, false);
+    for (auto &it : matCond) {
+        if (it.first < 0) {
+            continue;
+        }
+        double k[6] = {0,0,0,0,0,0};
+        if (it.second.size() == 6) { // arranged as: kxx, kyy, kzz, kxy, kxz, kyz
+            std::copy(it.second.begin(), it.second.end(), k);
+        } else if (!it.second.empty()) { // only 1 entry means isotropic phase --> place single entry on diagonal
+            k[0] = k[1] = k[2] = it.second[0];
+        }
+        tableID[it.first] = kMat->addTensor(k);
+        oriented[it.first] = it.second.size() == 2;
+        if (oriented[it.first]) {
+            kMat->allocateVoxelTensors();
+        }
+    }
+
         omp_set_num_threads(numThreads);
 #pragma omp parallel for
         for (long i=0; i<kMat->X(); i++) {
             double phi = NAN, theta = NAN;
             Eigen::MatrixXd Ry_k_rot(3,3), Rz_kinit(3,3), R(3,3), R_inv(3,3);
+            double kRot[6];
             for (long j=0; j<kMat->Y(); j++) {
                 for (long k=0; k < kMat->Z(); k++) {
 
-                    // If 6 entries in matCond, we just assign the input anisotropic tensor, ignoring whether or not direction present
-                    // arranged as: kxx, kyy, kzz, kxy, kxz, kyz
-                    if (matCond[(*segWS)(i, j, k)].size() == 6) {
-                        kMat->at(i,j,k) = matCond[(*segWS)(i,j,k)];
-
-                    } else if (matCond[(*segWS)(i, j, k)].size() == 1) { // only 1 entry means isotropic phase --> place single entry on diagonal
-                        kMat->at(i,j,k)[0] = matCond[(*segWS)(i,j,k)][0];
-                        kMat->at(i,j,k)[1] = matCond[(*segWS)(i,j,k)][0];
-                        kMat->at(i,j,k)[2] = matCond[(*segWS)(i,j,k)][0];
-
-                    } else {  // if 2 entries, compute tensor rotation for non-intersecting fibers
-
-                        // If non intersecting fibers
-                        if (direction->at(i, j, k).magnitude() < 1.5) {
-
-                            // Tensor rotation
-                            phi = atan2(direction->at(i, j, k).y, direction->at(i, j, k).x);
-                            theta = asin(direction->at(i, j, k).z);
-
-                            Rz_kinit << cos(phi), -sin(phi), 0,
-                                    sin(phi), cos(phi), 0,
-                                    0, 0, 1;
-                            Ry_k_rot << cos(theta), 0, sin(theta),
-                                    0, 1, 0,
-                                    -sin(theta), 0, cos(theta);
-
-                            R = Rz_kinit * Ry_k_rot;
-
-                            R_inv = R.inverse();
-
-                            Rz_kinit << matCond[(*segWS)(i, j, k)][0], 0, 0,
-                                    0, matCond[(*segWS)(i, j, k)][1], 0,
-                                    0, 0, matCond[(*segWS)(i, j, k)][1];
-
-                            Ry_k_rot = R * Rz_kinit * R_inv;
-
-                            kMat->at(i, j, k)[0] = Ry_k_rot(0); // kxx
-                            kMat->at(i, j, k)[1] = Ry_k_rot(4); // kyy
-                            kMat->at(i, j, k)[2] = Ry_k_rot(8); // kzz
-                            kMat->at(i, j, k)[3] = Ry_k_rot(1); // kxy
-                            kMat->at(i, j, k)[4] = Ry_k_rot(2); // kxz
-                            kMat->at(i, j, k)[5] = Ry_k_rot(5); // kyz
-                        }
-
-                            // fiber intersections are flagged with dir.magnitude = 2
-                            // treat these areas as isotropic
-                        else {
-                            kMat->at(i,j,k)[0] = matCond[(*segWS)(i,j,k)][0];
-                            kMat->at(i,j,k)[1] = matCond[(*segWS)(i,j,k)][0];
-                            kMat->at(i,j,k)[2] = matCond[(*segWS)(i,j,k)][0];
-                        }
+                    long m = (*segWS)(i, j, k);
+                    if (m < 0 || m > maxID) {
+                        kMat->id(i,j,k) = zeroID;
+                        continue;
+                    }
+                    kMat->id(i,j,k) = tableID[m];
+
+                    // if 2 entries, compute tensor rotation for non-intersecting fibers
+                    // fiber intersections are flagged with dir.magnitude = 2, treat these areas as isotropic
+                    if (oriented[m] && direction->at(i, j, k).magnitude() < 1.5) {
+                        const std::vector<double> &kPhase = matCond.at((int)m);
+
+                        // Tensor rotation
+                        phi = atan2(direction->at(i, j, k).y, direction->at(i, j, k).x);
+                        theta = asin(direction->at(i, j, k).z);
+
+                        Rz_kinit << cos(phi), -sin(phi), 0,
+                                sin(phi), cos(phi), 0,
+                                0, 0, 1;
+                        Ry_k_rot << cos(theta), 0, sin(theta),
+                                0, 1, 0,
+                                -sin(theta), 0, cos(theta);
+
+                        R = Rz_kinit * Ry_k_rot;
+
+                        R_inv = R.inverse();
+
+                        Rz_kinit << kPhase[0], 0, 0,
+                                0, kPhase[1], 0,
+                                0, 0, kPhase[1];
+
+                        Ry_k_rot = R * Rz_kinit * R_inv;
+
+                        kRot[0] = Ry_k_rot(0); // kxx
+                        kRot[1] = Ry_k_rot(4); // kyy
+                        kRot[2] = Ry_k_rot(8); // kzz
+                        kRot[3] = Ry_k_rot(1); // kxy
+                        kRot[4] = Ry_k_rot(2); // kxz
+                        kRot[5] = Ry_k_rot(5); // kyz
+                        kMat->setTensor(i, j, k, kRot);
                     }
                 }
             }
@@ -77,7 +96,7 @@ bool FV_anisotropic_Diffusion::computeKMatrix(puma::Workspace *segWS, std::map<i
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-FV_anisotropic_Diffusion::FV_anisotropic_Diffusion(puma::Matrix<double> *T, puma::MatVec3<double> *q, puma::Matrix<std::vector<double> > *kMat,
+FV_anisotropic_Diffusion::FV_anisotropic_Diffusion(puma::Matrix<double> *T, puma::MatVec3<double> *q, FV_anisotropic_TensorField *kMat,
                                                    std::string sideBC, puma::Matrix<double> *prescribedBC, std::string solverType, char dir, double voxelLength,
                                                    double solverTol, int solverMaxIt, bool print, std::string method, int numThreads)
 {
@@ -108,21 +127,19 @@ puma::Vec3<double> FV_anisotropic_Diffusion::compute_DiffusionCoefficient()
     // Resizing necessary puma matrices
     T->resize(kMat->X(),kMat->Y(),kMat->Z(),0);
     q->resize(kMat->X(),kMat->Y(),kMat->Z());
-    flux_Matrix.resize(kMat->X(),kMat->Y(),kMat->Z(), std::vector<double> (24,0));
-    E_Matrix.resize(kMat->X()+1,kMat->Y()+1,kMat->Z()+1, std::vector<double> (96,0)); //E_Matrix(i,j,k).resize(96);
 
     initializeLinearProfile();
-    computeEMatrix();
+    if(!computeEMatrix()) {
+        return puma::Vec3<double>(-1,-1,-1);
+    }
 
-    FV_anisotropic_AMatrix A(&E_Matrix,&flux_Matrix,startend,sideBC,numThreads); // boundaries
+    FV_anisotropic_AMatrix A(&E_Index,&E_Table,startend,sideBC,numThreads); // boundaries
     if(!runIterativeSolver(&A)) {
         return puma::Vec3<double>(-1,-1,-1);
     }
 
-    A.computeQuadrantFluxes(T);
-
     puma::Vec3<double> fluxes(0,0,0),length(0,0,0);
-    computeLengthFluxes(&fluxes,&length);
+    computeLengthFluxes(&A,&fluxes,&length);
 
     return diffusionCoefficient;
 }
@@ -249,193 +266,252 @@ bool FV_anisotropic_Diffusion::initializeLinearProfile() {
 
 bool FV_anisotropic_Diffusion::computeEMatrix() {
 
-    if (method == "m" && print) { std::cout << "Computing E matrix using MPFA " << std::endl; }
-    else if (method == "e" && print) { std::cout << "Computing E matrix using eMPFA " << std::endl; }
-
-    for(long i=startend[0];i<startend[1];i++){
+    if (method == "m" && print) { std::cout << "Computing E matrix using MPFA ... " << std::flush; }
+    else if (method == "e" && print) { std::cout << "Computing E matrix using eMPFA ... " << std::flush; }
 
-        if (print) { std::cout << std::setprecision(3) << '\r' << ((double)i/(double)(startend[1]-1))*100 << "% done" << std::flush; }
+    // The stencil of a node only depends on the tensors of the 8 voxels around it, so nodes surrounded by the same
+    // table entries share one stencil. Nodes touching a voxel with its own tensor get their own.
+    E_Index.resize(X+1,Y+1,Z+1,-1);
+    std::vector<long> nodes; // a node using each stencil, as (i*(Y+1)+j)*(Z+1)+k
+    std::map<std::array<unsigned short,8>, int> shared;
+    std::array<unsigned short,8> key{}, lastKey{};
+    int last = -1;
 
-        omp_set_num_threads(numThreads);
-#pragma omp parallel for
+    for(long i=startend[0];i<startend[1];i++){
         for(long j=startend[2];j<startend[3];j++){
-            // Initializing matrices
-            std::vector<double> mat(12*12), mat2(12*12);
-            Eigen::MatrixXd mat2_eigen(12,12);
-            std::vector<double> kl(48);
-
             for(long k=startend[4];k<startend[5];k++){
-
-                for (int i2=0;i2<6;i2++) {
-                    kl[i2]    = (*kMat).at(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k-1,Z))[i2]; // Cell P
-                    kl[i2+6]  = (*kMat).at(indexAt(i,X),indexAt(j-1,Y),indexAt(k-1,Z))[i2];   // Cell E
-                    kl[i2+12] = (*kMat).at(indexAt(i-1,X),indexAt(j,Y),indexAt(k-1,Z))[i2];   // Cell N
-                    kl[i2+18] = (*kMat).at(indexAt(i,X),indexAt(j,Y),indexAt(k-1,Z))[i2];     // Cell NE
-                    kl[i2+24] = (*kMat).at(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k,Z))[i2];   // Cell T
-                    kl[i2+30] = (*kMat).at(indexAt(i,X),indexAt(j-1,Y),indexAt(k,Z))[i2];     // Cell TE
-                    kl[i2+36] = (*kMat).at(indexAt(i-1,X),indexAt(j,Y),indexAt(k,Z))[i2];     // Cell TN
-                    kl[i2+42] = (*kMat).at(indexAt(i,X),indexAt(j,Y),indexAt(k,Z))[i2];       // Cell TNE
+                key = { kMat->id(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k-1,Z)), kMat->id(indexAt(i,X),indexAt(j-1,Y),indexAt(k-1,Z)),
+                        kMat->id(indexAt(i-1,X),indexAt(j,Y),indexAt(k-1,Z)),   kMat->id(indexAt(i,X),indexAt(j,Y),indexAt(k-1,Z)),
+                        kMat->id(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k,Z)),   kMat->id(indexAt(i,X),indexAt(j-1,Y),indexAt(k,Z)),
+                        kMat->id(indexAt(i-1,X),indexAt(j,Y),indexAt(k,Z)),     kMat->id(indexAt(i,X),indexAt(j,Y),indexAt(k,Z)) };
+
+                if(nodes.size() >= (size_t)std::numeric_limits<int>::max()) {
+                    std::cout << "Finite Volume Anisotropic Diffusion Error: too many nodes for the stencil index" << std::endl;
+                    return false;
                 }
 
-                // Carrying out: A*C^(-1)*D + B
-                if (method == "m") {
-                    // MPFA
-
-                    mat2_eigen << kl[6] + kl[0], 0, kl[3], -kl[9], kl[4], -kl[10], 0, 0, 0, 0, 0, 0,
-                            0, kl[12] + kl[18], -kl[15], kl[21], 0, 0, kl[16], -kl[22], 0, 0, 0, 0,
-                            0, 0, 0, 0, -kl[28], kl[34], 0, 0, kl[24] + kl[30], 0, kl[27], -kl[33],
-                            0, 0, 0, 0, 0, 0, -kl[40], kl[46], 0, kl[36] + kl[42], -kl[39], kl[45],
-                            kl[3], -kl[15], kl[13] + kl[1], 0, kl[5], 0, -kl[17], 0, 0, 0, 0, 0,
-                            -kl[9], kl[21], 0, kl[7] + kl[19], 0, kl[11], 0, -kl[23], 0, 0, 0, 0,
-                            0, 0, 0, 0, -kl[29], 0, kl[41], 0, kl[27], -kl[39], kl[25] + kl[37], 0,
-                            0, 0, 0, 0, 0, -kl[35], 0, kl[47], -kl[33], kl[45], 0, kl[31] + kl[43],
-                            kl[4], 0, kl[5], 0, kl[2] + kl[26], 0, 0, 0, -kl[28], 0, -kl[29], 0,
-                            -kl[10], 0, 0, kl[11], 0, kl[8] + kl[32], 0, 0, kl[34], 0, 0, -kl[35],
-                            0, kl[16], -kl[17], 0, 0, 0, kl[14] + kl[38], 0, 0, -kl[40], kl[41], 0,
-                            0, -kl[22], 0, -kl[23], 0, 0, 0, kl[20] + kl[44], 0, kl[46], 0, kl[47];
-
-                    mat2_eigen = mat2_eigen.inverse();
-                    mat2_eigen.transposeInPlace();
-
-                    mat2.resize(12*12);
-                    for(int t=0; t<mat2.size(); t++){
-                        mat2[t] = mat2_eigen(t);
-                    }
-
-                    mat = {-kl[0], 0, -kl[3], 0, -kl[4], 0, 0, 0, 0, 0, 0, 0,
-                           0, -kl[12], kl[15], 0, 0, 0, -kl[16], 0, 0, 0, 0, 0,
-                           0, 0, 0, 0, kl[28], 0, 0, 0, -kl[24], 0, -kl[27], 0,
-                           0, 0, 0, 0, 0, 0, kl[40], 0, 0, -kl[36], kl[39], 0,
-                           -kl[3], 0, -kl[1], 0, -kl[5], 0, 0, 0, 0, 0, 0, 0,
-                           kl[9], 0, 0, -kl[7], 0, -kl[11], 0, 0, 0, 0, 0, 0,
-                           0, 0, 0, 0, kl[29], 0, 0, 0, -kl[27], 0, -kl[25], 0,
-                           0, 0, 0, 0, 0, kl[35], 0, 0, kl[33], 0, 0, -kl[31],
-                           -kl[4], 0, -kl[5], 0, -kl[2], 0, 0, 0, 0, 0, 0, 0,
-                           kl[10], 0, 0, -kl[11], 0, -kl[8], 0, 0, 0, 0, 0, 0,
-                           0, -kl[16], kl[17], 0, 0, 0, -kl[14], 0, 0, 0, 0, 0,
-                           0, kl[22], 0, kl[23], 0, 0, 0, -kl[20], 0, 0, 0, 0}; // A 12x12
-
-                    mat2 = matrixMultiply(&mat, 12, 12, &mat2, 12); // E1 = A*C^(-1)
-
-                    mat  = {kl[0] + kl[3] + kl[4], kl[6] - kl[9] - kl[10], 0, 0, 0, 0, 0, 0,
-                            0, 0, kl[12] - kl[15] + kl[16], kl[18] + kl[21] - kl[22], 0, 0, 0, 0,
-                            0, 0, 0, 0, kl[24] + kl[27] - kl[28], kl[30] - kl[33] + kl[34], 0, 0,
-                            0, 0, 0, 0, 0, 0, kl[36] - kl[39] - kl[40], kl[42] + kl[45] + kl[46],
-                            kl[3] + kl[1] + kl[5], 0, -kl[15] + kl[13] - kl[17], 0, 0, 0, 0, 0,
-                            0, -kl[9] + kl[7] + kl[11], 0, kl[21] + kl[19] - kl[23], 0, 0, 0, 0,
-                            0, 0, 0, 0, kl[27] + kl[25] - kl[29], 0, -kl[39] + kl[37] + kl[41], 0,
-                            0, 0, 0, 0, 0, -kl[33] + kl[31] - kl[35], 0, kl[45] + kl[43] + kl[47],
-                            kl[4] + kl[5] + kl[2], 0, 0, 0, -kl[28] - kl[29] + kl[26], 0, 0, 0,
-                            0, -kl[10] + kl[11] + kl[8], 0, 0, 0, kl[34] - kl[35] + kl[32], 0, 0,
-                            0, 0, kl[16] - kl[17] + kl[14], 0, 0, 0, -kl[40] + kl[41] + kl[38], 0,
-                            0, 0, 0, -kl[22] - kl[23] + kl[20], 0, 0, 0, kl[46] + kl[47] + kl[44]}; // D 12x8
-
-                    mat2 = matrixMultiply(&mat2, 12, 12, &mat, 8); // E2 = E1*D
-
-                    mat = {kl[0] + kl[3] + kl[4], 0, 0, 0, 0, 0, 0, 0,
-                           0, 0, kl[12] - kl[15] + kl[16], 0, 0, 0, 0, 0,
-                           0, 0, 0, 0, kl[24] + kl[27] - kl[28], 0, 0, 0,
-                           0, 0, 0, 0, 0, 0, kl[36] - kl[39] - kl[40], 0,
-                           kl[3] + kl[1] + kl[5], 0, 0, 0, 0, 0, 0, 0,
-                           0, -kl[9] + kl[7] + kl[11], 0, 0, 0, 0, 0, 0,
-                           0, 0, 0, 0, kl[27] + kl[25] - kl[29], 0, 0, 0,
-                           0, 0, 0, 0, 0, -kl[33] + kl[31] - kl[35], 0, 0,
-                           kl[4] + kl[5] + kl[2], 0, 0, 0, 0, 0, 0, 0,
-                           0, -kl[10] + kl[11] + kl[8], 0, 0, 0, 0, 0, 0,
-                           0, 0, kl[16] - kl[17] + kl[14], 0, 0, 0, 0, 0,
-                           0, 0, 0, -kl[22] - kl[23] + kl[20], 0, 0, 0, 0}; // B 12x8
+                bool ownTensors = std::find(key.begin(), key.end(), FV_anisotropic_TensorField::voxelTensor) != key.end();
+                if(ownTensors) {
+                    last = -1;
+                    E_Index.at(i,j,k) = (int)nodes.size();
+                    nodes.push_back((i*(Y+1)+j)*(Z+1)+k);
+                    continue;
                 }
-                else if (method == "e") {
-                    // eMPFA
-                    mat2_eigen << kl[6]+kl[0]+kl[9]/2-kl[3]/2+kl[10]/2-kl[4]/2, -(kl[9]/2)+kl[3]/2, -(kl[9]/2)+kl[3]/2, -(kl[9]/2)+kl[3]/2, -(kl[10]/2)+kl[4]/2, -(kl[10]/2)+kl[4]/2, 0, 0, -(kl[10]/2)+kl[4]/2, 0, 0, 0,
-                            -(kl[15]/2)+kl[21]/2, kl[12]+kl[18]+kl[15]/2-kl[21]/2-kl[16]/2+kl[22]/2, -(kl[15]/2)+kl[21]/2, -(kl[15]/2)+kl[21]/2, 0, 0, kl[16]/2-kl[22]/2, kl[16]/2-kl[22]/2, 0, kl[16]/2-kl[22]/2, 0, 0,
-                            -(kl[28]/2)+kl[34]/2, 0, 0, 0, -(kl[28]/2)+kl[34]/2, -(kl[28]/2)+kl[34]/2, 0, 0, kl[24]+kl[30]-kl[27]/2+kl[33]/2+kl[28]/2-kl[34]/2, kl[27]/2-kl[33]/2, kl[27]/2-kl[33]/2, kl[27]/2-kl[33]/2,
-                            0, -(kl[40]/2)+kl[46]/2, 0, 0, 0, 0, -(kl[40]/2)+kl[46]/2, -(kl[40]/2)+kl[46]/2, -(kl[39]/2)+kl[45]/2, kl[36]+kl[42]+kl[39]/2-kl[45]/2+kl[40]/2-kl[46]/2, -(kl[39]/2)+kl[45]/2, -(kl[39]/2)+kl[45]/2,
-                            -(kl[15]/2)+kl[3]/2, -(kl[15]/2)+kl[3]/2, kl[15]/2-kl[3]/2+kl[13]+kl[1]+kl[17]/2-kl[5]/2, -(kl[15]/2)+kl[3]/2, -(kl[17]/2)+kl[5]/2, 0, -(kl[17]/2)+kl[5]/2, 0, 0, 0, -(kl[17]/2)+kl[5]/2, 0,
-                            -(kl[9]/2)+kl[21]/2, -(kl[9]/2)+kl[21]/2, -(kl[9]/2)+kl[21]/2, kl[9]/2-kl[21]/2+kl[7]+kl[19]-kl[11]/2+kl[23]/2, 0, kl[11]/2-kl[23]/2, 0, kl[11]/2-kl[23]/2, 0, 0, 0, kl[11]/2-kl[23]/2,
-                            0, 0, -(kl[29]/2)+kl[41]/2, 0, -(kl[29]/2)+kl[41]/2, 0, -(kl[29]/2)+kl[41]/2, 0, kl[27]/2-kl[39]/2, kl[27]/2-kl[39]/2, -(kl[27]/2)+kl[39]/2+kl[25]+kl[37]+kl[29]/2-kl[41]/2, kl[27]/2-kl[39]/2,
-                            0, 0, 0, -(kl[35]/2)+kl[47]/2, 0, -(kl[35]/2)+kl[47]/2, 0, -(kl[35]/2)+kl[47]/2, -(kl[33]/2)+kl[45]/2, -(kl[33]/2)+kl[45]/2, -(kl[33]/2)+kl[45]/2, kl[33]/2-kl[45]/2+kl[31]+kl[43]+kl[35]/2-kl[47]/2,
-                            kl[4]/2-kl[28]/2, 0, kl[5]/2-kl[29]/2, 0, -(kl[4]/2)+kl[28]/2-kl[5]/2+kl[29]/2+kl[2]+kl[26], kl[4]/2-kl[28]/2, kl[5]/2-kl[29]/2, 0, kl[4]/2-kl[28]/2, 0, kl[5]/2-kl[29]/2, 0,
-                            -(kl[10]/2)+kl[34]/2, 0, 0, kl[11]/2-kl[35]/2, -(kl[10]/2)+kl[34]/2, kl[10]/2-kl[34]/2-kl[11]/2+kl[35]/2+kl[8]+kl[32], 0, kl[11]/2-kl[35]/2, -(kl[10]/2)+kl[34]/2, 0, 0, kl[11]/2-kl[35]/2,
-                            0, kl[16]/2-kl[40]/2, -(kl[17]/2)+kl[41]/2, 0, -(kl[17]/2)+kl[41]/2, 0, -(kl[16]/2)+kl[40]/2+kl[17]/2-kl[41]/2+kl[14]+kl[38], kl[16]/2-kl[40]/2, 0, kl[16]/2-kl[40]/2, -(kl[17]/2)+kl[41]/2, 0,
-                            0, -(kl[22]/2)+kl[46]/2, 0, -(kl[23]/2)+kl[47]/2, 0, -(kl[23]/2)+kl[47]/2, -(kl[22]/2)+kl[46]/2, kl[22]/2-kl[46]/2+kl[23]/2-kl[47]/2+kl[20]+kl[44], 0, -(kl[22]/2)+kl[46]/2, 0, -(kl[23]/2)+kl[47]/2; // C 12x12
-
-                    mat2_eigen = mat2_eigen.inverse();
-                    mat2_eigen.transposeInPlace();
-
-                    mat2.resize(12*12);
-                    for(int t=0; t<mat2.size(); t++){
-                        mat2[t] = mat2_eigen(t);
-                    }
-
-                    mat = {-kl[0]+kl[3]/2+kl[4]/2, -(kl[3]/2), -(kl[3]/2), -(kl[3]/2), -(kl[4]/2), -(kl[4]/2), 0, 0, -(kl[4]/2), 0, 0, 0,
-                           kl[15]/2, -kl[12]-kl[15]/2+kl[16]/2, kl[15]/2, kl[15]/2, 0, 0, -(kl[16]/2), -(kl[16]/2), 0, -(kl[16]/2), 0, 0,
-                           kl[28]/2, 0, 0, 0, kl[28]/2, kl[28]/2, 0, 0, -kl[24]+kl[27]/2-kl[28]/2, -(kl[27]/2), -(kl[27]/2), -(kl[27]/2),
-                           0, kl[40]/2, 0, 0, 0, 0, kl[40]/2, kl[40]/2, kl[39]/2, -kl[36]-kl[39]/2-kl[40]/2, kl[39]/2, kl[39]/2,
-                           -(kl[3]/2), -(kl[3]/2), kl[3]/2-kl[1]+kl[5]/2, -(kl[3]/2), -(kl[5]/2), 0, -(kl[5]/2), 0, 0, 0, -(kl[5]/2), 0,
-                           kl[9]/2, kl[9]/2, kl[9]/2, -(kl[9]/2)-kl[7]+kl[11]/2, 0, -(kl[11]/2), 0, -(kl[11]/2), 0, 0, 0, -(kl[11]/2),
-                           0, 0, kl[29]/2, 0, kl[29]/2, 0, kl[29]/2, 0, -(kl[27]/2), -(kl[27]/2), kl[27]/2-kl[25]-kl[29]/2, -(kl[27]/2),
-                           0, 0, 0, kl[35]/2, 0, kl[35]/2, 0, kl[35]/2, kl[33]/2, kl[33]/2, kl[33]/2, -(kl[33]/2)-kl[31]-kl[35]/2,
-                           -(kl[4]/2), 0, -(kl[5]/2), 0, kl[4]/2+kl[5]/2-kl[2], -(kl[4]/2), -(kl[5]/2), 0, -(kl[4]/2), 0, -(kl[5]/2), 0,
-                           kl[10]/2, 0, 0, -(kl[11]/2), kl[10]/2, -(kl[10]/2)+kl[11]/2-kl[8], 0, -(kl[11]/2), kl[10]/2, 0, 0, -(kl[11]/2),
-                           0, -(kl[16]/2), kl[17]/2, 0, kl[17]/2, 0, kl[16]/2-kl[17]/2-kl[14], -(kl[16]/2), 0, -(kl[16]/2), kl[17]/2, 0,
-                           0, kl[22]/2, 0, kl[23]/2, 0, kl[23]/2, kl[22]/2, -(kl[22]/2)-kl[23]/2-kl[20], 0, kl[22]/2, 0, kl[23]/2}; // A 12x12
-
-                    mat2 = matrixMultiply(&mat, 12, 12, &mat2, 12); // E1 = A*C^(-1)
-
-                    mat = {kl[0]-kl[9]/4+kl[3]/4-kl[10]/4+kl[4]/4, kl[6]-kl[9]/4+kl[3]/4-kl[10]/4+kl[4]/4, -(kl[9]/4)+kl[3]/4, -(kl[9]/4)+kl[3]/4, -(kl[10]/4)+kl[4]/4, -(kl[10]/4)+kl[4]/4, 0, 0,
-                           -(kl[15]/4)+kl[21]/4, -(kl[15]/4)+kl[21]/4, kl[12]-kl[15]/4+kl[21]/4+kl[16]/4-kl[22]/4, kl[18]-kl[15]/4+kl[21]/4+kl[16]/4-kl[22]/4, 0, 0, kl[16]/4-kl[22]/4, kl[16]/4-kl[22]/4,
-                           -(kl[28]/4)+kl[34]/4, -(kl[28]/4)+kl[34]/4, 0, 0, kl[24]+kl[27]/4-kl[33]/4-kl[28]/4+kl[34]/4, kl[30]+kl[27]/4-kl[33]/4-kl[28]/4+kl[34]/4, kl[27]/4-kl[33]/4, kl[27]/4-kl[33]/4,
-                           0, 0, -(kl[40]/4)+kl[46]/4, -(kl[40]/4)+kl[46]/4, -(kl[39]/4)+kl[45]/4, -(kl[39]/4)+kl[45]/4, kl[36]-kl[39]/4+kl[45]/4-kl[40]/4+kl[46]/4, kl[42]-kl[39]/4+kl[45]/4-kl[40]/4+kl[46]/4,
-                           -(kl[15]/4)+kl[3]/4+kl[1]-kl[17]/4+kl[5]/4, -(kl[15]/4)+kl[3]/4, -(kl[15]/4)+kl[3]/4+kl[13]-kl[17]/4+kl[5]/4, -(kl[15]/4)+kl[3]/4, -(kl[17]/4)+kl[5]/4, 0, -(kl[17]/4)+kl[5]/4, 0,
-                           -(kl[9]/4)+kl[21]/4, -(kl[9]/4)+kl[21]/4+kl[7]+kl[11]/4-kl[23]/4, -(kl[9]/4)+kl[21]/4, -(kl[9]/4)+kl[21]/4+kl[19]+kl[11]/4-kl[23]/4, 0, kl[11]/4-kl[23]/4, 0, kl[11]/4-kl[23]/4,
-                           -(kl[29]/4)+kl[41]/4, 0, -(kl[29]/4)+kl[41]/4, 0, kl[27]/4-kl[39]/4+kl[25]-kl[29]/4+kl[41]/4, kl[27]/4-kl[39]/4, kl[27]/4-kl[39]/4+kl[37]-kl[29]/4+kl[41]/4, kl[27]/4-kl[39]/4,
-                           0, -(kl[35]/4)+kl[47]/4, 0, -(kl[35]/4)+kl[47]/4, -(kl[33]/4)+kl[45]/4, -(kl[33]/4)+kl[45]/4+kl[31]-kl[35]/4+kl[47]/4, -(kl[33]/4)+kl[45]/4, -(kl[33]/4)+kl[45]/4+kl[43]-kl[35]/4+kl[47]/4,
-                           kl[4]/4-kl[28]/4+kl[5]/4-kl[29]/4+kl[2], kl[4]/4-kl[28]/4, kl[5]/4-kl[29]/4, 0, kl[4]/4-kl[28]/4+kl[5]/4-kl[29]/4+kl[26], kl[4]/4-kl[28]/4, kl[5]/4-kl[29]/4, 0,
-                           -(kl[10]/4)+kl[34]/4, -(kl[10]/4)+kl[34]/4+kl[11]/4-kl[35]/4+kl[8], 0, kl[11]/4-kl[35]/4, -(kl[10]/4)+kl[34]/4, -(kl[10]/4)+kl[34]/4+kl[11]/4-kl[35]/4+kl[32], 0, kl[11]/4-kl[35]/4,
-                           -(kl[17]/4)+kl[41]/4, 0, kl[16]/4-kl[40]/4-kl[17]/4+kl[41]/4+kl[14], kl[16]/4-kl[40]/4, -(kl[17]/4)+kl[41]/4, 0, kl[16]/4-kl[40]/4-kl[17]/4+kl[41]/4+kl[38], kl[16]/4-kl[40]/4,
-                           0, -(kl[23]/4)+kl[47]/4, -(kl[22]/4)+kl[46]/4, -(kl[22]/4)+kl[46]/4-kl[23]/4+kl[47]/4+kl[20], 0, -(kl[23]/4)+kl[47]/4, -(kl[22]/4)+kl[46]/4, -(kl[22]/4)+kl[46]/4-kl[23]/4+kl[47]/4+kl[44]}; // D 12x8
-
-                    mat2 = matrixMultiply(&mat2, 12, 12, &mat, 8); // E2 = E1*D
-
-                    mat = {kl[0]+kl[3]/4+kl[4]/4, kl[3]/4+kl[4]/4, kl[3]/4, kl[3]/4, kl[4]/4, kl[4]/4, 0, 0,
-                           -(kl[15]/4), -(kl[15]/4), kl[12]-kl[15]/4+kl[16]/4, -(kl[15]/4)+kl[16]/4, 0, 0, kl[16]/4, kl[16]/4,
-                           -(kl[28]/4), -(kl[28]/4), 0, 0, kl[24]+kl[27]/4-kl[28]/4, kl[27]/4-kl[28]/4, kl[27]/4, kl[27]/4,
-                           0, 0, -(kl[40]/4), -(kl[40]/4), -(kl[39]/4), -(kl[39]/4), kl[36]-kl[39]/4-kl[40]/4, -(kl[39]/4)-kl[40]/4,
-                           kl[3]/4+kl[1]+kl[5]/4, kl[3]/4, kl[3]/4+kl[5]/4, kl[3]/4, kl[5]/4, 0, kl[5]/4, 0,
-                           -(kl[9]/4), -(kl[9]/4)+kl[7]+kl[11]/4, -(kl[9]/4), -(kl[9]/4)+kl[11]/4, 0, kl[11]/4, 0, kl[11]/4,
-                           -(kl[29]/4), 0, -(kl[29]/4), 0, kl[27]/4+kl[25]-kl[29]/4, kl[27]/4, kl[27]/4-kl[29]/4, kl[27]/4,
-                           0, -(kl[35]/4), 0, -(kl[35]/4), -(kl[33]/4), -(kl[33]/4)+kl[31]-kl[35]/4, -(kl[33]/4), -(kl[33]/4)-kl[35]/4,
-                           kl[4]/4+kl[5]/4+kl[2], kl[4]/4, kl[5]/4, 0, kl[4]/4+kl[5]/4, kl[4]/4, kl[5]/4, 0,
-                           -(kl[10]/4), -(kl[10]/4)+kl[11]/4+kl[8], 0, kl[11]/4, -(kl[10]/4), -(kl[10]/4)+kl[11]/4, 0, kl[11]/4,
-                           -(kl[17]/4), 0, kl[16]/4-kl[17]/4+kl[14], kl[16]/4, -(kl[17]/4), 0, kl[16]/4-kl[17]/4, kl[16]/4,
-                           0, -(kl[23]/4), -(kl[22]/4), -(kl[22]/4)-kl[23]/4+kl[20], 0, -(kl[23]/4), -(kl[22]/4), -(kl[22]/4)-kl[23]/4}; // B 12x8
-                }
-
-                for(int i2=0;i2<12;i2++){
-                    for(int j2=0;j2<8;j2++){
-                        E_Matrix.at(i,j,k)[8*i2+j2] = mat2[8*i2+j2] + mat[8*i2+j2];  // E = E2+B
+                if(last < 0 || key != lastKey) {
+                    auto it = shared.find(key);
+                    if(it == shared.end()) {
+                        it = shared.emplace(key, (int)nodes.size()).first;
+                        nodes.push_back((i*(Y+1)+j)*(Z+1)+k);
                     }
+                    last = it->second;
+                    lastKey = key;
                 }
+                E_Index.at(i,j,k) = last;
             }
         }
     }
-    if (print) { std::cout << std::endl; }
+
+    E_Table.assign(96*nodes.size(), 0.);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(dynamic,64)
+    for(long n=0;n<(long)nodes.size();n++) {
+        long k = nodes[n]%(Z+1);
+        long j = (nodes[n]/(Z+1))%(Y+1);
+        long i = nodes[n]/((Z+1)*(Y+1));
+        computeNodeE(i,j,k,&E_Table[96*n]);
+    }
+
+    if (print) { std::cout << "Done, " << nodes.size() << " distinct stencils" << std::endl; }
 
     return true;
 }
 
 
+void FV_anisotropic_Diffusion::computeNodeE(long i, long j, long k, double *E) {
+
+    // Initializing matrices
+    std::vector<double> mat(12*12), mat2(12*12);
+    Eigen::MatrixXd mat2_eigen(12,12);
+    std::vector<double> kl(48);
+
+    kMat->getTensor(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k-1,Z),&kl[0]);  // Cell P
+    kMat->getTensor(indexAt(i,X),indexAt(j-1,Y),indexAt(k-1,Z),&kl[6]);    // Cell E
+    kMat->getTensor(indexAt(i-1,X),indexAt(j,Y),indexAt(k-1,Z),&kl[12]);   // Cell N
+    kMat->getTensor(indexAt(i,X),indexAt(j,Y),indexAt(k-1,Z),&kl[18]);     // Cell NE
+    kMat->getTensor(indexAt(i-1,X),indexAt(j-1,Y),indexAt(k,Z),&kl[24]);   // Cell T
+    kMat->getTensor(indexAt(i,X),indexAt(j-1,Y),indexAt(k,Z),&kl[30]);     // Cell TE
+    kMat->getTensor(indexAt(i-1,X),indexAt(j,Y),indexAt(k,Z),&kl[36]);     // Cell TN
+    kMat->getTensor(indexAt(i,X),indexAt(j,Y),indexAt(k,Z),&kl[42]);       // Cell TNE
+
+    // Carrying out: A*C^(-1)*D + B
+    if (method == "m") {
+        // MPFA
+
+        mat2_eigen << kl[6] + kl[0], 0, kl[3], -kl[9], kl[4], -kl[10], 0, 0, 0, 0, 0, 0,
+                0, kl[12] + kl[18], -kl[15], kl[21], 0, 0, kl[16], -kl[22], 0, 0, 0, 0,
+                0, 0, 0, 0, -kl[28], kl[34], 0, 0, kl[24] + kl[30], 0, kl[27], -kl[33],
+                0, 0, 0, 0, 0, 0, -kl[40], kl[46], 0, kl[36] + kl[42], -kl[39], kl[45],
+                kl[3], -kl[15], kl[13] + kl[1], 0, kl[5], 0, -kl[17], 0, 0, 0, 0, 0,
+                -kl[9], kl[21], 0, kl[7] + kl[19], 0, kl[11], 0, -kl[23], 0, 0, 0, 0,
+                0, 0, 0, 0, -kl[29], 0, kl[41], 0, kl[27], -kl[39], kl[25] + kl[37], 0,
+                0, 0, 0, 0, 0, -kl[35], 0, kl[47], -kl[33], kl[45], 0, kl[31] + kl[43],
+                kl[4], 0, kl[5], 0, kl[2] + kl[26], 0, 0, 0, -kl[28], 0, -kl[29], 0,
+                -kl[10], 0, 0, kl[11], 0, kl[8] + kl[32], 0, 0, kl[34], 0, 0, -kl[35],
+                0, kl[16], -kl[17], 0, 0, 0, kl[14] + kl[38], 0, 0, -kl[40], kl[41], 0,
+                0, -kl[22], 0, -kl[23], 0, 0, 0, kl[20] + kl[44], 0, kl[46], 0, kl[47];
+
+        mat2_eigen = mat2_eigen.inverse();
+        mat2_eigen.transposeInPlace();
+
+        mat2.resize(12*12);
+        for(int t=0; t<mat2.size(); t++){
+            mat2[t] = mat2_eigen(t);
+        }
+
+        mat = {-kl[0], 0, -kl[3], 0, -kl[4], 0, 0, 0, 0, 0, 0, 0,
+               0, -kl[12], kl[15], 0, 0, 0, -kl[16], 0, 0, 0, 0, 0,
+               0, 0, 0, 0, kl[28], 0, 0, 0, -kl[24], 0, -kl[27], 0,
+               0, 0, 0, 0, 0, 0, kl[40], 0, 0, -kl[36], kl[39], 0,
+               -kl[3], 0, -kl[1], 0, -kl[5], 0, 0, 0, 0, 0, 0, 0,
+               kl[9], 0, 0, -kl[7], 0, -kl[11], 0, 0, 0, 0, 0, 0,
+               0, 0, 0, 0, kl[29], 0, 0, 0, -kl[27], 0, -kl[25], 0,
+               0, 0, 0, 0, 0, kl[35], 0, 0, kl[33], 0, 0, -kl[31],
+               -kl[4], 0, -kl[5], 0, -kl[2], 0, 0, 0, 0, 0, 0, 0,
+               kl[10], 0, 0, -kl[11], 0, -kl[8], 0, 0, 0, 0, 0, 0,
+               0, -kl[16], kl[17], 0, 0, 0, -kl[14], 0, 0, 0, 0, 0,
+               0, kl[22], 0, kl[23], 0, 0, 0, -kl[20], 0, 0, 0, 0}; // A 12x12
+
+        mat2 = matrixMultiply(&mat, 12, 12, &mat2, 12); // E1 = A*C^(-1)
+
+        mat  = {kl[0] + kl[3] + kl[4], kl[6] - kl[9] - kl[10], 0, 0, 0, 0, 0, 0,
+                0, 0, kl[12] - kl[15] + kl[16], kl[18] + kl[21] - kl[22], 0, 0, 0, 0,
+                0, 0, 0, 0, kl[24] + kl[27] - kl[28], kl[30] - kl[33] + kl[34], 0, 0,
+                0, 0, 0, 0, 0, 0, kl[36] - kl[39] - kl[40], kl[42] + kl[45] + kl[46],
+                kl[3] + kl[1] + kl[5], 0, -kl[15] + kl[13] - kl[17], 0, 0, 0, 0, 0,
+                0, -kl[9] + kl[7] + kl[11], 0, kl[21] + kl[19] - kl[23], 0, 0, 0, 0,
+                0, 0, 0, 0, kl[27] + kl[25] - kl[29], 0, -kl[39] + kl[37] + kl[41], 0,
+                0, 0, 0, 0, 0, -kl[33] + kl[31] - kl[35], 0, kl[45] + kl[43] + kl[47],
+                kl[4] + kl[5] + kl[2], 0, 0, 0, -kl[28] - kl[29] + kl[26], 0, 0, 0,
+                0, -kl[10] + kl[11] + kl[8], 0, 0, 0, kl[34] - kl[35] + kl[32], 0, 0,
+                0, 0, kl[16] - kl[17] + kl[14], 0, 0, 0, -kl[40] + kl[41] + kl[38], 0,
+                0, 0, 0, -kl[22] - kl[23] + kl[20], 0, 0, 0, kl[46] + kl[47] + kl[44]}; // D 12x8
+
+        mat2 = matrixMultiply(&mat2, 12, 12, &mat, 8); // E2 = E1*D
+
+        mat = {kl[0] + kl[3] + kl[4], 0, 0, 0, 0, 0, 0, 0,
+               0, 0, kl[12] - kl[15] + kl[16], 0, 0, 0, 0, 0,
+               0, 0, 0, 0, kl[24] + kl[27] - kl[28], 0, 0, 0,
+               0, 0, 0, 0, 0, 0, kl[36] - kl[39] - kl[40], 0,
+               kl[3] + kl[1] + kl[5], 0, 0, 0, 0, 0, 0, 0,
+               0, -kl[9] + kl[7] + kl[11], 0, 0, 0, 0, 0, 0,
+               0, 0, 0, 0, kl[27] + kl[25] - kl[29], 0, 0, 0,
+               0, 0, 0, 0, 0, -kl[33] + kl[31] - kl[35], 0, 0,
+               kl[4] + kl[5] + kl[2], 0, 0, 0, 0, 0, 0, 0,
+               0, -kl[10] + kl[11] + kl[8], 0, 0, 0, 0, 0, 0,
+               0, 0, kl[16] - kl[17] + kl[14], 0, 0, 0, 0, 0,
+               0, 0, 0, -kl[22] - kl[23] + kl[20], 0, 0, 0, 0}; // B 12x8
+    }
+    else if (method == "e") {
+        // eMPFA
+        mat2_eigen << kl[6]+kl[0]+kl[9]/2-kl[3]/2+kl[10]/2-kl[4]/2, -(kl[9]/2)+kl[3]/2, -(kl[9]/2)+kl[3]/2, -(kl[9]/2)+kl[3]/2, -(kl[10]/2)+kl[4]/2, -(kl[10]/2)+kl[4]/2, 0, 0, -(kl[10]/2)+kl[4]/2, 0, 0, 0,
+                -(kl[15]/2)+kl[21]/2, kl[12]+kl[18]+kl[15]/2-kl[21]/2-kl[16]/2+kl[22]/2, -(kl[15]/2)+kl[21]/2, -(kl[15]/2)+kl[21]/2, 0, 0, kl[16]/2-kl[22]/2, kl[16]/2-kl[22]/2, 0, kl[16]/2-kl[22]/2, 0, 0,
+                -(kl[28]/2)+kl[34]/2, 0, 0, 0, -(kl[28]/2)+kl[34]/2, -(kl[28]/2)+kl[34]/2, 0, 0, kl[24]+kl[30]-kl[27]/2+kl[33]/2+kl[28]/2-kl[34]/2, kl[27]/2-kl[33]/2, kl[27]/2-kl[33]/2, kl[27]/2-kl[33]/2,
+                0, -(kl[40]/2)+kl[46]/2, 0, 0, 0, 0, -(kl[40]/2)+kl[46]/2, -(kl[40]/2)+kl[46]/2, -(kl[39]/2)+kl[45]/2, kl[36]+kl[42]+kl[39]/2-kl[45]/2+kl[40]/2-kl[46]/2, -(kl[39]/2)+kl[45]/2, -(kl[39]/2)+kl[45]/2,
+                -(kl[15]/2)+kl[3]/2, -(kl[15]/2)+kl[3]/2, kl[15]/2-kl[3]/2+kl[13]+kl[1]+kl[17]/2-kl[5]/2, -(kl[15]/2)+kl[3]/2, -(kl[17]/2)+kl[5]/2, 0, -(kl[17]/2)+kl[5]/2, 0, 0, 0, -(kl[17]/2)+kl[5]/2, 0,
+                -(kl[9]/2)+kl[21]/2, -(kl[9]/2)+kl[21]/2, -(kl[9]/2)+kl[21]/2, kl[9]/2-kl[21]/2+kl[7]+kl[19]-kl[11]/2+kl[23]/2, 0, kl[11]/2-kl[23]/2, 0, kl[11]/2-kl[23]/2, 0, 0, 0, kl[11]/2-kl[23]/2,
+                0, 0, -(kl[29]/2)+kl[41]/2, 0, -(kl[29]/2)+kl[41]/2, 0, -(kl[29]/2)+kl[41]/2, 0, kl[27]/2-kl[39]/2, kl[27]/2-kl[39]/2, -(kl[27]/2)+kl[39]/2+kl[25]+kl[37]+kl[29]/2-kl[41]/2, kl[27]/2-kl[39]/2,
+                0, 0, 0, -(kl[35]/2)+kl[47]/2, 0, -(kl[35]/2)+kl[47]/2, 0, -(kl[35]/2)+kl[47]/2, -(kl[33]/2)+kl[45]/2, -(kl[33]/2)+kl[45]/2, -(kl[33]/2)+kl[45]/2, kl[33]/2-kl[45]/2+kl[31]+kl[43]+kl[35]/2-kl[47]/2,
+                kl[4]/2-kl[28]/2, 0, kl[5]/2-kl[29]/2, 0, -(kl[4]/2)+kl[28]/2-kl[5]/2+kl[29]/2+kl[2]+kl[26], kl[4]/2-kl[28]/2, kl[5]/2-kl[29]/2, 0, kl[4]/2-kl[28]/2, 0, kl[5]/2-kl[29]/2, 0,
+                -(kl[10]/2)+kl[34]/2, 0, 0, kl[11]/2-kl[35]/2, -(kl[10]/2)+kl[34]/2, kl[10]/2-kl[34]/2-kl[11]/2+kl[35]/2+kl[8]+kl[32], 0, kl[11]/2-kl[35]/2, -(kl[10]/2)+kl[34]/2, 0, 0, kl[11]/2-kl[35]/2,
+                0, kl[16]/2-kl[40]/2, -(kl[17]/2)+kl[41]/2, 0, -(kl[17]/2)+kl[41]/2, 0, -(kl[16]/2)+kl[40]/2+kl[17]/2-kl[41]/2+kl[14]+kl[38], kl[16]/2-kl[40]/2, 0, kl[16]/2-kl[40]/2, -(kl[17]/2)+kl[41]/2, 0,
+                0, -(kl[22]/2)+kl[46]/2, 0, -(kl[23]/2)+kl[47]/2, 0, -(kl[23]/2)+kl[47]/2, -(kl[22]/2)+kl[46]/2, kl[22]/2-kl[46]/2+kl[23]/2-kl[47]/2+kl[20]+kl[44], 0, -(kl[22]/2)+kl[46]/2, 0, -(kl[23]/2)+kl[47]/2; // C 12x12
+
+        mat2_eigen = mat2_eigen.inverse();
+        mat2_eigen.transposeInPlace();
+
+        mat2.resize(12*12);
+        for(int t=0; t<mat2.size(); t++){
+            mat2[t] = mat2_eigen(t);
+        }
+
+        mat = {-kl[0]+kl[3]/2+kl[4]/2, -(kl[3]/2), -(kl[3]/2), -(kl[3]/2), -(kl[4]/2), -(kl[4]/2), 0, 0, -(kl[4]/2), 0, 0, 0,
+               kl[15]/2, -kl[12]-kl[15]/2+kl[16]/2, kl[15]/2, kl[15]/2, 0, 0, -(kl[16]/2), -(kl[16]/2), 0, -(kl[16]/2), 0, 0,
+               kl[28]/2, 0, 0, 0, kl[28]/2, kl[28]/2, 0, 0, -kl[24]+kl[27]/2-kl[28]/2, -(kl[27]/2), -(kl[27]/2), -(kl[27]/2),
+               0, kl[40]/2, 0, 0, 0, 0, kl[40]/2, kl[40]/2, kl[39]/2, -kl[36]-kl[39]/2-kl[40]/2, kl[39]/2, kl[39]/2,
+               -(kl[3]/2), -(kl[3]/2), kl[3]/2-kl[1]+kl[5]/2, -(kl[3]/2), -(kl[5]/2), 0, -(kl[5]/2), 0, 0, 0, -(kl[5]/2), 0,
+               kl[9]/2, kl[9]/2, kl[9]/2, -(kl[9]/2)-kl[7]+kl[11]/2, 0, -(kl[11]/2), 0, -(kl[11]/2), 0, 0, 0, -(kl[11]/2),
+               0, 0, kl[29]/2, 0, kl[29]/2, 0, kl[29]/2, 0, -(kl[27]/2), -(kl[27]/2), kl[27]/2-kl[25]-kl[29]/2, -(kl[27]/2),
+               0, 0, 0, kl[35]/2, 0, kl[35]/2, 0, kl[35]/2, kl[33]/2, kl[33]/2, kl[33]/2, -(kl[33]/2)-kl[31]-kl[35]/2,
+               -(kl[4]/2), 0, -(kl[5]/2), 0, kl[4]/2+kl[5]/2-kl[2], -(kl[4]/2), -(kl[5]/2), 0, -(kl[4]/2), 0, -(kl[5]/2), 0,
+               kl[10]/2, 0, 0, -(kl[11]/2), kl[10]/2, -(kl[10]/2)+kl[11]/2-kl[8], 0, -(kl[11]/2), kl[10]/2, 0, 0, -(kl[11]/2),
+               0, -(kl[16]/2), kl[17]/2, 0, kl[17]/2, 0, kl[16]/2-kl[17]/2-kl[14], -(kl[16]/2), 0, -(kl[16]/2), kl[17]/2, 0,
+               0, kl[22]/2, 0, kl[23]/2, 0, kl[23]/2, kl[22]/2, -(kl[22]/2)-kl[23]/2-kl[20], 0, kl[22]/2, 0, kl[23]/2}; // A 12x12
+
+        mat2 = matrixMultiply(&mat, 12, 12, &mat2, 12); // E1 = A*C^(-1)
+
+        mat = {kl[0]-kl[9]/4+kl[3]/4-kl[10]/4+kl[4]/4, kl[6]-kl[9]/4+kl[3]/4-kl[10]/4+kl[4]/4, -(kl[9]/4)+kl[3]/4, -(kl[9]/4)+kl[3]/4, -(kl[10]/4)+kl[4]/4, -(kl[10]/4)+kl[4]/4, 0, 0,
+               -(kl[15]/4)+kl[21]/4, -(kl[15]/4)+kl[21]/4, kl[12]-kl[15]/4+kl[21]/4+kl[16]/4-kl[22]/4, kl[18]-kl[15]/4+kl[21]/4+kl[16]/4-kl[22]/4, 0, 0, kl[16]/4-kl[22]/4, kl[16]/4-kl[22]/4,
+               -(kl[28]/4)+kl[34]/4, -(kl[28]/4)+kl[34]/4, 0, 0, kl[24]+kl[27]/4-kl[33]/4-kl[28]/4+kl[34]/4, kl[30]+kl[27]/4-kl[33]/4-kl[28]/4+kl[34]/4, kl[27]/4-kl[33]/4, kl[27]/4-kl[33]/4,
+               0, 0, -(kl[40]/4)+kl[46]/4, -(kl[40]/4)+kl[46]/4, -(kl[39]/4)+kl[45]/4, -(kl[39]/4)+kl[45]/4, kl[36]-kl[39]/4+kl[45]/4-kl[40]/4+kl[46]/4, kl[42]-kl[39]/4+kl[45]/4-kl[40]/4+kl[46]/4,
+               -(kl[15]/4)+kl[3]/4+kl[1]-kl[17]/4+kl[5]/4, -(kl[15]/4)+kl[3]/4, -(kl[15]/4)+kl[3]/4+kl[13]-kl[17]/4+kl[5]/4, -(kl[15]/4)+kl[3]/4, -(kl[17]/4)+kl[5]/4, 0, -(kl[17]/4)+kl[5]/4, 0,
+               -(kl[9]/4)+kl[21]/4, -(kl[9]/4)+kl[21]/4+kl[7]+kl[11]/4-kl[23]/4, -(kl[9]/4)+kl[21]/4, -(kl[9]/4)+kl[21]/4+kl[19]+kl[11]/4-kl[23]/4, 0, kl[11]/4-kl[23]/4, 0, kl[11]/4-kl[23]/4,
+               -(kl[29]/4)+kl[41]/4, 0, -(kl[29]/4)+kl[41]/4, 0, kl[27]/4-kl[39]/4+kl[25]-kl[29]/4+kl[41]/4, kl[27]/4-kl[39]/4, kl[27]/4-kl[39]/4+kl[37]-kl[29]/4+kl[41]/4, kl[27]/4-kl[39]/4,
+               0, -(kl[35]/4)+kl[47]/4, 0, -(kl[35]/4)+kl[47]/4, -(kl[33]/4)+kl[45]/4, -(kl[33]/4)+kl[45]/4+kl[31]-kl[35]/4+kl[47]/4, -(kl[33]/4)+kl[45]/4, -(kl[33]/4)+kl[45]/4+kl[43]-kl[35]/4+kl[47]/4,
+               kl[4]/4-kl[28]/4+kl[5]/4-kl[29]/4+kl[2], kl[4]/4-kl[28]/4, kl[5]/4-kl[29]/4, 0, kl[4]/4-kl[28]/4+kl[5]/4-kl[29]/4+kl[26], kl[4]/4-kl[28]/4, kl[5]/4-kl[29]/4, 0,
+               -(kl[10]/4)+kl[34]/4, -(kl[10]/4)+kl[34]/4+kl[11]/4-kl[35]/4+kl[8], 0, kl[11]/4-kl[35]/4, -(kl[10]/4)+kl[34]/4, -(kl[10]/4)+kl[34]/4+kl[11]/4-kl[35]/4+kl[32], 0, kl[11]/4-kl[35]/4,
+               -(kl[17]/4)+kl[41]/4, 0, kl[16]/4-kl[40]/4-kl[17]/4+kl[41]/4+kl[14], kl[16]/4-kl[40]/4, -(kl[17]/4)+kl[41]/4, 0, kl[16]/4-kl[40]/4-kl[17]/4+kl[41]/4+kl[38], kl[16]/4-kl[40]/4,
+               0, -(kl[23]/4)+kl[47]/4, -(kl[22]/4)+kl[46]/4, -(kl[22]/4)+kl[46]/4-kl[23]/4+kl[47]/4+kl[20], 0, -(kl[23]/4)+kl[47]/4, -(kl[22]/4)+kl[46]/4, -(kl[22]/4)+kl[46]/4-kl[23]/4+kl[47]/4+kl[44]}; // D 12x8
+
+        mat2 = matrixMultiply(&mat2, 12, 12, &mat, 8); // E2 = E1*D
+
+        mat = {kl[0]+kl[3]/4+kl[4]/4, kl[3]/4+kl[4]/4, kl[3]/4, kl[3]/4, kl[4]/4, kl[4]/4, 0, 0,
+               -(kl[15]/4), -(kl[15]/4), kl[12]-kl[15]/4+kl[16]/4, -(kl[15]/4)+kl[16]/4, 0, 0, kl[16]/4, kl[16]/4,
+               -(kl[28]/4), -(kl[28]/4), 0, 0, kl[24]+kl[27]/4-kl[28]/4, kl[27]/4-kl[28]/4, kl[27]/4, kl[27]/4,
+               0, 0, -(kl[40]/4), -(kl[40]/4), -(kl[39]/4), -(kl[39]/4), kl[36]-kl[39]/4-kl[40]/4, -(kl[39]/4)-kl[40]/4,
+               kl[3]/4+kl[1]+kl[5]/4, kl[3]/4, kl[3]/4+kl[5]/4, kl[3]/4, kl[5]/4, 0, kl[5]/4, 0,
+               -(kl[9]/4), -(kl[9]/4)+kl[7]+kl[11]/4, -(kl[9]/4), -(kl[9]/4)+kl[11]/4, 0, kl[11]/4, 0, kl[11]/4,
+               -(kl[29]/4), 0, -(kl[29]/4), 0, kl[27]/4+kl[25]-kl[29]/4, kl[27]/4, kl[27]/4-kl[29]/4, kl[27]/4,
+               0, -(kl[35]/4), 0, -(kl[35]/4), -(kl[33]/4), -(kl[33]/4)+kl[31]-kl[35]/4, -(kl[33]/4), -(kl[33]/4)-kl[35]/4,
+               kl[4]/4+kl[5]/4+kl[2], kl[4]/4, kl[5]/4, 0, kl[4]/4+kl[5]/4, kl[4]/4, kl[5]/4, 0,
+               -(kl[10]/4), -(kl[10]/4)+kl[11]/4+kl[8], 0, kl[11]/4, -(kl[10]/4), -(kl[10]/4)+kl[11]/4, 0, kl[11]/4,
+               -(kl[17]/4), 0, kl[16]/4-kl[17]/4+kl[14], kl[16]/4, -(kl[17]/4), 0, kl[16]/4-kl[17]/4, kl[16]/4,
+               0, -(kl[23]/4), -(kl[22]/4), -(kl[22]/4)-kl[23]/4+kl[20], 0, -(kl[23]/4), -(kl[22]/4), -(kl[22]/4)-kl[23]/4}; // B 12x8
+    }
+
+    for(int i2=0;i2<12;i2++){
+        for(int j2=0;j2<8;j2++){
+            E[8*i2+j2] = mat2[8*i2+j2] + mat[8*i2+j2];  // E = E2+B
+            // singular C (e.g. zero conductivities) leaves non finite coefficients, which do not contribute to the fluxes
+            if(std::isnan(E[8*i2+j2]) || std::isinf(E[8*i2+j2])) { E[8*i2+j2] = 0; }
+        }
+    }
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
 bool FV_anisotropic_Diffusion::runIterativeSolver(FV_anisotropic_AMatrix *A) {
+    if (telemetry && solverType != "bicgstab" && solverType != "bicgstab_fused" && solverType != "cg_fused") {
+        std::cout << "Finite Volume Anisotropic Diffusion Warning: telemetry is only supported by the bicgstab and fused solvers, running without" << std::endl;
+    }
+
     if (solverType == "bicgstab"){
-        IterativeSolver::BiCGSTAB(A,T,solverTol,solverMaxIt,print,numThreads);
+        puma::Printer printer;
+        IterativeSolver::BiCGSTAB(A,T,solverTol,solverMaxIt,print,&printer,telemetry,numThreads);
     }
     else if (solverType == "cg") {
         IterativeSolver::ConjugateGradient(A,T,solverTol,solverMaxIt,print,numThreads);
     }
+    else if (solverType == "bicgstab_fused") {
+        puma::Printer printer;
+        IterativeSolver::BiCGSTAB_Fused(A,T,nullptr,solverTol,solverMaxIt,print,&printer,telemetry,numThreads);
+    }
+    else if (solverType == "cg_fused") {
+        puma::Printer printer;
+        IterativeSolver::ConjugateGradient_Fused(A,T,nullptr,solverTol,solverMaxIt,print,&printer,telemetry,numThreads);
+    }
 
     return true;
 }
@@ -449,33 +525,17 @@ bool FV_anisotropic_Diffusion::runIterativeSolver(FV_anisotropic_AMatrix *A) {
  * Inputs: None
  * Outputs: Heat flux for the simulation direction, including diagonals. (Example: XX, XY, XZ)
  */
-bool FV_anisotropic_Diffusion::computeLengthFluxes(puma::Vec3<double> *fluxes, puma::Vec3<double> *length) {
+bool FV_anisotropic_Diffusion::computeLengthFluxes(FV_anisotropic_AMatrix *A, puma::Vec3<double> *fluxes, puma::Vec3<double> *length) {
+
+    // Passing converged voxel fluxes
+    A->computeFluxes(T,q,4*voxelLength);
 
     for(long i=startend[6];i<startend[7];i++) {
         for(long j=startend[8]; j<startend[9]; j++) {
             for(long k=startend[10]; k<startend[11]; k++) {
-                (*fluxes).x += (flux_Matrix.at(i,j,k)[0] + flux_Matrix.at(i,j,k)[1] + flux_Matrix.at(i,j,k)[2] + flux_Matrix.at(i,j,k)[3] +
-                                flux_Matrix.at(i,j,k)[4] + flux_Matrix.at(i,j,k)[5] + flux_Matrix.at(i,j,k)[6] + flux_Matrix.at(i,j,k)[7]) / ( 4*voxelLength );
-                (*fluxes).y += (flux_Matrix.at(i,j,k)[0+8] + flux_Matrix.at(i,j,k)[1+8] + flux_Matrix.at(i,j,k)[2+8] + flux_Matrix.at(i,j,k)[3+8] +
-                                flux_Matrix.at(i,j,k)[4+8] + flux_Matrix.at(i,j,k)[5+8] + flux_Matrix.at(i,j,k)[6+8] + flux_Matrix.at(i,j,k)[7+8]) / ( 4*voxelLength );
-                (*fluxes).z += (flux_Matrix.at(i,j,k)[0+16] + flux_Matrix.at(i,j,k)[1+16] + flux_Matrix.at(i,j,k)[2+16] + flux_Matrix.at(i,j,k)[3+16] +
-                                flux_Matrix.at(i,j,k)[4+16] + flux_Matrix.at(i,j,k)[5+16] + flux_Matrix.at(i,j,k)[6+16] + flux_Matrix.at(i,j,k)[7+16]) / ( 4*voxelLength );
-            }
-        }
-    }
-
-    // Passing converged voxel fluxes
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(int i=0;i<X;i++) {
-        for(int j=0; j<Y; j++) {
-            for(int k=0; k<Z; k++) {
-                (*q).at(i,j,k).x = (flux_Matrix.at(i,j,k)[0] + flux_Matrix.at(i,j,k)[1] + flux_Matrix.at(i,j,k)[2] + flux_Matrix.at(i,j,k)[3] +
-                                    flux_Matrix.at(i,j,k)[4] + flux_Matrix.at(i,j,k)[5] + flux_Matrix.at(i,j,k)[6] + flux_Matrix.at(i,j,k)[7]) / ( 4*voxelLength );
-                (*q).at(i,j,k).y = (flux_Matrix.at(i,j,k)[0+8] + flux_Matrix.at(i,j,k)[1+8] + flux_Matrix.at(i,j,k)[2+8] + flux_Matrix.at(i,j,k)[3+8] +
-                                    flux_Matrix.at(i,j,k)[4+8] + flux_Matrix.at(i,j,k)[5+8] + flux_Matrix.at(i,j,k)[6+8] + flux_Matrix.at(i,j,k)[7+8]) / ( 4*voxelLength );
-                (*q).at(i,j,k).z = (flux_Matrix.at(i,j,k)[0+16] + flux_Matrix.at(i,j,k)[1+16] + flux_Matrix.at(i,j,k)[2+16] + flux_Matrix.at(i,j,k)[3+16] +
-                                    flux_Matrix.at(i,j,k)[4+16] + flux_Matrix.at(i,j,k)[5+16] + flux_Matrix.at(i,j,k)[6+16] + flux_Matrix.at(i,j,k)[7+16]) / ( 4*voxelLength );
+                (*fluxes).x += (*q).at(i,j,k).x;
+                (*fluxes).y += (*q).at(i,j,k).y;
+                (*fluxes).z += (*q).at(i,j,k).z;
             }
         }
     }
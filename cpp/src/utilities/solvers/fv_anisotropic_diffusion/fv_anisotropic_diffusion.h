@@ -6,8 +6,10 @@
 #include "logger.h"
 #include "iterativesolvers.h"
 #include "fv_anisotropic_AMatrix.h"
+#include "fv_anisotropic_tensorfield.h"
 
 #include <Dense>
+#include <array>
 #include <vector>
 #include <map>
 #include <string>
@@ -19,13 +21,27 @@
 class FV_anisotropic_Diffusion
 {
 public:
-    FV_anisotropic_Diffusion(puma::Matrix<double> *T, puma::MatVec3<double> *q, puma::Matrix< std::vector<double> > *kMat,
+    FV_anisotropic_Diffusion(puma::Matrix<double> *T, puma::MatVec3<double> *q, FV_anisotropic_TensorField *kMat,
                              std::string sideBC, puma::Matrix<double> *prescribedBC, std::string solverType, char dir, double voxelLength,
                              double solverTol, int solverMaxIt, bool print, std::string method, int numThreads);
     puma::Vec3<double> compute_DiffusionCoefficient();
 
+    //! records the residual and the time breakdown of each iteration of the solver. Only the bicgstab solver supports it.
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
+
+    //! fills the conductivity tensor field of a segmented workspace.
+    /*!
+     * Materials with 1 (isotropic) or 6 (kxx, kyy, kzz, kxy, kxz, kyz) entries in matCond take one entry of the table
+     * of kMat. Materials with 2 entries (axial and transverse conductivity) are rotated along direction voxel by
+     * voxel, except where direction flags a fiber intersection (magnitude of 2), which is treated as isotropic.
+     * \param segWS a pointer to a segmented workspace containing the domain.
+     * \param matCond a map from the material IDs to their conductivities.
+     * \param kMat a pointer to the tensor field, resized to the workspace.
+     * \param direction a pointer to the orientation of each voxel (only read for materials with 2 entries).
+     * \return a boolean indicating the function executed without errors.
+     */
     static bool computeKMatrix(puma::Workspace *segWS, std::map<int,std::vector<double>> matCond,
-                               puma::Matrix< std::vector<double> > *kMat, puma::MatVec3<double> *direction, bool print, int numThreads);
+                               FV_anisotropic_TensorField *kMat, puma::MatVec3<double> *direction, bool print, int numThreads);
 
     static std::vector<double> matrixMultiply(std::vector<double> *matrix1, int X1, int Y1, std::vector<double> *matrix2, int X2);
 
@@ -33,12 +49,13 @@ private:
     puma::Vec3<double> diffusionCoefficient;
     puma::Matrix<double> *T;
     puma::MatVec3<double> *q;
-    puma::Matrix < std::vector < double > > *kMat;
+    FV_anisotropic_TensorField *kMat;
     puma::Matrix<double> b;
     int X,Y,Z;
 
-    puma::Matrix< std::vector<double> > flux_Matrix;
-    puma::Matrix< std::vector<double> > E_Matrix;
+    // the 12x8 flux stencil of each node is E_Table[96*E_Index(i,j,k)], shared by the nodes with the same surrounding tensors
+    puma::Matrix<int> E_Index;
+    std::vector<double> E_Table;
 
     std::string sideBC;
     puma::Matrix<double> *prescribedBC;
@@ -50,16 +67,18 @@ private:
     bool print;
     std::string method;
     int numThreads;
+    puma::SolverTelemetry *telemetry{nullptr};
 
     bool initializeLinearProfile();
 
     std::vector<long> startend;
 
     bool computeEMatrix();
+    void computeNodeE(long i, long j, long k, double *E);
 
     bool runIterativeSolver(FV_anisotropic_AMatrix *A);
 
-    bool computeLengthFluxes(puma::Vec3<double> *fluxes, puma::Vec3<double> *length);
+    bool computeLengthFluxes(FV_anisotropic_AMatrix *A, puma::Vec3<double> *fluxes, puma::Vec3<double> *length);
 
     long indexAt(long index, long size);
 };
@@ -0,0 +1,41 @@
+#include "fv_anisotropic_tensorfield.h"
+
+
+FV_anisotropic_TensorField::FV_anisotropic_TensorField() = default;
+
+FV_anisotropic_TensorField::FV_anisotropic_TensorField(long X, long Y, long Z) {
+    resize(X, Y, Z);
+}
+
+void FV_anisotropic_TensorField::resize(long X, long Y, long Z) {
+    ids.resize(X, Y, Z, 0);
+    table.clear();
+    for(auto &k : voxelK) {
+        k.resize(0, 0, 0);
+    }
+}
+
+unsigned short FV_anisotropic_TensorField::addTensor(const double *k) {
+    if(tableSize() >= voxelTensor) {
+        return voxelTensor;
+    }
+    table.insert(table.end(), k, k+6);
+    return (unsigned short)(tableSize()-1);
+}
+
+void FV_anisotropic_TensorField::allocateVoxelTensors() {
+    if(hasVoxelTensors()) {
+        return;
+    }
+    for(auto &k : voxelK) {
+        k.resize(ids.X(), ids.Y(), ids.Z(), 0);
+    }
+}
+
+double FV_anisotropic_TensorField::memoryBytes() const {
+    double bytes = (double)ids.size() * sizeof(unsigned short) + (double)table.size() * sizeof(double);
+    for(auto &k : voxelK) {
+        bytes += (double)k.size() * sizeof(double);
+    }
+    return bytes;
+}
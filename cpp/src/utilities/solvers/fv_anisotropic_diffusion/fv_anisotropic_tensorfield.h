@@ -0,0 +1,80 @@
+#ifndef FV_ANISOTROPIC_TENSORFIELD_H
+#define FV_ANISOTROPIC_TENSORFIELD_H
+
+#include "matrix.h"
+
+#include <vector>
+
+
+//! A field of symmetric conductivity tensors, stored as a material ID per voxel indexing a table of tensors.
+/*!
+ *  Tensors are arranged as kxx, kyy, kzz, kxy, kxz, kyz. Phases with a constant tensor take one entry of the table,
+ *  so a voxel only costs its 2 byte ID. Voxels whose tensor is set individually (e.g. rotated along a fiber
+ *  orientation) get the ID voxelTensor, and their components are kept in six contiguous puma matrices (one per
+ *  component), which are only allocated once allocateVoxelTensors is called.
+ *  \sa FV_anisotropic_Diffusion
+ */
+class FV_anisotropic_TensorField
+{
+public:
+
+    //! the ID of the voxels whose tensor is stored per voxel.
+    static const unsigned short voxelTensor = 0xFFFF;
+
+    FV_anisotropic_TensorField();
+    FV_anisotropic_TensorField(long X, long Y, long Z);
+
+    //! resizes the field, setting every voxel to the ID 0 and clearing the table and the voxel tensors.
+    void resize(long X, long Y, long Z);
+
+    long X() { return ids.X(); }
+    long Y() { return ids.Y(); }
+    long Z() { return ids.Z(); }
+    long size() const { return ids.size(); }
+
+    //! appends a tensor to the table.
+    /*!
+     * \param k a pointer to the 6 components of the tensor.
+     * \return the ID of the new entry, or voxelTensor if the table is full.
+     */
+    unsigned short addTensor(const double *k);
+    long tableSize() const { return (long)table.size()/6; }
+
+    //! allocates the per voxel components, needed before setTensor is used. Not thread safe.
+    void allocateVoxelTensors();
+    bool hasVoxelTensors() const { return voxelK[0].size() > 0; }
+
+    unsigned short& id(long i, long j, long k) { return ids.at(i,j,k); }
+
+    //! sets the tensor of a single voxel, which then no longer refers to the table.
+    void setTensor(long i, long j, long k, const double *kVoxel) {
+        ids.at(i,j,k) = voxelTensor;
+        for(int c=0;c<6;c++) {
+            voxelK[c].at(i,j,k) = kVoxel[c];
+        }
+    }
+
+    //! copies the 6 components of the tensor of a voxel into k.
+    void getTensor(long i, long j, long k, double *kVoxel) const {
+        unsigned short n = ids.at(i,j,k);
+        if(n == voxelTensor) {
+            for(int c=0;c<6;c++) {
+                kVoxel[c] = voxelK[c].at(i,j,k);
+            }
+        } else {
+            for(int c=0;c<6;c++) {
+                kVoxel[c] = table[6*n+c];
+            }
+        }
+    }
+
+    //! returns the memory used by the field, in bytes.
+    double memoryBytes() const;
+
+private:
+    puma::Matrix<unsigned short> ids;
+    std::vector<double> table;
+    puma::Matrix<double> voxelK[6];
+};
+
+#endif // FV_ANISOTROPIC_TENSORFIELD_H
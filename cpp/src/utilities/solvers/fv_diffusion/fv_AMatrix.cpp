@@ -4,44 +4,55 @@
 #include <math.h>
 
 
-FV_AMatrix::FV_AMatrix(puma::Matrix<double> *kMat, std::vector<FV_BoundaryCondition*> *bcs, int numThreads) {
+FV_AMatrix::FV_AMatrix(puma::Matrix<double> *kMat, std::vector<FV_BoundaryCondition*> *bcs, int numThreads)
+        : FV_AMatrix(kMat, bcs, numThreads, false) {
+}
+
+FV_AMatrix::FV_AMatrix(puma::Matrix<double> *kMat, std::vector<FV_BoundaryCondition*> *bcs, int numThreads, bool floatConductances) {
     this->kMat = kMat;
     this->bcs = bcs;
+    this->floatConductances = floatConductances;
     this->numThreads = numThreads;
     this->X = (int)kMat->X();
     this->Y = (int)kMat->Y();
     this->Z = (int)kMat->Z();
+    systems.push_back(bcs);
 
     setup_KMinMax();
 }
 
+int FV_AMatrix::addSystem(std::vector<FV_BoundaryCondition*> *bcs) {
+    systems.push_back(bcs);
+    return (int)systems.size()-1;
+}
+
 bool FV_AMatrix::setup_KMinMax() {
     kX.resize( X+1, Y,   Z   );
     kY.resize( X,   Y+1, Z   );
     kZ.resize( X,   Y,   Z+1 );
     Minv.resize(X,   Y,   Z);
 
+    // every face is written once by these two, with NaNs (0/0 between two non-conducting voxels) replaced by 0
     setup_KMM_Interior();
     setup_KMM_Boundaries();
 
-    for(long i=0;i<kX.size();i++) {
-        if(kX(i)!=kX(i)) {
-            std::cout << "nan problem" << std::endl;
-        }
-    }
-    for(long i=0;i<kY.size();i++) {
-        if(kY(i)!=kY(i)) {
-            std::cout << "nan problem" << std::endl;
-        }
-    }
-    for(long i=0;i<kZ.size();i++) {
-        if(kZ(i)!=kZ(i)) {
-            std::cout << "nan problem" << std::endl;
-        }
-    }
-
     setup_Minv();
 
+    if(floatConductances) {
+        kXf.resize(X+1, Y,   Z  );
+        kYf.resize(X,   Y+1, Z  );
+        kZf.resize(X,   Y,   Z+1);
+
+        auto toFloat = [](const double &k, float &kf) { kf = (float)k; };
+        puma::for_each_voxel(&kX, &kXf, toFloat, numThreads);
+        puma::for_each_voxel(&kY, &kYf, toFloat, numThreads);
+        puma::for_each_voxel(&kZ, &kZf, toFloat, numThreads);
+
+        kX.resize(0,0,0);
+        kY.resize(0,0,0);
+        kZ.resize(0,0,0);
+    }
+
     return true;
 }
 
@@ -61,13 +72,31 @@ bool FV_AMatrix::setup_Minv(){
 }
 
 bool FV_AMatrix::A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) {
+    std::vector<puma::Matrix<double>*> xVec(1,x), rVec(1,r);
+    return A_times_X(&xVec, &rVec);
+}
+
+bool FV_AMatrix::A_times_X(std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *r) {
+    if(x->size() > systems.size() || r->size() < x->size()) {
+        std::cout << "FV_AMatrix Error: more vectors than systems" << std::endl;
+        return false;
+    }
 
     computeInteriorResidual(x,r);
-    computeBoundaryResidual(x,r);
+    for(size_t s=0;s<x->size();s++) {
+        if(x->at(s)) {
+            computeBoundaryResidual(x->at(s), r->at(s), (int)s);
+        }
+    }
 
     return true;
 }
 
+double FV_AMatrix::productBytes(puma::Matrix<double> *x) {
+    double kBytes = floatConductances ? sizeof(float) : sizeof(double);
+    return (2. * sizeof(double) + 3. * kBytes) * x->size();
+}
+
 bool FV_AMatrix::Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r){
     omp_set_num_threads(numThreads);
 #pragma omp parallel for
@@ -78,42 +107,54 @@ bool FV_AMatrix::Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r){
     return true;
 }
 
-bool FV_AMatrix::setup_KMM_Interior() {
-    //setting up kX interior
+bool FV_AMatrix::A_times_X(puma::Matrix<float> *x, puma::Matrix<float> *r) {
+    std::vector<puma::Matrix<float>*> xVec(1,x), rVec(1,r);
+    computeInteriorResidual(&xVec,&rVec);
+    computeBoundaryResidual(x, r, 0);
+    return true;
+}
+
+bool FV_AMatrix::Minv_times_X(puma::Matrix<float> *x, puma::Matrix<float> *r){
     omp_set_num_threads(numThreads);
 #pragma omp parallel for
-    for(int i=1;i<X;i++){
-        for(int j=0;j<Y;j++){
-            for(int k=0;k<Z;k++){
-                kX(i,j,k) = kMat->at(i,j,k) * kMat->at(i-1,j,k) / ( kMat->at(i,j,k) + kMat->at(i-1,j,k) );
-                if(kX(i,j,k)!=kX(i,j,k)) { kX(i,j,k)=0; }
-            }
-        }
+    for(long i=0;i<r->size();i++) {
+        r->at(i) = (float)( Minv.at(i) * x->at(i) );
     }
 
-    //setting up kY interior
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(int i=0;i<X;i++){
-        for(int j=1;j<Y;j++){
-            for(int k=0;k<Z;k++){
-                kY(i,j,k) = kMat->at(i,j,k) * kMat->at(i,j-1,k) / ( kMat->at(i,j,k) + kMat->at(i,j-1,k) );
-                if(kY(i,j,k)!=kY(i,j,k)) { kY(i,j,k)=0; }
-            }
+    return true;
+}
+
+bool FV_AMatrix::Minv_times_X(std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *r) {
+    for(size_t s=0;s<x->size();s++) {
+        if(x->at(s)) {
+            Minv_times_X(x->at(s), r->at(s));
         }
     }
+    return true;
+}
+
+bool FV_AMatrix::setup_KMM_Interior() {
+    typedef puma::Shape<puma::Offset<-1,0,0>> FaceX;
+    typedef puma::Shape<puma::Offset<0,-1,0>> FaceY;
+    typedef puma::Shape<puma::Offset<0,0,-1>> FaceZ;
+
+    //setting up kX interior
+    puma::for_each_stencil<FaceX>(kMat, &kX, [](const puma::Stencil<double,FaceX> &k, double &face) {
+        face = k() * k.at<-1,0,0>() / ( k() + k.at<-1,0,0>() );
+        if(face!=face) { face=0; }
+    }, numThreads);
+
+    //setting up kY interior
+    puma::for_each_stencil<FaceY>(kMat, &kY, [](const puma::Stencil<double,FaceY> &k, double &face) {
+        face = k() * k.at<0,-1,0>() / ( k() + k.at<0,-1,0>() );
+        if(face!=face) { face=0; }
+    }, numThreads);
 
     //setting up kZ interior
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(int i=0;i<X;i++){
-        for(int j=0;j<Y;j++){
-            for(int k=1;k<Z;k++){
-                kZ(i,j,k) = kMat->at(i,j,k) * kMat->at(i,j,k-1) / ( kMat->at(i,j,k) + kMat->at(i,j,k-1) );
-                if(kZ(i,j,k)!=kZ(i,j,k)) { kZ(i,j,k)=0; }
-            }
-        }
-    }
+    puma::for_each_stencil<FaceZ>(kMat, &kZ, [](const puma::Stencil<double,FaceZ> &k, double &face) {
+        face = k() * k.at<0,0,-1>() / ( k() + k.at<0,0,-1>() );
+        if(face!=face) { face=0; }
+    }, numThreads);
 
     return true;
 }
@@ -186,25 +227,199 @@ bool FV_AMatrix::setup_KMM_Boundaries() {
 }
 
 
-void FV_AMatrix::computeInteriorResidual(puma::Matrix<double> *x, puma::Matrix<double> *r) {
+template<class V> void FV_AMatrix::computeInteriorResidual(std::vector<puma::Matrix<V>*> *x, std::vector<puma::Matrix<V>*> *r) {
 
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for(long i=1;i<X-1;i++){
-        for(long j=1;j<Y-1;j++){
-            for(long k=1;k<Z-1;k++){
-                r->at(i,j,k) =  ( kX(i+1,j,k) * ( x->at(i+1,j,k)-x->at(i,j,k) ) + kX(i,j,k) * ( x->at(i-1,j,k)-x->at(i,j,k) ) )
-                                +       ( kY(i,j+1,k) * ( x->at(i,j+1,k)-x->at(i,j,k) ) + kY(i,j,k) * ( x->at(i,j-1,k)-x->at(i,j,k) ) )
-                                +       ( kZ(i,j,k+1) * ( x->at(i,j,k+1)-x->at(i,j,k) ) + kZ(i,j,k) * ( x->at(i,j,k-1)-x->at(i,j,k) ) );
+    if(!stencilInterior()) {
+        return;
+    }
+
+    if(floatConductances) {
+        computeInteriorResidual<float,V>(&kXf.at(0), &kYf.at(0), &kZf.at(0), x, r);
+    } else {
+        computeInteriorResidual<double,V>(&kX.at(0), &kY.at(0), &kZ.at(0), x, r);
+    }
+}
+
+/*
+ * Rows (i,j) with 0<i<X-1 and 0<j<Y-1, including their two end voxels k=0 and k=Z-1, which are computed with the
+ * boundary conditions while the row is still in cache.
+ * Each thread owns a contiguous slab of i (same split as a static "omp parallel for" over i) and walks it tile by
+ * tile in j and k, so that the x planes i-1, i and i+1 of a tile are still in cache when the next i is reached.
+ * The k loop is contiguous in every array and vectorizes. With several systems, each row of conductances is used
+ * for all of them while it is in cache. The arithmetic is done in the precision V of the vectors.
+ * Array layouts: x, r (X,Y,Z)   kx (X+1,Y,Z)   ky (X,Y+1,Z)   kz (X,Y,Z+1)
+ */
+template<class K, class V> void FV_AMatrix::computeInteriorResidual(const K *kx, const K *ky, const K *kz, std::vector<puma::Matrix<V>*> *xMats, std::vector<puma::Matrix<V>*> *rMats) {
 
+    const int nSys = (int)xMats->size();
+
+    const long sY = Z;
+    const long sX = (long)Y*Z;
+    const long sYky = (long)(Y+1)*Z;
+    const long sZkz = Z+1;
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel
+    {
+        int nT = omp_get_num_threads();
+        int tID = omp_get_thread_num();
+        long nI = X-2;
+        long iStart = 1 + (nI*tID)/nT;
+        long iEnd = 1 + (nI*(tID+1))/nT;
+
+        for(long j0=1;j0<Y-1;j0+=blockJ) {
+            long j1 = std::min(j0+blockJ, (long)Y-1);
+            for(long k0=1;k0<Z-1;k0+=blockK) {
+                long k1 = std::min(k0+blockK, (long)Z-1);
+                for(long i=iStart;i<iEnd;i++) {
+                    for(long j=j0;j<j1;j++) {
+
+                        const K * __restrict kxm = kx + sX*i + sY*j;
+                        const K * __restrict kxp = kxm + sX;
+                        const K * __restrict kym = ky + sYky*i + sY*j;
+                        const K * __restrict kyp = kym + sY;
+                        const K * __restrict kzc = kz + sZkz*((long)Y*i + j);
+
+                        for(int s=0;s<nSys;s++) {
+                            puma::Matrix<V> *xMat = (*xMats)[s];
+                            puma::Matrix<V> *rMat = (*rMats)[s];
+                            if(!xMat) {
+                                continue;
+                            }
+
+                            if(k0==1) {
+                                rMat->at(i,j,0) = boundaryResidual(i,j,0,xMat,s);
+                            }
+
+                            const V * __restrict xc = &xMat->at(0) + sX*i + sY*j;
+                            V * __restrict rc = &rMat->at(0) + sX*i + sY*j;
+
+#pragma omp simd
+                            for(long k=k0;k<k1;k++) {
+                                V xi = xc[k];
+                                rc[k] =  ( (V)kxp[k] * ( xc[k+sX]-xi ) + (V)kxm[k] * ( xc[k-sX]-xi ) )
+                                         +       ( (V)kyp[k] * ( xc[k+sY]-xi ) + (V)kym[k] * ( xc[k-sY]-xi ) )
+                                         +       ( (V)kzc[k+1] * ( xc[k+1]-xi ) + (V)kzc[k] * ( xc[k-1]-xi ) );
+                            }
+
+                            if(k1==Z-1) {
+                                rMat->at(i,j,Z-1) = boundaryResidual(i,j,Z-1,xMat,s);
+                            }
+                        }
+                    }
+                }
             }
         }
     }
+}
+
+template<class V> double FV_AMatrix::boundaryResidual(long i, long j, long k, puma::Matrix<V> *x, int s) {
+    std::vector<FV_BoundaryCondition*> *bcs = systems[s];
+    return  ( KX(i+1,j,k,s) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) + KX(i,j,k,s) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) )
+            +       ( KY(i,j+1,k,s) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) + KY(i,j,k,s) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) )
+            +       ( KZ(i,j,k+1,s) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) + KZ(i,j,k,s) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
+}
+
+// same expressions as setup_KMM_Boundaries, with the boundary conditions of system s
+double FV_AMatrix::boundaryFaceK(int s, int face, long i, long j, long k) {
+    FV_BoundaryCondition *bc = systems[s]->at(face);
+    double kIn, kOut;
+    switch(face) {
+        case 0: kIn = kMat->at(0,j,k);   kOut = bc->getK_at(-1,j,k,kMat); break;
+        case 1: kIn = kMat->at(X-1,j,k); kOut = bc->getK_at(X,j,k,kMat);  break;
+        case 2: kIn = kMat->at(i,0,k);   kOut = bc->getK_at(i,-1,k,kMat); break;
+        case 3: kIn = kMat->at(i,Y-1,k); kOut = bc->getK_at(i,Y,k,kMat);  break;
+        case 4: kIn = kMat->at(i,j,0);   kOut = bc->getK_at(i,j,-1,kMat); break;
+        default: kIn = kMat->at(i,j,Z-1); kOut = bc->getK_at(i,j,Z,kMat); break;
+    }
+    double kFace = kIn * kOut / ( kIn + kOut );
+    if(kFace!=kFace) { kFace=0; }
+    return floatConductances ? (double)(float)kFace : kFace;
+}
+
+bool FV_AMatrix::relaxRedBlack(puma::Matrix<double> *x, puma::Matrix<double> *b, int color, double omega) {
+
+    if(floatConductances) {
+        relaxRedBlack<float>(&kXf.at(0), &kYf.at(0), &kZf.at(0), x, b, color, omega);
+    } else {
+        relaxRedBlack<double>(&kX.at(0), &kY.at(0), &kZ.at(0), x, b, color, omega);
+    }
+    return true;
+}
+
+/*
+ * Relaxes a voxel next to the domain boundary. Its diagonal is probed from the stencil rather than taken from Minv,
+ * since the ghost values depend on x (e.g. -x for a constant value), which setup_Minv does not account for. With the
+ * diagonal of Minv, the relaxation is unstable for omega above ~1.7.
+ */
+void FV_AMatrix::relaxBoundaryVoxel(long i, long j, long k, puma::Matrix<double> *x, puma::Matrix<double> *b, double omega) {
+    double xi = x->at(i,j,k);
+    double Ax = boundaryResidual(i,j,k,x,0);
+    x->at(i,j,k) = xi + 1;
+    double diag = boundaryResidual(i,j,k,x,0) - Ax;
+    x->at(i,j,k) = (diag != 0) ? xi + omega * ( b->at(i,j,k) - Ax ) / diag : xi;
+}
+
+/*
+ * x += omega * Minv * (b - A x) on the voxels of one colour. Interior rows use the raw-array stencil with a
+ * stride-2 k loop, boundary rows and the row ends go through relaxBoundaryVoxel.
+ */
+template<class K> void FV_AMatrix::relaxRedBlack(const K *kx, const K *ky, const K *kz, puma::Matrix<double> *xMat, puma::Matrix<double> *bMat, int color, double omega) {
+
+    double *x = &xMat->at(0);
+    const double *b = &bMat->at(0);
+    const double *minv = &Minv.at(0);
 
+    const long sY = Z;
+    const long sX = (long)Y*Z;
+    const long sYky = (long)(Y+1)*Z;
+    const long sZkz = Z+1;
 
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for
+    for(long i=0;i<X;i++) {
+        for(long j=0;j<Y;j++) {
+
+            long kFirst = (color + i + j) & 1;
+            long row = sX*i + sY*j;
+
+            if(!stencilInterior() || i==0 || i==X-1 || j==0 || j==Y-1) {
+                for(long k=kFirst;k<Z;k+=2) {
+                    relaxBoundaryVoxel(i,j,k,xMat,bMat,omega);
+                }
+                continue;
+            }
+
+            if(kFirst == 0) {
+                relaxBoundaryVoxel(i,j,0,xMat,bMat,omega);
+            }
+
+            double *xc = x + row;
+            const double *bc = b + row;
+            const double *mc = minv + row;
+            const K *kxm = kx + row;
+            const K *kxp = kxm + sX;
+            const K *kym = ky + sYky*i + sY*j;
+            const K *kyp = kym + sY;
+            const K *kzc = kz + sZkz*((long)Y*i + j);
+
+#pragma omp simd
+            for(long k=2-kFirst;k<Z-1;k+=2) {
+                double xi = xc[k];
+                double Ax =  ( (double)kxp[k] * ( xc[k+sX]-xi ) + (double)kxm[k] * ( xc[k-sX]-xi ) )
+                             +       ( (double)kyp[k] * ( xc[k+sY]-xi ) + (double)kym[k] * ( xc[k-sY]-xi ) )
+                             +       ( (double)kzc[k+1] * ( xc[k+1]-xi ) + (double)kzc[k] * ( xc[k-1]-xi ) );
+                xc[k] = xi + omega * mc[k] * ( bc[k] - Ax );
+            }
+
+            if(((Z-1-kFirst) & 1) == 0) {
+                relaxBoundaryVoxel(i,j,Z-1,xMat,bMat,omega);
+            }
+        }
+    }
 }
 
-void FV_AMatrix::computeBoundaryResidual(puma::Matrix<double> *x, puma::Matrix<double> *r) {
+template<class V> void FV_AMatrix::computeBoundaryResidual(puma::Matrix<V> *x, puma::Matrix<V> *r, int s) {
 
     //X Boundaries residual
     omp_set_num_threads(numThreads);
@@ -212,10 +427,7 @@ void FV_AMatrix::computeBoundaryResidual(puma::Matrix<double> *x, puma::Matrix<d
     for(int j=0;j<Y;j++){
         for(int i=0;i<X;i+= std::max(X-1,1) ) {
             for(int k=0;k<Z;k++){
-                r->at(i,j,k) =  ( kX(i+1,j,k) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) + kX(i,j,k) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) )
-                                +       ( kY(i,j+1,k) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) + kY(i,j,k) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) )
-                                +       ( kZ(i,j,k+1) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) + kZ(i,j,k) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
-
+                r->at(i,j,k) = boundaryResidual(i,j,k,x,s);
             }
         }
     }
@@ -226,22 +438,21 @@ void FV_AMatrix::computeBoundaryResidual(puma::Matrix<double> *x, puma::Matrix<d
     for(int i=0;i<X;i++) {
         for(int j=0;j<Y;j+= std::max(Y-1,1) ){
             for(int k=0;k<Z;k++){
-                r->at(i,j,k) =  ( kX(i+1,j,k) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) + kX(i,j,k) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) )
-                                +       ( kY(i,j+1,k) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) + kY(i,j,k) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) )
-                                +       ( kZ(i,j,k+1) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) + kZ(i,j,k) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
+                r->at(i,j,k) = boundaryResidual(i,j,k,x,s);
             }
         }
     }
 
-    //Z Boundaries residual
+    //Z Boundaries residual, already covered by the interior rows unless the domain is too thin for the stencil
+    if(stencilInterior()) {
+        return;
+    }
     omp_set_num_threads(numThreads);
 #pragma omp parallel for
     for(int i=0;i<X;i++) {
         for(int j=0;j<Y;j++){
             for(int k=0;k<Z;k+= std::max(Z-1,1) ){
-                r->at(i,j,k) =  ( kX(i+1,j,k) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) + kX(i,j,k) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) )
-                                +       ( kY(i,j+1,k) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) + kY(i,j,k) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) )
-                                +       ( kZ(i,j,k+1) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) + kZ(i,j,k) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
+                r->at(i,j,k) = boundaryResidual(i,j,k,x,s);
             }
         }
     }
@@ -249,6 +460,11 @@ void FV_AMatrix::computeBoundaryResidual(puma::Matrix<double> *x, puma::Matrix<d
 
 
 puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir ) {
+    return computeFluxes(x, dir, 0);
+}
+
+puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir, int s) {
+    std::vector<FV_BoundaryCondition*> *bcs = systems[s];
     std::vector<double> fluxVec_X(X,0);
     std::vector<double> fluxVec_Y(Y,0);
     std::vector<double> fluxVec_Z(Z,0);
@@ -259,7 +475,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long i=1;i<X-1;i++){
             for(long j=0;j<Y;j++){
                 for(long k=0;k<Z;k++){
-                    double localFlux_X = ( kX(i+1,j,k) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - kX(i,j,k) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
+                    double localFlux_X = ( KX(i+1,j,k,s) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - KX(i,j,k,s) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
                     if(localFlux_X!=localFlux_X){localFlux_X=0;}
                     fluxVec_X[i]+=localFlux_X;
                 }
@@ -269,7 +485,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         long i = 0;
         for(long j=0;j<Y;j++){
             for(long k=0;k<Z;k++){
-                double localFlux_X = ( kX(i+1,j,k) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - kX(i,j,k) * ( ( -x->at(i,j,k)) - x->at(i,j,k) ) );
+                double localFlux_X = ( KX(i+1,j,k,s) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - KX(i,j,k,s) * ( bcs->at(0)->getFieldX_at(i-1,j,k,x) - x->at(i,j,k) ) );
                 if(localFlux_X!=localFlux_X){localFlux_X=0;}
                 fluxVec_X[i]+=localFlux_X;
             }
@@ -278,7 +494,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         i = X-1;
         for(long j=0;j<Y;j++){
             for(long k=0;k<Z;k++){
-                double localFlux_X = ( kX(i+1,j,k) * ( (2 - x->at(i,j,k) ) - x->at(i,j,k) ) - kX(i,j,k) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
+                double localFlux_X = ( KX(i+1,j,k,s) * ( bcs->at(1)->getFieldX_at(i+1,j,k,x) - x->at(i,j,k) ) - KX(i,j,k,s) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
                 if(localFlux_X!=localFlux_X){localFlux_X=0;}
                 fluxVec_X[i]+=localFlux_X;
             }
@@ -289,7 +505,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long j=0;j<Y;j++){
             for(long i=0;i<X;i++){
                 for(long k=0;k<Z;k++){
-                    double localFlux_Y = ( kY(i,j+1,k) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - kY(i,j,k) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
+                    double localFlux_Y = ( KY(i,j+1,k,s) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - KY(i,j,k,s) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
                     if(localFlux_Y!=localFlux_Y){localFlux_Y=0;}
                     fluxVec_Y[j]+=localFlux_Y;
                 }
@@ -301,7 +517,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long k=0;k<Z;k++){
             for(long i=0;i<X;i++){
                 for(long j=0;j<Y;j++){
-                    double localFlux_Z = ( kZ(i,j,k+1) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - kZ(i,j,k) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
+                    double localFlux_Z = ( KZ(i,j,k+1,s) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - KZ(i,j,k,s) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
                     if(localFlux_Z!=localFlux_Z){localFlux_Z=0;}
                     fluxVec_Z[k]+=localFlux_Z;
                 }
@@ -316,7 +532,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long i=0;i<X;i++){
             for(long j=0;j<Y;j++){
                 for(long k=0;k<Z;k++){
-                    double localFlux_X = ( kX(i+1,j,k) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - kX(i,j,k) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
+                    double localFlux_X = ( KX(i+1,j,k,s) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - KX(i,j,k,s) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
                     if(localFlux_X!=localFlux_X){localFlux_X=0;}
                     fluxVec_X[i]+=localFlux_X;
                 }
@@ -328,7 +544,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long j=1;j<Y-1;j++){
             for(long i=0;i<X;i++){
                 for(long k=0;k<Z;k++){
-                    double localFlux_Y = ( kY(i,j+1,k) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - kY(i,j,k) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
+                    double localFlux_Y = ( KY(i,j+1,k,s) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - KY(i,j,k,s) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
                     if(localFlux_Y!=localFlux_Y){localFlux_Y=0;}
                     fluxVec_Y[j]+=localFlux_Y;
                 }
@@ -338,7 +554,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         long j = 0;
         for(long i=0;i<X;i++){
             for(long k=0;k<Z;k++){
-                double localFlux_Y = ( kY(i,j+1,k) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - kY(i,j,k) * ( ( -x->at(i,j,k)) -x->at(i,j,k) ) );
+                double localFlux_Y = ( KY(i,j+1,k,s) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - KY(i,j,k,s) * ( bcs->at(2)->getFieldX_at(i,j-1,k,x) - x->at(i,j,k) ) );
                 if(localFlux_Y!=localFlux_Y){localFlux_Y=0;}
                 fluxVec_Y[j]+=localFlux_Y;
             }
@@ -348,7 +564,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         j = Y-1;
         for(long i=0;i<X;i++){
             for(long k=0;k<Z;k++){
-                double localFlux_Y = ( kY(i,j+1,k) * ( (2 - x->at(i,j,k) ) -x->at(i,j,k) ) - kY(i,j,k) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
+                double localFlux_Y = ( KY(i,j+1,k,s) * ( bcs->at(3)->getFieldX_at(i,j+1,k,x) - x->at(i,j,k) ) - KY(i,j,k,s) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
                 if(localFlux_Y!=localFlux_Y){localFlux_Y=0;}
                 fluxVec_Y[j]+=localFlux_Y;
             }
@@ -359,7 +575,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long k=0;k<Z;k++){
             for(long i=0;i<X;i++){
                 for(long j=0;j<Y;j++){
-                    double localFlux_Z = ( kZ(i,j,k+1) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - kZ(i,j,k) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
+                    double localFlux_Z = ( KZ(i,j,k+1,s) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - KZ(i,j,k,s) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
                     if(localFlux_Z!=localFlux_Z){localFlux_Z=0;}
                     fluxVec_Z[k]+=localFlux_Z;
                 }
@@ -374,7 +590,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long i=0;i<X;i++){
             for(long j=0;j<Y;j++){
                 for(long k=0;k<Z;k++){
-                    double localFlux_X = ( kX(i+1,j,k) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - kX(i,j,k) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
+                    double localFlux_X = ( KX(i+1,j,k,s) * ( bcs->at(1)->getX_at(i+1,j,k,x)-x->at(i,j,k) ) - KX(i,j,k,s) * ( bcs->at(0)->getX_at(i-1,j,k,x)-x->at(i,j,k) ) );
                     if(localFlux_X!=localFlux_X){localFlux_X=0;}
                     fluxVec_X[i]+=localFlux_X;
                 }
@@ -386,7 +602,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long j=0;j<Y;j++){
             for(long i=0;i<X;i++){
                 for(long k=0;k<Z;k++){
-                    double localFlux_Y = ( kY(i,j+1,k) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - kY(i,j,k) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
+                    double localFlux_Y = ( KY(i,j+1,k,s) * ( bcs->at(3)->getX_at(i,j+1,k,x)-x->at(i,j,k) ) - KY(i,j,k,s) * ( bcs->at(2)->getX_at(i,j-1,k,x)-x->at(i,j,k) ) );
                     if(localFlux_Y!=localFlux_Y){localFlux_Y=0;}
                     fluxVec_Y[j]+=localFlux_Y;
                 }
@@ -398,7 +614,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         for(long k=1;k<Z-1;k++){
             for(long i=0;i<X;i++){
                 for(long j=0;j<Y;j++){
-                    double localFlux_Z = ( kZ(i,j,k+1) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - kZ(i,j,k) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
+                    double localFlux_Z = ( KZ(i,j,k+1,s) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - KZ(i,j,k,s) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
                     if(localFlux_Z!=localFlux_Z){localFlux_Z=0;}
                     fluxVec_Z[k]+=localFlux_Z;
                 }
@@ -408,7 +624,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         long k = 0;
         for(long i=0;i<X;i++){
             for(long j=0;j<Y;j++){
-                double localFlux_Z = ( kZ(i,j,k+1) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - kZ(i,j,k) * ( ( -x->at(i,j,k)) -x->at(i,j,k) ) );
+                double localFlux_Z = ( KZ(i,j,k+1,s) * ( bcs->at(5)->getX_at(i,j,k+1,x)-x->at(i,j,k) ) - KZ(i,j,k,s) * ( bcs->at(4)->getFieldX_at(i,j,k-1,x) - x->at(i,j,k) ) );
                 if(localFlux_Z!=localFlux_Z){localFlux_Z=0;}
                 fluxVec_Z[k]+=localFlux_Z;
             }
@@ -417,7 +633,7 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
         k = Z-1;
         for(long i=0;i<X;i++){
             for(long j=0;j<Y;j++){
-                double localFlux_Z = ( kZ(i,j,k+1) * (   (2 - x->at(i,j,k) ) -x->at(i,j,k) ) - kZ(i,j,k) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
+                double localFlux_Z = ( KZ(i,j,k+1,s) * ( bcs->at(5)->getFieldX_at(i,j,k+1,x) - x->at(i,j,k) ) - KZ(i,j,k,s) * ( bcs->at(4)->getX_at(i,j,k-1,x)-x->at(i,j,k) ) );
                 if(localFlux_Z!=localFlux_Z){localFlux_Z=0;}
                 fluxVec_Z[k]+=localFlux_Z;
             }
@@ -425,18 +641,12 @@ puma::Vec3<double> FV_AMatrix::computeFluxes(puma::Matrix<double> *x, char dir )
 
     }
 
-    // MAC
     puma::Vec3<double> fluxes(0,0,0);
 
-#ifdef MAC
-    fluxes.x = accumulate(fluxVec_X.begin(), fluxVec_X.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.y = accumulate(fluxVec_Y.begin(), fluxVec_Y.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.z = accumulate(fluxVec_Z.begin(), fluxVec_Z.end(),0.0)/((X)*(Y)*(Z));
-#elif LINUX
-    fluxes.x = __gnu_parallel::accumulate(fluxVec_X.begin(), fluxVec_X.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.y = __gnu_parallel::accumulate(fluxVec_Y.begin(), fluxVec_Y.end(),0.0)/((X)*(Y)*(Z));
-    fluxes.z = __gnu_parallel::accumulate(fluxVec_Z.begin(), fluxVec_Z.end(),0.0)/((X)*(Y)*(Z));
-#endif
+    // summed with puma::Reduction so that the fluxes do not depend on the number of threads
+    fluxes.x = puma::Reduction::sum((long)fluxVec_X.size(), [&fluxVec_X](long n) { return fluxVec_X[n]; }, numThreads)/((X)*(Y)*(Z));
+    fluxes.y = puma::Reduction::sum((long)fluxVec_Y.size(), [&fluxVec_Y](long n) { return fluxVec_Y[n]; }, numThreads)/((X)*(Y)*(Z));
+    fluxes.z = puma::Reduction::sum((long)fluxVec_Z.size(), [&fluxVec_Z](long n) { return fluxVec_Z[n]; }, numThreads)/((X)*(Y)*(Z));
 
     return fluxes;
 }
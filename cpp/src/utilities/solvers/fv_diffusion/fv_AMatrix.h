@@ -4,39 +4,108 @@
 #include "vector.h"
 #include "fv_boundarycondition.h"
 #include "AMatrix.h"
-
-#ifdef MAC
-#include <numeric>
-#elif LINUX
-#include <parallel/numeric>
-#endif
+#include "reduction.h"
 
 
 class FV_AMatrix : public AMatrix
 {
 public:
     FV_AMatrix(puma::Matrix<double> *kMat, std::vector<FV_BoundaryCondition*> *bcs, int numThreads);
+
+    //! constructs the linear system, optionally storing the face conductances in single precision.
+    /*!
+     * \param kMat a pointer to a puma matrix containing the conductivity of each voxel.
+     * \param bcs a pointer to the six boundary conditions (xMin, xMax, yMin, yMax, zMin, zMax).
+     * \param numThreads an integer which specifies the number of threads used.
+     * \param floatConductances a boolean which, if true, stores kX, kY and kZ as floats. This halves the memory
+     *        traffic of the conductances in A_times_X, at the cost of rounding them to ~7 significant digits.
+     */
+    FV_AMatrix(puma::Matrix<double> *kMat, std::vector<FV_BoundaryCondition*> *bcs, int numThreads, bool floatConductances);
     bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override;
     bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override;
     puma::Vec3<double> computeFluxes(puma::Matrix<double> *x, char dir );
 
+    //! adds a system which shares the conductances of this operator but has different boundary conditions.
+    /*!
+     * Only the faces on the domain boundary depend on the boundary conditions, so these are evaluated on the fly
+     * for the added systems. The constructor's boundary conditions are system 0.
+     * \param bcs a pointer to the six boundary conditions of the new system.
+     * \return the index of the new system.
+     */
+    int addSystem(std::vector<FV_BoundaryCondition*> *bcs);
+
+    //! applies system s to (*x)[s], reading the conductances once for all systems. nullptr entries are skipped.
+    bool A_times_X(std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *r) override;
+
+    //! applies the diagonal preconditioner of system 0 to every vector. It differs from the one of the other systems only on boundary voxels.
+    bool Minv_times_X(std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *r) override;
+
+    //! single precision product with system 0, used by the inner iterations of the mixed precision solvers.
+    /*!
+     * Same stencil as the double precision product, evaluated in single precision. With float conductances, every
+     * array read by the interior kernel is single precision, which halves its memory traffic.
+     */
+    bool A_times_X(puma::Matrix<float> *x, puma::Matrix<float> *r) override;
+    bool Minv_times_X(puma::Matrix<float> *x, puma::Matrix<float> *r) override;
+
+    //! counts x, the result and the three face conductances of each voxel.
+    double productBytes(puma::Matrix<double> *x) override;
+
+    //! computes the fluxes of the solution x of system s.
+    puma::Vec3<double> computeFluxes(puma::Matrix<double> *x, char dir, int s);
+
+    //! relaxes the voxels of one colour of a red-black ordering of A x = b (Gauss-Seidel for omega = 1, SOR for 1 < omega < 2).
+    /*!
+     * Voxels with (i+j+k)%2 == color are updated in parallel, since they only couple to voxels of the other colour.
+     * \param x a pointer to a puma matrix holding the current iterate, updated in place.
+     * \param b a pointer to a puma matrix holding the right-hand side.
+     * \param color 0 for red voxels, 1 for black voxels.
+     * \param omega the relaxation factor.
+     * \return true.
+     */
+    bool relaxRedBlack(puma::Matrix<double> *x, puma::Matrix<double> *b, int color, double omega) override;
+
 private:
     std::vector<FV_BoundaryCondition*> *bcs;
+    std::vector<std::vector<FV_BoundaryCondition*>*> systems;
     puma::Matrix<double> *kMat;
     puma::Matrix<double> kX;
     puma::Matrix<double> kY;
     puma::Matrix<double> kZ;
     puma::Matrix<double> Minv;
+    puma::Matrix<float> kXf;
+    puma::Matrix<float> kYf;
+    puma::Matrix<float> kZf;
+    bool floatConductances;
     int numThreads;
     int X,Y,Z;
 
+    // tile sizes of the interior stencil in j and k
+    static const long blockJ = 16;
+    static const long blockK = 512;
+
+    double KX(long i, long j, long k) { return floatConductances ? kXf(i,j,k) : kX(i,j,k); }
+    double KY(long i, long j, long k) { return floatConductances ? kYf(i,j,k) : kY(i,j,k); }
+    double KZ(long i, long j, long k) { return floatConductances ? kZf(i,j,k) : kZ(i,j,k); }
+
+    // face conductances of system s: system 0 is stored, the domain boundary faces of the others are computed
+    double KX(long i, long j, long k, int s) { return (s==0 || (i>0 && i<X)) ? KX(i,j,k) : boundaryFaceK(s, i==0 ? 0 : 1, i, j, k); }
+    double KY(long i, long j, long k, int s) { return (s==0 || (j>0 && j<Y)) ? KY(i,j,k) : boundaryFaceK(s, j==0 ? 2 : 3, i, j, k); }
+    double KZ(long i, long j, long k, int s) { return (s==0 || (k>0 && k<Z)) ? KZ(i,j,k) : boundaryFaceK(s, k==0 ? 4 : 5, i, j, k); }
+    double boundaryFaceK(int s, int face, long i, long j, long k);
+
     bool setup_KMinMax();
     bool setup_KMM_Interior();
     bool setup_KMM_Boundaries();
     bool setup_Minv();
 
-    void computeInteriorResidual(puma::Matrix<double> *x, puma::Matrix<double> *r);
-    void computeBoundaryResidual(puma::Matrix<double> *x, puma::Matrix<double> *r);
+    template<class V> void computeInteriorResidual(std::vector<puma::Matrix<V>*> *x, std::vector<puma::Matrix<V>*> *r);
+    template<class K, class V> void computeInteriorResidual(const K *kx, const K *ky, const K *kz, std::vector<puma::Matrix<V>*> *xMats, std::vector<puma::Matrix<V>*> *rMats);
+    template<class K> void relaxRedBlack(const K *kx, const K *ky, const K *kz, puma::Matrix<double> *xMat, puma::Matrix<double> *bMat, int color, double omega);
+    template<class V> double boundaryResidual(long i, long j, long k, puma::Matrix<V> *x, int s);
+    void relaxBoundaryVoxel(long i, long j, long k, puma::Matrix<double> *x, puma::Matrix<double> *b, double omega);
+    bool stencilInterior() { return X>=3 && Y>=3 && Z>=3; }
+    template<class V> void computeBoundaryResidual(puma::Matrix<V> *x, puma::Matrix<V> *r, int s);
 };
 
 #endif // FV_AMatrix_H
@@ -7,8 +7,22 @@
 class FV_BoundaryCondition
 {
 public:
+    virtual ~FV_BoundaryCondition() = default;
     virtual double getK_at(long i, long j, long k, puma::Matrix<double> *kMat) = 0;
     virtual double getX_at(long i, long j, long k, puma::Matrix<double> *x) = 0;
+
+    //! single precision version of getX_at, used by the single precision products of FV_AMatrix.
+    virtual float getX_at(long i, long j, long k, puma::Matrix<float> *x) = 0;
+
+    //! ghost value of the full field (the solution plus the imposed linear profile), used to compute the fluxes.
+    /*!
+     * getX_at gives the ghost of the homogeneous problem solved by FV_AMatrix. They only differ for boundaries
+     * imposing a value, so the default returns getX_at.
+     */
+    virtual double getFieldX_at(long i, long j, long k, puma::Matrix<double> *x) { return getX_at(i,j,k,x); }
+
+    //! creates a boundary condition of the same type for a domain of a different size (e.g. a coarser grid).
+    virtual FV_BoundaryCondition* clone(int X, int Y, int Z) = 0;
 };
 
 #endif // FV_BOUNDARYCONDITION_H
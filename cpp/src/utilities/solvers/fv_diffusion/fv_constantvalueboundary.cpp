@@ -31,7 +31,7 @@ double FV_ConstantValueBoundary::getK_at(long i, long j, long k, puma::Matrix<do
     return kMat->at(i,j,k);
 }
 
-double FV_ConstantValueBoundary::getX_at(long i, long j, long k,puma::Matrix<double> *T) {
+template<class V> V FV_ConstantValueBoundary::ghostX(long i, long j, long k, puma::Matrix<V> *T) {
     if(i==-1) {
         return -T->at(0,j,k);
     }
@@ -52,3 +52,21 @@ double FV_ConstantValueBoundary::getX_at(long i, long j, long k,puma::Matrix<dou
     }
     return T->at(i,j,k);
 }
+
+double FV_ConstantValueBoundary::getX_at(long i, long j, long k,puma::Matrix<double> *T) {
+    return ghostX(i,j,k,T);
+}
+
+float FV_ConstantValueBoundary::getX_at(long i, long j, long k,puma::Matrix<float> *T) {
+    return ghostX(i,j,k,T);
+}
+
+// the face is at the imposed value, so the ghost mirrors the voxel about it
+double FV_ConstantValueBoundary::getFieldX_at(long i, long j, long k,puma::Matrix<double> *T) {
+    bool outside = i<0 || j<0 || k<0 || i>=X || j>=Y || k>=Z;
+    return outside ? 2*value + ghostX(i,j,k,T) : ghostX(i,j,k,T);
+}
+
+FV_BoundaryCondition* FV_ConstantValueBoundary::clone(int X, int Y, int Z) {
+    return new FV_ConstantValueBoundary(value, X, Y, Z);
+}
@@ -1,19 +1,31 @@
 #include "fv_diffusion.h"
 
+#include <iomanip>
+#include <sstream>
+
 
 bool FV_Diffusion::computeKMatrix(puma::Workspace *segWS, std::map<int, double> matCond, puma::Matrix<double> *kMat, int numThreads) {
     kMat->resize(segWS->X(),segWS->Y(),segWS->Z(),0);
+    if(segWS->size() == 0) {
+        return true;
+    }
 
-// TEMPORARY FIX: removing parallelization to this for loop as it intermittently fails on some linux systems
-//    omp_set_num_threads(numThreads);
-//#pragma omp parallel for
-    for (long i=0; i<kMat->X(); i++) {
-        for (long j=0; j<kMat->Y(); j++) {
-            for (long k=0; k<kMat->Z(); k++) {
-                kMat->at(i,j,k) = matCond[segWS->at(i,j,k)];
-            }
+    // the conductivities are looked up in a table over the grayscale range, since the shared std::map cannot be read
+    // through operator[] from several threads (it inserts missing keys), which made the parallel loop fail
+    short minValue = segWS->matrix.min(numThreads);
+    short maxValue = segWS->matrix.max(numThreads);
+    std::vector<double> table(maxValue - minValue + 1, 0.);
+    for(int value=minValue; value<=maxValue; value++) {
+        auto it = matCond.find(value);
+        if(it != matCond.end()) {
+            table[value - minValue] = it->second;
         }
     }
+
+    const double *cond = &table[0];
+    puma::for_each_voxel(&segWS->matrix, kMat, [cond,minValue](const short &value, double &k) {
+        k = cond[value - minValue];
+    }, numThreads);
     return true;
 }
 
@@ -68,6 +80,14 @@ FV_Diffusion::~FV_Diffusion() {
     if(printer && delPrinter) {
         delete printer;
     }
+    for(auto *bc : boundaries) {
+        delete bc;
+    }
+    for(auto &bcs : tensorBoundaries) {
+        for(auto *bc : bcs) {
+            delete bc;
+        }
+    }
 }
 
 puma::Vec3<double> FV_Diffusion::compute_DiffusionCoefficient()
@@ -75,20 +95,35 @@ puma::Vec3<double> FV_Diffusion::compute_DiffusionCoefficient()
     if(!setupBoundaries()) {
         return puma::Vec3<double>(-1,-1,-1);
     }
+    if(slab && !setupHaloBoundaries()) {
+        return puma::Vec3<double>(-1,-1,-1);
+    }
     if(!setInitialConditions()) {
         return puma::Vec3<double>(-1,-1,-1);
     }
 
-    FV_AMatrix A(kMat,&boundaries,numThreads);
+    // the mixed precision solver streams single precision conductances in its inner iterations
+    FV_AMatrix A(kMat,&boundaries,numThreads,mixedPrecision());
 
     if(!runIterativeSolver(&A)) {
         return puma::Vec3<double>(-1,-1,-1);
     }
 
-    addLinearProfile();
+    addLinearProfile(1);
+    if(slab && !slab->exchange(T, periodicX(), &haloX[0], &haloX[1])) {
+        return puma::Vec3<double>(-1,-1,-1);
+    }
 
     puma::Vec3<double> fluxes = A.computeFluxes(T, dir);
-    puma::Vec3<double> length(X, Y, Z);
+    puma::Vec3<double> length(globalX(), Y, Z);
+
+    if(slab) {
+        // computeFluxes averages over the local slab
+        double share = (double)X / globalX();
+        fluxes.x = slab->sum(fluxes.x * share);
+        fluxes.y = slab->sum(fluxes.y * share);
+        fluxes.z = slab->sum(fluxes.z * share);
+    }
 
     diffusionCoefficient.x = fluxes.x * length.x;
     diffusionCoefficient.y = fluxes.y * length.y;
@@ -97,6 +132,61 @@ puma::Vec3<double> FV_Diffusion::compute_DiffusionCoefficient()
     return diffusionCoefficient;
 }
 
+std::vector<puma::Vec3<double>> FV_Diffusion::compute_DiffusionTensor(puma::Matrix<double> *Tx, puma::Matrix<double> *Ty, puma::Matrix<double> *Tz)
+{
+    std::vector<puma::Vec3<double>> coefficients(3, puma::Vec3<double>(-1,-1,-1));
+    if(slab) {
+        printer->print("Finite Volume Diffusion Error: the diffusion tensor is not supported on a decomposed domain");
+        return coefficients;
+    }
+    puma::Matrix<double> *fields[3] = { Tx, Ty, Tz };
+    const char dirs[3] = { 'x', 'y', 'z' };
+
+    // the single direction routines work on T, dir, boundaries and b
+    char userDir = dir;
+    puma::Matrix<double> *userT = T;
+
+    std::vector<puma::Matrix<double>> bVec(3);
+    tensorBoundaries.resize(3);
+    for(int d=0;d<3;d++) {
+        dir = dirs[d];
+        T = fields[d];
+        bool ok = setupBoundaries() && setInitialConditions();
+        tensorBoundaries[d] = boundaries;
+        boundaries.clear();
+        if(!ok) {
+            dir = userDir;
+            T = userT;
+            return coefficients;
+        }
+        bVec[d].copy(&b);
+    }
+
+    FV_AMatrix A(kMat,&tensorBoundaries[0],numThreads);
+    A.addSystem(&tensorBoundaries[1]);
+    A.addSystem(&tensorBoundaries[2]);
+
+    std::vector<puma::Matrix<double>*> xPtr = { Tx, Ty, Tz };
+    std::vector<puma::Matrix<double>*> bPtr = { &bVec[0], &bVec[1], &bVec[2] };
+    runBlockSolver(&A, &xPtr, &bPtr);
+
+    puma::Vec3<double> length(X, Y, Z);
+    for(int d=0;d<3;d++) {
+        dir = dirs[d];
+        T = fields[d];
+        addLinearProfile(1);
+
+        puma::Vec3<double> fluxes = A.computeFluxes(T, dir, d);
+        coefficients[d].x = fluxes.x * length.x;
+        coefficients[d].y = fluxes.y * length.y;
+        coefficients[d].z = fluxes.z * length.z;
+    }
+
+    dir = userDir;
+    T = userT;
+    return coefficients;
+}
+
 
 bool FV_Diffusion::setupBoundaries()
 {
@@ -170,12 +260,17 @@ bool FV_Diffusion::setupBoundaries()
 
 bool FV_Diffusion::setInitialConditions() {
 
-    T->resize(X,Y,Z,0);
+    if(warmStart && T->X() == X && T->Y() == Y && T->Z() == Z) {
+        // the previous field, minus the linear profile, is the initial guess for the solver
+        addLinearProfile(-1);
+    } else {
+        T->resize(X,Y,Z,0);
+    }
 
     b.resize(X,Y,Z);
 
     if (dir == 'x' || dir == 'X') {
-        double h = 1.0/T->X();
+        double h = 1.0/globalX();
         omp_set_num_threads(numThreads);
 #pragma omp parallel for
         for (long i=0; i<X; i++) {
@@ -230,31 +325,138 @@ bool FV_Diffusion::setInitialConditions() {
 }
 
 
+bool FV_Diffusion::setupHaloBoundaries() {
+    // decided from the global sizes, so that all the ranks fail together instead of waiting in an exchange
+    if(!slab->isValid()) {
+        printer->print("Finite Volume Diffusion Error: more ranks than planes in x");
+        return false;
+    }
+    if(slab->globalX() / slab->getSize() < 2) {
+        printer->print("Finite Volume Diffusion Error: each slab needs at least two planes in x");
+        return false;
+    }
+    if(slab->localX() != X) {
+        printer->print("Finite Volume Diffusion Error: the conductivity matrix does not hold the slab of this rank");
+        return false;
+    }
+
+    bool periodic = periodicX();
+    if(!slab->exchange(kMat, periodic, &haloK[0], &haloK[1])) {
+        return false;
+    }
+    for(int side=0;side<2;side++) {
+        if(slab->neighbor(side, periodic) >= 0) {
+            delete boundaries[side];
+            boundaries[side] = new FV_HaloBoundary(X, Y, Z, &haloK[side], &haloX[side]);
+        }
+    }
+    return true;
+}
+
+bool FV_Diffusion::runSlabSolver(FV_AMatrix *A) {
+    if (!bicgstab() && !conjugateGradient()) {
+        printer->print("Finite Volume Diffusion Error: only the bicgstab and conjugate gradient solvers run on a decomposed domain");
+        return false;
+    }
+    if (checkpoint) {
+        printer->print("Finite Volume Diffusion Warning: checkpoints are not supported on a decomposed domain, running without");
+    }
+
+    FV_SlabAMatrix slabA(A, slab, periodicX(), haloX);
+    bool printRank = print && slab->getRank() == 0;
+    if (bicgstab()) {
+        IterativeSolver::BiCGSTAB(&slabA,T,&b,solverTol,solverMaxIt,printRank, printer, nullptr, telemetry, numThreads);
+    }
+    else {
+        IterativeSolver::ConjugateGradient_Jacobian(&slabA,T,&b,solverTol,solverMaxIt,printRank,printer, numThreads);
+    }
+
+    return true;
+}
+
 bool FV_Diffusion::runIterativeSolver(FV_AMatrix *A) {
-    if (solverType.compare("bicgstab") == 0 || solverType.compare("BiCGSTAB") == 0 || solverType.compare("Bicgstab") == 0){
-        IterativeSolver::BiCGSTAB(A,T,&b,solverTol,solverMaxIt,print, printer, numThreads);
-    }
-    else if (solverType.compare("conjugategradient") == 0 || solverType.compare("ConjugateGradient") == 0 ||
-             solverType.compare("Conjugategradient") == 0 || solverType.compare("conjugateGradient") == 0 ||
-             solverType.compare("conjugate gradient") == 0 || solverType.compare("Conjugate Gradient") == 0 ||
-             solverType.compare("Conjugate gradient") == 0 || solverType.compare("conjugate Gradient") == 0 ||
-             solverType.compare("conjugate_gradient") == 0 || solverType.compare("Conjugate_Gradient") == 0 ||
-             solverType.compare("Conjugate_gradient") == 0 || solverType.compare("conjugate_Gradient") == 0 ||
-             solverType.compare("cg") == 0) {
+    if (slab) {
+        return runSlabSolver(A);
+    }
+
+    bool bicgstab = this->bicgstab();
+    if (checkpoint && !bicgstab) {
+        printer->print("Finite Volume Diffusion Warning: checkpoints are only supported by the bicgstab solver, running without");
+    }
+    bool fusedBicgstab = solverType.compare("bicgstab_fused") == 0 || solverType.compare("BiCGSTAB_Fused") == 0;
+    bool fusedCG = solverType.compare("cg_fused") == 0 || solverType.compare("CG_Fused") == 0;
+    if (telemetry && !bicgstab && !fusedBicgstab && !fusedCG) {
+        printer->print("Finite Volume Diffusion Warning: telemetry is only supported by the bicgstab and fused solvers, running without");
+    }
+
+    if (bicgstab){
+        if (checkpoint) {
+            std::stringstream settings;
+            settings << "FV_Diffusion " << dir << ' ' << sideBC << ' ' << X << ' ' << Y << ' ' << Z << ' ' << std::setprecision(17) << solverTol;
+            checkpoint->setOperator(kMat, settings.str());
+        }
+        IterativeSolver::BiCGSTAB(A,T,&b,solverTol,solverMaxIt,print, printer, checkpoint, telemetry, numThreads);
+    }
+    else if (conjugateGradient()) {
         IterativeSolver::ConjugateGradient_Jacobian(A,T,&b,solverTol,solverMaxIt,print,printer, numThreads);
     }
+    else if (fusedBicgstab) {
+        IterativeSolver::BiCGSTAB_Fused(A,T,&b,solverTol,solverMaxIt,print,printer, telemetry, numThreads);
+    }
+    else if (fusedCG) {
+        IterativeSolver::ConjugateGradient_Fused(A,T,&b,solverTol,solverMaxIt,print,printer, telemetry, numThreads);
+    }
+    else if (mixedPrecision()) {
+        IterativeSolver::BiCGSTAB_MixedPrecision(A,T,&b,solverTol,solverMaxIt,print,printer, numThreads);
+    }
+    else if (solverType.compare("multigrid") == 0 || solverType.compare("Multigrid") == 0 ||
+             solverType.compare("cg_multigrid") == 0 || solverType.compare("CG_Multigrid") == 0) {
+        FV_Multigrid M(A,kMat,&boundaries,numThreads);
+        IterativeSolver::ConjugateGradient_Jacobian(&M,T,&b,solverTol,solverMaxIt,print,printer, numThreads);
+    }
+    else if (redBlackSOR()) {
+        IterativeSolver::SOR_RedBlack(A,T,&b,0,solverTol,solverMaxIt,print,printer, numThreads);
+    }
+
+    return true;
+}
+
+bool FV_Diffusion::runBlockSolver(FV_AMatrix *A, std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *bVec) {
+    if (solverType.compare("bicgstab") == 0 || solverType.compare("BiCGSTAB") == 0 || solverType.compare("Bicgstab") == 0 ||
+        solverType.compare("bicgstab_fused") == 0 || solverType.compare("BiCGSTAB_Fused") == 0 || mixedPrecision()) {
+        IterativeSolver::BiCGSTAB_Block(A,x,bVec,solverTol,solverMaxIt,print,printer, numThreads);
+    }
+    else if (solverType.compare("multigrid") == 0 || solverType.compare("Multigrid") == 0 ||
+             solverType.compare("cg_multigrid") == 0 || solverType.compare("CG_Multigrid") == 0) {
+        // the multigrid hierarchy is built per system, so the three systems are solved one after the other
+        for(size_t s=0;s<x->size();s++) {
+            FV_AMatrix As(kMat,&tensorBoundaries[s],numThreads);
+            FV_Multigrid M(&As,kMat,&tensorBoundaries[s],numThreads);
+            IterativeSolver::ConjugateGradient_Jacobian(&M,x->at(s),bVec->at(s),solverTol,solverMaxIt,print,printer, numThreads);
+        }
+    }
+    else if (redBlackSOR()) {
+        // SOR has no block form, so each system is relaxed with an operator built on its own boundary conditions
+        for(size_t s=0;s<x->size();s++) {
+            FV_AMatrix As(kMat,&tensorBoundaries[s],numThreads);
+            IterativeSolver::SOR_RedBlack(&As,x->at(s),bVec->at(s),0,solverTol,solverMaxIt,print,printer, numThreads);
+        }
+    }
+    else {
+        IterativeSolver::ConjugateGradient_Block(A,x,bVec,solverTol,solverMaxIt,print,printer, numThreads);
+    }
 
     return true;
 }
 
-bool FV_Diffusion::addLinearProfile() {
+bool FV_Diffusion::addLinearProfile(double scale) {
     if(dir == 'x' || dir == 'X') {
         for(int i=0;i<X;i++) {
             for(int j=0;j<Y;j++) {
                 for(int k=0;k<Z;k++) {
-                    double h = 1./T->X();
+                    double h = 1./globalX();
                     double T0 = 0.5*h;
-                    (*T)(i,j,k) += T0+i*h;
+                    (*T)(i,j,k) += scale*(T0+(xOffset()+i)*h);
                 }
             }
         }
@@ -266,7 +468,7 @@ bool FV_Diffusion::addLinearProfile() {
                 for(int k=0;k<Z;k++) {
                     double h = 1./T->Y();
                     double T0 = 0.5*h;
-                    (*T)(i,j,k) += T0+j*h;
+                    (*T)(i,j,k) += scale*(T0+j*h);
                 }
             }
         }
@@ -278,7 +480,7 @@ bool FV_Diffusion::addLinearProfile() {
                 for(int k=0;k<Z;k++) {
                     double h = 1./T->Z();
                     double T0 = 0.5*h;
-                    (*T)(i,j,k) += T0+k*h;
+                    (*T)(i,j,k) += scale*(T0+k*h);
                 }
             }
         }
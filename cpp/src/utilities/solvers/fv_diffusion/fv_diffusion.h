@@ -4,10 +4,14 @@
 #include "workspace.h"
 #include "vector.h"
 #include "fv_AMatrix.h"
+#include "fv_multigrid.h"
 #include "iterativesolvers.h"
 #include "fv_periodicboundary.h"
 #include "fv_symmetricboundary.h"
 #include "fv_constantvalueboundary.h"
+#include "fv_haloboundary.h"
+#include "fv_slabdecomposition.h"
+#include "fv_slabAMatrix.h"
 #include "fv_boundarycondition.h"
 #include "Printer.h"
 
@@ -24,6 +28,43 @@ public:
     ~FV_Diffusion();
     puma::Vec3<double> compute_DiffusionCoefficient();
 
+    //! computes the diffusion coefficients for gradients applied in x, y and z, solving the three problems together.
+    /*!
+     * The operator is built once and shared by the three systems, which only differ in their boundary conditions.
+     * The bicgstab and conjugate gradient solvers run as block solves, with one pass over the conductances per
+     * product for all three systems (bicgstab_mixed runs as a double precision block bicgstab); the multigrid and sor
+     * solvers solve the systems one after the other.
+     * The T and dir passed to the constructor are not used.
+     * \param Tx a pointer to a puma matrix to store the field for the gradient in x.
+     * \param Ty a pointer to a puma matrix to store the field for the gradient in y.
+     * \param Tz a pointer to a puma matrix to store the field for the gradient in z.
+     * \return the diffusion coefficient vectors for the gradients in x, y and z, in this order.
+     */
+    std::vector<puma::Vec3<double>> compute_DiffusionTensor(puma::Matrix<double> *Tx, puma::Matrix<double> *Ty, puma::Matrix<double> *Tz);
+
+    //! if set, fields passed in with the size of the domain are used as initial guesses (e.g. the solution of a previous run with other conductivities).
+    void setWarmStart(bool warmStart) { this->warmStart = warmStart; }
+
+    //! saves the solver state to a checkpoint file, and resumes from it, during compute_DiffusionCoefficient. Only the bicgstab solver supports it.
+    void setCheckpoint(puma::SolverCheckpoint *checkpoint) { this->checkpoint = checkpoint; }
+
+    //! records the residual and the time breakdown of each iteration of the solver. Only the bicgstab solver supports it.
+    void setTelemetry(puma::SolverTelemetry *telemetry) { this->telemetry = telemetry; }
+
+    //! solves one slab of a domain decomposed along x, in compute_DiffusionCoefficient.
+    /*!
+     * kMat and T then only hold the planes of the slab of this rank (FV_SlabDecomposition::getStart to getEnd), and
+     * the returned coefficients are those of the whole domain, on every rank. Only the bicgstab and conjugate
+     * gradient solvers are supported, and only rank 0 prints the iterations.
+     * \param slab a pointer to the decomposition (not owned), or nullptr to solve the whole domain.
+     */
+    void setDecomposition(FV_SlabDecomposition *slab) {
+        this->slab = slab;
+        if(slab) {
+            slab->setPrinter(printer);
+        }
+    }
+
     static bool computeKMatrix(puma::Workspace *segWS, std::map<int, double> matCond, puma::Matrix<double> *kMat, int numThreads);
 
 private:
@@ -40,18 +81,48 @@ private:
     int solverMaxIt;
     bool print;
     int numThreads;
+    bool warmStart{false};
+    puma::SolverCheckpoint *checkpoint{nullptr};
+    puma::SolverTelemetry *telemetry{nullptr};
+
+    // ghost planes of the neighbouring slabs (low and high side), when the domain is decomposed
+    FV_SlabDecomposition *slab{nullptr};
+    puma::Matrix<double> haloK[2];
+    puma::Matrix<double> haloX[2];
 
     puma::Printer *printer;
     bool delPrinter;
 
     std::vector<FV_BoundaryCondition*> boundaries;
+    std::vector<std::vector<FV_BoundaryCondition*>> tensorBoundaries;
+
+    bool mixedPrecision() { return solverType.compare("bicgstab_mixed") == 0 || solverType.compare("BiCGSTAB_Mixed") == 0; }
+    bool redBlackSOR() { return solverType.compare("sor") == 0 || solverType.compare("SOR") == 0; }
+    bool bicgstab() { return solverType.compare("bicgstab") == 0 || solverType.compare("BiCGSTAB") == 0 || solverType.compare("Bicgstab") == 0; }
+    bool conjugateGradient() {
+        return solverType.compare("conjugategradient") == 0 || solverType.compare("ConjugateGradient") == 0 ||
+               solverType.compare("Conjugategradient") == 0 || solverType.compare("conjugateGradient") == 0 ||
+               solverType.compare("conjugate gradient") == 0 || solverType.compare("Conjugate Gradient") == 0 ||
+               solverType.compare("Conjugate gradient") == 0 || solverType.compare("conjugate Gradient") == 0 ||
+               solverType.compare("conjugate_gradient") == 0 || solverType.compare("Conjugate_Gradient") == 0 ||
+               solverType.compare("Conjugate_gradient") == 0 || solverType.compare("conjugate_Gradient") == 0 ||
+               solverType.compare("cg") == 0;
+    }
+
+    // the x faces connect the first and last slab when the sides are periodic and the gradient is not along x
+    bool periodicX() { return (sideBC.compare("periodic") == 0 || sideBC.compare("Periodic") == 0) && !(dir == 'x' || dir == 'X'); }
+    long globalX() { return slab ? slab->globalX() : X; }
+    long xOffset() { return slab ? slab->getStart() : 0; }
 
     bool setupBoundaries();
     bool setInitialConditions();
 
+    bool setupHaloBoundaries();
     bool runIterativeSolver(FV_AMatrix *A);
+    bool runSlabSolver(FV_AMatrix *A);
+    bool runBlockSolver(FV_AMatrix *A, std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *bVec);
 
-    bool addLinearProfile();
+    bool addLinearProfile(double scale);
 
 
 };
@@ -0,0 +1,36 @@
+#include "fv_haloboundary.h"
+
+
+FV_HaloBoundary::FV_HaloBoundary(int X, int Y, int Z, puma::Matrix<double> *kHalo, puma::Matrix<double> *xHalo) {
+    this->X = X;
+    this->Y = Y;
+    this->Z = Z;
+    this->kHalo = kHalo;
+    this->xHalo = xHalo;
+}
+
+double FV_HaloBoundary::getK_at(long i, long j, long k, puma::Matrix<double> *kMat) {
+    if(i==-1 || i==X) {
+        return kHalo->at(0,j,k);
+    }
+    return kMat->at(i,j,k);
+}
+
+double FV_HaloBoundary::getX_at(long i, long j, long k, puma::Matrix<double> *T) {
+    if(i==-1 || i==X) {
+        return xHalo->at(0,j,k);
+    }
+    return T->at(i,j,k);
+}
+
+// the ghost planes are only exchanged in double precision, so single precision products go through A_times_X in double
+float FV_HaloBoundary::getX_at(long i, long j, long k, puma::Matrix<float> *T) {
+    if(i==-1 || i==X) {
+        return (float)xHalo->at(0,j,k);
+    }
+    return T->at(i,j,k);
+}
+
+FV_BoundaryCondition* FV_HaloBoundary::clone(int X, int Y, int Z) {
+    return new FV_HaloBoundary(X, Y, Z, kHalo, xHalo);
+}
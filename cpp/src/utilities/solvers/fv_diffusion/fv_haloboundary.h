@@ -0,0 +1,36 @@
+#ifndef FV_HALOBOUNDARY_H
+#define FV_HALOBOUNDARY_H
+
+#include "fv_boundarycondition.h"
+#include "matrix.h"
+
+
+//! An x face of a slab shared with a neighbouring slab, whose ghost values are the plane received from that slab.
+/*!
+ *  The ghost planes are filled by FV_SlabDecomposition::exchange: the conductivities once, and the field before each
+ *  use (FV_SlabAMatrix does it before each product). Only the x faces may use this boundary condition.
+ *  \sa FV_SlabDecomposition, FV_SlabAMatrix
+ */
+class FV_HaloBoundary : public FV_BoundaryCondition
+{
+public:
+
+    //! creates the boundary condition of a slab of X planes.
+    /*!
+     * \param kHalo a pointer to a puma matrix (1 x Y x Z) holding the conductivities of the ghost plane (not owned).
+     * \param xHalo a pointer to a puma matrix (1 x Y x Z) holding the field on the ghost plane (not owned).
+     */
+    FV_HaloBoundary(int X, int Y, int Z, puma::Matrix<double> *kHalo, puma::Matrix<double> *xHalo);
+    double getK_at(long i, long j, long k, puma::Matrix<double> *kMat) override;
+    double getX_at(long i, long j, long k,puma::Matrix<double> *T) override;
+    float getX_at(long i, long j, long k,puma::Matrix<float> *T) override;
+    FV_BoundaryCondition* clone(int X, int Y, int Z) override;
+
+private:
+    puma::Matrix<double> *kHalo;
+    puma::Matrix<double> *xHalo;
+    int X, Y, Z;
+
+};
+
+#endif // FV_HALOBOUNDARY_H
@@ -0,0 +1,70 @@
+#ifndef FV_MULTIGRID_H
+#define FV_MULTIGRID_H
+
+#include "fv_AMatrix.h"
+#include "fv_boundarycondition.h"
+#include "AMatrix.h"
+#include "matrix.h"
+
+#include <vector>
+
+
+//! A geometric multigrid V-cycle preconditioner for the finite volume diffusion operator.
+/*!
+ *  Wraps an FV_AMatrix: A_times_X applies the fine operator, Minv_times_X applies one V-cycle, so that it plugs into
+ *  the preconditioned solvers in place of the diagonal (e.g. IterativeSolver::ConjugateGradient_Jacobian).
+ *  Coarse levels are rediscretized from the conductivity field, coarsened 2x2x2 by arithmetic averaging,
+ *  with the same boundary condition types. Smoothing is red-black Gauss-Seidel, ordered red-black before the
+ *  coarse correction and black-red after it, so that the V-cycle is symmetric.
+ *  \sa FV_AMatrix, FV_Diffusion
+ */
+class FV_Multigrid : public AMatrix
+{
+public:
+
+    //! builds the multigrid hierarchy.
+    /*!
+     * \param A a pointer to the fine level FV_AMatrix (not owned).
+     * \param kMat a pointer to the puma matrix containing the conductivity of each voxel, used to build A.
+     * \param bcs a pointer to the six boundary conditions used to build A.
+     * \param numThreads an integer which specifies the number of threads used.
+     */
+    FV_Multigrid(FV_AMatrix *A, puma::Matrix<double> *kMat, std::vector<FV_BoundaryCondition*> *bcs, int numThreads);
+    ~FV_Multigrid();
+
+    bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override;
+    bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override;
+
+    //! returns the number of levels in the hierarchy, including the fine level.
+    int numLevels() { return (int)levels.size(); }
+
+    //! smoothing sweeps before and after the coarse correction, and on the coarsest level.
+    int preSweeps{2};
+    int postSweeps{2};
+    int coarseSweeps{20};
+
+private:
+
+    struct Level {
+        FV_AMatrix *A;
+        puma::Matrix<double> kMat;
+        std::vector<FV_BoundaryCondition*> bcs;
+        puma::Matrix<double> x, b, r;
+        long X, Y, Z;
+    };
+
+    std::vector<Level*> levels;
+    int numThreads;
+
+    // coarsening stops once a side would drop below this many voxels
+    static const long minCoarseSize = 4;
+    static const int maxLevels = 12;
+
+    void vCycle(int l, puma::Matrix<double> *x, puma::Matrix<double> *b);
+    void restrictResidual(int l);
+    void prolongCorrection(int l, puma::Matrix<double> *x);
+
+    static void coarsenConductivity(puma::Matrix<double> *fine, puma::Matrix<double> *coarse, int numThreads);
+};
+
+#endif // FV_MULTIGRID_H
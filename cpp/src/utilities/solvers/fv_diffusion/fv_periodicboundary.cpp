@@ -30,7 +30,7 @@ double FV_PeriodicBoundary::getK_at(long i, long j, long k, puma::Matrix<double>
     return kMat->at(i,j,k);
 }
 
-double FV_PeriodicBoundary::getX_at(long i, long j, long k,puma::Matrix<double> *T) {
+template<class V> V FV_PeriodicBoundary::ghostX(long i, long j, long k, puma::Matrix<V> *T) {
     if(i==-1) {
         return T->at(X-1,j,k);
     }
@@ -51,3 +51,15 @@ double FV_PeriodicBoundary::getX_at(long i, long j, long k,puma::Matrix<double>
     }
     return T->at(i,j,k);
 }
+
+double FV_PeriodicBoundary::getX_at(long i, long j, long k,puma::Matrix<double> *T) {
+    return ghostX(i,j,k,T);
+}
+
+float FV_PeriodicBoundary::getX_at(long i, long j, long k,puma::Matrix<float> *T) {
+    return ghostX(i,j,k,T);
+}
+
+FV_BoundaryCondition* FV_PeriodicBoundary::clone(int X, int Y, int Z) {
+    return new FV_PeriodicBoundary(X, Y, Z);
+}
@@ -11,8 +11,11 @@ public:
     FV_PeriodicBoundary(int X, int Y, int Z);
     double getK_at(long i, long j, long k, puma::Matrix<double> *kMat) override;
     double getX_at(long i, long j, long k,puma::Matrix<double> *T) override;
+    float getX_at(long i, long j, long k,puma::Matrix<float> *T) override;
+    FV_BoundaryCondition* clone(int X, int Y, int Z) override;
 
 private:
+    template<class V> V ghostX(long i, long j, long k, puma::Matrix<V> *T);
     int X, Y, Z;
     //  int constantIndex;
 
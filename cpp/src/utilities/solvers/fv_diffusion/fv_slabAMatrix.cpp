@@ -0,0 +1,29 @@
+#include "fv_slabAMatrix.h"
+
+
+FV_SlabAMatrix::FV_SlabAMatrix(FV_AMatrix *A, FV_SlabDecomposition *slab, bool periodic, puma::Matrix<double> *xHalo) {
+    this->A = A;
+    this->slab = slab;
+    this->periodic = periodic;
+    this->xHalo = xHalo;
+}
+
+bool FV_SlabAMatrix::A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) {
+    if(!slab->exchange(x, periodic, &xHalo[0], &xHalo[1])) {
+        return false;
+    }
+    return A->A_times_X(x, r);
+}
+
+bool FV_SlabAMatrix::Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) {
+    return A->Minv_times_X(x, r);
+}
+
+double FV_SlabAMatrix::dot(puma::Matrix<double> *x, puma::Matrix<double> *y, int numThreads) {
+    return slab->sum(x->dot(y, numThreads));
+}
+
+// the two ghost planes are small next to the slab, so only the local product is counted
+double FV_SlabAMatrix::productBytes(puma::Matrix<double> *x) {
+    return A->productBytes(x);
+}
@@ -0,0 +1,43 @@
+#ifndef FV_SLABAMATRIX_H
+#define FV_SLABAMATRIX_H
+
+#include "fv_AMatrix.h"
+#include "fv_slabdecomposition.h"
+#include "AMatrix.h"
+#include "matrix.h"
+
+
+//! The finite volume operator of a domain decomposed in slabs along x, seen from one slab.
+/*!
+ *  Wraps the FV_AMatrix of the local slab, whose x faces shared with other slabs use FV_HaloBoundary. Before each
+ *  product, the first and last planes of x are exchanged with the neighbouring slabs, and the dot products are
+ *  summed over all the slabs, so that the unmodified iterative solvers (e.g. IterativeSolver::BiCGSTAB) solve the
+ *  global system while every vector only holds the local slab.
+ *  \sa FV_SlabDecomposition, FV_Diffusion::setDecomposition
+ */
+class FV_SlabAMatrix : public AMatrix
+{
+public:
+
+    //! wraps the operator of a slab.
+    /*!
+     * \param A a pointer to the FV_AMatrix of the local slab (not owned).
+     * \param slab a pointer to the decomposition (not owned).
+     * \param periodic a boolean which, if true, connects the first and the last slab.
+     * \param xHalo a pointer to the two ghost planes (low and high side) read by the FV_HaloBoundary of A.
+     */
+    FV_SlabAMatrix(FV_AMatrix *A, FV_SlabDecomposition *slab, bool periodic, puma::Matrix<double> *xHalo);
+
+    bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override;
+    bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override;
+    double dot(puma::Matrix<double> *x, puma::Matrix<double> *y, int numThreads = 0) override;
+    double productBytes(puma::Matrix<double> *x) override;
+
+private:
+    FV_AMatrix *A;
+    FV_SlabDecomposition *slab;
+    bool periodic;
+    puma::Matrix<double> *xHalo;
+};
+
+#endif // FV_SLABAMATRIX_H
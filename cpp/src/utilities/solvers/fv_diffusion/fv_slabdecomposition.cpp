@@ -0,0 +1,125 @@
+#include "fv_slabdecomposition.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+// used until a printer is set
+static puma::Printer standardPrinter;
+
+void FV_SlabDecomposition::report(const std::string &message) {
+    (printer ? printer : &standardPrinter)->error("Slab Decomposition Error: " + message);
+}
+
+FV_SlabDecomposition::FV_SlabDecomposition(long globalX) {
+    X = globalX;
+    start = 0;
+    end = globalX;
+}
+
+#ifdef PUMA_MPI
+FV_SlabDecomposition::FV_SlabDecomposition(MPI_Comm comm, long globalX) {
+    this->comm = comm;
+    X = globalX;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    range(X, rank, size, &start, &end);
+}
+#endif
+
+void FV_SlabDecomposition::range(long globalX, int rank, int size, long *start, long *end) {
+    long base = globalX / size;
+    long remainder = globalX % size;
+    *start = rank*base + std::min((long)rank, remainder);
+    *end = *start + base + (rank < remainder ? 1 : 0);
+}
+
+int FV_SlabDecomposition::neighbor(int side, bool periodic) {
+    if(side == 0) {
+        return (rank > 0) ? rank-1 : (periodic ? size-1 : -1);
+    }
+    return (rank < size-1) ? rank+1 : (periodic ? 0 : -1);
+}
+
+bool FV_SlabDecomposition::extract(puma::Matrix<double> *global, puma::Matrix<double> *local) {
+    if(!isValid()) {
+        report("more ranks than planes in x");
+        return false;
+    }
+    if(global->X() != X) {
+        report("the matrix does not have the size of the domain");
+        return false;
+    }
+    long plane = (long)global->Y()*global->Z();
+    local->resize(localX(), global->Y(), global->Z());
+    if(local->size() > 0) {
+        std::memcpy(&local->at(0), &global->at(start,0,0), sizeof(double)*plane*localX());
+    }
+    return true;
+}
+
+// planes are contiguous, since i is the slowest index of a puma matrix
+bool FV_SlabDecomposition::exchange(puma::Matrix<double> *x, bool periodic, puma::Matrix<double> *low, puma::Matrix<double> *high) {
+    if(!isValid()) {
+        report("more ranks than planes in x");
+        return false;
+    }
+    long Y = x->Y();
+    long Z = x->Z();
+    long plane = Y*Z;
+    long last = x->X()-1;
+    int lowRank = neighbor(0, periodic);
+    int highRank = neighbor(1, periodic);
+    if(lowRank >= 0) {
+        low->resize(1, Y, Z);
+    }
+    if(highRank >= 0) {
+        high->resize(1, Y, Z);
+    }
+
+#ifdef PUMA_MPI
+    if(comm != MPI_COMM_NULL) {
+        // on the domain edges, the peer is MPI_PROC_NULL and nothing is received
+        double *lowBuf = (lowRank >= 0) ? &low->at(0) : nullptr;
+        double *highBuf = (highRank >= 0) ? &high->at(0) : nullptr;
+        int lowPeer = (lowRank >= 0) ? lowRank : MPI_PROC_NULL;
+        int highPeer = (highRank >= 0) ? highRank : MPI_PROC_NULL;
+        int lowCount = (lowRank >= 0) ? (int)plane : 0;
+        int highCount = (highRank >= 0) ? (int)plane : 0;
+
+        // last plane goes up while the low ghost comes in, then the first plane goes down
+        int error = MPI_Sendrecv(&x->at(last,0,0), highCount, MPI_DOUBLE, highPeer, 0,
+                                 lowBuf, lowCount, MPI_DOUBLE, lowPeer, 0, comm, MPI_STATUS_IGNORE);
+        if(error == MPI_SUCCESS) {
+            error = MPI_Sendrecv(&x->at(0,0,0), lowCount, MPI_DOUBLE, lowPeer, 1,
+                                 highBuf, highCount, MPI_DOUBLE, highPeer, 1, comm, MPI_STATUS_IGNORE);
+        }
+        if(error != MPI_SUCCESS) {
+            report("halo exchange failed");
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    // single slab: the only neighbour is the slab itself, when periodic
+    if(lowRank >= 0) {
+        std::memcpy(&low->at(0), &x->at(last,0,0), sizeof(double)*plane);
+    }
+    if(highRank >= 0) {
+        std::memcpy(&high->at(0), &x->at(0,0,0), sizeof(double)*plane);
+    }
+    return true;
+}
+
+double FV_SlabDecomposition::sum(double local) {
+#ifdef PUMA_MPI
+    if(comm != MPI_COMM_NULL) {
+        double global = 0;
+        MPI_Allreduce(&local, &global, 1, MPI_DOUBLE, MPI_SUM, comm);
+        return global;
+    }
+#endif
+    return local;
+}
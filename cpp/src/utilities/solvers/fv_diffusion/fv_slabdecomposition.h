@@ -0,0 +1,86 @@
+#ifndef FV_SLABDECOMPOSITION_H
+#define FV_SLABDECOMPOSITION_H
+
+#include "matrix.h"
+#include "Printer.h"
+
+#ifdef PUMA_MPI
+#include <mpi.h>
+#endif
+
+
+//! Splits a domain into slabs along x, one per MPI rank, and exchanges the planes between neighbouring slabs.
+/*!
+ *  Rank r owns the planes [start, end) of the global domain, with the remainder of the division spread over the
+ *  first ranks. Each rank only holds the conductivities and the fields of its own slab, plus one ghost plane on each
+ *  side, which is what FV_Diffusion needs to run on a domain larger than the memory of a node.
+ *  Without PUMA_MPI (or with the serial constructor), the decomposition has a single slab covering the domain.
+ *  \sa FV_Diffusion::setDecomposition, FV_HaloBoundary, FV_SlabAMatrix
+ */
+class FV_SlabDecomposition
+{
+public:
+
+    //! a single slab covering the whole domain.
+    explicit FV_SlabDecomposition(long globalX);
+
+#ifdef PUMA_MPI
+    //! one slab per rank of comm, which must have at most globalX ranks (see isValid).
+    FV_SlabDecomposition(MPI_Comm comm, long globalX);
+#endif
+
+    //! false if there are more ranks than planes in x. extract and exchange then fail on every rank.
+    bool isValid() { return size <= X; }
+
+    //! sets the printer the errors are reported to (not owned). FV_Diffusion::setDecomposition passes its own.
+    void setPrinter(puma::Printer *printer) { this->printer = printer; }
+
+    //! computes the planes [start, end) owned by a rank.
+    static void range(long globalX, int rank, int size, long *start, long *end);
+
+    int getRank() { return rank; }
+    int getSize() { return size; }
+    long globalX() { return X; }
+    long localX() { return end - start; }
+    long getStart() { return start; }
+    long getEnd() { return end; }
+
+    //! returns the rank holding the slab before (side 0) or after (side 1) this one, or -1 on the domain edge.
+    /*!
+     * \param side 0 for the low x side, 1 for the high x side.
+     * \param periodic a boolean which, if true, connects the first and the last slab.
+     */
+    int neighbor(int side, bool periodic);
+
+    //! copies the planes of this slab out of a matrix holding the whole domain.
+    bool extract(puma::Matrix<double> *global, puma::Matrix<double> *local);
+
+    //! sends the first and last planes of x to the neighbouring slabs, and receives theirs.
+    /*!
+     * \param x a pointer to a puma matrix holding the local slab.
+     * \param periodic a boolean which, if true, connects the first and the last slab.
+     * \param low a pointer to a puma matrix receiving the last plane of the low neighbour (left untouched on the domain edge).
+     * \param high a pointer to a puma matrix receiving the first plane of the high neighbour (left untouched on the domain edge).
+     * \return a boolean indicating the exchange executed without errors.
+     */
+    bool exchange(puma::Matrix<double> *x, bool periodic, puma::Matrix<double> *low, puma::Matrix<double> *high);
+
+    //! sums a value over all the slabs.
+    double sum(double local);
+
+private:
+    long X;
+    long start;
+    long end;
+    int rank{0};
+    int size{1};
+    puma::Printer *printer{nullptr};
+
+    void report(const std::string &message);
+
+#ifdef PUMA_MPI
+    MPI_Comm comm{MPI_COMM_NULL};
+#endif
+};
+
+#endif // FV_SLABDECOMPOSITION_H
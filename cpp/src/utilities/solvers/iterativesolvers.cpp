@@ -1,7 +1,12 @@
 #include "iterativesolvers.h"
 
+#include <algorithm>
 #include <sstream>
 
+#ifdef __SSE2__
+#include <pmmintrin.h>
+#endif
+
 
 /*
  * Description: BiConjugate Gradient Stabilized Solver for problems of type: Ax = 0
@@ -20,111 +25,12 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, double tol,
 
 
 bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
-    puma::Timer t1;
-    t1.reset();
-    puma::Matrix<double> v(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> p(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> s(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> t(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> r(x->X(),x->Y(),x->Z(),0);
-
-    A->A_times_X(x,&r);
-
-    omp_set_num_threads(numThreads);
-#pragma omp parallel for
-    for (long i=0;i<r.size();i++){
-        r(i)*=-1;
-    }
-
-    if(sqrt(r.dot(&r)) < tol ) {
-        return true;
-    }
-
-    puma::Matrix<double> r_hat(&r);
-    double rho = 1;
-    double alpha = 1;
-    double omega = 1;
-    double rho_old = rho;
-    double beta = 0;
-    double tau = 0;
-
-    if(print) {
-        printer->print("BiCGSTAB Solver running");
-    }
-
-    for(int it=0;it<maxIt;it++){
-        rho = r.dot(&r_hat);
-        if (rho == 0.) {
-            // BiCGSTAB Breakdown
-            printer->print("BiCGSTAB Warning:  rho = 0");
-            return false;
-        }
-        beta = (rho/rho_old)*(alpha/omega);
-
-        omp_set_num_threads(numThreads);
-#pragma omp parallel for
-        for(long i=0;i<r.size();i++){
-            p(i)=r(i)+beta*(p(i)-omega*v(i));
-        }
-
-        A->A_times_X(&p,&v);
-        tau = v.dot(&r_hat);
-        if (tau == 0.) {
-            // BiCGSTAB Breakdown
-            printer->print("BiCGSTAB Warning:  tau = 0");
-            return false;
-        }
-        alpha = rho/tau;
-
-        omp_set_num_threads(numThreads);
-#pragma omp parallel for
-        for(long i=0;i<r.size();i++){
-            s(i)=r(i)-alpha*v(i);
-        }
-        A->A_times_X(&s,&t);
-
-        tau = t.dot(&t);
-        if (s.dot(&s) == 0.) {
-            omega = 0;
-        }
-        else if (tau == 0.) {
-            // BiCGSTAB Breakdown
-            printer->print("BiCGSTAB Warning:  tau = 0");
-            return false;
-        }
-        else {
-            omega = t.dot(&s)/tau;
-        }
-
-        omp_set_num_threads(numThreads);
-#pragma omp parallel for
-        for(long i=0;i<r.size();i++){
-            // Update Solution and Residual
-            r(i) = s(i)-omega*t(i);
-            (*x)(i) += alpha*p(i)+omega*s(i);
-        }
-
-        double zeta = sqrt(r.dot(&r));
-        if(print) {
-            std::stringstream buffer;
-            buffer << '\r' << "Iteration: " << it+1 << "  -  " << "Time: " << t1.elapsed() << "  -  " << "Residual: " << zeta;
-            printer->print(buffer.str());
-        }
-
-        if(zeta < tol){
-            return true;
-        }
-        rho_old = rho;
-        if (omega == 0.)
-        {
-            // BiCGSTAB Breakdown
-            printer->print("BiCGSTAB Warning:  omega = 0");
-            return false;
-        }
+    return BiCGSTAB(A, x, nullptr, tol, maxIt, print, printer, nullptr, nullptr, numThreads);
+}
 
-    }
-    printer->print( "BiCGSTAB Warning: Max Iterations Reached");
-    return false;
+bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, double tol, int maxIt, bool print, puma::Printer *printer,
+                               puma::SolverTelemetry *telemetry, int numThreads) {
+    return BiCGSTAB(A, x, nullptr, tol, maxIt, print, printer, nullptr, telemetry, numThreads);
 }
 
 
@@ -147,28 +53,70 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
  * Outputs: x - Converged solution
  */
 bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
-    puma::Timer t1;
-    t1.reset();
+    return BiCGSTAB(A, x, b, tol, maxIt, print, printer, nullptr, numThreads);
+}
 
-    puma::Matrix<double> v(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> p(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> s(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> t(x->X(),x->Y(),x->Z(),0);
-    puma::Matrix<double> r(x->X(),x->Y(),x->Z(),0);
+bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer,
+                               puma::SolverCheckpoint *checkpoint, int numThreads) {
+    return BiCGSTAB(A, x, b, tol, maxIt, print, printer, checkpoint, nullptr, numThreads);
+}
 
-    A->A_times_X(x,&r);
+// charges the time and the bytes of a kernel to a telemetry recorder, if there is one
+class PhaseRecorder {
+public:
+    explicit PhaseRecorder(puma::SolverTelemetry *telemetry) : telemetry(telemetry) {}
+    void begin() { if(telemetry) telemetry->beginPhase(); }
+    void end(puma::SolverTelemetry::Phase phase, double bytes, int passes = 1) { if(telemetry) telemetry->endPhase(phase, bytes, passes); }
+private:
+    puma::SolverTelemetry *telemetry;
+};
+
+// loads the state of a solver from a checkpoint, if the stored residual r is the residual b - Ax of the stored solution
+// for this operator: the recurrence lets the two drift apart slowly, while a checkpoint of another operator gives a
+// different residual. The solution, the other fields and the scalars are left as they were when the state is not resumed.
+static bool resumeCheckpoint(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, puma::Matrix<double> *r, double tol,
+                             puma::SolverCheckpoint *checkpoint, int *iteration, std::vector<double> *scalars,
+                             const std::vector<puma::Matrix<double>*> &fields, puma::Printer *printer, int numThreads) {
+    puma::Matrix<double> initial(*x);
+    std::vector<double> initialScalars = *scalars;
+    if(!checkpoint->load("BiCGSTAB", b, iteration, scalars, fields)) {
+        return false;
+    }
 
+    puma::Matrix<double> gap(x->X(),x->Y(),x->Z(),0);
+    A->A_times_X(x,&gap);
     omp_set_num_threads(numThreads);
 #pragma omp parallel for
-    for (long i=0;i<r.size();i++){
-        r(i)=(*b)(i)-r(i);
+    for (long i=0;i<gap.size();i++){
+        gap(i) = (b ? (*b)(i) : 0.) - gap(i) - (*r)(i);
     }
 
-    if(sqrt(r.dot(&r)) < tol ) {
+    if(sqrt(A->dot(&gap,&gap,numThreads)) <= 0.1*sqrt(A->dot(r,r,numThreads)) + tol) {
         return true;
     }
 
-    puma::Matrix<double> r_hat(&r);
+    printer->print("Solver Checkpoint Warning: the residual of " + checkpoint->getFileName() + " does not match its solution, starting over");
+    x->copy(&initial);
+    for(size_t f=1;f<fields.size();f++) {
+        fields[f]->set(0);
+    }
+    *scalars = initialScalars;
+    *iteration = 0;
+    return false;
+}
+
+bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer,
+                               puma::SolverCheckpoint *checkpoint, puma::SolverTelemetry *telemetry, int numThreads) {
+    puma::Timer t1;
+    t1.reset();
+
+    puma::Matrix<double> v(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<double> p(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<double> s(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<double> t(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<double> r(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<double> r_hat(x->X(),x->Y(),x->Z(),0);
+
     double rho = 1;
     double alpha = 1;
     double omega = 1;
@@ -176,12 +124,51 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
     double beta = 0;
     double tau = 0;
 
+    // the recurrence is fully defined by these, so a resumed solve follows the same iterates as an uninterrupted one
+    std::vector<double> scalars = { rho_old, alpha, omega };
+    std::vector<puma::Matrix<double>*> fields = { x, &r, &r_hat, &p, &v };
+    int it0 = 0;
+    if(checkpoint && resumeCheckpoint(A, x, b, &r, tol, checkpoint, &it0, &scalars, fields, printer, numThreads)) {
+        rho_old = scalars[0];
+        alpha = scalars[1];
+        omega = scalars[2];
+        if(print) {
+            std::stringstream buffer;
+            buffer << "BiCGSTAB resuming from iteration " << it0 << " of " << checkpoint->getFileName();
+            printer->print(buffer.str());
+        }
+    } else {
+        A->A_times_X(x,&r);
+
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for
+        for (long i=0;i<r.size();i++){
+            r(i)=(b ? (*b)(i) : 0.)-r(i);
+        }
+
+        if(sqrt(A->dot(&r,&r,numThreads)) < tol ) {
+            return true;
+        }
+
+        r_hat.copy(&r);
+    }
+
+    // bytes moved by a kernel which reads or writes n vectors, and by a product with A
+    const double vec = (double)r.size() * sizeof(double);
+    const double product = A->productBytes(x);
+    PhaseRecorder phase(telemetry);
+    if(telemetry) {
+        telemetry->start("BiCGSTAB", r.size());
+    }
+
     if(print) {
         printer->print("BiCGSTAB Solver running");
     }
 
-    for(int it=0;it<maxIt;it++){
-        rho = r.dot(&r_hat);
+    for(int it=it0;it<maxIt;it++){
+        phase.begin();
+        rho = A->dot(&r,&r_hat,numThreads);
+        phase.end(puma::SolverTelemetry::Reduction, 2*vec);
         if (rho == 0.) {
             // BiCGSTAB Breakdown
             printer->print("BiCGSTAB Warning:  rho = 0");
@@ -189,14 +176,21 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
         }
         beta = (rho/rho_old)*(alpha/omega);
 
+        phase.begin();
         omp_set_num_threads(numThreads);
 #pragma omp parallel for
         for(long i=0;i<r.size();i++){
             p(i)=r(i)+beta*(p(i)-omega*v(i));
         }
+        phase.end(puma::SolverTelemetry::Update, 4*vec);
 
+        phase.begin();
         A->A_times_X(&p,&v);
-        tau = v.dot(&r_hat);
+        phase.end(puma::SolverTelemetry::Product, product);
+
+        phase.begin();
+        tau = A->dot(&v,&r_hat,numThreads);
+        phase.end(puma::SolverTelemetry::Reduction, 2*vec);
         if (tau == 0.) {
             // BiCGSTAB Breakdown
             printer->print("BiCGSTAB Warning:  tau = 0");
@@ -204,15 +198,25 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
         }
         alpha = rho/tau;
 
+        phase.begin();
         omp_set_num_threads(numThreads);
 #pragma omp parallel for
         for(long i=0;i<r.size();i++){
             s(i)=r(i)-alpha*v(i);
         }
-        A->A_times_X(&s,&t);
+        phase.end(puma::SolverTelemetry::Update, 3*vec);
 
-        tau = t.dot(&t);
-        if (s.dot(&s) == 0.) {
+        phase.begin();
+        A->A_times_X(&s,&t);
+        phase.end(puma::SolverTelemetry::Product, product);
+
+        phase.begin();
+        tau = A->dot(&t,&t,numThreads);
+        double ss = A->dot(&s,&s,numThreads);
+        bool needTs = ss != 0. && tau != 0.;
+        double ts = needTs ? A->dot(&t,&s,numThreads) : 0.;
+        phase.end(puma::SolverTelemetry::Reduction, needTs ? 4*vec : 2*vec, needTs ? 3 : 2);
+        if (ss == 0.) {
             printer->print("BiCGSTAB Warning:  omega = 0");
             omega = 0;
         }
@@ -222,9 +226,10 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
             return false;
         }
         else {
-            omega = t.dot(&s)/tau;
+            omega = ts/tau;
         }
 
+        phase.begin();
         omp_set_num_threads(numThreads);
 #pragma omp parallel for
         for(long i=0;i<r.size();i++){
@@ -232,8 +237,15 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
             r(i) = s(i)-omega*t(i);
             (*x)(i) += alpha*p(i)+omega*s(i);
         }
+        phase.end(puma::SolverTelemetry::Update, 6*vec);
 
-        double zeta = sqrt(r.dot(&r));
+        phase.begin();
+        double zeta = sqrt(A->dot(&r,&r,numThreads));
+        phase.end(puma::SolverTelemetry::Reduction, vec);
+
+        if(telemetry) {
+            telemetry->endIteration(it+1, zeta);
+        }
         if(print) {
             std::stringstream buffer;
             buffer << '\r' << "Iteration: " << it+1 << "  -  " << "Time: " << t1.elapsed() << "  -  " << "Residual: " << zeta;
@@ -241,6 +253,9 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
         }
 
         if(zeta < tol){
+            if(checkpoint) {
+                checkpoint->remove();
+            }
             return true;
         }
         rho_old = rho;
@@ -251,6 +266,9 @@ bool IterativeSolver::BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix
             return false;
         }
 
+        if(checkpoint && checkpoint->due(it+1)) {
+            checkpoint->save("BiCGSTAB", b, it+1, { rho_old, alpha, omega }, fields);
+        }
     }
     printer->print("BiCGSTAB Warning: Max Iterations Reached");
     return false;
@@ -292,17 +310,17 @@ bool IterativeSolver::ConjugateGradient(AMatrix *A, puma::Matrix<double> *x, dou
     }
     puma::Matrix<double> p(&r);
 
-    if(sqrt(r.dot(&r)) < tol ) {
+    if(sqrt(A->dot(&r,&r,numThreads)) < tol ) {
         return true;
     }
     if(print) printer->print("Conjugate Gradient Solver running");
 
     // Start of Iterations
-    double rsold = r.dot(&r);
+    double rsold = A->dot(&r,&r,numThreads);
     for(int it=0;it<maxIt;it++){
 
         A->A_times_X(&p,&Ap);
-        psold = p.dot(&Ap);
+        psold = A->dot(&p,&Ap,numThreads);
         alpha = rsold/psold;
         omp_set_num_threads(numThreads);
 #pragma omp parallel for
@@ -310,7 +328,7 @@ bool IterativeSolver::ConjugateGradient(AMatrix *A, puma::Matrix<double> *x, dou
             (*x)(i) += alpha*p(i);
             r(i) += -alpha*Ap(i);
         }
-        rsnew = r.dot(&r);
+        rsnew = A->dot(&r,&r,numThreads);
 
         if(sqrt(rsnew)<tol) {
             return true;
@@ -376,7 +394,7 @@ bool IterativeSolver::ConjugateGradient(AMatrix *A, puma::Matrix<double> *x, pum
     }
     puma::Matrix<double> p(&r);
 
-    if(sqrt(r.dot(&r)) < tol ) {
+    if(sqrt(A->dot(&r,&r,numThreads)) < tol ) {
         return true;
     }
     if(print) {
@@ -384,11 +402,11 @@ bool IterativeSolver::ConjugateGradient(AMatrix *A, puma::Matrix<double> *x, pum
     }
 
     // Start of Iterations
-    double rsold = r.dot(&r);
+    double rsold = A->dot(&r,&r,numThreads);
     for(int it=0;it<maxIt;it++){
 
         A->A_times_X(&p,&Ap);
-        psold = p.dot(&Ap);
+        psold = A->dot(&p,&Ap,numThreads);
         alpha = rsold/psold;
         omp_set_num_threads(numThreads);
 #pragma omp parallel for
@@ -396,7 +414,7 @@ bool IterativeSolver::ConjugateGradient(AMatrix *A, puma::Matrix<double> *x, pum
             (*x)(i) += alpha*p(i);
             r(i) += -alpha*Ap(i);
         }
-        rsnew = r.dot(&r);
+        rsnew = A->dot(&r,&r,numThreads);
 
         if(sqrt(rsnew)<tol) {
             return true;
@@ -443,7 +461,7 @@ bool IterativeSolver::ConjugateGradient_Jacobian(AMatrix *A, puma::Matrix<double
 
     puma::Matrix<double> p(&z);
 
-    if(sqrt(r.dot(&r)) < tol ) {
+    if(sqrt(A->dot(&r,&r,numThreads)) < tol ) {
         return true;
     }
     if(print) {
@@ -451,12 +469,12 @@ bool IterativeSolver::ConjugateGradient_Jacobian(AMatrix *A, puma::Matrix<double
     }
 
     // Start of Iterations
-    double rsold = r.dot(&r);
-    double rzold = r.dot(&z);
+    double rsold = A->dot(&r,&r,numThreads);
+    double rzold = A->dot(&r,&z,numThreads);
     for(int it=0;it<maxIt;it++){
 
         A->A_times_X(&p,&Ap);
-        psold = p.dot(&Ap);
+        psold = A->dot(&p,&Ap,numThreads);
         alpha = rzold/psold;
 
         omp_set_num_threads(numThreads);
@@ -465,7 +483,7 @@ bool IterativeSolver::ConjugateGradient_Jacobian(AMatrix *A, puma::Matrix<double
             (*x)(i) += alpha*p(i);
             r(i) += -alpha*Ap(i);
         }
-        rsnew = r.dot(&r);
+        rsnew = A->dot(&r,&r,numThreads);
 
         if(sqrt(rsnew)<tol) {
             return true;
@@ -477,7 +495,7 @@ bool IterativeSolver::ConjugateGradient_Jacobian(AMatrix *A, puma::Matrix<double
         }
 
         A->Minv_times_X(&r, &z);
-        double rznew = r.dot(&z);
+        double rznew = A->dot(&r,&z,numThreads);
         double beta = rznew/rzold;
 
         omp_set_num_threads(numThreads);
@@ -493,3 +511,1066 @@ bool IterativeSolver::ConjugateGradient_Jacobian(AMatrix *A, puma::Matrix<double
     return false;
 }
 
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IterativeSolver::BiCGSTAB_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, int numThreads){
+    puma::Printer printer;
+    return BiCGSTAB_Fused(A, x, b, tol, maxIt, print, &printer, numThreads);
+}
+
+/*
+ * Description: BiConjugate Gradient Stabilized Solver for problems of type: Ax = b, with fused vector kernels
+ *              Passes over memory per iteration (excluding A_times_X):
+ *                 1. tau = v.r_hat
+ *                 2. s = r - alpha*v,  s.s
+ *                 3. t.s,  t.t
+ *                 4. r = s - omega*t,  x += alpha*p + omega*s,  r.r,  r.r_hat
+ *                 5. p = r + beta*(p - omega*v)
+ *              1-2 and 3-5 each run inside a single parallel region
+ * Inputs: A - matrix class
+ *         x - unknowns
+ *         b - vector (nullptr for Ax = 0)
+ *         tol tolerance
+ *         maxIt - maximum iterations
+ *         print - print of the iteration number, time and residual
+ *         numThreads - number of threads to split the for loop
+ * Outputs: x - Converged solution
+ */
+bool IterativeSolver::BiCGSTAB_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
+    return BiCGSTAB_Fused(A, x, b, tol, maxIt, print, printer, nullptr, numThreads);
+}
+
+bool IterativeSolver::BiCGSTAB_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer,
+                                     puma::SolverTelemetry *telemetry, int numThreads) {
+    puma::Timer t1;
+    t1.reset();
+
+    long N = x->size();
+
+    puma::Matrix<double> v(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<double> p(x->X(),x->Y(),x->Z());
+    puma::Matrix<double> s(x->X(),x->Y(),x->Z());
+    puma::Matrix<double> t(x->X(),x->Y(),x->Z());
+    puma::Matrix<double> r(x->X(),x->Y(),x->Z());
+    puma::Matrix<double> r_hat(x->X(),x->Y(),x->Z());
+
+    A->A_times_X(x,&r);
+
+    // the dot products are summed per block of puma::Reduction and the blocks combined in a fixed order, so that
+    // the iterates do not depend on the number of threads
+    long numBlocks = puma::Reduction::blocks(N);
+    std::vector<double> blockSum1(numBlocks), blockSum2(numBlocks);
+
+    // r = b - Ax, r_hat = p = r and r.r in one pass
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(static)
+    for (long blk=0;blk<numBlocks;blk++){
+        blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+            double ri = (b ? (*b)(i) : 0.) - r(i);
+            r(i) = ri;
+            r_hat(i) = ri;
+            p(i) = ri;
+            return ri*ri;
+        });
+    }
+    double rr = puma::Reduction::combine(blockSum1.data(), numBlocks);
+
+    if(sqrt(rr) < tol ) {
+        return true;
+    }
+
+    // since r_hat = r, the first rho is r.r, and the first p is r
+    double rho = rr;
+    double alpha = 1;
+    double omega = 1;
+    double tau = 0;
+
+    // bytes moved by a kernel which reads or writes n vectors, and by a product with A
+    const double vec = (double)N * sizeof(double);
+    const double product = A->productBytes(x);
+    PhaseRecorder phase(telemetry);
+    if(telemetry) {
+        telemetry->start("BiCGSTAB_Fused", N);
+    }
+
+    if(print) {
+        printer->print("BiCGSTAB Solver running");
+    }
+
+    for(int it=0;it<maxIt;it++){
+        if (rho == 0.) {
+            // BiCGSTAB Breakdown
+            printer->print("BiCGSTAB Warning:  rho = 0");
+            return false;
+        }
+
+        phase.begin();
+        A->A_times_X(&p,&v);
+        phase.end(puma::SolverTelemetry::Product, product);
+
+        phase.begin();
+        tau = 0;
+        double ss = 0;
+        omp_set_num_threads(numThreads);
+#pragma omp parallel
+        {
+#pragma omp for schedule(static)
+            for(long blk=0;blk<numBlocks;blk++){
+                blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return v(i)*r_hat(i); });
+            }
+#pragma omp single
+            tau = puma::Reduction::combine(blockSum1.data(), numBlocks);
+
+            // tau is visible to every thread after the implicit barrier of single
+            if(tau != 0.) {
+                double a = rho/tau;
+#pragma omp for schedule(static)
+                for(long blk=0;blk<numBlocks;blk++){
+                    blockSum2[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+                        double si = r(i)-a*v(i);
+                        s(i) = si;
+                        return si*si;
+                    });
+                }
+#pragma omp single
+                ss = puma::Reduction::combine(blockSum2.data(), numBlocks);
+            }
+        }
+        phase.end(puma::SolverTelemetry::Update, tau != 0. ? 5*vec : 2*vec, tau != 0. ? 2 : 1);
+
+        if (tau == 0.) {
+            // BiCGSTAB Breakdown
+            printer->print("BiCGSTAB Warning:  tau = 0");
+            return false;
+        }
+        alpha = rho/tau;
+
+        phase.begin();
+        A->A_times_X(&s,&t);
+        phase.end(puma::SolverTelemetry::Product, product);
+
+        phase.begin();
+        double ts = 0, tt = 0;
+        double rho_new = 0;
+        rr = 0;
+        omp_set_num_threads(numThreads);
+#pragma omp parallel
+        {
+            // the second sum of a block reads t from cache
+#pragma omp for schedule(static)
+            for(long blk=0;blk<numBlocks;blk++){
+                blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return t(i)*s(i); });
+                blockSum2[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return t(i)*t(i); });
+            }
+#pragma omp single
+            {
+                ts = puma::Reduction::combine(blockSum1.data(), numBlocks);
+                tt = puma::Reduction::combine(blockSum2.data(), numBlocks);
+            }
+
+            if(ss == 0. || tt != 0.) {
+                double w = (ss == 0.) ? 0. : ts/tt;
+
+#pragma omp for schedule(static)
+                for(long blk=0;blk<numBlocks;blk++){
+                    blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+                        // Update Solution and Residual
+                        double ri = s(i)-w*t(i);
+                        r(i) = ri;
+                        (*x)(i) += alpha*p(i)+w*s(i);
+                        return ri*ri;
+                    });
+                    blockSum2[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return r(i)*r_hat(i); });
+                }
+#pragma omp single
+                {
+                    rr = puma::Reduction::combine(blockSum1.data(), numBlocks);
+                    rho_new = puma::Reduction::combine(blockSum2.data(), numBlocks);
+                }
+
+                // p is only needed if another iteration follows
+                if(sqrt(rr) >= tol && w != 0. && rho_new != 0.) {
+                    double beta = (rho_new/rho)*(alpha/w);
+#pragma omp for
+                    for(long i=0;i<N;i++){
+                        p(i)=r(i)+beta*(p(i)-w*v(i));
+                    }
+                }
+            }
+        }
+        if(ss == 0. || tt != 0.) {
+            double w = (ss == 0.) ? 0. : ts/tt;
+            bool updateP = sqrt(rr) >= tol && w != 0. && rho_new != 0.;
+            phase.end(puma::SolverTelemetry::Update, updateP ? 13*vec : 9*vec, updateP ? 3 : 2);
+        }
+        else {
+            phase.end(puma::SolverTelemetry::Reduction, 2*vec);
+        }
+
+        // s = 0 means that x + alpha*p is the exact solution, which the convergence test below accepts
+        if (ss == 0.) {
+            omega = 0;
+        }
+        else if (tt == 0.) {
+            // BiCGSTAB Breakdown
+            printer->print("BiCGSTAB Warning:  tau = 0");
+            return false;
+        }
+        else {
+            omega = ts/tt;
+        }
+
+        double zeta = sqrt(rr);
+        if(telemetry) {
+            telemetry->endIteration(it+1, zeta);
+        }
+        if(print) {
+            std::stringstream buffer;
+            buffer << '\r' << "Iteration: " << it+1 << "  -  " << "Time: " << t1.elapsed() << "  -  " << "Residual: " << zeta;
+            printer->print(buffer.str());
+        }
+
+        if(zeta < tol){
+            return true;
+        }
+        rho = rho_new;
+        if (omega == 0.)
+        {
+            // BiCGSTAB Breakdown
+            printer->print("BiCGSTAB Warning:  omega = 0");
+            return false;
+        }
+
+    }
+    printer->print("BiCGSTAB Warning: Max Iterations Reached");
+    return false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool IterativeSolver::ConjugateGradient_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, int numThreads){
+    puma::Printer printer;
+    return ConjugateGradient_Fused(A, x, b, tol, maxIt, print, &printer, numThreads);
+}
+
+/*
+ * Description: Conjugate Gradient Solver for problems of type: Ax = b, with fused vector kernels
+ *              Passes over memory per iteration (excluding A_times_X), all inside a single parallel region:
+ *                 1. p.Ap
+ *                 2. x += alpha*p,  r -= alpha*Ap,  r.r
+ *                 3. p = r + beta*p
+ * Inputs: A - matrix class
+ *         x - unknowns
+ *         b - vector (nullptr for Ax = 0)
+ *         tol tolerance
+ *         maxIt - maximum iterations
+ *         print - print of the iteration number, time and residual
+ *         numThreads - number of threads to split the for loop
+ * Outputs: x - Converged solution
+ */
+bool IterativeSolver::ConjugateGradient_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
+    return ConjugateGradient_Fused(A, x, b, tol, maxIt, print, printer, nullptr, numThreads);
+}
+
+bool IterativeSolver::ConjugateGradient_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer,
+                                              puma::SolverTelemetry *telemetry, int numThreads) {
+    puma::Timer t1;
+    t1.reset();
+
+    long N = x->size();
+
+    puma::Matrix<double> r(x->X(),x->Y(),x->Z());
+    puma::Matrix<double> p(x->X(),x->Y(),x->Z());
+    puma::Matrix<double> Ap(x->X(),x->Y(),x->Z(),0);
+
+    A->A_times_X(x,&r);
+
+    // the dot products are summed per block of puma::Reduction and the blocks combined in a fixed order, so that
+    // the iterates do not depend on the number of threads
+    long numBlocks = puma::Reduction::blocks(N);
+    std::vector<double> blockSum1(numBlocks), blockSum2(numBlocks);
+
+    // r = b - Ax, p = r and r.r in one pass
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(static)
+    for (long blk=0;blk<numBlocks;blk++){
+        blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+            double ri = (b ? (*b)(i) : 0.) - r(i);
+            r(i) = ri;
+            p(i) = ri;
+            return ri*ri;
+        });
+    }
+    double rsold = puma::Reduction::combine(blockSum1.data(), numBlocks);
+
+    if(sqrt(rsold) < tol ) {
+        return true;
+    }
+
+    // bytes moved by a kernel which reads or writes n vectors, and by a product with A
+    const double vec = (double)N * sizeof(double);
+    const double product = A->productBytes(x);
+    PhaseRecorder phase(telemetry);
+    if(telemetry) {
+        telemetry->start("ConjugateGradient_Fused", N);
+    }
+
+    if(print) {
+        printer->print("Conjugate Gradient Solver running");
+    }
+
+    // Start of Iterations
+    for(int it=0;it<maxIt;it++){
+
+        phase.begin();
+        A->A_times_X(&p,&Ap);
+        phase.end(puma::SolverTelemetry::Product, product);
+
+        phase.begin();
+        double psold = 0;
+        double rsnew = 0;
+        omp_set_num_threads(numThreads);
+#pragma omp parallel
+        {
+#pragma omp for schedule(static)
+            for(long blk=0;blk<numBlocks;blk++){
+                blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return p(i)*Ap(i); });
+            }
+#pragma omp single
+            psold = puma::Reduction::combine(blockSum1.data(), numBlocks);
+
+            double alpha = rsold/psold;
+#pragma omp for schedule(static)
+            for(long blk=0;blk<numBlocks;blk++){
+                blockSum2[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+                    (*x)(i) += alpha*p(i);
+                    double ri = r(i) - alpha*Ap(i);
+                    r(i) = ri;
+                    return ri*ri;
+                });
+            }
+#pragma omp single
+            rsnew = puma::Reduction::combine(blockSum2.data(), numBlocks);
+
+            // p is only needed if another iteration follows
+            if(sqrt(rsnew) >= tol) {
+                double beta = rsnew/rsold;
+#pragma omp for
+                for(long i=0;i<N;i++){
+                    p(i)=r(i)+beta*p(i);
+                }
+            }
+        }
+        bool updateP = sqrt(rsnew) >= tol;
+        phase.end(puma::SolverTelemetry::Update, updateP ? 11*vec : 8*vec, updateP ? 3 : 2);
+        if(telemetry) {
+            telemetry->endIteration(it+1, sqrt(rsnew));
+        }
+
+        if(sqrt(rsnew)<tol) {
+            return true;
+        }
+        if(print) {
+            std::stringstream buffer;
+            buffer << '\r' << "Iteration: " << it+1 << "  -  " << "Time: " << t1.elapsed() << "  -  " << "Residual: " << sqrt(rsnew);
+            printer->print(buffer.str());
+        }
+
+        rsold=rsnew;
+    }
+    printer->print("Conjugate Gradient Warning: Max Iterations Reached");
+
+    return false;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// block product over the systems that are still active: dst[m] = A src[m], or Minv src[m]
+static bool blockProduct(AMatrix *A, std::vector<bool> &active, std::vector<puma::Matrix<double>> *src, std::vector<puma::Matrix<double>> *dst,
+                         bool preconditioner) {
+    std::vector<puma::Matrix<double>*> in(active.size(), nullptr), out(active.size(), nullptr);
+    for(size_t m=0;m<active.size();m++) {
+        if(active[m]) {
+            in[m] = &src->at(m);
+            out[m] = &dst->at(m);
+        }
+    }
+    return preconditioner ? A->Minv_times_X(&in, &out) : A->A_times_X(&in, &out);
+}
+
+// r[m] = b[m] - A x[m] for every system
+static bool blockResidual(AMatrix *A, std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *b,
+                          std::vector<puma::Matrix<double>> *r, int numThreads) {
+    std::vector<puma::Matrix<double>*> out(x->size());
+    for(size_t m=0;m<x->size();m++) {
+        r->at(m).resize(x->at(m)->X(),x->at(m)->Y(),x->at(m)->Z(),0);
+        out[m] = &r->at(m);
+    }
+    if(!A->A_times_X(x, &out)) {
+        return false;
+    }
+    for(size_t m=0;m<x->size();m++) {
+        puma::Matrix<double> &rm = r->at(m);
+        puma::Matrix<double> *bm = b->at(m);
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for
+        for (long i=0;i<rm.size();i++){
+            rm(i) = (*bm)(i) - rm(i);
+        }
+    }
+    return true;
+}
+
+/*
+ * Description: BiConjugate Gradient Stabilized Solver for several problems of type: A_m x_m = b_m
+ *              One recurrence per system, the two products with A of each iteration are block products
+ * Inputs: A - matrix class, applying system m to vector m
+ *         x - unknowns
+ *         b - vectors
+ *         tol tolerance, for each system
+ *         maxIt - maximum iterations
+ *         print - print of the iteration number, time and largest residual
+ *         numThreads - number of threads to split the for loop
+ * Outputs: x - Converged solutions
+ */
+bool IterativeSolver::BiCGSTAB_Block(AMatrix *A, std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
+    puma::Timer t1;
+    t1.reset();
+
+    size_t nSys = x->size();
+    std::vector<puma::Matrix<double>> v(nSys), p(nSys), s(nSys), t(nSys), r(nSys), r_hat(nSys);
+    if(!blockResidual(A, x, b, &r, numThreads)) {
+        return false;
+    }
+
+    std::vector<bool> active(nSys, true);
+    std::vector<double> rho(nSys,1), rho_old(nSys,1), alpha(nSys,1), omega(nSys,1);
+    bool converged = true;
+    size_t nActive = nSys;
+
+    for(size_t m=0;m<nSys;m++) {
+        long X = r[m].X(), Y = r[m].Y(), Z = r[m].Z();
+        v[m].resize(X,Y,Z,0);
+        p[m].resize(X,Y,Z,0);
+        s[m].resize(X,Y,Z,0);
+        t[m].resize(X,Y,Z,0);
+        r_hat[m].copy(&r[m]);
+        if(sqrt(r[m].dot(&r[m],numThreads)) < tol) {
+            active[m] = false;
+            nActive--;
+        }
+    }
+    if(nActive == 0) {
+        return true;
+    }
+
+    if(print) {
+        printer->print("Block BiCGSTAB Solver running");
+    }
+
+    for(int it=0;it<maxIt;it++){
+
+        for(size_t m=0;m<nSys;m++) {
+            if(!active[m]) {
+                continue;
+            }
+            rho[m] = r[m].dot(&r_hat[m],numThreads);
+            if (rho[m] == 0.) {
+                // BiCGSTAB Breakdown
+                printer->print("BiCGSTAB Warning:  rho = 0");
+                active[m] = false; nActive--; converged = false;
+                continue;
+            }
+            double beta = (rho[m]/rho_old[m])*(alpha[m]/omega[m]);
+
+            puma::Matrix<double> &pm = p[m], &rm = r[m], &vm = v[m];
+            double om = omega[m];
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0;i<rm.size();i++){
+                pm(i)=rm(i)+beta*(pm(i)-om*vm(i));
+            }
+        }
+
+        blockProduct(A, active, &p, &v, false);
+
+        for(size_t m=0;m<nSys;m++) {
+            if(!active[m]) {
+                continue;
+            }
+            double tau = v[m].dot(&r_hat[m],numThreads);
+            if (tau == 0.) {
+                // BiCGSTAB Breakdown
+                printer->print("BiCGSTAB Warning:  tau = 0");
+                active[m] = false; nActive--; converged = false;
+                continue;
+            }
+            alpha[m] = rho[m]/tau;
+
+            puma::Matrix<double> &sm = s[m], &rm = r[m], &vm = v[m];
+            double al = alpha[m];
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0;i<rm.size();i++){
+                sm(i)=rm(i)-al*vm(i);
+            }
+        }
+
+        blockProduct(A, active, &s, &t, false);
+
+        double zetaMax = 0;
+        for(size_t m=0;m<nSys;m++) {
+            if(!active[m]) {
+                continue;
+            }
+            double tau = t[m].dot(&t[m],numThreads);
+            if (s[m].dot(&s[m],numThreads) == 0.) {
+                omega[m] = 0;
+            }
+            else if (tau == 0.) {
+                // BiCGSTAB Breakdown
+                printer->print("BiCGSTAB Warning:  tau = 0");
+                active[m] = false; nActive--; converged = false;
+                continue;
+            }
+            else {
+                omega[m] = t[m].dot(&s[m],numThreads)/tau;
+            }
+
+            puma::Matrix<double> &sm = s[m], &rm = r[m], &tm = t[m], &pm = p[m], &xm = *x->at(m);
+            double al = alpha[m], om = omega[m];
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0;i<rm.size();i++){
+                // Update Solution and Residual
+                rm(i) = sm(i)-om*tm(i);
+                xm(i) += al*pm(i)+om*sm(i);
+            }
+
+            double zeta = sqrt(rm.dot(&rm,numThreads));
+            zetaMax = std::max(zetaMax, zeta);
+            rho_old[m] = rho[m];
+
+            if(zeta < tol) {
+                active[m] = false; nActive--;
+            }
+            else if (omega[m] == 0.) {
+                // BiCGSTAB Breakdown
+                printer->print("BiCGSTAB Warning:  omega = 0");
+                active[m] = false; nActive--; converged = false;
+            }
+        }
+
+        if(print) {
+            std::stringstream buffer;
+            buffer << '\r' << "Iteration: " << it+1 << "  -  " << "Time: " << t1.elapsed() << "  -  " << "Residual: " << zetaMax;
+            printer->print(buffer.str());
+        }
+
+        if(nActive == 0) {
+            return converged;
+        }
+    }
+    printer->print( "BiCGSTAB Warning: Max Iterations Reached");
+    return false;
+}
+
+
+/*
+ * Description: Jacobi preconditioned Conjugate Gradient Solver for several problems of type: A_m x_m = b_m
+ *              One recurrence per system, the product with A and the preconditioner are block products
+ * Inputs: A - matrix class, applying system m to vector m
+ *         x - unknowns
+ *         b - vectors
+ *         tol tolerance, for each system
+ *         maxIt - maximum iterations
+ *         print - print of the iteration number, time and largest residual
+ *         numThreads - number of threads to split the for loop
+ * Outputs: x - Converged solutions
+ */
+bool IterativeSolver::ConjugateGradient_Block(AMatrix *A, std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
+    puma::Timer t1;
+    t1.reset();
+
+    size_t nSys = x->size();
+    std::vector<puma::Matrix<double>> r(nSys), z(nSys), p(nSys), Ap(nSys);
+    if(!blockResidual(A, x, b, &r, numThreads)) {
+        return false;
+    }
+
+    std::vector<bool> active(nSys, true);
+    std::vector<double> rzold(nSys);
+    size_t nActive = nSys;
+
+    for(size_t m=0;m<nSys;m++) {
+        z[m].resize(r[m].X(),r[m].Y(),r[m].Z(),0);
+        Ap[m].resize(r[m].X(),r[m].Y(),r[m].Z(),0);
+    }
+    blockProduct(A, active, &r, &z, true);
+
+    for(size_t m=0;m<nSys;m++) {
+        p[m].copy(&z[m]);
+        rzold[m] = r[m].dot(&z[m],numThreads);
+        if(sqrt(r[m].dot(&r[m],numThreads)) < tol) {
+            active[m] = false;
+            nActive--;
+        }
+    }
+    if(nActive == 0) {
+        return true;
+    }
+
+    if(print) {
+        printer->print("Block Conjugate Gradient Solver running");
+    }
+
+    for(int it=0;it<maxIt;it++){
+
+        blockProduct(A, active, &p, &Ap, false);
+
+        double rsMax = 0;
+        for(size_t m=0;m<nSys;m++) {
+            if(!active[m]) {
+                continue;
+            }
+            double alpha = rzold[m]/p[m].dot(&Ap[m],numThreads);
+
+            puma::Matrix<double> &rm = r[m], &pm = p[m], &Apm = Ap[m], &xm = *x->at(m);
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0;i<rm.size();i++){
+                xm(i) += alpha*pm(i);
+                rm(i) += -alpha*Apm(i);
+            }
+
+            double rsnew = sqrt(rm.dot(&rm,numThreads));
+            rsMax = std::max(rsMax, rsnew);
+            if(rsnew < tol) {
+                active[m] = false;
+                nActive--;
+            }
+        }
+
+        if(print) {
+            std::stringstream buffer;
+            buffer << '\r' << "Iteration: " << it+1 << "  -  " << "Time: " << t1.elapsed() << "  -  " << "Residual: " << rsMax;
+            printer->print(buffer.str());
+        }
+
+        if(nActive == 0) {
+            return true;
+        }
+
+        blockProduct(A, active, &r, &z, true);
+
+        for(size_t m=0;m<nSys;m++) {
+            if(!active[m]) {
+                continue;
+            }
+            double rznew = r[m].dot(&z[m],numThreads);
+            double beta = rznew/rzold[m];
+
+            puma::Matrix<double> &pm = p[m], &zm = z[m];
+            omp_set_num_threads(numThreads);
+#pragma omp parallel for
+            for(long i=0;i<pm.size();i++){
+                pm(i)=zm(i)+ beta*pm(i);
+            }
+            rzold[m] = rznew;
+        }
+    }
+    printer->print("Conjugate Gradient Warning: Max Iterations Reached");
+
+    return false;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*
+ * In the first iterations the Krylov vectors decay geometrically away from the sources, and in single precision many
+ * of their entries reach the denormal range, where arithmetic is much slower (2x per iteration on a 200^3 domain).
+ * Flushing them to zero does not affect the refinement, whose residual is computed in double. The mode is per thread,
+ * so it is set in every thread of the team, and the mode each thread had is restored when the object goes out of scope.
+ */
+class DenormalFlush {
+public:
+    explicit DenormalFlush(int numThreads) : numThreads(numThreads) {
+#ifdef __SSE2__
+        omp_set_num_threads(numThreads);
+        flushModes.assign(omp_get_max_threads(), 0);
+        denormalModes.assign(omp_get_max_threads(), 0);
+#pragma omp parallel
+        {
+            size_t thread = omp_get_thread_num();
+            if(thread < flushModes.size()) {
+                flushModes[thread] = _MM_GET_FLUSH_ZERO_MODE();
+                denormalModes[thread] = _MM_GET_DENORMALS_ZERO_MODE();
+            }
+            _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+            _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+        }
+#endif
+    }
+
+    ~DenormalFlush() {
+#ifdef __SSE2__
+        omp_set_num_threads(numThreads);
+#pragma omp parallel
+        {
+            size_t thread = omp_get_thread_num();
+            if(thread < flushModes.size()) {
+                _MM_SET_FLUSH_ZERO_MODE(flushModes[thread]);
+                _MM_SET_DENORMALS_ZERO_MODE(denormalModes[thread]);
+            }
+        }
+#endif
+    }
+
+private:
+    int numThreads;
+    std::vector<unsigned int> flushModes;
+    std::vector<unsigned int> denormalModes;
+};
+
+/*
+ * BiCGSTAB on A e = b with the vectors and products in the precision T, and the reductions accumulated in double.
+ * The vector kernels are fused as in BiCGSTAB_Fused. Used for the corrections of BiCGSTAB_MixedPrecision: b is the
+ * scaled residual of the outer iteration, so the printed residual is the estimate scale*||b - A e||. The solve also
+ * stops when the residual has not reached a new minimum in the last 100 iterations, which is where single precision
+ * rounding takes over from convergence.
+ * Returns the number of iterations done, or -1 on a breakdown.
+ */
+template<class T> static int innerBiCGSTAB(AMatrix *A, puma::Matrix<T> *e, puma::Matrix<T> *b, double tol, int maxIt, int itOffset, double scale,
+                                           bool print, puma::Printer *printer, puma::Timer *t1, int numThreads) {
+
+    long N = e->size();
+
+    puma::Matrix<T> v(e->X(),e->Y(),e->Z(),0);
+    puma::Matrix<T> p(e->X(),e->Y(),e->Z());
+    puma::Matrix<T> s(e->X(),e->Y(),e->Z());
+    puma::Matrix<T> t(e->X(),e->Y(),e->Z());
+    puma::Matrix<T> r(e->X(),e->Y(),e->Z());
+    puma::Matrix<T> r_hat(e->X(),e->Y(),e->Z());
+
+    A->A_times_X(e,&r);
+
+    // as in BiCGSTAB_Fused, the sums go through the blocks of puma::Reduction, so that the corrections and the
+    // number of inner iterations do not depend on the number of threads
+    long numBlocks = puma::Reduction::blocks(N);
+    std::vector<double> blockSum1(numBlocks), blockSum2(numBlocks);
+
+    omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(static)
+    for (long blk=0;blk<numBlocks;blk++){
+        blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+            T ri = (*b)(i) - r(i);
+            r(i) = ri;
+            r_hat(i) = ri;
+            p(i) = ri;
+            return (double)ri*ri;
+        });
+    }
+    double rr = puma::Reduction::combine(blockSum1.data(), numBlocks);
+
+    double rho = rr;
+    double alpha, omega;
+
+    double zetaMin = sqrt(rr);
+    int itMin = 0;
+
+    for(int it=0;it<maxIt;it++){
+        if (rho == 0.) {
+            return -1;
+        }
+
+        A->A_times_X(&p,&v);
+
+        double tau = puma::Reduction::sum(N, [&](long i) { return (double)v(i)*r_hat(i); }, numThreads);
+        if (tau == 0.) {
+            return -1;
+        }
+        alpha = rho/tau;
+
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(static)
+        for(long blk=0;blk<numBlocks;blk++){
+            blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+                T si = r(i)-(T)alpha*v(i);
+                s(i) = si;
+                return (double)si*si;
+            });
+        }
+        double ss = puma::Reduction::combine(blockSum1.data(), numBlocks);
+
+        A->A_times_X(&s,&t);
+
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(static)
+        for(long blk=0;blk<numBlocks;blk++){
+            blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return (double)t(i)*s(i); });
+            blockSum2[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return (double)t(i)*t(i); });
+        }
+        double ts = puma::Reduction::combine(blockSum1.data(), numBlocks);
+        double tt = puma::Reduction::combine(blockSum2.data(), numBlocks);
+        if (ss != 0. && tt == 0.) {
+            return -1;
+        }
+        omega = (ss == 0.) ? 0. : ts/tt;
+
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for schedule(static)
+        for(long blk=0;blk<numBlocks;blk++){
+            blockSum1[blk] = puma::Reduction::blockSum(blk, N, [&](long i) {
+                T ri = s(i)-(T)omega*t(i);
+                r(i) = ri;
+                (*e)(i) += (T)alpha*p(i)+(T)omega*s(i);
+                return (double)ri*ri;
+            });
+            blockSum2[blk] = puma::Reduction::blockSum(blk, N, [&](long i) { return (double)r(i)*r_hat(i); });
+        }
+        rr = puma::Reduction::combine(blockSum1.data(), numBlocks);
+        double rho_new = puma::Reduction::combine(blockSum2.data(), numBlocks);
+
+        double zeta = sqrt(rr);
+        if(print) {
+            std::stringstream buffer;
+            buffer << '\r' << "Iteration: " << itOffset+it+1 << "  -  " << "Time: " << t1->elapsed() << "  -  " << "Residual: " << scale*zeta;
+            printer->print(buffer.str());
+        }
+
+        if(zeta < zetaMin) {
+            zetaMin = zeta;
+            itMin = it;
+        }
+        if(zeta < tol || omega == 0. || it-itMin >= 100){
+            return it+1;
+        }
+
+        double beta = (rho_new/rho)*(alpha/omega);
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for
+        for(long i=0;i<N;i++){
+            p(i) = r(i)+(T)beta*(p(i)-(T)omega*v(i));
+        }
+        rho = rho_new;
+    }
+    return maxIt;
+}
+
+/*
+ * Description: Mixed precision BiConjugate Gradient Stabilized Solver (iterative refinement) for problems of type: Ax = b
+ *         Each outer iteration computes r = b - A x in double, solves A e = r/|r| with BiCGSTAB in single precision
+ *         down to a relative residual of 1e-3 (or just the final tolerance), and adds |r| e to x. The inner solves are
+ *         limited to 200 iterations: past that, single precision BiCGSTAB tends to stagnate or diverge, and a restart
+ *         from the double precision residual converges faster.
+ *         If an outer iteration does not halve the residual, single precision has reached its limit for this
+ *         system, and the remaining iterations are done by BiCGSTAB in double.
+ * Inputs: A - matrix class
+ *         x - unknowns
+ *         b - vector
+ *         tol tolerance
+ *         maxIt - maximum iterations, counting the inner iterations
+ *         print - print of the iteration number, time and residual
+ *         numThreads - number of threads to split the for loop
+ * Outputs: x - Converged solution
+ */
+bool IterativeSolver::BiCGSTAB_MixedPrecision(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, int numThreads) {
+    puma::Printer printer;
+    return BiCGSTAB_MixedPrecision( A, x, b, tol, maxIt, print, &printer, numThreads);
+}
+
+bool IterativeSolver::BiCGSTAB_MixedPrecision(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
+    puma::Timer t1;
+    t1.reset();
+
+    const double innerReduction = 1e-3;
+    const int innerRestart = 200;
+
+    puma::Matrix<double> r(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<float> rF(x->X(),x->Y(),x->Z(),0);
+    puma::Matrix<float> eF(x->X(),x->Y(),x->Z(),0);
+
+    if(print) {
+        printer->print("BiCGSTAB Mixed Precision Solver running");
+    }
+
+    int it = 0;
+    double zetaOld = 0;
+    while(true) {
+
+        A->A_times_X(x,&r);
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for
+        for (long i=0;i<r.size();i++){
+            r(i)=(*b)(i)-r(i);
+        }
+
+        double zeta = sqrt(r.dot(&r,numThreads));
+        if(zeta < tol) {
+            return true;
+        }
+        if(it >= maxIt) {
+            printer->print("BiCGSTAB Mixed Precision Warning: Max Iterations Reached");
+            return false;
+        }
+        if(zetaOld > 0 && zeta > 0.5*zetaOld) {
+            if(print) {
+                printer->print("BiCGSTAB Mixed Precision: single precision stagnated, continuing in double precision");
+            }
+            return BiCGSTAB(A,x,b,tol,maxIt-it,print,printer,numThreads);
+        }
+        zetaOld = zeta;
+
+        // scaled so that the single precision values stay of order one whatever the residual
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for
+        for (long i=0;i<r.size();i++){
+            rF(i) = (float)(r(i)/zeta);
+            eF(i) = 0;
+        }
+
+        double innerTol = std::max(innerReduction, 0.5*tol/zeta);
+        int innerIt;
+        {
+            DenormalFlush flush(numThreads);
+            innerIt = innerBiCGSTAB(A,&eF,&rF,innerTol,std::min(innerRestart,maxIt-it),it,zeta,print,printer,&t1,numThreads);
+        }
+        if(innerIt < 0) {
+            if(print) {
+                printer->print("BiCGSTAB Mixed Precision: single precision breakdown, continuing in double precision");
+            }
+            return BiCGSTAB(A,x,b,tol,maxIt-it,print,printer,numThreads);
+        }
+        it += innerIt;
+
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for
+        for (long i=0;i<r.size();i++){
+            (*x)(i) += zeta*(double)eF(i);
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+/*
+ * Description: Red-black Successive Over-Relaxation for problems of type: Ax = b
+ * Inputs: A - matrix class, which must implement relaxRedBlack
+ *         x - unknowns
+ *         b - right hand side (nullptr for Ax = 0)
+ *         omega - relaxation factor, or 0 to estimate it during the solve
+ *         tol tolerance
+ *         maxIt - maximum number of sweeps
+ *         print - print of the iteration number, time and residual
+ *         numThreads - number of threads to split the for loop
+ * Outputs: x - Converged solution
+ */
+bool IterativeSolver::SOR_RedBlack(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double omega, double tol, int maxIt, bool print, int numThreads) {
+    puma::Printer printer;
+    return SOR_RedBlack(A, x, b, omega, tol, maxIt, print, &printer, numThreads);
+}
+
+bool IterativeSolver::SOR_RedBlack(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double omega, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads) {
+    puma::Timer t1;
+    t1.reset();
+
+    // sweeps between two residual evaluations, each costing about as much as a sweep
+    const int checkInterval = 10;
+    const double maxOmega = 1.99;
+
+    puma::Matrix<double> zero;
+    if(!b) {
+        zero.resize(x->X(),x->Y(),x->Z(),0);
+        b = &zero;
+    }
+
+    puma::Matrix<double> r(x->X(),x->Y(),x->Z(),0);
+    auto residual = [&]() {
+        A->A_times_X(x,&r);
+        omp_set_num_threads(numThreads);
+#pragma omp parallel for
+        for (long i=0;i<r.size();i++){
+            r(i)=(*b)(i)-r(i);
+        }
+        return sqrt(A->dot(&r,&r,numThreads));
+    };
+
+    double res = residual();
+    if(res < tol) {
+        return true;
+    }
+    if(print) {
+        printer->print("Red-Black SOR Solver running");
+    }
+
+    bool adaptive = omega <= 0;
+    if(adaptive) {
+        omega = 1;
+    }
+    if(omega >= 2) {
+        printer->print("Red-Black SOR Error: omega must be smaller than 2");
+        return false;
+    }
+
+    double resOld = res;
+    double rateOld = 0;
+    for(int it=0;it<maxIt;it++){
+
+        if(!A->relaxRedBlack(x,b,0,omega)) {
+            printer->print("Red-Black SOR Error: the operator does not support red-black relaxation");
+            return false;
+        }
+        A->relaxRedBlack(x,b,1,omega);
+
+        if((it+1)%checkInterval != 0 && it+1 < maxIt) {
+            continue;
+        }
+
+        res = residual();
+        if(res < tol) {
+            return true;
+        }
+        if(!std::isfinite(res)) {
+            printer->print("Red-Black SOR Error: the iterations diverged");
+            return false;
+        }
+        if(print) {
+            std::stringstream buffer;
+            buffer << '\r' << "Iteration: " << it+1 << "  -  " << "Time: " << t1.elapsed() << "  -  " << "Residual: " << res << "  -  " << "Omega: " << omega;
+            printer->print(buffer.str());
+        }
+
+        /*
+         * Adaptive omega (Hageman & Young): once the convergence rate per sweep has settled, the spectral radius of
+         * the Jacobi iteration follows from the SOR rate, rhoJ^2 = (rate + omega - 1)^2 / (omega^2 rate), which
+         * gives the optimal omega = 2 / (1 + sqrt(1 - rhoJ^2)). Red-black ordering of the 7 point stencil is
+         * consistently ordered, so this relation holds. Omega is only increased: below the optimum, the estimate
+         * is too small while the transient of the smooth error components has not died out.
+         */
+        if(adaptive) {
+            double rate = std::pow(res/resOld, 1./checkInterval);
+            if(rate < 1 && rateOld > 0 && std::fabs(rate-rateOld) < 0.1*(1-rate)) {
+                double rhoJ2 = (rate+omega-1)*(rate+omega-1) / (omega*omega*rate);
+                double omegaNew = (rhoJ2 < 1) ? std::min(maxOmega, 2./(1.+sqrt(1.-rhoJ2))) : maxOmega;
+                if(omegaNew > omega + 1e-3) {
+                    omega = omegaNew;
+                    rate = 0;
+                }
+            }
+            rateOld = rate;
+        }
+        resOld = res;
+    }
+    printer->print("Red-Black SOR Warning: Max Iterations Reached");
+
+    return false;
+}
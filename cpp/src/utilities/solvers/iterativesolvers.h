@@ -5,8 +5,11 @@
 #include "matrix.h"
 #include "timer.h"
 #include "Printer.h"
+#include "solvercheckpoint.h"
+#include "solvertelemetry.h"
 
 #include <cmath>
+#include <vector>
 
 
 namespace IterativeSolver {
@@ -36,6 +39,27 @@ namespace IterativeSolver {
     bool BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, int numThreads);
     bool BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
 
+    //! solves a linear system of equations using the biconjugate gradient stabilized method, saving its state to a checkpoint.
+    /*!
+     * Same as BiCGSTAB, but the state is saved when the checkpoint is due, and a solve of the same problem continues
+     * from the checkpoint file if it exists and resuming is enabled. The file has to match b and the operator set with
+     * SolverCheckpoint::setOperator, and its residual has to match b - Ax for its solution, otherwise the solve starts
+     * over from x. The file is deleted on convergence.
+     * \param checkpoint a pointer to a SolverCheckpoint (nullptr to disable checkpointing).
+     */
+    bool BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, puma::SolverCheckpoint *checkpoint, int numThreads);
+
+    //! solves a linear system of equations using the biconjugate gradient stabilized method, recording each iteration.
+    /*!
+     * Same as BiCGSTAB, but the residual, the time spent in products, reductions and vector updates, and an estimate
+     * of the bytes moved are recorded at each iteration.
+     * \param b a pointer to a puma matrix which stores the right-hand side (nullptr for a homogeneous system).
+     * \param checkpoint a pointer to a SolverCheckpoint (nullptr to disable checkpointing).
+     * \param telemetry a pointer to a SolverTelemetry receiving the records (nullptr to disable recording).
+     */
+    bool BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, puma::SolverCheckpoint *checkpoint, puma::SolverTelemetry *telemetry, int numThreads);
+    bool BiCGSTAB(AMatrix *A, puma::Matrix<double> *x, double tol, int maxIt, bool print, puma::Printer *printer, puma::SolverTelemetry *telemetry, int numThreads);
+
     //! solves a homogeneous (right-hand side equals zero) linear system of equations using the conjugate gradient method.
     /*!
      * \param A a pointer to an AMatrix representing the linear system being solved.
@@ -63,5 +87,116 @@ namespace IterativeSolver {
 
     bool ConjugateGradient_Jacobian(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
 
+    //! solves a linear system of equations using the biconjugate gradient stabilized method, with fused vector kernels.
+    /*!
+     * Same iterates as BiCGSTAB, but each vector update is merged with the dot products that follow it, and the
+     * kernels between two A_times_X calls share one parallel region. This takes the passes over memory per
+     * iteration (excluding A_times_X) from 9 down to 5. The dot products are summed over the fixed blocks of
+     * puma::Reduction, so the iterates are bitwise the same on any number of threads.
+     * \param A a pointer to an AMatrix representing the linear system being solved.
+     * \param x a pointer to a puma matrix which stores the solution. The matrix should contain an initial guess for the solution when passed in.
+     * \param b a pointer to a puma matrix which stores the right-hand side of the system of equations (nullptr for a homogeneous system).
+     * \param tol a double specifying the convergence criterion.
+     * \param maxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
+     * \param print a boolean which specifies whether the the number of iterations and residual are printed after each iteration of the solver.
+     * \return a boolean indicating whether or not convergence was achieved.
+     */
+    bool BiCGSTAB_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, int numThreads);
+    bool BiCGSTAB_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
+
+    //! same as BiCGSTAB_Fused, recording each iteration (see BiCGSTAB). The fused kernels are charged to the update phase.
+    /*!
+     * \param telemetry a pointer to a SolverTelemetry receiving the records (nullptr to disable recording).
+     */
+    bool BiCGSTAB_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, puma::SolverTelemetry *telemetry, int numThreads);
+
+    //! solves a linear system of equations using the conjugate gradient method, with fused vector kernels.
+    /*!
+     * Same iterates as ConjugateGradient, but the solution/residual update is merged with the residual norm, and
+     * the kernels between two A_times_X calls share one parallel region. This takes the passes over memory per
+     * iteration (excluding A_times_X) from 4 down to 3. As in BiCGSTAB_Fused, the dot products do not depend on
+     * the number of threads.
+     * \param A a pointer to an AMatrix representing the linear system being solved.
+     * \param x a pointer to a puma matrix which stores the solution. The matrix should contain an initial guess for the solution when passed in.
+     * \param b a pointer to a puma matrix which stores the right-hand side of the system of equations (nullptr for a homogeneous system).
+     * \param tol a double specifying the convergence criterion.
+     * \param maxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
+     * \param print a boolean which specifies whether the the number of iterations and residual are printed after each iteration of the solver.
+     * \return a boolean indicating whether or not convergence was achieved.
+     */
+    bool ConjugateGradient_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, int numThreads);
+    bool ConjugateGradient_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
+
+    //! same as ConjugateGradient_Fused, recording each iteration (see BiCGSTAB). The fused kernels are charged to the update phase.
+    /*!
+     * \param telemetry a pointer to a SolverTelemetry receiving the records (nullptr to disable recording).
+     */
+    bool ConjugateGradient_Fused(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, puma::SolverTelemetry *telemetry, int numThreads);
+
+    //! solves a linear system of equations using the biconjugate gradient stabilized method in single precision, refined in double precision.
+    /*!
+     * The residual and the solution are kept in double, and each correction is computed by BiCGSTAB with single
+     * precision vectors and products (AMatrix::A_times_X on float matrices). This halves the memory traffic and the
+     * size of the Krylov vectors, while the tolerance is still checked on the double precision residual. Systems
+     * too ill-conditioned for single precision corrections are finished with BiCGSTAB in double.
+     * \param A a pointer to an AMatrix representing the linear system being solved.
+     * \param x a pointer to a puma matrix which stores the solution. The matrix should contain an initial guess for the solution when passed in.
+     * \param b a pointer to a puma matrix which stores the right-hand side of the system of equations.
+     * \param tol a double specifying the convergence criterion.
+     * \param maxIt an integer specifying the maximum number of iterations the solver may execute before exiting, counting the single precision iterations.
+     * \param print a boolean which specifies whether the the number of iterations and residual are printed after each iteration of the solver.
+     * \return a boolean indicating whether or not convergence was achieved.
+     */
+    bool BiCGSTAB_MixedPrecision(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, int numThreads);
+    bool BiCGSTAB_MixedPrecision(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
+
+    //! solves several linear systems of the same size at once using the biconjugate gradient stabilized method.
+    /*!
+     * Each system keeps its own BiCGSTAB recurrence, so the iterates are those of separate BiCGSTAB solves, but the
+     * products with A are done for all the systems in one call to the block A_times_X. A system stops being updated
+     * once it has converged.
+     * \param A a pointer to an AMatrix representing the linear systems being solved (system s is applied to (*x)[s]).
+     * \param x a pointer to a vector of puma matrices which store the solutions. They should contain an initial guess for the solutions when passed in.
+     * \param b a pointer to a vector of puma matrices which store the right-hand sides of the systems of equations.
+     * \param tol a double specifying the convergence criterion, applied to each system.
+     * \param maxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
+     * \param print a boolean which specifies whether the the number of iterations and largest residual are printed after each iteration of the solver.
+     * \return a boolean indicating whether or not convergence was achieved for all the systems.
+     */
+    bool BiCGSTAB_Block(AMatrix *A, std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
+
+    //! solves several linear systems of the same size at once using the Jacobi preconditioned conjugate gradient method.
+    /*!
+     * Each system keeps its own recurrence, with the products with A and the preconditioner done for all the systems
+     * in one call.
+     * \param A a pointer to an AMatrix representing the linear systems being solved (system s is applied to (*x)[s]).
+     * \param x a pointer to a vector of puma matrices which store the solutions. They should contain an initial guess for the solutions when passed in.
+     * \param b a pointer to a vector of puma matrices which store the right-hand sides of the systems of equations.
+     * \param tol a double specifying the convergence criterion, applied to each system.
+     * \param maxIt an integer specifying the maximum number of iterations the solver may execute before exiting.
+     * \param print a boolean which specifies whether the the number of iterations and largest residual are printed after each iteration of the solver.
+     * \return a boolean indicating whether or not convergence was achieved for all the systems.
+     */
+    bool ConjugateGradient_Block(AMatrix *A, std::vector<puma::Matrix<double>*> *x, std::vector<puma::Matrix<double>*> *b, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
+
+    //! solves a linear system of equations using successive over-relaxation with a red-black ordering.
+    /*!
+     * Each sweep relaxes the red and then the black unknowns (AMatrix::relaxRedBlack), each colour in parallel.
+     * A sweep costs about as much as one product with A, and the residual is only evaluated every 10 sweeps.
+     * With omega = 0, the solver starts as Gauss-Seidel and raises omega towards the optimum estimated from the
+     * observed convergence rate. SOR needs more iterations than the Krylov solvers on large or high contrast
+     * domains, but no extra vectors besides the residual.
+     * \param A a pointer to an AMatrix representing the linear system being solved, which must support relaxRedBlack.
+     * \param x a pointer to a puma matrix which stores the solution. The matrix should contain an initial guess for the solution when passed in.
+     * \param b a pointer to a puma matrix which stores the right-hand side of the system of equations (nullptr for a homogeneous system).
+     * \param omega a double specifying the relaxation factor (between 0 and 2), or 0 to estimate it during the solve.
+     * \param tol a double specifying the convergence criterion.
+     * \param maxIt an integer specifying the maximum number of sweeps the solver may execute before exiting.
+     * \param print a boolean which specifies whether the the number of iterations and residual are printed each time the residual is evaluated.
+     * \return a boolean indicating whether or not convergence was achieved.
+     */
+    bool SOR_RedBlack(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double omega, double tol, int maxIt, bool print, int numThreads);
+    bool SOR_RedBlack(AMatrix *A, puma::Matrix<double> *x, puma::Matrix<double> *b, double omega, double tol, int maxIt, bool print, puma::Printer *printer, int numThreads);
+
 }
 #endif // ITERATIVESOLVER_H
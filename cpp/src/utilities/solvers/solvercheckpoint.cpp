@@ -0,0 +1,161 @@
+#include "solvercheckpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+
+// file layout: magic, version, solver name, problem and operator hashes, iteration, scalars, then each field as X, Y, Z and its data
+static const char checkpointMagic[8] = { 'P', 'U', 'M', 'A', 'C', 'K', 'P', 'T' };
+static const int checkpointVersion = 2;
+
+
+puma::SolverCheckpoint::SolverCheckpoint(std::string fileName, int everyIterations, double everySeconds, bool resume) {
+    this->fileName = std::move(fileName);
+    this->everyIterations = everyIterations;
+    this->everySeconds = everySeconds;
+    this->resume = resume;
+    timer.reset();
+}
+
+bool puma::SolverCheckpoint::due(int iteration) {
+    if(everyIterations > 0 && iteration - lastIteration >= everyIterations) {
+        return true;
+    }
+    return everySeconds > 0 && timer.elapsed() >= everySeconds;
+}
+
+void puma::SolverCheckpoint::setOperator(puma::Matrix<double> *coefficients, const std::string &settings) {
+    operatorHash = hash(coefficients);
+    operatorHash = hash(settings.data(), settings.size(), operatorHash);
+}
+
+// FNV-1a, continuing from h
+unsigned long long puma::SolverCheckpoint::hash(const void *data, size_t bytes, unsigned long long h) {
+    const unsigned char *values = reinterpret_cast<const unsigned char*>(data);
+    for(size_t i=0;i<bytes;i++) {
+        h ^= values[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// FNV-1a over the bytes of b
+unsigned long long puma::SolverCheckpoint::hash(puma::Matrix<double> *b) {
+    unsigned long long h = 14695981039346656037ULL;
+    if(!b || b->size() == 0) {
+        return h;
+    }
+    return hash(&b->at(0), b->size() * sizeof(double), h);
+}
+
+bool puma::SolverCheckpoint::save(const std::string &solver, puma::Matrix<double> *b, int iteration, const std::vector<double> &scalars,
+                                  const std::vector<puma::Matrix<double>*> &fields) {
+    lastIteration = iteration;
+    timer.reset();
+
+    std::string tmpName = fileName + ".tmp";
+    FILE *file = fopen(tmpName.c_str(), "wb");
+    if(file == nullptr) {
+        std::cout << "Solver Checkpoint Error: could not create " << tmpName << std::endl;
+        return false;
+    }
+
+    bool ok = fwrite(checkpointMagic, 1, 8, file) == 8;
+    ok &= fwrite(&checkpointVersion, sizeof(int), 1, file) == 1;
+
+    long nameLength = (long)solver.size();
+    ok &= fwrite(&nameLength, sizeof(long), 1, file) == 1;
+    ok &= fwrite(solver.c_str(), 1, nameLength, file) == (size_t)nameLength;
+
+    unsigned long long problem = hash(b);
+    ok &= fwrite(&problem, sizeof(problem), 1, file) == 1;
+    ok &= fwrite(&operatorHash, sizeof(operatorHash), 1, file) == 1;
+    ok &= fwrite(&iteration, sizeof(int), 1, file) == 1;
+
+    long nScalars = (long)scalars.size();
+    ok &= fwrite(&nScalars, sizeof(long), 1, file) == 1;
+    ok &= fwrite(scalars.data(), sizeof(double), nScalars, file) == (size_t)nScalars;
+
+    long nFields = (long)fields.size();
+    ok &= fwrite(&nFields, sizeof(long), 1, file) == 1;
+    for(auto *field : fields) {
+        long dims[3] = { field->X(), field->Y(), field->Z() };
+        ok &= fwrite(dims, sizeof(long), 3, file) == 3;
+        ok &= fwrite(&field->at(0), sizeof(double), field->size(), file) == (size_t)field->size();
+    }
+
+    ok &= fclose(file) == 0;
+    if(!ok || std::rename(tmpName.c_str(), fileName.c_str()) != 0) {
+        std::cout << "Solver Checkpoint Error: could not write " << fileName << std::endl;
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool puma::SolverCheckpoint::load(const std::string &solver, puma::Matrix<double> *b, int *iteration, std::vector<double> *scalars,
+                                  const std::vector<puma::Matrix<double>*> &fields) {
+    if(!resume) {
+        return false;
+    }
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if(file == nullptr) {
+        return false;
+    }
+
+    // the header is checked completely before any field is overwritten
+    char magic[8];
+    int version = 0;
+    long nameLength = 0;
+    bool ok = fread(magic, 1, 8, file) == 8 && memcmp(magic, checkpointMagic, 8) == 0;
+    ok = ok && fread(&version, sizeof(int), 1, file) == 1 && version == checkpointVersion;
+    ok = ok && fread(&nameLength, sizeof(long), 1, file) == 1 && nameLength == (long)solver.size();
+
+    std::string name(ok ? nameLength : 0, ' ');
+    ok = ok && fread(&name[0], 1, nameLength, file) == (size_t)nameLength && name == solver;
+
+    unsigned long long problem = 0, op = 0;
+    int it = 0;
+    long nScalars = 0, nFields = 0;
+    ok = ok && fread(&problem, sizeof(problem), 1, file) == 1 && problem == hash(b);
+    ok = ok && fread(&op, sizeof(op), 1, file) == 1 && op == operatorHash;
+    ok = ok && fread(&it, sizeof(int), 1, file) == 1;
+    ok = ok && fread(&nScalars, sizeof(long), 1, file) == 1 && nScalars == (long)scalars->size();
+
+    std::vector<double> values(ok ? nScalars : 0);
+    ok = ok && fread(values.data(), sizeof(double), nScalars, file) == (size_t)nScalars;
+    ok = ok && fread(&nFields, sizeof(long), 1, file) == 1 && nFields == (long)fields.size();
+
+    long dataStart = ftell(file);
+    for(size_t f=0;ok && f<fields.size();f++) {
+        long dims[3];
+        ok = fread(dims, sizeof(long), 3, file) == 3 &&
+             dims[0] == fields[f]->X() && dims[1] == fields[f]->Y() && dims[2] == fields[f]->Z();
+        ok = ok && fseek(file, fields[f]->size() * (long)sizeof(double), SEEK_CUR) == 0;
+    }
+
+    if(ok) {
+        fseek(file, dataStart, SEEK_SET);
+        for(auto *field : fields) {
+            long dims[3];
+            ok = ok && fread(dims, sizeof(long), 3, file) == 3;
+            ok = ok && fread(&field->at(0), sizeof(double), field->size(), file) == (size_t)field->size();
+        }
+    }
+    fclose(file);
+
+    if(!ok) {
+        return false;
+    }
+
+    *iteration = it;
+    *scalars = values;
+    lastIteration = it;
+    timer.reset();
+    return true;
+}
+
+bool puma::SolverCheckpoint::remove() {
+    return std::remove(fileName.c_str()) == 0;
+}
@@ -0,0 +1,84 @@
+#ifndef SOLVERCHECKPOINT_H
+#define SOLVERCHECKPOINT_H
+
+#include "matrix.h"
+#include "timer.h"
+
+#include <string>
+#include <vector>
+
+
+namespace puma {
+
+//! Periodically saves the state of an iterative solver to a binary file, so that an interrupted run can resume from it.
+/*!
+ *  The file holds the solver name, the iteration, the solver's scalars and vectors (including the solution), and
+ *  hashes of the right-hand side and of the operator (see setOperator), so that a checkpoint is only resumed by the
+ *  same problem. The solver also checks that the stored residual is the residual of the stored solution before
+ *  continuing. The file is written to fileName.tmp and then renamed, so a run killed while saving leaves the
+ *  previous checkpoint intact.
+ *  The file is deleted when the solver converges.
+ *  Currently supported by IterativeSolver::BiCGSTAB.
+ */
+class SolverCheckpoint
+{
+public:
+
+    //! creates a checkpoint policy.
+    /*!
+     * \param fileName a string containing the path of the checkpoint file.
+     * \param everyIterations an integer specifying that the state is saved every this many iterations (0 to disable).
+     * \param everySeconds a double specifying that the state is saved once this many seconds have passed since the last save (0 to disable).
+     * \param resume a boolean which, if true, makes the solver continue from the file when it exists and belongs to the same problem.
+     */
+    SolverCheckpoint(std::string fileName, int everyIterations, double everySeconds, bool resume);
+
+    //! returns true if the state should be saved after the given iteration.
+    bool due(int iteration);
+
+    //! identifies the operator of the problem, which is saved with the state and has to match for it to be resumed.
+    /*!
+     * \param coefficients a pointer to the coefficients the operator is built from (e.g. the conductivities), or nullptr.
+     * \param settings a string holding everything else that defines the operator and the solve (direction, boundary conditions, sizes, tolerance).
+     */
+    void setOperator(puma::Matrix<double> *coefficients, const std::string &settings);
+
+    //! writes the solver state.
+    /*!
+     * \param solver a string identifying the solver.
+     * \param b a pointer to the right-hand side of the problem, hashed to identify it.
+     * \param iteration the number of iterations done.
+     * \param scalars the scalars of the solver's recurrence.
+     * \param fields the vectors of the solver's recurrence, including the solution.
+     * \return a boolean indicating the file was written.
+     */
+    bool save(const std::string &solver, puma::Matrix<double> *b, int iteration, const std::vector<double> &scalars, const std::vector<puma::Matrix<double>*> &fields);
+
+    //! reads the solver state, if resuming is enabled and the file matches the solver, the problem and the sizes of the fields.
+    /*!
+     * \return a boolean indicating the state was restored. Nothing is modified otherwise.
+     */
+    bool load(const std::string &solver, puma::Matrix<double> *b, int *iteration, std::vector<double> *scalars, const std::vector<puma::Matrix<double>*> &fields);
+
+    //! deletes the checkpoint file.
+    bool remove();
+
+    std::string getFileName() { return fileName; }
+
+private:
+    std::string fileName;
+    int everyIterations;
+    double everySeconds;
+    bool resume;
+
+    int lastIteration{0};
+    puma::Timer timer;
+    unsigned long long operatorHash{0};
+
+    static unsigned long long hash(const void *data, size_t bytes, unsigned long long h);
+    static unsigned long long hash(puma::Matrix<double> *b);
+};
+
+}
+
+#endif // SOLVERCHECKPOINT_H
@@ -0,0 +1,104 @@
+#include "solvertelemetry.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+puma::SolverTelemetry::SolverTelemetry() {
+    current = SolverIterationRecord();
+}
+
+void puma::SolverTelemetry::start(const std::string &solver, long unknowns) {
+    solverName = solver;
+    this->unknowns = unknowns;
+    iterations.clear();
+    current = SolverIterationRecord();
+    solveTimer.reset();
+}
+
+void puma::SolverTelemetry::beginPhase() {
+    phaseTimer.reset();
+}
+
+void puma::SolverTelemetry::endPhase(Phase phase, double bytes, int passes) {
+    double elapsed = phaseTimer.elapsed();
+    switch(phase) {
+        case Product:   current.productTime += elapsed;   break;
+        case Reduction: current.reductionTime += elapsed; break;
+        case Update:    current.updateTime += elapsed;    break;
+    }
+    current.bytes += bytes;
+    if(phase != Product) {
+        current.passes += passes;
+    }
+}
+
+void puma::SolverTelemetry::endIteration(int iteration, double residual) {
+    current.iteration = iteration;
+    current.residual = residual;
+    current.time = solveTimer.elapsed();
+    iterations.push_back(current);
+    if(callback) {
+        callback(current);
+    }
+    current = SolverIterationRecord();
+}
+
+double puma::SolverTelemetry::totalTime(Phase phase) {
+    double total = 0;
+    for(auto &record : iterations) {
+        total += (phase == Product) ? record.productTime : (phase == Reduction) ? record.reductionTime : record.updateTime;
+    }
+    return total;
+}
+
+bool puma::SolverTelemetry::exportCSV(const std::string &fileName) {
+    std::ofstream file(fileName);
+    if(!file.is_open()) {
+        std::cout << "Solver Telemetry Error: could not create " << fileName << std::endl;
+        return false;
+    }
+
+    file << "iteration,residual,time,productTime,reductionTime,updateTime,bytes,passes\n";
+    file << std::setprecision(10);
+    for(auto &record : iterations) {
+        file << record.iteration << ',' << record.residual << ',' << record.time << ',' << record.productTime << ','
+             << record.reductionTime << ',' << record.updateTime << ',' << record.bytes << ',' << record.passes << '\n';
+    }
+    return file.good();
+}
+
+bool puma::SolverTelemetry::exportJSON(const std::string &fileName) {
+    std::ofstream file(fileName);
+    if(!file.is_open()) {
+        std::cout << "Solver Telemetry Error: could not create " << fileName << std::endl;
+        return false;
+    }
+
+    file << std::setprecision(10);
+    file << "{\n";
+    file << "  \"solver\": \"" << solverName << "\",\n";
+    file << "  \"unknowns\": " << unknowns << ",\n";
+    file << "  \"productTime\": " << totalTime(Product) << ",\n";
+    file << "  \"reductionTime\": " << totalTime(Reduction) << ",\n";
+    file << "  \"updateTime\": " << totalTime(Update) << ",\n";
+    file << "  \"iterations\": [";
+    for(size_t i=0;i<iterations.size();i++) {
+        const SolverIterationRecord &record = iterations[i];
+        file << (i==0 ? "\n" : ",\n");
+        file << "    {\"iteration\": " << record.iteration << ", \"residual\": ";
+        // JSON has no literal for inf and nan
+        if(std::isfinite(record.residual)) {
+            file << record.residual;
+        } else {
+            file << "null";
+        }
+        file << ", \"time\": " << record.time
+             << ", \"productTime\": " << record.productTime << ", \"reductionTime\": " << record.reductionTime
+             << ", \"updateTime\": " << record.updateTime << ", \"bytes\": " << record.bytes << ", \"passes\": " << record.passes << "}";
+    }
+    file << "\n  ]\n}\n";
+    return file.good();
+}
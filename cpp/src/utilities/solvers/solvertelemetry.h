@@ -0,0 +1,96 @@
+#ifndef SOLVERTELEMETRY_H
+#define SOLVERTELEMETRY_H
+
+#include "timer.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace puma {
+
+//! The measurements of one iteration of an iterative solver.
+struct SolverIterationRecord {
+    int iteration;
+    double residual;
+    double time;            //!< time since the start of the solve
+    double productTime;     //!< time spent in A_times_X during this iteration
+    double reductionTime;   //!< time spent in dot products and norms during this iteration
+    double updateTime;      //!< time spent in vector updates during this iteration
+    double bytes;           //!< estimate of the bytes read and written during this iteration
+    int passes;             //!< number of passes over the vectors (reductions and updates) during this iteration
+};
+
+//! Records the convergence and the time breakdown of an iterative solver, iteration by iteration.
+/*!
+ *  Passed to a solver (IterativeSolver::BiCGSTAB, BiCGSTAB_Fused and ConjugateGradient_Fused, through FV_Diffusion,
+ *  EJ_Diffusion and FV_anisotropic_Diffusion::setTelemetry), it collects a SolverIterationRecord per iteration, which can be read
+ *  with getIterations(), received as it is produced with a callback, or exported to CSV or JSON.
+ *  The bytes are a model of the memory traffic: the vectors read and written by each kernel, and
+ *  AMatrix::productBytes for the products. A recorder keeps the iterations of one solve; starting a new solve clears it.
+ */
+class SolverTelemetry
+{
+public:
+
+    enum Phase { Product, Reduction, Update };
+
+    SolverTelemetry();
+
+    //! sets a function called with each record as soon as its iteration is done.
+    void setCallback(std::function<void(const SolverIterationRecord&)> callback) { this->callback = std::move(callback); }
+
+    //! called by the solver before its first iteration.
+    /*!
+     * \param solver a string identifying the solver.
+     * \param unknowns the number of unknowns of the system.
+     */
+    void start(const std::string &solver, long unknowns);
+
+    //! called by the solver around each kernel: beginPhase starts the clock, endPhase charges the elapsed time and the bytes to a phase.
+    /*!
+     * \param passes the number of passes over the vectors done by the kernel, not counted for products.
+     */
+    void beginPhase();
+    void endPhase(Phase phase, double bytes, int passes = 1);
+
+    //! called by the solver at the end of each iteration.
+    void endIteration(int iteration, double residual);
+
+    std::string getSolverName() { return solverName; }
+    long getUnknowns() { return unknowns; }
+    const std::vector<SolverIterationRecord>& getIterations() { return iterations; }
+
+    //! returns the time spent in a phase over the whole solve.
+    double totalTime(Phase phase);
+
+    //! writes one line per iteration, with a header line.
+    /*!
+     * \param fileName a string containing the path of the file.
+     * \return a boolean indicating the file was written.
+     */
+    bool exportCSV(const std::string &fileName);
+
+    //! writes the solver name, the number of unknowns, the totals per phase and the array of iterations.
+    /*!
+     * \param fileName a string containing the path of the file.
+     * \return a boolean indicating the file was written.
+     */
+    bool exportJSON(const std::string &fileName);
+
+private:
+    std::string solverName;
+    long unknowns{0};
+    std::vector<SolverIterationRecord> iterations;
+    std::function<void(const SolverIterationRecord&)> callback;
+
+    puma::Timer solveTimer;
+    puma::Timer phaseTimer;
+    SolverIterationRecord current;
+};
+
+}
+
+#endif // SOLVERTELEMETRY_H
@@ -34,6 +34,7 @@
 #include "testsuites/exportvtk_test.cpp"
 #include "testsuites/particlescuberilletortuosity_test.cpp"
 #include "testsuites/orientation_test.cpp"
+#include "testsuites/filterpipeline_test.cpp"
 
 MasterTest::MasterTest() {
 
@@ -69,6 +70,7 @@ MasterTest::MasterTest() {
     testSuites.push_back(ExportVTK_Test());
     testSuites.push_back(ParticlesCuberilleTortuosity_Test());
     testSuites.push_back(Orientation_Test());
+    testSuites.push_back(FilterPipeline_Test());
 }
 
 std::vector<TestResult> MasterTest::runAllTests() {
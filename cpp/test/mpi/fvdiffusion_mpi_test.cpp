@@ -0,0 +1,139 @@
+#include "../testframework/subtest.h"
+#include "puma.h"
+
+#include <map>
+#include <mpi.h>
+
+
+// every rank builds the whole domain and the serial reference, and solves its own slab of it
+class FVDiffusionMPI_Test : public SubTest {
+public:
+
+    FVDiffusionMPI_Test() {
+        testSuiteName = "FVDiffusionMPI_Test";
+
+        tests.push_back(test1);
+        tests.push_back(test2);
+        tests.push_back(test3);
+        tests.push_back(test4);
+        tests.push_back(test5);
+    }
+
+    static puma::Vec3<double> solve(puma::Workspace *segWS, std::string sideBC, std::string solverType, char dir, bool decomposed) {
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 20;
+        matCond[2] = 0.05;
+
+        puma::Matrix<double> kMat;
+        FV_Diffusion::computeKMatrix(segWS, matCond, &kMat, 0);
+        puma::Matrix<double> T;
+        if(!decomposed) {
+            FV_Diffusion solver(&T,&kMat,sideBC,solverType,dir,1e-10,10000,false,0);
+            return solver.compute_DiffusionCoefficient();
+        }
+
+        FV_SlabDecomposition slab(MPI_COMM_WORLD, kMat.X());
+        puma::Matrix<double> kSlab;
+        slab.extract(&kMat, &kSlab);
+        FV_Diffusion solver(&T,&kSlab,sideBC,solverType,dir,1e-10,10000,false,0);
+        solver.setDecomposition(&slab);
+        return solver.compute_DiffusionCoefficient();
+    }
+
+    static void buildDomain(puma::Workspace *segWS) {
+        long X = segWS->X();
+        long Y = segWS->Y();
+        long Z = segWS->Z();
+        segWS->matrix.set(X/4,X-X/3,2,Y-5,Z/3,Z-2,1);
+        segWS->matrix.set(0,X-1,Y/2,Y/2+2,0,Z/2,2);
+    }
+
+    static bool compare(puma::Vec3<double> k, puma::Vec3<double> kSlab, TestResult *result) {
+        return assertEquals(k.x,kSlab.x,1e-7,result) && assertEquals(k.y,kSlab.y,1e-7,result) && assertEquals(k.z,kSlab.z,1e-7,result);
+    }
+
+    static TestResult test1() {
+
+        std::string suiteName = "FVDiffusionMPI_Test";
+        std::string testName = "FVDiffusionMPI_Test: Test 1 - bicgstab, periodic, y direction";
+        std::string testDescription = "the slab decomposed solve should match the serial one, with the x faces periodic across the first and last rank";
+        TestResult result(suiteName, testName, 1, testDescription);
+
+        puma::Workspace segWS(24,20,18,0,1e-6,false);
+        buildDomain(&segWS);
+
+        compare(solve(&segWS,"periodic","bicgstab",'y',false), solve(&segWS,"periodic","bicgstab",'y',true), &result);
+        return result;
+    }
+
+    static TestResult test2() {
+
+        std::string suiteName = "FVDiffusionMPI_Test";
+        std::string testName = "FVDiffusionMPI_Test: Test 2 - bicgstab, symmetric, x direction";
+        std::string testDescription = "the slab decomposed solve should match the serial one, with the gradient across the slabs";
+        TestResult result(suiteName, testName, 2, testDescription);
+
+        puma::Workspace segWS(24,20,18,0,1e-6,false);
+        buildDomain(&segWS);
+
+        compare(solve(&segWS,"symmetric","bicgstab",'x',false), solve(&segWS,"symmetric","bicgstab",'x',true), &result);
+        return result;
+    }
+
+    static TestResult test3() {
+
+        std::string suiteName = "FVDiffusionMPI_Test";
+        std::string testName = "FVDiffusionMPI_Test: Test 3 - conjugate gradient, periodic, x direction";
+        std::string testDescription = "the slab decomposed solve should match the serial one";
+        TestResult result(suiteName, testName, 3, testDescription);
+
+        puma::Workspace segWS(24,20,18,0,1e-6,false);
+        buildDomain(&segWS);
+
+        compare(solve(&segWS,"periodic","cg",'x',false), solve(&segWS,"periodic","cg",'x',true), &result);
+        return result;
+    }
+
+    static TestResult test4() {
+
+        std::string suiteName = "FVDiffusionMPI_Test";
+        std::string testName = "FVDiffusionMPI_Test: Test 4 - bicgstab, periodic, z direction, uneven slabs";
+        std::string testDescription = "the slab decomposed solve should match the serial one when the planes do not divide evenly between the ranks";
+        TestResult result(suiteName, testName, 4, testDescription);
+
+        puma::Workspace segWS(23,16,21,0,1e-6,false);
+        buildDomain(&segWS);
+
+        compare(solve(&segWS,"periodic","bicgstab",'z',false), solve(&segWS,"periodic","bicgstab",'z',true), &result);
+        return result;
+    }
+
+    static TestResult test5() {
+
+        std::string suiteName = "FVDiffusionMPI_Test";
+        std::string testName = "FVDiffusionMPI_Test: Test 5 - too many ranks";
+        std::string testDescription = "a decomposition with more ranks than planes, or slabs thinner than two planes, should fail on every rank";
+        TestResult result(suiteName, testName, 5, testDescription);
+
+        int size;
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+        FV_SlabDecomposition tooMany(MPI_COMM_WORLD, size-1);
+        if(!assertEquals(false, tooMany.isValid(), &result)) {
+            return result;
+        }
+        puma::Matrix<double> global(size-1,4,4,1);
+        puma::Matrix<double> local;
+        if(!assertEquals(false, tooMany.extract(&global, &local), &result)) {
+            return result;
+        }
+
+        // one plane per rank, with the smallest slab below two planes
+        puma::Workspace segWS(2*size-1,10,10,0,1e-6,false);
+        puma::Vec3<double> k = solve(&segWS,"symmetric","bicgstab",'x',true);
+        assertEquals(-1.,k.x,&result);
+        return result;
+    }
+
+};
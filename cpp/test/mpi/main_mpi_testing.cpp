@@ -0,0 +1,45 @@
+#include "fvdiffusion_mpi_test.cpp"
+#include "../testframework/color.h"
+
+#include <iostream>
+#include <mpi.h>
+
+
+// runs the MPI test suites, e.g. with 'mpirun -np 4 pumaX_mpi_testing'. Every rank runs every test, since the
+// solves are collective, and only rank 0 reports.
+int main(int argc, char** argv) {
+
+    MPI_Init(&argc, &argv);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::streambuf *coutBuffer = std::cout.rdbuf();
+    if(rank != 0) {
+        std::cout.rdbuf(nullptr);
+    }
+
+    std::cout << "[** MPI Test Suites on " << size << " ranks **]" << std::endl;
+    FVDiffusionMPI_Test suite;
+    std::vector<TestResult> failedTests = suite.runAllTests();
+
+    int failed = (int)failedTests.size();
+    int failedAnyRank = 0;
+    MPI_Allreduce(&failed, &failedAnyRank, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    Color::Modifier red(Color::FG_RED);
+    Color::Modifier green(Color::FG_GREEN);
+    Color::Modifier def(Color::FG_DEFAULT);
+    if(failedAnyRank > 0) {
+        std::cout << red << "\n[---- Failed " << failedAnyRank << " / " << suite.numTests() << " Tests ----]" << def << std::endl;
+        for(auto &test : failedTests) {
+            std::cout << "    " << test.testTitle << "  Expected: " << test.expected << "  Actual: " << test.actual << std::endl;
+        }
+    } else {
+        std::cout << green << "\n[---- Passed " << suite.numTests() << " / " << suite.numTests() << " Tests ----]" << def << std::endl;
+    }
+
+    std::cout.rdbuf(coutBuffer);
+    MPI_Finalize();
+    return failedAnyRank > 0 ? 1 : 0;
+}
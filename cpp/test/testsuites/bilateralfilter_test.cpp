@@ -19,6 +19,8 @@ public:
         tests.push_back(test8);
         tests.push_back(test9);
         tests.push_back(test10);
+        tests.push_back(test11);
+        tests.push_back(test12);
     }
 
 
@@ -288,4 +290,115 @@ public:
         return result;
     }
 
+    static TestResult test11() {
+
+        std::string suiteName = "BilateralFilter_Test";
+        std::string testName = "BilateralFilter_Test: tabulated weights";
+        std::string testDescription = "The filter with tabulated weights gives the direct formula with exp of every pair of voxels, on signed values, cut windows, radii larger than the domain and several thread counts";
+        TestResult result(suiteName, testName, 11, testDescription);
+
+        puma::Workspace original(12,9,10,0,1e-6,false);
+        for(long i=0;i<original.matrix.size();i++) {
+            original.matrix(i) = (short)((i*7919)%3001 - 1500);
+        }
+
+        int radii[3] = {1,3,12};
+        int threads[2] = {1,0};
+        double sigma_d = 1.5, sigma_r = 400;
+        for(int r : radii) {
+            for(int n : threads) {
+                puma::Workspace work(&original);
+                if(!assertEquals(true, puma::filter_Bilateral(&work,r,sigma_d,sigma_r,n), &result)) {
+                    return result;
+                }
+
+                for(long i=0;i<work.X();i++) {
+                    for(long j=0;j<work.Y();j++) {
+                        for(long k=0;k<work.Z();k++) {
+                            double sum_w = 0, sum_I_times_w = 0;
+                            double center = original.matrix(i,j,k);
+                            for(long a=std::max(0L,i-r);a<=std::min(work.X()-1,i+r);a++) {
+                                for(long b=std::max(0L,j-r);b<=std::min(work.Y()-1,j+r);b++) {
+                                    for(long c=std::max(0L,k-r);c<=std::min(work.Z()-1,k+r);c++) {
+                                        double value = original.matrix(a,b,c);
+                                        double w = exp( - ( (i-a)*(i-a) + (j-b)*(j-b) + (k-c)*(k-c) ) / (2*sigma_d*sigma_d)
+                                                        - (center-value)*(center-value) / (2*sigma_r*sigma_r) );
+                                        sum_w += w;
+                                        sum_I_times_w += value*w;
+                                    }
+                                }
+                            }
+                            // the tabulated weights differ from exp by a few units in the last place, so a mean that
+                            // is within round-off of an integer can be truncated from either side of it
+                            double mean = sum_I_times_w/sum_w;
+                            short below = (short)(mean - 1e-9), above = (short)(mean + 1e-9);
+                            short expected = work.matrix(i,j,k) == above ? above : below;
+                            if(!assertEquals((int)expected, (int)work.matrix(i,j,k), &result)) {
+                                return result;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+
+    static TestResult test12() {
+
+        std::string suiteName = "BilateralFilter_Test";
+        std::string testName = "BilateralFilter_Test: bilateral grid";
+        std::string testDescription = "The bilateral grid keeps a uniform image and stays within its documented error of the exact filter on a noisy two-phase image";
+        TestResult result(suiteName, testName, 12, testDescription);
+
+        puma::Workspace uniform(20,20,20,120,1e-6,false);
+        if(!assertEquals(true, puma::filter_BilateralGrid(&uniform,3,30,0), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)120.0,uniform.average(),&result)) {
+            return result;
+        }
+
+        long N = 40;
+        double sigma_d = 3, sigma_r = 30;
+        puma::Workspace original(N,N,N,0,1e-6,false);
+        for(long i=0;i<N;i++) {
+            for(long j=0;j<N;j++) {
+                for(long k=0;k<N;k++) {
+                    double dx = i-N/2., dy = j-N/2., dz = k-N/2.;
+                    short phase = dx*dx+dy*dy+dz*dz < N*N/9. ? 200 : 50;
+                    original.matrix(i,j,k) = (short)(phase + ((i*N*N+j*N+k)*7919)%81 - 40);
+                }
+            }
+        }
+
+        puma::Workspace exact(&original);
+        puma::filter_Bilateral(&exact,(int)(2*sigma_d),sigma_d,sigma_r,0);
+
+        puma::Workspace approximate(&original);
+        if(!assertEquals(true, puma::filter_BilateralGrid(&approximate,sigma_d,sigma_r,0), &result)) {
+            return result;
+        }
+
+        double meanError = 0;
+        int maxError = 0;
+        for(long i=0;i<exact.matrix.size();i++) {
+            int error = std::abs(exact.matrix(i) - approximate.matrix(i));
+            meanError += error;
+            maxError = std::max(maxError,error);
+        }
+        meanError /= exact.matrix.size();
+
+        if(!assertEquals(true, meanError < sigma_r/10, &result)) {
+            return result;
+        }
+        if(!assertEquals(true, maxError < sigma_r/3, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
 };
@@ -22,6 +22,7 @@ public:
         tests.push_back(test10);
         tests.push_back(test11);
         tests.push_back(test12);
+        tests.push_back(test13);
 
     }
 
@@ -292,41 +293,47 @@ public:
         return result;
     }
 
+    static TestResult test13() {
 
+        std::string suiteName = "export_bin_Test";
+        std::string testName = "export_bin_Test: Test 13 - run-length encoded workspace";
+        std::string testDescription = "Exporting an RLEWorkspace writes the same file as the dense workspace";
+        TestResult result(suiteName, testName, 13, testDescription);
+
+        // mostly void domain with a few spheres of two materials
+        puma::Workspace segWS(60,50,40,0,1e-6,false);
+        for(long i=0;i<60;i++) {
+            for(long j=0;j<50;j++) {
+                for(long k=0;k<40;k++) {
+                    if((i-20)*(i-20)+(j-15)*(j-15)+(k-10)*(k-10) < 81) { segWS.matrix(i,j,k) = 1; }
+                    if((i-45)*(i-45)+(j-35)*(j-35)+(k-25)*(k-25) < 144) { segWS.matrix(i,j,k) = 2; }
+                }
+            }
+        }
+        puma::RLEWorkspace rleWS(&segWS);
 
-};
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+        std::string dense = puma::PString::get_puma_directory()+"cpp/test/out/bin/test13_dense";
+        std::string runs = puma::PString::get_puma_directory()+"cpp/test/out/bin/test13_rle";
+        if(!assertEquals(true, puma::export_bin(&segWS,dense), &result)) {
+            return result;
+        }
+        if(!assertEquals(true, puma::export_bin(&rleWS,runs), &result)) {
+            return result;
+        }
 
+        std::ifstream denseFile(dense+".puma", std::ios::binary);
+        std::ifstream runsFile(runs+".puma", std::ios::binary);
+        std::string denseBytes((std::istreambuf_iterator<char>(denseFile)), std::istreambuf_iterator<char>());
+        std::string runsBytes((std::istreambuf_iterator<char>(runsFile)), std::istreambuf_iterator<char>());
 
+        if(!assertEquals((long)(60*50*40+3)*2, (long)runsBytes.size(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true, denseBytes == runsBytes, &result)) {
+            return result;
+        }
 
+        return result;
+    }
 
+};
@@ -0,0 +1,215 @@
+#include "../testframework/subtest.h"
+#include "puma.h"
+
+
+class FilterPipeline_Test : public SubTest {
+public:
+
+    FilterPipeline_Test() {
+
+        testSuiteName = "FilterPipeline_Test";
+
+        tests.push_back(test1);
+        tests.push_back(test2);
+        tests.push_back(test3);
+        tests.push_back(test4);
+        tests.push_back(test5);
+    }
+
+
+    static TestResult test1() {
+
+        std::string suiteName = "FilterPipeline_Test";
+        std::string testName = "FilterPipeline_Test: invalid pipelines";
+        std::string testDescription = "Should return false for an empty pipeline, a filter with invalid parameters and the bilateral grid";
+        TestResult result(suiteName, testName, 1, testDescription);
+
+        puma::Workspace work(10,10,10,1,1e-6,false);
+
+        FilterPipeline empty(&work);
+        if(!assertEquals(false, empty.execute(), &result)) {
+            return result;
+        }
+
+        MeanFilter3D invalid(&work,0);
+        FilterPipeline withInvalid(&work);
+        withInvalid.add(&invalid);
+        if(!assertEquals(false, withInvalid.execute(), &result)) {
+            return result;
+        }
+
+        BilateralFilter grid(&work,0,2,20,0,true);
+        FilterPipeline withGrid(&work);
+        withGrid.add(&grid);
+        if(!assertEquals(false, withGrid.execute(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+
+    static TestResult test2() {
+
+        std::string suiteName = "FilterPipeline_Test";
+        std::string testName = "FilterPipeline_Test: median, mean and bilateral";
+        std::string testDescription = "The pipeline gives exactly the filters executed one after the other, for chunks of one slab to the whole domain and several thread counts";
+        TestResult result(suiteName, testName, 2, testDescription);
+
+        puma::Workspace original(23,11,9,0,1e-6,false);
+        fill(&original);
+
+        puma::Workspace expected(&original);
+        puma::filter_Median3D(&expected,2,0);
+        puma::filter_Mean3D(&expected,1,0);
+        puma::filter_Bilateral(&expected,2,1.5,300,0);
+
+        long chunks[4] = {1,3,0,100};
+        int threads[2] = {1,0};
+        for(long chunk : chunks) {
+            for(int n : threads) {
+                puma::Workspace work(&original);
+                MedianFilter3D median(&work,2,n);
+                MeanFilter3D mean(&work,1,n);
+                BilateralFilter bilateral(&work,2,1.5,300,n);
+
+                FilterPipeline pipeline(&work,chunk,n);
+                pipeline.add(&median);
+                pipeline.add(&mean);
+                pipeline.add(&bilateral);
+                if(!assertEquals(true, pipeline.execute(), &result)) {
+                    return result;
+                }
+
+                if(!sameVoxels(&expected,&work,&result)) {
+                    return result;
+                }
+            }
+        }
+
+        return result;
+    }
+
+
+    static TestResult test3() {
+
+        std::string suiteName = "FilterPipeline_Test";
+        std::string testName = "FilterPipeline_Test: halos larger than the domain";
+        std::string testDescription = "Filters whose windows span the whole domain along x still give the filters executed one after the other";
+        TestResult result(suiteName, testName, 3, testDescription);
+
+        puma::Workspace original(4,12,10,0,1e-6,false);
+        fill(&original);
+
+        puma::Workspace expected(&original);
+        puma::filter_Mean3D(&expected,3,0);
+        puma::filter_Median3D(&expected,5,0);
+
+        puma::Workspace work(&original);
+        MeanFilter3D mean(&work,3);
+        MedianFilter3D median(&work,5);
+        FilterPipeline pipeline(&work,1);
+        pipeline.add(&mean);
+        pipeline.add(&median);
+        if(!assertEquals(true, pipeline.execute(), &result)) {
+            return result;
+        }
+
+        sameVoxels(&expected,&work,&result);
+        return result;
+    }
+
+
+    static TestResult test4() {
+
+        std::string suiteName = "FilterPipeline_Test";
+        std::string testName = "FilterPipeline_Test: workspace view";
+        std::string testDescription = "A pipeline on a view filters the box as the filters executed on the view, and leaves the rest unchanged";
+        TestResult result(suiteName, testName, 4, testDescription);
+
+        puma::Workspace original(20,18,16,0,1e-6,false);
+        fill(&original);
+
+        puma::Workspace expected(&original);
+        puma::WorkspaceView expectedView(&expected,4,13,2,17,5,11);
+        puma::filter_Mean3D(&expectedView,2,0);
+        puma::filter_Median3D(&expectedView,1,0);
+
+        puma::Workspace work(&original);
+        puma::WorkspaceView view(&work,4,13,2,17,5,11);
+        MeanFilter3D mean(&view,2);
+        MedianFilter3D median(&view,1);
+        FilterPipeline pipeline(&view,2);
+        pipeline.add(&mean);
+        pipeline.add(&median);
+        if(!assertEquals(true, pipeline.execute(), &result)) {
+            return result;
+        }
+
+        sameVoxels(&expected,&work,&result);
+        return result;
+    }
+
+
+    static TestResult test5() {
+
+        std::string suiteName = "FilterPipeline_Test";
+        std::string testName = "FilterPipeline_Test: nested pipelines";
+        std::string testDescription = "A pipeline chained in another one gives the same result as all of its filters chained directly";
+        TestResult result(suiteName, testName, 5, testDescription);
+
+        puma::Workspace original(17,10,8,0,1e-6,false);
+        fill(&original);
+
+        puma::Workspace expected(&original);
+        puma::filter_Median3D(&expected,1,0);
+        puma::filter_Mean3D(&expected,2,0);
+        puma::filter_Median3D(&expected,3,0);
+
+        puma::Workspace work(&original);
+        MedianFilter3D first(&work,1);
+        MeanFilter3D second(&work,2);
+        MedianFilter3D third(&work,3);
+
+        FilterPipeline inner(&work);
+        inner.add(&second);
+        inner.add(&third);
+
+        FilterPipeline outer(&work,2);
+        outer.add(&first);
+        outer.add(&inner);
+        if(!assertEquals(true, outer.execute(), &result)) {
+            return result;
+        }
+
+        sameVoxels(&expected,&work,&result);
+        return result;
+    }
+
+
+    // signed values with structure, so that every filter changes them
+    static void fill(puma::Workspace *work) {
+        for(long i=0;i<work->X();i++) {
+            for(long j=0;j<work->Y();j++) {
+                for(long k=0;k<work->Z();k++) {
+                    long noise = ((i*work->Y()*work->Z()+j*work->Z()+k)*7919)%601 - 300;
+                    work->matrix(i,j,k) = (short)((i+j < 12 ? 1000 : -500) + noise);
+                }
+            }
+        }
+    }
+
+    static bool sameVoxels(puma::Workspace *expected, puma::Workspace *actual, TestResult *result) {
+        for(long i=0;i<expected->X();i++) {
+            for(long j=0;j<expected->Y();j++) {
+                for(long k=0;k<expected->Z();k++) {
+                    if(!assertEquals((int)expected->matrix(i,j,k), (int)actual->matrix(i,j,k), result)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+};
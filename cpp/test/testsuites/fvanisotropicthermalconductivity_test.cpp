@@ -83,6 +83,12 @@ public:
         // Orientation
         tests.push_back(test_rotatexy);
         tests.push_back(test_rotatexz);
+
+        // Tensor storage
+        tests.push_back(test_tensorField);
+
+        // Telemetry
+        tests.push_back(test_telemetry);
     }
 
 
@@ -2656,5 +2662,105 @@ public:
         return result;
     }
 
-};
 
+    static TestResult test_tensorField() {
+
+        std::string suiteName = "FVanisotropicConductivity_Test";
+        std::string testDescription = "phases should share table entries, oriented voxels should hold their rotated tensor";
+        TestResult result(suiteName, __FUNCTION__, testDescription);
+
+        puma::Workspace ws(10, 10, 10, 0, 1.);
+        ws.matrix.set(0,9,0,4,0,9,1);
+        puma::MatVec3<double> tangents(10, 10, 10, puma::Vec3<double>(0., 1., 0.));
+        tangents.at(2,2,2) = puma::Vec3<double>(2., 0., 0.); // fiber intersection
+
+        std::map<int, std::vector<double>> matCond;
+        matCond[0] = {2};
+        matCond[1] = {12, 1.2};
+
+        FV_anisotropic_TensorField kMat;
+        FV_anisotropic_Diffusion::computeKMatrix(&ws, matCond, &kMat, &tangents, false, 0);
+
+        double k[6];
+        kMat.getTensor(5,5,5,k);
+        std::vector<double> expected = {2,2,2,0,0,0};
+        for(int c=0;c<6;c++) {
+            if(!assertEquals(expected[c],k[c],1e-12, &result)) {
+                return result;
+            }
+        }
+
+        // rotated along y, except at the intersection which is isotropic
+        kMat.getTensor(5,3,5,k);
+        expected = {1.2,12,1.2,0,0,0};
+        for(int c=0;c<6;c++) {
+            if(!assertEquals(expected[c],k[c],1e-12, &result)) {
+                return result;
+            }
+        }
+        kMat.getTensor(2,2,2,k);
+        expected = {12,12,12,0,0,0};
+        for(int c=0;c<6;c++) {
+            if(!assertEquals(expected[c],k[c],1e-12, &result)) {
+                return result;
+            }
+        }
+        if(!assertEquals((int)FV_anisotropic_TensorField::voxelTensor,(int)kMat.id(5,3,5), &result)) {
+            return result;
+        }
+
+        // without orientation, a voxel only costs its ID
+        matCond[1] = {12, 1.2, 1.2, 0.5, 0, 0};
+        FV_anisotropic_Diffusion::computeKMatrix(&ws, matCond, &kMat, &tangents, false, 0);
+        if(!assertEquals(false,kMat.hasVoxelTensors(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true,kMat.memoryBytes() < kMat.size()*sizeof(unsigned short) + 1000, &result)) {
+            return result;
+        }
+        kMat.getTensor(5,3,5,k);
+        if(!assertEquals(0.5,k[3],1e-12, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    static TestResult test_telemetry() {
+
+        std::string suiteName = "FVanisotropicConductivity_Test";
+        std::string testDescription = "the public function should record the iterations of the solver without changing the result";
+        TestResult result(suiteName, __FUNCTION__, testDescription);
+
+        puma::Workspace grayWS(20, 20, 20, 0, 1e-6, false);
+        grayWS.matrix.set(5,14,0,19,5,14,255);
+        std::map<int, std::vector<double>> matCond;
+        matCond[128] = {1};
+        matCond[255] = {10, 2, 1, 0, 0, 0};
+
+        puma::Matrix<double> T;
+        puma::MatVec3<double> q;
+        puma::Vec3<double> k = puma::compute_FVanisotropicThermalConductivity(&grayWS, &T, &q, matCond,"mpfa","symmetric","bicgstab",'x',1e-6,10000,false);
+
+        puma::SolverTelemetry telemetry;
+        puma::Vec3<double> kTelemetry = puma::compute_FVanisotropicThermalConductivity(&grayWS, &T, &q, matCond,"mpfa","symmetric","bicgstab",'x',1e-6,10000,false,&telemetry);
+
+        if(!assertEquals(k.x,kTelemetry.x,1e-12, &result)) {
+            return result;
+        }
+        if(!assertEquals(std::string("BiCGSTAB"),telemetry.getSolverName(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true,telemetry.getIterations().size() > 1, &result)) {
+            return result;
+        }
+        if(!assertEquals(true,telemetry.getIterations().back().residual < 1e-6, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+};
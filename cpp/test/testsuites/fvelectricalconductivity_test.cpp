@@ -72,6 +72,7 @@ public:
         tests.push_back(test60);
         //tests.push_back(test61);
         //tests.push_back(test62);
+        tests.push_back(test63);
 
     }
 
@@ -1948,4 +1949,45 @@ public:
         return result;
     }
 
+
+    static TestResult test63() {
+
+        std::string suiteName = "FVElectricalConductivity_Test";
+        std::string testName = "FVElectricalConductivity_Test: Test 63 - Telemetry";
+        std::string testDescription = "the public function should record the iterations of the solver without changing the result";
+        TestResult result(suiteName, testName, 63, testDescription);
+
+        puma::Workspace grayWS(30,30,30,0,1e-6,false);
+        grayWS.matrix.set(5,24,8,19,3,26,200);
+        std::map<int, double> matCond;
+        matCond[128] = 1;
+        matCond[255] = 100;
+
+        puma::Matrix<double> T;
+        puma::Vec3<double> k = puma::compute_FVElectricalConductivity(&grayWS, &T, matCond,"symmetric","bicgstab",'x',1e-8,10000,false);
+
+        long calls = 0;
+        puma::SolverTelemetry telemetry;
+        telemetry.setCallback([&calls](const puma::SolverIterationRecord &) { calls++; });
+        puma::Vec3<double> kTelemetry = puma::compute_FVElectricalConductivity(&grayWS, &T, matCond,"symmetric","bicgstab",'x',1e-8,10000,false,&telemetry);
+
+        if(!assertEquals(k.x,kTelemetry.x,1e-12, &result)) {
+            return result;
+        }
+        if(!assertEquals(std::string("BiCGSTAB"),telemetry.getSolverName(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true,telemetry.getIterations().size() > 1, &result)) {
+            return result;
+        }
+        if(!assertEquals((long)telemetry.getIterations().size(),calls, &result)) {
+            return result;
+        }
+        if(!assertEquals(true,telemetry.getIterations().back().residual < 1e-8, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
 };
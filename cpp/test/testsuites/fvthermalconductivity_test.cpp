@@ -1,8 +1,14 @@
 #include "../testframework/subtest.h"
 #include "puma.h"
 
+#include <cstdio>
+#include <fstream>
 #include <map>
 
+#ifdef __SSE2__
+#include <pmmintrin.h>
+#endif
+
 
 class FVThermalConductivity_Test : public SubTest {
 public:
@@ -72,6 +78,23 @@ public:
         tests.push_back(test60);
 //        tests.push_back(test61);
 //        tests.push_back(test62);
+        tests.push_back(test63);
+        tests.push_back(test64);
+        tests.push_back(test65);
+        tests.push_back(test66);
+        tests.push_back(test67);
+        tests.push_back(test68);
+        tests.push_back(test69);
+        tests.push_back(test70);
+        tests.push_back(test71);
+        tests.push_back(test72);
+        tests.push_back(test73);
+        tests.push_back(test74);
+        tests.push_back(test75);
+        tests.push_back(test76);
+        tests.push_back(test77);
+        tests.push_back(test78);
+        tests.push_back(test79);
 
     }
 
@@ -1947,4 +1970,781 @@ public:
         return result;
     }
 
+    static TestResult test63() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 63 - Fused BiCGSTAB against BiCGSTAB, cube inclusion";
+        std::string testDescription = "bicgstab_fused should converge to the same conductivity as bicgstab";
+        TestResult result(suiteName, testName, 63, testDescription);
+
+        puma::Workspace segWS(40,40,40,0,1e-6,false);
+        segWS.matrix.set(10,29,5,24,12,31,1);
+        puma::Matrix<double> T;
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 100;
+
+        puma::Vec3<double> k = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab",'x',1e-6,10000,false);
+        puma::Vec3<double> kFused = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab_fused",'x',1e-6,10000,false);
+
+        if(!assertEquals(k.x,kFused.x, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.y,kFused.y, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.z,kFused.z, 1e-4, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test64() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 64 - Fused CG against BiCGSTAB, cube inclusion";
+        std::string testDescription = "cg_fused should converge to the same conductivity as bicgstab";
+        TestResult result(suiteName, testName, 64, testDescription);
+
+        puma::Workspace segWS(40,40,40,0,1e-6,false);
+        segWS.matrix.set(10,29,5,24,12,31,1);
+        puma::Matrix<double> T;
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 100;
+
+        puma::Vec3<double> k = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"periodic","bicgstab",'z',1e-6,10000,false);
+        puma::Vec3<double> kFused = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"periodic","cg_fused",'z',1e-6,10000,false);
+
+        if(!assertEquals(k.z,kFused.z, 1e-4, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test65() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 65 - FV_AMatrix with single precision face conductances";
+        std::string testDescription = "A_times_X should match the double precision operator to float accuracy";
+        TestResult result(suiteName, testName, 65, testDescription);
+
+        long X = 30, Y = 20, Z = 25;
+        puma::Matrix<double> kMat(X,Y,Z);
+        puma::Matrix<double> x(X,Y,Z);
+        for(long i=0;i<kMat.size();i++) {
+            kMat(i) = (i%7==0) ? 0.0257 : 12.;
+            x(i) = std::sin(0.01*i);
+        }
+
+        FV_ConstantValueBoundary xMin(0, X, Y, Z), xMax(1, X, Y, Z);
+        FV_SymmetricBoundary yMin(X, Y, Z), yMax(X, Y, Z);
+        FV_PeriodicBoundary zMin(X, Y, Z), zMax(X, Y, Z);
+        std::vector<FV_BoundaryCondition*> bcs = { &xMin, &xMax, &yMin, &yMax, &zMin, &zMax };
+
+        FV_AMatrix A(&kMat,&bcs,1);
+        FV_AMatrix Af(&kMat,&bcs,1,true);
+
+        puma::Matrix<double> r(X,Y,Z,0);
+        puma::Matrix<double> rf(X,Y,Z,0);
+        A.A_times_X(&x,&r);
+        Af.A_times_X(&x,&rf);
+
+        double maxDiff = 0;
+        for(long i=0;i<r.size();i++) {
+            maxDiff = std::max(maxDiff, std::fabs(r(i)-rf(i)));
+        }
+
+        if(!assertEquals(0.,maxDiff, 1e-5, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test66() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 66 - Multigrid preconditioned CG against BiCGSTAB, cube inclusion";
+        std::string testDescription = "multigrid should converge to the same conductivity as bicgstab";
+        TestResult result(suiteName, testName, 66, testDescription);
+
+        puma::Workspace segWS(40,40,40,0,1e-6,false);
+        segWS.matrix.set(10,29,5,24,12,31,1);
+        puma::Matrix<double> T;
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 1000;
+
+        puma::Vec3<double> k = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab",'y',1e-6,10000,false);
+        puma::Vec3<double> kMG = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","multigrid",'y',1e-6,10000,false);
+
+        if(!assertEquals(k.x,kMG.x, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.y,kMG.y, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.z,kMG.z, 1e-4, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test67() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 67 - Conductivity tensor against single direction runs, periodic";
+        std::string testDescription = "the block solve of the three directions should match three separate solves";
+        TestResult result(suiteName, testName, 67, testDescription);
+
+        puma::Workspace segWS(30,24,36,0,1e-6,false);
+        segWS.matrix.set(5,19,3,14,10,30,1);
+        segWS.matrix.set(0,29,16,18,0,35,1);
+        puma::Matrix<double> T;
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 50;
+
+        puma::Vec3<double> kx = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"periodic","bicgstab",'x',1e-8,10000,false);
+        puma::Vec3<double> ky = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"periodic","bicgstab",'y',1e-8,10000,false);
+        puma::Vec3<double> kz = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"periodic","bicgstab",'z',1e-8,10000,false);
+
+        puma::Matrix<double> Tx, Ty, Tz;
+        std::vector<puma::Vec3<double>> k = puma::compute_FVThermalConductivityTensor(&segWS, &Tx, &Ty, &Tz, matCond,"periodic","bicgstab",1e-8,10000,false,false);
+
+        puma::Vec3<double> expected[3] = { kx, ky, kz };
+        for(int d=0;d<3;d++) {
+            if(!assertEquals(expected[d].x,k[d].x, 1e-5, &result)) {
+                return result;
+            }
+            if(!assertEquals(expected[d].y,k[d].y, 1e-5, &result)) {
+                return result;
+            }
+            if(!assertEquals(expected[d].z,k[d].z, 1e-5, &result)) {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test68() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 68 - Conductivity tensor with warm start, symmetric";
+        std::string testDescription = "starting from the fields of another conductivity should converge to the cold start result";
+        TestResult result(suiteName, testName, 68, testDescription);
+
+        puma::Workspace segWS(32,32,32,0,1e-6,false);
+        segWS.matrix.set(8,23,4,27,10,21,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 20;
+
+        puma::Matrix<double> Tx, Ty, Tz;
+        puma::compute_FVThermalConductivityTensor(&segWS, &Tx, &Ty, &Tz, matCond,"symmetric","cg",1e-8,10000,false,false);
+
+        matCond[1] = 25;
+        std::vector<puma::Vec3<double>> kWarm = puma::compute_FVThermalConductivityTensor(&segWS, &Tx, &Ty, &Tz, matCond,"symmetric","cg",1e-8,10000,false,true);
+
+        puma::Matrix<double> Tx2, Ty2, Tz2;
+        std::vector<puma::Vec3<double>> kCold = puma::compute_FVThermalConductivityTensor(&segWS, &Tx2, &Ty2, &Tz2, matCond,"symmetric","cg",1e-8,10000,false,false);
+
+        for(int d=0;d<3;d++) {
+            if(!assertEquals(kCold[d].x,kWarm[d].x, 1e-5, &result)) {
+                return result;
+            }
+            if(!assertEquals(kCold[d].y,kWarm[d].y, 1e-5, &result)) {
+                return result;
+            }
+            if(!assertEquals(kCold[d].z,kWarm[d].z, 1e-5, &result)) {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test69() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 69 - BiCGSTAB checkpoint and resume";
+        std::string testDescription = "a run interrupted after a checkpoint and resumed should match an uninterrupted run";
+        TestResult result(suiteName, testName, 69, testDescription);
+
+        puma::Workspace segWS(30,30,30,0,1e-6,false);
+        segWS.matrix.set(5,24,8,19,3,26,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 100;
+
+        puma::Matrix<double> T;
+        puma::Vec3<double> k = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab",'x',1e-8,10000,false);
+
+        std::string fileName = puma::PString::get_puma_directory() + "cpp/test/out/bin/fvthermalconductivity_checkpoint.bin";
+        std::remove(fileName.c_str());
+
+        // stops before convergence, leaving the state of iteration 20 on disk
+        puma::Matrix<double> TStopped;
+        puma::SolverCheckpoint checkpoint(fileName, 5, 0, true);
+        puma::compute_FVThermalConductivity(&segWS, &TStopped, matCond,"symmetric","bicgstab",'x',1e-8,20,false,&checkpoint);
+
+        std::ifstream saved(fileName);
+        if(!assertEquals(true,saved.good(), &result)) {
+            return result;
+        }
+        saved.close();
+
+        puma::Matrix<double> TResumed;
+        puma::SolverCheckpoint resume(fileName, 5, 0, true);
+        puma::Vec3<double> kResumed = puma::compute_FVThermalConductivity(&segWS, &TResumed, matCond,"symmetric","bicgstab",'x',1e-8,10000,false,&resume);
+
+        if(!assertEquals(k.x,kResumed.x, 1e-8, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.y,kResumed.y, 1e-8, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.z,kResumed.z, 1e-8, &result)) {
+            return result;
+        }
+
+        double maxDiff = 0;
+        for(long i=0;i<T.size();i++) {
+            maxDiff = std::max(maxDiff, std::fabs(T(i)-TResumed(i)));
+        }
+        if(!assertEquals(0.,maxDiff, 1e-8, &result)) {
+            return result;
+        }
+
+        // the checkpoint is deleted once the solver has converged
+        std::ifstream removed(fileName);
+        if(!assertEquals(false,removed.good(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test70() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 70 - Mixed precision BiCGSTAB against BiCGSTAB, cube inclusion";
+        std::string testDescription = "single precision corrections refined in double should converge to the double precision conductivity";
+        TestResult result(suiteName, testName, 70, testDescription);
+
+        puma::Workspace segWS(40,40,40,0,1e-6,false);
+        segWS.matrix.set(10,29,5,24,12,31,1);
+        puma::Matrix<double> T;
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 100;
+
+        puma::Vec3<double> k = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab",'z',1e-6,10000,false);
+        puma::Vec3<double> kMixed = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab_mixed",'z',1e-6,10000,false);
+
+        if(!assertEquals(k.x,kMixed.x, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.y,kMixed.y, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.z,kMixed.z, 1e-4, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+
+    static TestResult test71() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 71 - BiCGSTAB telemetry";
+        std::string testDescription = "the solver should record one entry per iteration, ending below the tolerance, and export them";
+        TestResult result(suiteName, testName, 71, testDescription);
+
+        puma::Workspace segWS(30,30,30,0,1e-6,false);
+        segWS.matrix.set(5,24,8,19,3,26,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 100;
+
+        puma::Matrix<double> kMat;
+        FV_Diffusion::computeKMatrix(&segWS, matCond, &kMat, 0);
+
+        long calls = 0;
+        puma::SolverTelemetry telemetry;
+        telemetry.setCallback([&calls](const puma::SolverIterationRecord &) { calls++; });
+
+        puma::Matrix<double> T;
+        FV_Diffusion solver(&T,&kMat,"symmetric","bicgstab",'x',1e-8,10000,false,0);
+        solver.setTelemetry(&telemetry);
+        solver.compute_DiffusionCoefficient();
+
+        const std::vector<puma::SolverIterationRecord> &records = telemetry.getIterations();
+        if(!assertEquals(true,records.size() > 1, &result)) {
+            return result;
+        }
+        if(!assertEquals((long)records.size(),calls, &result)) {
+            return result;
+        }
+        if(!assertEquals(std::string("BiCGSTAB"),telemetry.getSolverName(), &result)) {
+            return result;
+        }
+        if(!assertEquals(kMat.size(),telemetry.getUnknowns(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true,records.back().residual < 1e-8, &result)) {
+            return result;
+        }
+
+        bool consistent = true;
+        for(size_t i=0;i<records.size();i++) {
+            const puma::SolverIterationRecord &record = records[i];
+            consistent = consistent && record.iteration == (int)i+1 && record.bytes > 0;
+            consistent = consistent && record.productTime >= 0 && record.reductionTime >= 0 && record.updateTime >= 0;
+            consistent = consistent && record.productTime + record.reductionTime + record.updateTime <= record.time + 1e-6;
+        }
+        if(!assertEquals(true,consistent, &result)) {
+            return result;
+        }
+
+        std::string fileName = puma::PString::get_puma_directory() + "cpp/test/out/bin/fvthermalconductivity_telemetry.csv";
+        if(!assertEquals(true,telemetry.exportCSV(fileName), &result)) {
+            return result;
+        }
+        std::ifstream csv(fileName);
+        std::string line;
+        long lines = 0;
+        while(std::getline(csv,line)) {
+            lines++;
+        }
+        if(!assertEquals((long)records.size()+1,lines, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test72() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 72 - Red-black SOR against BiCGSTAB, cube inclusion";
+        std::string testDescription = "sor should converge to the same conductivity as bicgstab";
+        TestResult result(suiteName, testName, 72, testDescription);
+
+        puma::Workspace segWS(40,40,40,0,1e-6,false);
+        segWS.matrix.set(10,29,5,24,12,31,1);
+        puma::Matrix<double> T;
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 1000;
+
+        puma::Vec3<double> k = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab",'y',1e-6,10000,false);
+        puma::Vec3<double> kSOR = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","sor",'y',1e-6,10000,false);
+
+        if(!assertEquals(k.x,kSOR.x, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.y,kSOR.y, 1e-4, &result)) {
+            return result;
+        }
+        if(!assertEquals(k.z,kSOR.z, 1e-4, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test73() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 73 - Single slab decomposition against the undecomposed solve";
+        std::string testDescription = "the slab path (halo boundaries, global reductions) on one slab should give the conductivity of the normal path";
+        TestResult result(suiteName, testName, 73, testDescription);
+
+        puma::Workspace segWS(24,20,18,0,1e-6,false);
+        segWS.matrix.set(6,15,2,15,6,16,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 20;
+
+        puma::Matrix<double> kMat;
+        FV_Diffusion::computeKMatrix(&segWS, matCond, &kMat, 0);
+
+        const char dirs[2] = { 'x', 'y' };
+        for(char dir : dirs) {
+            puma::Matrix<double> T, TSlab;
+            FV_Diffusion solver(&T,&kMat,"periodic","bicgstab",dir,1e-10,10000,false,0);
+            puma::Vec3<double> k = solver.compute_DiffusionCoefficient();
+
+            FV_SlabDecomposition slab(kMat.X());
+            FV_Diffusion slabSolver(&TSlab,&kMat,"periodic","bicgstab",dir,1e-10,10000,false,0);
+            slabSolver.setDecomposition(&slab);
+            puma::Vec3<double> kSlab = slabSolver.compute_DiffusionCoefficient();
+
+            if(!assertEquals(k.x,kSlab.x, 1e-9, &result)) {
+                return result;
+            }
+            if(!assertEquals(k.y,kSlab.y, 1e-9, &result)) {
+                return result;
+            }
+            if(!assertEquals(k.z,kSlab.z, 1e-9, &result)) {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+
+    static TestResult test74() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 74 - Passes over memory of the fused solvers";
+        std::string testDescription = "bicgstab should make 9 passes over the vectors per iteration, bicgstab_fused 5 and cg_fused 3, and an exact solve should not be reported as a breakdown";
+        TestResult result(suiteName, testName, 74, testDescription);
+
+        puma::Workspace segWS(20,20,20,0,1e-6,false);
+        segWS.matrix.set(5,14,5,14,5,14,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 10;
+
+        puma::Matrix<double> kMat;
+        FV_Diffusion::computeKMatrix(&segWS, matCond, &kMat, 0);
+
+        const std::string solvers[3] = { "bicgstab", "bicgstab_fused", "cg_fused" };
+        const int passes[3] = { 9, 5, 3 };
+        double bytes[3];
+        for(int n=0;n<3;n++) {
+            puma::SolverTelemetry telemetry;
+            puma::Matrix<double> T;
+            FV_Diffusion solver(&T,&kMat,"symmetric",solvers[n],'x',1e-8,10000,false,0);
+            solver.setTelemetry(&telemetry);
+            solver.compute_DiffusionCoefficient();
+
+            // the last iteration skips the update of the search direction
+            const std::vector<puma::SolverIterationRecord> &records = telemetry.getIterations();
+            if(!assertEquals(true,records.size() > 2, &result)) {
+                return result;
+            }
+            for(size_t i=0;i+1<records.size();i++) {
+                if(!assertEquals(passes[n],records[i].passes, &result)) {
+                    return result;
+                }
+            }
+            bytes[n] = records[0].bytes;
+        }
+        if(!assertEquals(true,bytes[1] < bytes[0], &result)) {
+            return result;
+        }
+
+        // with A = I, the first s = r - A r is zero, so x + alpha*p is the exact solution
+        class Identity : public AMatrix {
+        public:
+            bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override { r->copy(x); return true; }
+            bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override { r->copy(x); return true; }
+        };
+        class Recorder : public puma::Printer {
+        public:
+            std::string messages;
+            void print(std::string str) override { messages += str; }
+        };
+
+        Identity identity;
+        Recorder printer;
+        puma::Matrix<double> x(6,5,4,0), b(6,5,4,0);
+        for(long i=0;i<b.size();i++) {
+            b(i) = 1 + i%7;
+        }
+        if(!assertEquals(true,IterativeSolver::BiCGSTAB_Fused(&identity,&x,&b,1e-10,10,false,&printer,0), &result)) {
+            return result;
+        }
+        if(!assertEquals(std::string(),printer.messages, &result)) {
+            return result;
+        }
+        if(!assertEquals(b(17),x(17), 1e-12, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+
+    static TestResult test75() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 75 - Streamed FV_AMatrix stencil against the previous voxel by voxel product";
+        std::string testDescription = "A_times_X should give the residual of the voxel by voxel stencil it replaced, for every boundary condition and for domains too thin for the interior kernel";
+        TestResult result(suiteName, testName, 75, testDescription);
+
+        const long sizes[3][3] = { {30,20,25}, {7,2,9}, {3,40,600} };
+        for(auto &size : sizes) {
+            long X = size[0], Y = size[1], Z = size[2];
+            puma::Matrix<double> kMat(X,Y,Z);
+            puma::Matrix<double> x(X,Y,Z);
+            for(long i=0;i<kMat.size();i++) {
+                kMat(i) = (i%7==0) ? 0.0257 : (i%5==0) ? 0. : 12.;
+                x(i) = std::sin(0.01*i) + 0.3*std::cos(0.37*i);
+            }
+
+            FV_ConstantValueBoundary xMin(0, X, Y, Z), xMax(1, X, Y, Z);
+            FV_SymmetricBoundary yMin(X, Y, Z), yMax(X, Y, Z);
+            FV_PeriodicBoundary zMin(X, Y, Z), zMax(X, Y, Z);
+            std::vector<FV_BoundaryCondition*> bcs = { &xMin, &xMax, &yMin, &yMax, &zMin, &zMax };
+
+            FV_AMatrix A(&kMat,&bcs,0);
+            puma::Matrix<double> r(X,Y,Z,0);
+            A.A_times_X(&x,&r);
+
+            puma::Matrix<double> expected;
+            referenceProduct(&kMat,&bcs,&x,&expected);
+
+            for(long i=0;i<r.size();i++) {
+                if(!assertEquals(expected(i),r(i), 1e-12*(1+std::fabs(expected(i))), &result)) {
+                    return result;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // the harmonic mean face conductances and the voxel by voxel stencil of FV_AMatrix before its interior was streamed
+    static void referenceProduct(puma::Matrix<double> *kMat, std::vector<FV_BoundaryCondition*> *bcs, puma::Matrix<double> *x, puma::Matrix<double> *r) {
+        long X = kMat->X(), Y = kMat->Y(), Z = kMat->Z();
+        auto harmonic = [](double a, double b) { double k = a*b/(a+b); return k!=k ? 0. : k; };
+        auto K = [&](long i, long j, long k) {
+            if(i<0) return bcs->at(0)->getK_at(i,j,k,kMat);
+            if(i>=X) return bcs->at(1)->getK_at(i,j,k,kMat);
+            if(j<0) return bcs->at(2)->getK_at(i,j,k,kMat);
+            if(j>=Y) return bcs->at(3)->getK_at(i,j,k,kMat);
+            if(k<0) return bcs->at(4)->getK_at(i,j,k,kMat);
+            if(k>=Z) return bcs->at(5)->getK_at(i,j,k,kMat);
+            return kMat->at(i,j,k);
+        };
+
+        r->resize(X,Y,Z,0);
+        for(long i=0;i<X;i++) {
+            for(long j=0;j<Y;j++) {
+                for(long k=0;k<Z;k++) {
+                    double c = x->at(i,j,k);
+                    double kc = kMat->at(i,j,k);
+                    r->at(i,j,k) = ( harmonic(kc,K(i+1,j,k)) * ( bcs->at(1)->getX_at(i+1,j,k,x)-c ) + harmonic(kc,K(i-1,j,k)) * ( bcs->at(0)->getX_at(i-1,j,k,x)-c ) )
+                                   + ( harmonic(kc,K(i,j+1,k)) * ( bcs->at(3)->getX_at(i,j+1,k,x)-c ) + harmonic(kc,K(i,j-1,k)) * ( bcs->at(2)->getX_at(i,j-1,k,x)-c ) )
+                                   + ( harmonic(kc,K(i,j,k+1)) * ( bcs->at(5)->getX_at(i,j,k+1,x)-c ) + harmonic(kc,K(i,j,k-1)) * ( bcs->at(4)->getX_at(i,j,k-1,x)-c ) );
+                }
+            }
+        }
+    }
+
+
+    static TestResult test76() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 76 - Mixed precision floating point modes and default single precision products";
+        std::string testDescription = "the mixed precision solver should leave the flush to zero and denormals are zero modes of the caller as they were, and the default single precision products should follow the double ones when the vector size changes";
+        TestResult result(suiteName, testName, 76, testDescription);
+
+        puma::Workspace segWS(16,16,16,0,1e-6,false);
+        segWS.matrix.set(4,11,4,11,4,11,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 50;
+
+#ifdef __SSE2__
+        unsigned int flushMode = _MM_GET_FLUSH_ZERO_MODE();
+        unsigned int denormalMode = _MM_GET_DENORMALS_ZERO_MODE();
+        const bool modes[2] = { true, false };
+        for(bool on : modes) {
+            _MM_SET_FLUSH_ZERO_MODE(on ? _MM_FLUSH_ZERO_ON : _MM_FLUSH_ZERO_OFF);
+            _MM_SET_DENORMALS_ZERO_MODE(on ? _MM_DENORMALS_ZERO_ON : _MM_DENORMALS_ZERO_OFF);
+
+            puma::Matrix<double> T;
+            puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab_mixed",'x',1e-6,10000,false);
+
+            bool kept = _MM_GET_FLUSH_ZERO_MODE() == (on ? (unsigned int)_MM_FLUSH_ZERO_ON : (unsigned int)_MM_FLUSH_ZERO_OFF) &&
+                        _MM_GET_DENORMALS_ZERO_MODE() == (on ? (unsigned int)_MM_DENORMALS_ZERO_ON : (unsigned int)_MM_DENORMALS_ZERO_OFF);
+            _MM_SET_FLUSH_ZERO_MODE(flushMode);
+            _MM_SET_DENORMALS_ZERO_MODE(denormalMode);
+            if(!assertEquals(true,kept, &result)) {
+                return result;
+            }
+        }
+#endif
+
+        // an operator with only double precision products, r = 2x and Minv = 1/2
+        class Diagonal : public AMatrix {
+        public:
+            bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override {
+                for(long i=0;i<x->size();i++) { r->at(i) = 2*x->at(i); }
+                return true;
+            }
+            bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override {
+                for(long i=0;i<x->size();i++) { r->at(i) = 0.5*x->at(i); }
+                return true;
+            }
+            using AMatrix::A_times_X;
+            using AMatrix::Minv_times_X;
+        };
+
+        Diagonal diagonal;
+        const long sizes[3][3] = { {4,3,2}, {4,3,2}, {5,5,5} };
+        for(auto &size : sizes) {
+            puma::Matrix<float> x(size[0],size[1],size[2]), r(size[0],size[1],size[2],0), m(size[0],size[1],size[2],0);
+            for(long i=0;i<x.size();i++) {
+                x(i) = 0.25f*i;
+            }
+            diagonal.A_times_X(&x,&r);
+            diagonal.Minv_times_X(&x,&m);
+            for(long i=0;i<x.size();i++) {
+                if(!assertEquals(0.5f*i,r(i), &result) || !assertEquals(0.125f*i,m(i), &result)) {
+                    return result;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test77() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 77 - BiCGSTAB checkpoint of another operator";
+        std::string testDescription = "a checkpoint saved for other conductivities, or with a residual which does not match its solution, should not be resumed";
+        TestResult result(suiteName, testName, 77, testDescription);
+
+        puma::Workspace segWS(30,30,30,0,1e-6,false);
+        segWS.matrix.set(5,24,8,19,3,26,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 10;
+
+        puma::Matrix<double> T;
+        puma::Vec3<double> k = puma::compute_FVThermalConductivity(&segWS, &T, matCond,"symmetric","bicgstab",'x',1e-8,10000,false);
+
+        std::string fileName = puma::PString::get_puma_directory() + "cpp/test/out/bin/fvthermalconductivity_checkpoint.bin";
+        std::remove(fileName.c_str());
+
+        // the inclusion does not touch the x faces, so the right-hand side is the same for both conductivities
+        std::map<int, double> otherCond = matCond;
+        otherCond[1] = 100;
+        puma::Matrix<double> TStopped;
+        puma::SolverCheckpoint checkpoint(fileName, 5, 0, true);
+        puma::compute_FVThermalConductivity(&segWS, &TStopped, otherCond,"symmetric","bicgstab",'x',1e-8,20,false,&checkpoint);
+
+        puma::Matrix<double> TResumed;
+        puma::SolverCheckpoint resume(fileName, 5, 0, true);
+        puma::Vec3<double> kResumed = puma::compute_FVThermalConductivity(&segWS, &TResumed, matCond,"symmetric","bicgstab",'x',1e-8,10000,false,&resume);
+        if(!assertEquals(k.x,kResumed.x, 1e-8, &result)) {
+            return result;
+        }
+
+        // same operator identity, but the product is not the one the checkpoint was saved with
+        class Tridiagonal : public AMatrix {
+        public:
+            double diagonal{4};
+            bool A_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override {
+                long n = x->size();
+                for(long i=0;i<n;i++) {
+                    r->at(i) = diagonal*x->at(i) - (i > 0 ? x->at(i-1) : 0) - (i < n-1 ? x->at(i+1) : 0);
+                }
+                return true;
+            }
+            bool Minv_times_X(puma::Matrix<double> *x, puma::Matrix<double> *r) override { r->copy(x); return true; }
+            using AMatrix::A_times_X;
+            using AMatrix::Minv_times_X;
+        };
+
+        Tridiagonal A;
+        puma::Printer printer;
+        puma::Matrix<double> x(200,1,1,0), b(200,1,1,1);
+        puma::SolverCheckpoint first(fileName, 1, 0, true);
+        first.setOperator(nullptr, "tridiagonal");
+        IterativeSolver::BiCGSTAB(&A,&x,&b,1e-10,5,false,&printer,&first,0);
+
+        A.diagonal = 3;
+        puma::Matrix<double> xResumed(200,1,1,0), xFresh(200,1,1,0);
+        puma::SolverCheckpoint second(fileName, 1, 0, true);
+        second.setOperator(nullptr, "tridiagonal");
+        IterativeSolver::BiCGSTAB(&A,&xResumed,&b,1e-10,1000,false,&printer,&second,0);
+        IterativeSolver::BiCGSTAB(&A,&xFresh,&b,1e-10,1000,false,&printer,nullptr,0);
+        for(long i=0;i<x.size();i++) {
+            if(!assertEquals(xFresh(i),xResumed(i), 1e-8, &result)) {
+                return result;
+            }
+        }
+
+        std::remove(fileName.c_str());
+        return result;
+    }
+
+    static TestResult test78() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 78 - Fused solvers on any number of threads";
+        std::string testDescription = "bicgstab_fused and cg_fused should give bitwise the same temperatures and conductivity on 1 and 3 threads";
+        TestResult result(suiteName, testName, 78, testDescription);
+
+        // more blocks than one task of puma::Reduction
+        puma::Workspace segWS(50,50,50,0,1e-6,false);
+        segWS.matrix.set(10,39,5,34,12,41,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 100;
+
+        const std::string solvers[2] = { "bicgstab_fused", "cg_fused" };
+        for(const std::string &solver : solvers) {
+            puma::Matrix<double> T1, T3;
+            puma::Vec3<double> k1 = puma::compute_FVThermalConductivity(&segWS, &T1, matCond,"periodic",solver,'x',1e-6,10000,false,1);
+            puma::Vec3<double> k3 = puma::compute_FVThermalConductivity(&segWS, &T3, matCond,"periodic",solver,'x',1e-6,10000,false,3);
+
+            if(!assertEquals(true, k1.x == k3.x && k1.y == k3.y && k1.z == k3.z, &result)) {
+                return result;
+            }
+            for(long i=0; i<T1.size(); i++) {
+                if(!assertEquals(true, T1(i) == T3(i), &result)) {
+                    return result;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test79() {
+
+        std::string suiteName = "FVThermalConductivity_Test";
+        std::string testName = "FVThermalConductivity_Test: Test 79 - Mixed precision BiCGSTAB on any number of threads";
+        std::string testDescription = "bicgstab_mixed should give bitwise the same temperatures and conductivity on 1 and 3 threads";
+        TestResult result(suiteName, testName, 79, testDescription);
+
+        puma::Workspace segWS(50,50,50,0,1e-6,false);
+        segWS.matrix.set(10,39,5,34,12,41,1);
+        std::map<int, double> matCond;
+        matCond[0] = 1;
+        matCond[1] = 100;
+
+        puma::Matrix<double> T1, T3;
+        puma::Vec3<double> k1 = puma::compute_FVThermalConductivity(&segWS, &T1, matCond,"symmetric","bicgstab_mixed",'y',1e-6,10000,false,1);
+        puma::Vec3<double> k3 = puma::compute_FVThermalConductivity(&segWS, &T3, matCond,"symmetric","bicgstab_mixed",'y',1e-6,10000,false,3);
+
+        if(!assertEquals(true, k1.x == k3.x && k1.y == k3.y && k1.z == k3.z, &result)) {
+            return result;
+        }
+        for(long i=0; i<T1.size(); i++) {
+            if(!assertEquals(true, T1(i) == T3(i), &result)) {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
 };
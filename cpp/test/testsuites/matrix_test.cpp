@@ -98,6 +98,18 @@ public:
         tests.push_back(test86);
         //tests.push_back(test87);
         //tests.push_back(test88);
+        tests.push_back(test89);
+        tests.push_back(test90);
+        tests.push_back(test91);
+        tests.push_back(test92);
+        tests.push_back(test93);
+        tests.push_back(test94);
+        tests.push_back(test95);
+        tests.push_back(test96);
+        tests.push_back(test97);
+        tests.push_back(test98);
+        tests.push_back(test99);
+        tests.push_back(test100);
 
     }
 
@@ -2489,4 +2501,635 @@ public:
         return result;
     }
 
+    static TestResult test89() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Memory mapped matrix";
+        std::string testDescription = "Mapping a matrix to a temporary file keeps its values, and resize, copy, crop and releaseSlabs work on the mapping";
+        TestResult result(suiteName,testName,89,testDescription);
+
+        puma::Matrix<double> m(10,12,14);
+        for(long i=0;i<m.size();i++) {
+            m(i) = (double)i;
+        }
+
+        if(!assertEquals(true, m.mapFile(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true, m.isMapped(), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)(m.size()-1)*m.size()/2., m.reduce(), &result)) {
+            return result;
+        }
+
+        m.resize(100,30,40,2.5);
+        if(!assertEquals(true, m.isMapped(), &result)) {
+            return result;
+        }
+        m.set(10,19,0,-1,0,-1,1.5);
+
+        // dropping the pages of some slabs must not lose their values
+        if(!assertEquals(true, m.releaseSlabs(0,49), &result)) {
+            return result;
+        }
+        if(!assertEquals(2.5*90*1200+1.5*10*1200, m.reduce(), &result)) {
+            return result;
+        }
+
+        puma::Matrix<double> heap(&m);
+        if(!assertEquals(false, heap.isMapped(), &result)) {
+            return result;
+        }
+
+        m.crop(10,19,0,-1,0,-1);
+        if(!assertEquals((long)12000, m.size(), &result)) {
+            return result;
+        }
+        if(!assertEquals(1.5, m.average(), &result)) {
+            return result;
+        }
+
+        m.copy(&heap);
+        if(!assertEquals(true, m.isMapped(), &result)) {
+            return result;
+        }
+        if(!assertEquals(heap.reduce(), m.reduce(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test90() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Memory mapped matrix to a named file";
+        std::string testDescription = "The raw data of a matrix mapped to a named file is left in the file when the matrix is destroyed";
+        TestResult result(suiteName,testName,90,testDescription);
+
+        std::string fileName = "puma_matrix_test90.raw";
+
+        {
+            puma::Matrix<short> m;
+            if(!assertEquals(true, m.mapFile(fileName), &result)) {
+                return result;
+            }
+            m.resize(20,30,40,7);
+            m(19,29,39) = 3;
+        }
+
+        FILE *file = fopen(fileName.c_str(), "rb");
+        if(!assertEquals(true, file != nullptr, &result)) {
+            return result;
+        }
+
+        std::vector<short> values(20*30*40);
+        size_t read = fread(&values[0], sizeof(short), values.size(), file);
+        fclose(file);
+        remove(fileName.c_str());
+
+        if(!assertEquals((long)values.size(), (long)read, &result)) {
+            return result;
+        }
+        if(!assertEquals(7, (int)values[0], &result)) {
+            return result;
+        }
+        if(!assertEquals(3, (int)values.back(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test91() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Bricked matrix layout";
+        std::string testDescription = "Converting a matrix to the bricked layout and back, on a domain that is not a multiple of the brick size, and checking that the bricks cover every voxel once";
+        TestResult result(suiteName,testName,91,testDescription);
+
+        puma::Matrix<int> m(13,20,9);
+        for(long i=0;i<m.size();i++) {
+            m(i) = (int)i;
+        }
+
+        puma::BrickedMatrix<int> b;
+        b.fromMatrix(&m);
+        if(!assertEquals((long)(2*3*2*512), b.storageSize(), &result)) {
+            return result;
+        }
+        if(!assertEquals(m(12,19,8), b(12,19,8), &result)) {
+            return result;
+        }
+
+        long covered = 0;
+        for(const auto &brick : b.brickList()) {
+            const int *p = b.brickData(brick);
+            for(int i=0;i<brick.nx;i++) {
+                for(int j=0;j<brick.ny;j++) {
+                    for(int k=0;k<brick.nz;k++) {
+                        long n = puma::BrickedMatrix<int>::local(i,j,k);
+                        if(p[n] != m(brick.i0+i,brick.j0+j,brick.k0+k)) {
+                            assertEquals(m(brick.i0+i,brick.j0+j,brick.k0+k), p[n], &result);
+                            return result;
+                        }
+                        if(i>0 && p[n-puma::BrickedMatrix<int>::strideX] != m(brick.i0+i-1,brick.j0+j,brick.k0+k)) {
+                            assertEquals(m(brick.i0+i-1,brick.j0+j,brick.k0+k), p[n-puma::BrickedMatrix<int>::strideX], &result);
+                            return result;
+                        }
+                        covered++;
+                    }
+                }
+            }
+        }
+        if(!assertEquals(m.size(), covered, &result)) {
+            return result;
+        }
+
+        puma::Matrix<int> back;
+        b.toMatrix(&back);
+        if(!assertEquals(m.size(), back.size(), &result)) {
+            return result;
+        }
+        for(long i=0;i<m.size();i++) {
+            if(!assertEquals(m(i), back(i), &result)) {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test92() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Matrix value semantics";
+        std::string testDescription = "Copies are deep, copy reuses the storage when the size matches, and moves and swap exchange the storage without copying";
+        TestResult result(suiteName,testName,92,testDescription);
+
+        puma::Matrix<float> a(10,20,30,1.5);
+        const float *storageA = &a(0);
+
+        puma::Matrix<float> copied(a);
+        copied(0) = 2;
+        if(!assertEquals((float)1.5, a(0), &result)) {
+            return result;
+        }
+
+        puma::Matrix<float> b(10,20,30,0);
+        const float *storageB = &b(0);
+        b.copy(&a);
+        if(!assertEquals(true, &b(0) == storageB, &result)) {
+            return result;
+        }
+        b = copied;
+        if(!assertEquals(true, &b(0) == storageB, &result)) {
+            return result;
+        }
+        if(!assertEquals((float)2, b(0), &result)) {
+            return result;
+        }
+
+        puma::Matrix<float> moved(std::move(a));
+        if(!assertEquals(true, &moved(0) == storageA, &result)) {
+            return result;
+        }
+        if(!assertEquals((long)0, a.size(), &result)) {
+            return result;
+        }
+
+        puma::Matrix<float> small(2,2,2,7);
+        moved.swap(small);
+        if(!assertEquals((long)8, moved.size(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true, &small(0) == storageA, &result)) {
+            return result;
+        }
+        if(!assertEquals((long)20, small.Y(), &result)) {
+            return result;
+        }
+
+        a = std::move(small);
+        if(!assertEquals(true, &a(0) == storageA, &result)) {
+            return result;
+        }
+        if(!assertEquals((double)1.5*6000, a.reduce(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test93() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Workspace moves";
+        std::string testDescription = "Moving a workspace takes over its matrix and voxel length, and leaves the moved from workspace empty and usable";
+        TestResult result(suiteName,testName,93,testDescription);
+
+        puma::Workspace ws(10,11,12,3,2e-6,false);
+        const short *storage = &ws.matrix(0);
+
+        puma::Workspace moved(std::move(ws));
+        if(!assertEquals(true, &moved.matrix(0) == storage, &result)) {
+            return result;
+        }
+        if(!assertEquals(2e-6, moved.voxelLength, &result)) {
+            return result;
+        }
+        if(!assertEquals((long)0, ws.size(), &result)) {
+            return result;
+        }
+
+        ws.resize(5,5,5);
+        ws = std::move(moved);
+        if(!assertEquals((long)1320, ws.size(), &result)) {
+            return result;
+        }
+        if(!assertEquals(3, (int)ws(9,10,11), &result)) {
+            return result;
+        }
+        if(!assertEquals(true, ws.printer == puma::Workspace::defaultPrinter(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test94() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "NUMA first touch";
+        std::string testDescription = "With first touch enabled, new matrices are initialized in parallel, to zero when no value is given";
+        TestResult result(suiteName,testName,94,testDescription);
+
+        // the placement must not change the number of threads of the caller
+        int callerThreads = omp_get_max_threads();
+
+        puma::NUMA::setFirstTouch(true, 2);
+        if(!assertEquals(2, puma::NUMA::numThreads(), &result)) {
+            puma::NUMA::setFirstTouch(false);
+            return result;
+        }
+
+        puma::Matrix<double> zeros(20,30,40);
+        puma::Matrix<double> ones(20,30,40,1);
+        puma::Matrix<double> copied(ones);
+        puma::MatVec3<double> vectors(5,5,5,puma::Vec3<double>(1,2,3));
+        zeros.resize(10,30,40);
+        puma::Matrix<double> assigned;
+        assigned = ones;
+        puma::NUMA::setFirstTouch(false);
+
+        if(!assertEquals(callerThreads, omp_get_max_threads(), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)24000, assigned.reduce(), &result)) {
+            return result;
+        }
+
+        if(!assertEquals((double)0, zeros.reduce(), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)24000, ones.reduce(), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)24000, copied.reduce(), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)3, vectors(4,4,4).z, &result)) {
+            return result;
+        }
+        if(!assertEquals(false, puma::NUMA::firstTouch(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test95() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Reproducible reductions";
+        std::string testDescription = "reduce, dot, average, min and max give bitwise the same result on any number of threads";
+        TestResult result(suiteName,testName,95,testDescription);
+
+        // not a multiple of the block size, so that the last block is partial
+        puma::Matrix<double> a(71,53,37);
+        puma::Matrix<double> b(71,53,37);
+        for(long i=0; i<a.size(); i++) {
+            a(i) = std::sin(0.37*i)*1e11 + 1.5e11;
+            b(i) = std::cos(0.11*i);
+        }
+
+        double sum = a.reduce(1);
+        double dot = a.dot(&b, 1);
+        double average = a.average(1);
+        double min = a.min(1);
+        double max = a.max(1);
+
+        long double exact = 0;
+        for(long i=0; i<a.size(); i++) {
+            exact += a(i);
+        }
+        if(!assertEquals(true, std::abs(sum - (double)exact) < 1e-12*std::abs((double)exact), &result)) {
+            return result;
+        }
+
+        for(int numThreads = 2; numThreads <= 7; numThreads++) {
+            if(!assertEquals(true, a.reduce(numThreads) == sum, &result)) {
+                return result;
+            }
+            if(!assertEquals(true, a.dot(&b, numThreads) == dot, &result)) {
+                return result;
+            }
+            if(!assertEquals(true, a.average(numThreads) == average, &result)) {
+                return result;
+            }
+            if(!assertEquals(min, a.min(numThreads), &result)) {
+                return result;
+            }
+            if(!assertEquals(max, a.max(numThreads), &result)) {
+                return result;
+            }
+        }
+
+        // values beyond the old 1e10 starting point of min
+        if(!assertEquals(true, min > 4e10, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test96() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "MatrixView";
+        std::string testDescription = "A view reads and writes the box of its matrix in place, and an invalid box gives an empty view";
+        TestResult result(suiteName,testName,96,testDescription);
+
+        puma::Matrix<int> a(10,11,12);
+        for(long i=0; i<a.size(); i++) {
+            a(i) = (int)i;
+        }
+
+        puma::MatrixView<int> view(&a,2,5,3,-1,4,4);
+        if(!assertEquals((long)32, view.size(), &result)) {
+            return result;
+        }
+        if(!assertEquals(a(3,5,4), view(1,2,0), &result)) {
+            return result;
+        }
+
+        view(0,0,0) = -1;
+        if(!assertEquals(-1, a(2,3,4), &result)) {
+            return result;
+        }
+
+        puma::Matrix<int> box;
+        view.copyTo(&box);
+        box.set(7);
+        view.copyFrom(&box);
+        if(!assertEquals(7, a(5,10,4), &result)) {
+            return result;
+        }
+        if(!assertEquals((int)a.size()-1, a(9,10,11), &result)) {
+            return result;
+        }
+
+        puma::MatrixView<int> invalid(&a,5,2,0,-1,0,-1);
+        if(!assertEquals((long)0, invalid.size(), &result)) {
+            return result;
+        }
+
+        // the whole view of an empty matrix is empty, but valid
+        puma::Matrix<int> empty;
+        puma::MatrixView<int> emptyView(&empty);
+        if(!assertEquals((long)0, emptyView.size(), &result)) {
+            return result;
+        }
+        if(!assertEquals(true, emptyView.isWhole(), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test97() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Workspace pyramid";
+        std::string testDescription = "Coarse levels pool 2x2x2 blocks by mean or majority, are cached, and are rebuilt after the workspace is modified";
+        TestResult result(suiteName,testName,97,testDescription);
+
+        puma::Workspace ws(9,8,8,0,1e-6,false);
+        for(long i=0;i<9;i++) {
+            for(long j=0;j<8;j++) {
+                for(long k=0;k<8;k++) {
+                    ws.matrix(i,j,k) = (short)(100*(i/2) + ((j+k)%2)*10);
+                }
+            }
+        }
+
+        puma::Workspace *half = ws.coarse(2,'a');
+        if(!assertEquals((long)5, half->X(), &result)) {
+            return result;
+        }
+        if(!assertEquals(2e-6, half->voxelLength, &result)) {
+            return result;
+        }
+        // each block holds four 0 and four 10 on top of 100*(i/2)
+        if(!assertEquals(305, (int)half->matrix(3,1,2), &result)) {
+            return result;
+        }
+        // the last block along x is cut by the face, and keeps 4 voxels
+        if(!assertEquals(405, (int)half->matrix(4,0,0), &result)) {
+            return result;
+        }
+
+        puma::Workspace *eighth = ws.coarse(8,'a');
+        if(!assertEquals(true, ws.coarse(2,'a') == half, &result)) {
+            return result;
+        }
+        if(!assertEquals((long)2, eighth->X(), &result)) {
+            return result;
+        }
+        if(!assertEquals((long)1, eighth->Y(), &result)) {
+            return result;
+        }
+
+        ws.setMaterialID(puma::Cutoff(0,150),1);
+        ws.setMaterialID(puma::Cutoff(151,1000),2);
+        puma::Workspace *segmented = ws.coarse(2,'m');
+        if(!assertEquals(1, (int)segmented->matrix(0,0,0), &result)) {
+            return result;
+        }
+        if(!assertEquals(2, (int)segmented->matrix(2,3,3), &result)) {
+            return result;
+        }
+
+        ws.matrix(0,0,0) = 2;
+        ws.matrix(0,0,1) = 2;
+        ws.matrix(0,1,0) = 2;
+        ws.matrix(1,0,0) = 2;
+        ws.modified();
+        if(!assertEquals(1, (int)ws.coarse(2,'m')->matrix(0,0,0), &result)) {
+            return result;
+        }
+        ws.matrix(1,1,0) = 2;
+        ws.modified();
+        if(!assertEquals(2, (int)ws.coarse(2,'m')->matrix(0,0,0), &result)) {
+            return result;
+        }
+
+        if(!assertEquals(true, ws.coarse(3) == nullptr, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+
+    static TestResult test99() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Workspace pyramid after same shape writes";
+        std::string testDescription = "Coarse levels are rebuilt when data of the same shape is imported or set through matrix";
+        TestResult result(suiteName,testName,99,testDescription);
+
+        std::string path = puma::PString::get_puma_directory()+"cpp/test/out/bin/pyramid";
+        puma::Workspace written(16,16,16,10,1e-6,false);
+        puma::export_bin(&written,path);
+
+        puma::Workspace ws(1e-6,false);
+        puma::import_bin(&ws,path+".puma",0);
+        if(!assertEquals(10, (int)ws.coarse(2,'a')->matrix(3,3,3), &result)) {
+            return result;
+        }
+
+        // same shape, imported into the same storage
+        written.matrix.set(200);
+        puma::export_bin(&written,path);
+        puma::import_bin(&ws,path+".puma",0);
+        if(!assertEquals(200, (int)ws.coarse(2,'a')->matrix(3,3,3), &result)) {
+            return result;
+        }
+
+        ws.matrix.resize(16,16,16);
+        ws.matrix.set(50);
+        if(!assertEquals(50, (int)ws.coarse(4,'m')->matrix(1,1,1), &result)) {
+            return result;
+        }
+
+        // a copy of the same shape replaces the values
+        ws.matrix.copy(&written.matrix);
+        if(!assertEquals(200, (int)ws.coarse(4,'m')->matrix(1,1,1), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+
+    static TestResult test98() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Voxel kernels";
+        std::string testDescription = "for_each_voxel and for_each_stencil visit the same voxels as the indexed loops";
+        TestResult result(suiteName,testName,98,testDescription);
+
+        puma::Matrix<double> in(7,6,5);
+        for(long i=0;i<in.size();i++) {
+            in(i) = (double)((i*37)%11);
+        }
+
+        // a box, through the matrix and through a view
+        puma::Matrix<int> count(7,6,5,0);
+        puma::for_each_voxel(&count, 1,3, 0,5, 2,2, [](int &c) { c++; }, 2);
+        puma::MatrixView<int> view(&count, 2,5, 1,4, 0,-1);
+        puma::for_each_voxel(&view, [](int &c) { c += 10; }, 3);
+        for(long i=0;i<7;i++) {
+            for(long j=0;j<6;j++) {
+                for(long k=0;k<5;k++) {
+                    int expected = (i>=1 && i<=3 && k==2 ? 1 : 0) + (i>=2 && i<=5 && j>=1 && j<=4 ? 10 : 0);
+                    if(!assertEquals(expected, count(i,j,k), &result)) {
+                        return result;
+                    }
+                }
+            }
+        }
+
+        puma::Matrix<float> small(7,6,4);
+        if(!assertEquals(false, puma::for_each_voxel(&in, &small, [](const double &a, float &b) { b = (float)a; }), &result)) {
+            return result;
+        }
+
+        // central difference along y, written into a matrix larger than the input
+        typedef puma::Shape<puma::Offset<0,-1,0>, puma::Offset<0,1,0>> CentralY;
+        puma::Matrix<double> grad(7,7,5,-1.);
+        puma::for_each_stencil<CentralY>(&in, &grad, [](const puma::Stencil<double,CentralY> &s, double &g) {
+            g = (s.at<0,1,0>() - s.at<0,-1,0>())/2. + 100.*s.j;
+        }, 4);
+        for(long i=0;i<7;i++) {
+            for(long j=0;j<7;j++) {
+                for(long k=0;k<5;k++) {
+                    double expected = -1.;
+                    if(j>=1 && j<=4) {
+                        expected = (in(i,j+1,k) - in(i,j-1,k))/2. + 100.*j;
+                    }
+                    if(!assertEquals(expected, grad(i,j,k), &result)) {
+                        return result;
+                    }
+                }
+            }
+        }
+
+        // the ported Matrix functions
+        puma::Matrix<double> flipped(in);
+        flipped.flipAroundValue(5.f);
+        puma::Matrix<float> normalized;
+        in.normalize(&normalized, 0.f, 1.f);
+        for(long i=0;i<in.size();i++) {
+            if(!assertEquals(in(i) > 5 ? 10. - in(i) : in(i), flipped(i), &result)) {
+                return result;
+            }
+            if(!assertEquals((float)(in(i)/10.), normalized(i), &result)) {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+
+    static TestResult test100() {
+        std::string suiteName = "Matrix Tests: ";
+        std::string testName = "Reductions keep the thread count";
+        std::string testDescription = "reduce, dot, average, min and max do not change the number of threads of the caller";
+        TestResult result(suiteName,testName,100,testDescription);
+
+        int callerThreads = omp_get_max_threads();
+        int fewerThreads = callerThreads > 1 ? callerThreads - 1 : 1;
+        omp_set_num_threads(fewerThreads);
+
+        puma::Matrix<double> a(71,53,37,2.);
+        puma::Matrix<double> b(71,53,37,0.5);
+        double dot = a.dot(&b);
+        double average = a.average();
+        if(!assertEquals(fewerThreads, omp_get_max_threads(), &result)) {
+            omp_set_num_threads(callerThreads);
+            return result;
+        }
+
+        a.reduce(3);
+        a.min();
+        a.max(2);
+        int threadsAfter = omp_get_max_threads();
+        omp_set_num_threads(callerThreads);
+
+        if(!assertEquals(fewerThreads, threadsAfter, &result)) {
+            return result;
+        }
+        if(!assertEquals((double)a.size(), dot, &result)) {
+            return result;
+        }
+        if(!assertEquals(2., average, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
 };
@@ -17,6 +17,8 @@ public:
         tests.push_back(test6);
         tests.push_back(test7);
         tests.push_back(test8);
+        tests.push_back(test9);
+        tests.push_back(test10);
     }
 
 
@@ -433,4 +435,84 @@ public:
     }
 
 
+    static TestResult test9() {
+
+        std::string suiteName = "MeanFilter3D_Test";
+        std::string testName = "MeanFilter3D_Test: workspace view";
+        std::string testDescription = "Filtering a view of a box gives the same box as filtering the workspace cropped to it, and leaves the rest unchanged";
+        TestResult result(suiteName, testName, 9, testDescription);
+
+        puma::Workspace work(20,18,16,0,1e-6,false);
+        for(long i=0;i<work.matrix.size();i++) {
+            work.matrix(i) = (short)((i*7919)%255);
+        }
+        puma::Workspace original(&work);
+
+        puma::Workspace cropped(&work);
+        cropped.crop(4,13,2,17,5,11);
+        puma::filter_Mean3D(&cropped,2,0);
+
+        puma::WorkspaceView view(&work,4,13,2,17,5,11);
+        puma::filter_Mean3D(&view,2,0);
+
+        for(long i=0;i<work.X();i++) {
+            for(long j=0;j<work.Y();j++) {
+                for(long k=0;k<work.Z();k++) {
+                    bool inside = i>=4 && i<=13 && j>=2 && j<=17 && k>=5 && k<=11;
+                    short expected = inside ? cropped.matrix(i-4,j-2,k-5) : original.matrix(i,j,k);
+                    if(!assertEquals((int)expected, (int)work.matrix(i,j,k), &result)) {
+                        return result;
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test10() {
+
+        std::string suiteName = "MeanFilter3D_Test";
+        std::string testName = "MeanFilter3D_Test: clipped window sums";
+        std::string testDescription = "Random signed values, radii up to larger than the domain and several thread counts give the truncated mean of the window cut at the faces";
+        TestResult result(suiteName, testName, 10, testDescription);
+
+        puma::Workspace original(17,13,11,0,1e-6,false);
+        for(long i=0;i<original.matrix.size();i++) {
+            original.matrix(i) = (short)((i*7919)%4001 - 2000);
+        }
+
+        int radii[4] = {1,3,9,20};
+        int threads[3] = {1,3,0};
+        for(int r : radii) {
+            for(int n : threads) {
+                puma::Workspace work(&original);
+                if(!assertEquals(true, puma::filter_Mean3D(&work,r,n), &result)) {
+                    return result;
+                }
+
+                for(long i=0;i<work.X();i++) {
+                    for(long j=0;j<work.Y();j++) {
+                        for(long k=0;k<work.Z();k++) {
+                            long sum = 0, count = 0;
+                            for(long a=std::max(0L,i-r);a<=std::min(work.X()-1,i+r);a++) {
+                                for(long b=std::max(0L,j-r);b<=std::min(work.Y()-1,j+r);b++) {
+                                    for(long c=std::max(0L,k-r);c<=std::min(work.Z()-1,k+r);c++) {
+                                        sum += original.matrix(a,b,c);
+                                        count++;
+                                    }
+                                }
+                            }
+                            if(!assertEquals((int)(sum/count), (int)work.matrix(i,j,k), &result)) {
+                                return result;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
 };
@@ -28,6 +28,9 @@ public:
         tests.push_back(test18);
         tests.push_back(test19);
         tests.push_back(test20);
+        tests.push_back(test21);
+        tests.push_back(test22);
+        tests.push_back(test23);
 
     }
 
@@ -509,4 +512,139 @@ public:
         return result;
     }
 
+    static TestResult test21() {
+        std::string suiteName = "MeanInterceptLength_Test";
+        std::string testName = "MeanInterceptLength_Test: Test 21 - run-length encoded workspace";
+        std::string testDescription = "Mean intercept length on the runs of an RLEWorkspace matches the dense workspace";
+        TestResult result(suiteName, testName, 21, testDescription);
+
+        // mostly void domain with a few spheres of two materials
+        puma::Workspace segWS(60,50,40,0,1e-6,false);
+        for(long i=0;i<60;i++) {
+            for(long j=0;j<50;j++) {
+                for(long k=0;k<40;k++) {
+                    if((i-20)*(i-20)+(j-15)*(j-15)+(k-10)*(k-10) < 81) { segWS.matrix(i,j,k) = 1; }
+                    if((i-45)*(i-45)+(j-35)*(j-35)+(k-25)*(k-25) < 144) { segWS.matrix(i,j,k) = 2; }
+                }
+            }
+        }
+        puma::RLEWorkspace rleWS(&segWS);
+
+        puma::Vec3<double> mil = puma::compute_MeanInterceptLength(&segWS,puma::Cutoff(0,0));
+        puma::Vec3<double> milRLE = puma::compute_MeanInterceptLength(&rleWS,puma::Cutoff(0,0));
+
+        if(!assertEquals(mil.x,milRLE.x, &result)) {
+            return result;
+        }
+        if(!assertEquals(mil.y,milRLE.y, &result)) {
+            return result;
+        }
+        if(!assertEquals(mil.z,milRLE.z, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test22() {
+        std::string suiteName = "MeanInterceptLength_Test";
+        std::string testName = "MeanInterceptLength_Test: Test 22 - bit mask counts";
+        std::string testDescription = "Counts, transitions and chord lengths of a BitMask match a voxel by voxel count, for z sizes on and across word boundaries";
+        TestResult result(suiteName, testName, 22, testDescription);
+
+        long zSizes[3] = {64, 130, 7};
+        for(long z : zSizes) {
+            puma::Workspace grayWS(9,11,z,0,1e-6,false);
+            for(long i=0;i<grayWS.matrix.size();i++) {
+                grayWS.matrix(i) = (short)((i*7919 + i/13) % 5);
+            }
+            puma::Cutoff cutoff(1,2);
+            puma::BitMask mask(&grayWS,cutoff);
+
+            long count = 0, transitions[3] = {0,0,0}, bothWays[3] = {0,0,0};
+            std::vector<long> chords(z+1,0);
+            for(long i=0;i<9;i++) {
+                for(long j=0;j<11;j++) {
+                    long run = 0;
+                    for(long k=0;k<z;k++) {
+                        bool in = grayWS.matrix(i,j,k) >= cutoff.first && grayWS.matrix(i,j,k) <= cutoff.second;
+                        count += in;
+                        run = in ? run+1 : 0;
+                        if(run > 0 && (k == z-1 || !(grayWS.matrix(i,j,k+1) >= cutoff.first && grayWS.matrix(i,j,k+1) <= cutoff.second))) {
+                            chords[run]++;
+                        }
+                        long next[3][3] = {{i+1,j,k},{i,j+1,k},{i,j,k+1}};
+                        for(int d=0;d<3;d++) {
+                            if(next[d][0] >= 9 || next[d][1] >= 11 || next[d][2] >= z) {
+                                continue;
+                            }
+                            short value = grayWS.matrix(next[d][0],next[d][1],next[d][2]);
+                            bool inNext = value >= cutoff.first && value <= cutoff.second;
+                            transitions[d] += in && !inNext;
+                            bothWays[d] += in != inNext;
+                        }
+                    }
+                }
+            }
+
+            if(!assertEquals(count, mask.count(), &result)) {
+                return result;
+            }
+            char axes[3] = {'x','y','z'};
+            for(int d=0;d<3;d++) {
+                if(!assertEquals(transitions[d], mask.countTransitions(axes[d],false), &result)) {
+                    return result;
+                }
+                if(!assertEquals(bothWays[d], mask.countTransitions(axes[d],true), &result)) {
+                    return result;
+                }
+            }
+
+            std::vector<long> maskChords;
+            mask.chordLengthsZ(&maskChords);
+            for(long n=0;n<=z;n++) {
+                if(!assertEquals(chords[n], maskChords[n], &result)) {
+                    return result;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test23() {
+        std::string suiteName = "MeanInterceptLength_Test";
+        std::string testName = "MeanInterceptLength_Test: Test 23 - workspace view";
+        std::string testDescription = "Mean intercept length on a view of a box matches the one of the workspace cropped to the box";
+        TestResult result(suiteName, testName, 23, testDescription);
+
+        puma::Workspace segWS(60,50,40,0,1e-6,false);
+        for(long i=0;i<60;i++) {
+            for(long j=0;j<50;j++) {
+                for(long k=0;k<40;k++) {
+                    if((i-20)*(i-20)+(j-15)*(j-15)+(k-10)*(k-10) < 81) { segWS.matrix(i,j,k) = 1; }
+                    if((i-45)*(i-45)+(j-35)*(j-35)+(k-25)*(k-25) < 144) { segWS.matrix(i,j,k) = 2; }
+                }
+            }
+        }
+
+        puma::WorkspaceView view(&segWS,5,34,0,29,3,36);
+        puma::Workspace cropped(&segWS);
+        cropped.crop(5,34,0,29,3,36);
+
+        puma::Vec3<double> expected = puma::compute_MeanInterceptLength(&cropped,puma::Cutoff(0,0),0);
+        puma::Vec3<double> actual = puma::compute_MeanInterceptLength(&view,puma::Cutoff(0,0),0);
+        if(!assertEquals(expected.x, actual.x, &result)) {
+            return result;
+        }
+        if(!assertEquals(expected.y, actual.y, &result)) {
+            return result;
+        }
+        if(!assertEquals(expected.z, actual.z, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
 };
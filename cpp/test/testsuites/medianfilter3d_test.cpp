@@ -17,6 +17,7 @@ public:
         tests.push_back(test6);
         tests.push_back(test7);
         tests.push_back(test8);
+        tests.push_back(test9);
     }
 
 
@@ -335,6 +336,60 @@ public:
     }
 
 
+    static TestResult test9() {
+
+        std::string suiteName = "MedianFilter3D_Test";
+        std::string testName = "MedianFilter3D_Test: clipped window medians";
+        std::string testDescription = "Random signed values over the whole short range, radii up to larger than the domain and several thread counts give the median of the sorted window cut at the faces";
+        TestResult result(suiteName, testName, 9, testDescription);
+
+        puma::Workspace original(13,10,9,0,1e-6,false);
+        for(long i=0;i<original.matrix.size();i++) {
+            original.matrix(i) = (short)((i*7919*7919)%65536 - 32768);
+        }
+        // a narrow range as well, with many equal values
+        for(long i=0;i<original.X();i++) {
+            for(long j=0;j<original.Y();j++) {
+                original.matrix(i,j,0) = (short)((i+2*j)%5);
+            }
+        }
+
+        int radii[4] = {1,2,4,13};
+        int threads[3] = {1,3,0};
+        for(int r : radii) {
+            for(int n : threads) {
+                puma::Workspace work(&original);
+                if(!assertEquals(true, puma::filter_Median3D(&work,r,n), &result)) {
+                    return result;
+                }
+
+                for(long i=0;i<work.X();i++) {
+                    for(long j=0;j<work.Y();j++) {
+                        for(long k=0;k<work.Z();k++) {
+                            std::vector<short> window;
+                            for(long a=std::max(0L,i-r);a<=std::min(work.X()-1,i+r);a++) {
+                                for(long b=std::max(0L,j-r);b<=std::min(work.Y()-1,j+r);b++) {
+                                    for(long c=std::max(0L,k-r);c<=std::min(work.Z()-1,k+r);c++) {
+                                        window.push_back(original.matrix(a,b,c));
+                                    }
+                                }
+                            }
+                            std::sort(window.begin(),window.end());
+                            long size = window.size();
+                            double median = size%2 == 0 ? (window[size/2] + window[size/2-1])/2.0 : window[size/2];
+                            if(!assertEquals((int)(short)median, (int)work.matrix(i,j,k), &result)) {
+                                return result;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+
     // custom assertEquals to compare two Grayscale workspaces
     static bool myAssertEquals(puma::Workspace *valExpected, puma::Workspace *valActual, TestResult *result) {
 
@@ -56,6 +56,7 @@ public:
         tests.push_back(test_ST_wrongKernelSizes);
         tests.push_back(test_ST_application1);
         tests.push_back(test_ST_applicationGeneratedRandomFibers);
+        tests.push_back(test_ST_convolutionPaths);
     }
 
 
@@ -1275,4 +1276,69 @@ public:
 
         return result;
     }
+
+    static TestResult test_ST_convolutionPaths() {
+
+        std::string suiteName = "Orientation_Test";
+        std::string testName = "Test - ST separable, FFT and direct convolutions agree for both boundary conditions";
+        TestResult result(suiteName, testName, 43);
+
+        puma::Matrix<double> img(13,11,9);
+        for(long i=0; i<img.size(); i++) {
+            img(i) = (double)((i*7919)%255);
+        }
+
+        // derivative of Gaussian along y, as in the ST gradients
+        std::vector<double> dog = puma::Convolution::gaussianDerivative(1.1), gauss = puma::Convolution::gaussian(1.1);
+        puma::Matrix<double> kernel(gauss.size(), dog.size(), gauss.size());
+        for(long a=0; a<kernel.X(); a++) {
+            for(long b=0; b<kernel.Y(); b++) {
+                for(long c=0; c<kernel.Z(); c++) {
+                    kernel(a,b,c) = gauss[a]*dog[b]*gauss[c];
+                }
+            }
+        }
+
+        std::vector<double> kx, ky, kz;
+        if(!assertEquals(true, puma::Convolution::factor(&kernel, &kx, &ky, &kz), &result)) {
+            return result;
+        }
+        kernel(0,0,0) += 1e-3;
+        if(!assertEquals(false, puma::Convolution::factor(&kernel, &kx, &ky, &kz), &result)) {
+            return result;
+        }
+        kernel(0,0,0) -= 1e-3;
+
+        for(char bc : {'c','s'}) {
+            puma::Matrix<double> separable, fft, direct;
+            puma::Convolution::separable(&img, gauss, dog, gauss, &separable, bc, 2);
+            puma::Convolution::fft(&img, &kernel, &fft, bc, 2);
+            puma::Convolution::direct(&img, &kernel, &direct, bc, 2);
+
+            for(long i=0; i<img.size(); i++) {
+                if(!assertEquals(direct(i), separable(i), 1e-9, &result)) {
+                    return result;
+                }
+                if(!assertEquals(direct(i), fft(i), 1e-9, &result)) {
+                    return result;
+                }
+            }
+        }
+
+        // 'c' crops the kernel at the faces: a constant image loses the part of the Gaussian that falls outside
+        puma::Matrix<double> ones(9,9,9,1.), blurred;
+        puma::Convolution::separable(&ones, gauss, gauss, gauss, &blurred, 'c', 1);
+        if(!assertEquals(1., blurred(4,4,4), 1e-12, &result)) {
+            return result;
+        }
+        if(!assertEquals(true, blurred(0,4,4) < 0.9, &result)) {
+            return result;
+        }
+        puma::Convolution::separable(&ones, gauss, gauss, gauss, &blurred, 's', 1);
+        if(!assertEquals(1., blurred(0,0,0), 1e-12, &result)) {
+            return result;
+        }
+
+        return result;
+    }
 };
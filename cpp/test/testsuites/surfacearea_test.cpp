@@ -39,6 +39,8 @@ public:
 //        tests.push_back(test26);
         tests.push_back(test27);
         tests.push_back(test28);
+        tests.push_back(test29);
+        tests.push_back(test30);
 
     }
 
@@ -633,4 +635,76 @@ public:
 
         return result;
     }
+
+    static TestResult test29() {
+
+        std::string suiteName = "SurfaceArea_Test";
+        std::string testName = "SurfaceArea_Test: Test 29 - run-length encoded workspace, Voxel based";
+        std::string testDescription = "Voxel surface area on the runs of an RLEWorkspace matches the dense workspace";
+        TestResult result(suiteName, testName, 29, testDescription);
+
+        // mostly void domain with a few spheres of two materials
+        puma::Workspace segWS(60,50,40,0,1e-6,false);
+        for(long i=0;i<60;i++) {
+            for(long j=0;j<50;j++) {
+                for(long k=0;k<40;k++) {
+                    if((i-20)*(i-20)+(j-15)*(j-15)+(k-10)*(k-10) < 81) { segWS.matrix(i,j,k) = 1; }
+                    if((i-45)*(i-45)+(j-35)*(j-35)+(k-25)*(k-25) < 144) { segWS.matrix(i,j,k) = 2; }
+                }
+            }
+        }
+        puma::RLEWorkspace rleWS(&segWS);
+
+        std::pair<double, double> sa = puma::compute_SurfaceAreaVoxels(&segWS, puma::Cutoff(1, 2), 0);
+        std::pair<double, double> saRLE = puma::compute_SurfaceAreaVoxels(&rleWS, puma::Cutoff(1, 2), 0);
+
+        if(!assertEquals(sa.first,saRLE.first, &result)) {
+            return result;
+        }
+        if(!assertEquals(sa.second,saRLE.second, &result)) {
+            return result;
+        }
+
+        sa = puma::compute_SurfaceAreaVoxels(&segWS, puma::Cutoff(2, 2), 0);
+        saRLE = puma::compute_SurfaceAreaVoxels(&rleWS, puma::Cutoff(2, 2), 0);
+
+        if(!assertEquals(sa.first,saRLE.first, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
+    static TestResult test30() {
+        std::string suiteName = "SurfaceArea_Test";
+        std::string testName = "SurfaceArea_Test: Test 30 - workspace view";
+        std::string testDescription = "Voxel surface area on a view of a box matches the surface area of the workspace cropped to the box";
+        TestResult result(suiteName, testName, 30, testDescription);
+
+        puma::Workspace segWS(60,50,40,0,1e-6,false);
+        for(long i=0;i<60;i++) {
+            for(long j=0;j<50;j++) {
+                for(long k=0;k<40;k++) {
+                    if((i-20)*(i-20)+(j-15)*(j-15)+(k-10)*(k-10) < 81) { segWS.matrix(i,j,k) = 1; }
+                    if((i-45)*(i-45)+(j-35)*(j-35)+(k-25)*(k-25) < 144) { segWS.matrix(i,j,k) = 2; }
+                }
+            }
+        }
+
+        puma::WorkspaceView view(&segWS,30,59,20,49,10,39);
+        puma::Workspace cropped(&segWS);
+        cropped.crop(30,59,20,49,10,39);
+
+        std::pair<double,double> expected = puma::compute_SurfaceAreaVoxels(&cropped,puma::Cutoff(1,2),0);
+        std::pair<double,double> actual = puma::compute_SurfaceAreaVoxels(&view,puma::Cutoff(1,2),0);
+        if(!assertEquals(expected.first, actual.first, &result)) {
+            return result;
+        }
+        if(!assertEquals(expected.second, actual.second, &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
 };
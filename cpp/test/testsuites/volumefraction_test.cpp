@@ -24,6 +24,8 @@ public:
         tests.push_back(test14);
         tests.push_back(test15);
         tests.push_back(test16);
+        tests.push_back(test20);
+        tests.push_back(test21);
         //tests.push_back(test17);
         //tests.push_back(test18);
         //tests.push_back(test19);
@@ -451,4 +453,89 @@ public:
         return result;
     }
 
+    static TestResult test20() {
+        std::string suiteName = "VolumeFraction_test";
+        std::string testName = "VolumeFraction_test: Test 20 - run-length encoded workspace";
+        std::string testDescription = "Volume fraction on the runs of an RLEWorkspace matches the dense workspace, and the runs decode back to the same matrix";
+        TestResult result(suiteName, testName, 20, testDescription);
+
+        // mostly void domain with a few spheres of two materials
+        puma::Workspace segWS(60,50,40,0,1e-6,false);
+        for(long i=0;i<60;i++) {
+            for(long j=0;j<50;j++) {
+                for(long k=0;k<40;k++) {
+                    if((i-20)*(i-20)+(j-15)*(j-15)+(k-10)*(k-10) < 81) { segWS.matrix(i,j,k) = 1; }
+                    if((i-45)*(i-45)+(j-35)*(j-35)+(k-25)*(k-25) < 144) { segWS.matrix(i,j,k) = 2; }
+                }
+            }
+        }
+        puma::RLEWorkspace rleWS(&segWS);
+
+        if(!assertEquals(puma::compute_VolumeFraction(&segWS,puma::Cutoff(1,2),0), puma::compute_VolumeFraction(&rleWS,puma::Cutoff(1,2),0), &result)) {
+            return result;
+        }
+        if(!assertEquals(puma::compute_VolumeFraction(&segWS,puma::Cutoff(0,0),0), puma::compute_VolumeFraction(&rleWS,puma::Cutoff(0,0),0), &result)) {
+            return result;
+        }
+        if(!assertEquals((int)segWS.matrix(45,35,25), (int)rleWS.at(45,35,25), &result)) {
+            return result;
+        }
+        if(!assertEquals(true, rleWS.memoryBytes() < segWS.matrix.size()*sizeof(short), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)-1, puma::compute_VolumeFraction(&rleWS,puma::Cutoff(2,1),0), &result)) {
+            return result;
+        }
+
+        puma::Workspace decoded(1e-6,false);
+        rleWS.toWorkspace(&decoded);
+        for(long i=0;i<segWS.matrix.size();i++) {
+            if(!assertEquals((int)segWS.matrix(i), (int)decoded.matrix(i), &result)) {
+                return result;
+            }
+        }
+
+        return result;
+    }
+
+    static TestResult test21() {
+        std::string suiteName = "VolumeFraction_test";
+        std::string testName = "VolumeFraction_test: Test 21 - workspace view";
+        std::string testDescription = "Volume fraction on a view of a box matches the volume fraction of the workspace cropped to the box";
+        TestResult result(suiteName, testName, 21, testDescription);
+
+        puma::Workspace segWS(60,50,40,0,1e-6,false);
+        for(long i=0;i<60;i++) {
+            for(long j=0;j<50;j++) {
+                for(long k=0;k<40;k++) {
+                    if((i-20)*(i-20)+(j-15)*(j-15)+(k-10)*(k-10) < 81) { segWS.matrix(i,j,k) = 1; }
+                    if((i-45)*(i-45)+(j-35)*(j-35)+(k-25)*(k-25) < 144) { segWS.matrix(i,j,k) = 2; }
+                }
+            }
+        }
+
+        puma::WorkspaceView view(&segWS,10,39,5,29,0,-1);
+        puma::Workspace cropped(&segWS);
+        cropped.crop(10,39,5,29,0,39);
+
+        if(!assertEquals(puma::compute_VolumeFraction(&cropped,puma::Cutoff(1,2),0), puma::compute_VolumeFraction(&view,puma::Cutoff(1,2),0), &result)) {
+            return result;
+        }
+
+        puma::WorkspaceView whole(&segWS);
+        if(!assertEquals(puma::compute_VolumeFraction(&segWS,puma::Cutoff(0,0),0), puma::compute_VolumeFraction(&whole,puma::Cutoff(0,0),0), &result)) {
+            return result;
+        }
+
+        // the cutoff is checked as for the workspace
+        if(!assertEquals((double)-1, puma::compute_VolumeFraction(&view,puma::Cutoff(2,1),0), &result)) {
+            return result;
+        }
+        if(!assertEquals((double)-1, puma::compute_VolumeFraction(&view,puma::Cutoff(-1,1),0), &result)) {
+            return result;
+        }
+
+        return result;
+    }
+
 };